@@ -1,4 +1,6 @@
 #include "boost_gate.h"
+#include "undo.h"
+#include "schema.h"
 #include <stdio.h>
 
 // Note: This implementation assumes that your main C file (or a shared header like map_editor.h)
@@ -26,6 +28,7 @@ void AddBoostGate(cJSON *boost_gates, Vector2 cameraOffset, float displayScale)
     cJSON_AddItemToObject(new_pair, "a", new_a);
     cJSON_AddItemToObject(new_pair, "b", new_b);
     cJSON_AddItemToArray(boost_gates, new_pair);
+    UndoRecordAdd(LAYER_BOOST_GATES, cJSON_GetArraySize(boost_gates) - 1);
 
     printf("Added a new boost gate.\n");
 }
@@ -40,6 +43,8 @@ void DrawBoostGates(cJSON *boost_gates, Vector2 cameraOffset, float *displayScal
     int gateIndex = 0;
     cJSON_ArrayForEach(point_pair, boost_gates)
     {
+        if (SchemaIsQuarantined(point_pair)) { gateIndex++; continue; }
+
         cJSON *a = cJSON_GetObjectItem(point_pair, "a");
         cJSON *b = cJSON_GetObjectItem(point_pair, "b");
 
@@ -57,6 +57,7 @@
 #endif
 
 #include "cJSON.h"
+#include "simd_scan.h"
 
 /* define our own boolean type */
 #ifdef true
@@ -90,7 +91,12 @@ typedef struct
     const unsigned char *json;
     size_t position;
 } error;
+/* Per thread, so documents can be parsed on several threads at once */
+#if defined(__GNUC__) || defined(__clang__)
+static __thread error global_error = {NULL, 0};
+#else
 static error global_error = {NULL, 0};
+#endif
 
 CJSON_PUBLIC(const char *)
 cJSON_GetErrorPtr(void)
@@ -796,20 +802,23 @@ static cJSON_bool parse_string(cJSON *const item, parse_buffer *const input_buff
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        while ((size_t)(input_end - input_buffer->content) < input_buffer->length)
         {
+            /* jump to the next quote or escape sequence */
+            input_end += SimdFindQuoteOrBackslash(input_end, input_buffer->length - (size_t)(input_end - input_buffer->content));
+            if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end == '\"'))
+            {
+                break;
+            }
+
             /* is escape sequence */
-            if (input_end[0] == '\\')
+            if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
+                /* prevent buffer overflow when last input character is a backslash */
+                goto fail;
             }
-            input_end++;
+            skipped_bytes++;
+            input_end += 2;
         }
         if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
         {
@@ -829,12 +838,14 @@ static cJSON_bool parse_string(cJSON *const item, parse_buffer *const input_buff
     /* loop through the string literal */
     while (input_pointer < input_end)
     {
-        if (*input_pointer != '\\')
-        {
-            *output_pointer++ = *input_pointer++;
-        }
+        /* copy up to the next escape sequence, the only quotes before input_end are escaped */
+        size_t run_length = SimdFindQuoteOrBackslash(input_pointer, (size_t)(input_end - input_pointer));
+        memcpy(output_pointer, input_pointer, run_length);
+        output_pointer += run_length;
+        input_pointer += run_length;
+
         /* escape sequence */
-        else
+        if (input_pointer < input_end)
         {
             unsigned char sequence_length = 2;
             if ((input_end - input_pointer) < 1)
@@ -914,6 +925,7 @@ static cJSON_bool print_string_ptr(const unsigned char *const input, printbuffer
     unsigned char *output = NULL;
     unsigned char *output_pointer = NULL;
     size_t output_length = 0;
+    size_t input_length = 0;
     /* numbers of additional characters needed for escaping */
     size_t escape_characters = 0;
 
@@ -935,8 +947,9 @@ static cJSON_bool print_string_ptr(const unsigned char *const input, printbuffer
         return true;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    /* count escapes from the first character that needs one, if any */
+    input_length = strlen((const char *)input);
+    for (input_pointer = input + SimdFindEscape(input, input_length); *input_pointer; input_pointer++)
     {
         switch (*input_pointer)
         {
@@ -983,44 +996,46 @@ static cJSON_bool print_string_ptr(const unsigned char *const input, printbuffer
     /* copy the string */
     for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
     {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        /* copy the run of normal characters up to the next one that needs escaping */
+        size_t run_length = SimdFindEscape(input_pointer, input_length - (size_t)(input_pointer - input));
+        memcpy(output_pointer, input_pointer, run_length);
+        output_pointer += run_length;
+        input_pointer += run_length;
+        if (*input_pointer == '\0')
         {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
+            break;
         }
-        else
+
+        /* character needs to be escaped */
+        *output_pointer++ = '\\';
+        switch (*input_pointer)
         {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
-            {
-            case '\\':
-                *output_pointer = '\\';
-                break;
-            case '\"':
-                *output_pointer = '\"';
-                break;
-            case '\b':
-                *output_pointer = 'b';
-                break;
-            case '\f':
-                *output_pointer = 'f';
-                break;
-            case '\n':
-                *output_pointer = 'n';
-                break;
-            case '\r':
-                *output_pointer = 'r';
-                break;
-            case '\t':
-                *output_pointer = 't';
-                break;
-            default:
-                /* escape and print as unicode codepoint */
-                sprintf((char *)output_pointer, "u%04x", *input_pointer);
-                output_pointer += 4;
-                break;
-            }
+        case '\\':
+            *output_pointer = '\\';
+            break;
+        case '\"':
+            *output_pointer = '\"';
+            break;
+        case '\b':
+            *output_pointer = 'b';
+            break;
+        case '\f':
+            *output_pointer = 'f';
+            break;
+        case '\n':
+            *output_pointer = 'n';
+            break;
+        case '\r':
+            *output_pointer = 'r';
+            break;
+        case '\t':
+            *output_pointer = 't';
+            break;
+        default:
+            /* escape and print as unicode codepoint */
+            sprintf((char *)output_pointer, "u%04x", *input_pointer);
+            output_pointer += 4;
+            break;
         }
     }
     output[output_length + 1] = '\"';
@@ -1056,10 +1071,7 @@ static parse_buffer *buffer_skip_whitespace(parse_buffer *const buffer)
         return buffer;
     }
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
-    {
-        buffer->offset++;
-    }
+    buffer->offset += SimdSkipSpace(buffer_at_offset(buffer), buffer->length - buffer->offset);
 
     if (buffer->offset == buffer->length)
     {
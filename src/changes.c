@@ -0,0 +1,137 @@
+#include "changes.h"
+#include "memtrack.h"
+#include "pointer_map.h"
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_COMPACT_ENTRIES 1024
+
+static uint64_t _version = 0;
+static uint64_t _lostVersion = 0;       // Latest change that could not be recorded
+static uint64_t _layerVersions[LAYER_COUNT] = { 0 };
+static uint64_t _structureVersions[LAYER_COUNT] = { 0 };
+static PointerMap _elements = { 0 };    // Latest version of each changed element
+static ElementChange *_log = NULL;      // In version order; an entry is stale once its element changed again
+static int _logCount = 0;
+static int _logCapacity = 0;
+
+//------------------------------------------------------------------------------------
+// Change log
+//------------------------------------------------------------------------------------
+// Drops the entries of elements that changed again later; one live entry per element remains
+static void CompactLog(void)
+{
+    int kept = 0;
+    for (int i = 0; i < _logCount; i++)
+    {
+        if ((uint64_t)PointerMapGet(&_elements, PointerKey(_log[i].element), 0) == _log[i].version) _log[kept++] = _log[i];
+    }
+    _logCount = kept;
+}
+
+static bool AppendLog(ElementChange change)
+{
+    // A drag marks the same elements every frame, so stale entries are dropped before growing
+    if (_logCount == _logCapacity && _logCount >= MIN_COMPACT_ENTRIES && (size_t)_logCount > 2 * _elements.count) CompactLog();
+    if (_logCount == _logCapacity)
+    {
+        int capacity = (_logCapacity == 0) ? 256 : _logCapacity * 2;
+        ElementChange *log = MemRealloc(_log, sizeof(ElementChange) * capacity);
+        if (log == NULL) return false;
+        _log = log;
+        _logCapacity = capacity;
+    }
+    _log[_logCount++] = change;
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+uint64_t ChangesGetVersion(void)
+{
+    return _version;
+}
+
+uint64_t ChangesGetLayerVersion(EditLayer layer)
+{
+    if (layer < 0 || layer >= LAYER_COUNT) return 0;
+    return _layerVersions[layer];
+}
+
+uint64_t ChangesGetStructureVersion(EditLayer layer)
+{
+    if (layer < 0 || layer >= LAYER_COUNT) return 0;
+    return _structureVersions[layer];
+}
+
+uint64_t ChangesGetElementVersion(const cJSON *element)
+{
+    return element ? (uint64_t)PointerMapGet(&_elements, PointerKey(element), 0) : 0;
+}
+
+void ChangesMarkElement(EditLayer layer, int index, const cJSON *element)
+{
+    if (element == NULL || layer < 0 || layer >= LAYER_COUNT) return;
+
+    uint64_t version = ++_version;
+    _layerVersions[layer] = version;
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+
+    // Repeated changes of the element changed last rewrite its entry instead of appending
+    ElementChange change = { element, layer, index, version };
+    bool recorded = PointerMapPut(&_elements, PointerKey(element), (int64_t)version);
+    if (recorded && _logCount > 0 && _log[_logCount - 1].element == element) _log[_logCount - 1] = change;
+    else if (recorded) recorded = AppendLog(change);
+    if (!recorded) _lostVersion = version;
+
+    MemPopSubsystem();
+}
+
+void ChangesMarkStructure(EditLayer layer)
+{
+    if (layer < 0 || layer >= LAYER_COUNT) return;
+    _structureVersions[layer] = _layerVersions[layer] = ++_version;
+}
+
+bool ChangesComplete(uint64_t since)
+{
+    return _lostVersion <= since;
+}
+
+ChangeIterator ChangesBegin(uint64_t since)
+{
+    // Entries are in version order, so the first one after since is found by bisection
+    int low = 0, high = _logCount;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (_log[middle].version <= since) low = middle + 1;
+        else high = middle;
+    }
+    return (ChangeIterator){ since, low };
+}
+
+bool ChangesNext(ChangeIterator *it, ElementChange *change)
+{
+    while (it->position < _logCount)
+    {
+        const ElementChange *entry = &_log[it->position++];
+        if ((uint64_t)PointerMapGet(&_elements, PointerKey(entry->element), 0) != entry->version) continue;
+        *change = *entry;
+        return true;
+    }
+    return false;
+}
+
+void ChangesClear(void)
+{
+    PointerMapFree(&_elements);
+    MemFree(_log);
+    _log = NULL;
+    _logCount = _logCapacity = 0;
+
+    // Versions keep counting up, so nothing synced to the old document looks current
+    uint64_t version = ++_version;
+    for (int i = 0; i < LAYER_COUNT; i++) _layerVersions[i] = _structureVersions[i] = version;
+}
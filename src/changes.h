@@ -0,0 +1,91 @@
+#ifndef CHANGES_H
+#define CHANGES_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Model-wide change versions. Every edit takes the next value of one counter; the
+// element it touched, its layer and, for insertions and removals, the layer's structure
+// remember that value. A consumer keeps the version it last synced at and asks what
+// changed since then, instead of comparing or rebuilding everything.
+//
+// Element versions are keyed by pointer and live until the document is reloaded, so a
+// detached or freed element stays changed even if its address is reused.
+
+typedef struct {
+    const cJSON *element;
+    EditLayer layer;
+    int index;                  // Array index at the time of the change (0 for world areas)
+    uint64_t version;
+} ElementChange;
+
+typedef struct {
+    uint64_t since;
+    int position;               // Next entry of the change log
+} ChangeIterator;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the version of the latest change. Never decreases, not even across reloads.
+ */
+uint64_t ChangesGetVersion(void);
+
+/**
+ * @brief Returns the version of the latest change of any kind in a layer.
+ */
+uint64_t ChangesGetLayerVersion(EditLayer layer);
+
+/**
+ * @brief Returns the version at which elements were last inserted into or removed from a layer,
+ *        or the document was reloaded. Array indices recorded after it are still valid.
+ */
+uint64_t ChangesGetStructureVersion(EditLayer layer);
+
+/**
+ * @brief Returns the version of the last change to an element, 0 if it is unchanged since the load.
+ */
+uint64_t ChangesGetElementVersion(const cJSON *element);
+
+/**
+ * @brief Records that a top-level layer element (or a world area object) was modified, or
+ *        detached from its array. Cheap enough to call every frame during a drag.
+ */
+void ChangesMarkElement(EditLayer layer, int index, const cJSON *element);
+
+/**
+ * @brief Records that elements were inserted into or detached from a layer's array.
+ *        Called by HandleLayerChanged().
+ */
+void ChangesMarkStructure(EditLayer layer);
+
+/**
+ * @brief Returns false if a change after the given version could not be recorded (out of
+ *        memory). Consumers then have to treat everything as changed.
+ */
+bool ChangesComplete(uint64_t since);
+
+/**
+ * @brief Starts an iteration over the elements changed after a version, oldest first,
+ *        each element once with its latest change.
+ */
+ChangeIterator ChangesBegin(uint64_t since);
+
+/**
+ * @brief Returns the next changed element, or false when there are no more.
+ *        Recording changes while iterating is not supported.
+ */
+bool ChangesNext(ChangeIterator *it, ElementChange *change);
+
+/**
+ * @brief Forgets every element of the old document and marks all layers as restructured.
+ *        Call when the document is replaced.
+ */
+void ChangesClear(void);
+
+#endif // CHANGES_H
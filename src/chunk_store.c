@@ -0,0 +1,657 @@
+#include "chunk_store.h"
+#include "handles.h"
+#include "file_util.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CHUNK_FORMAT "wee-boats-chunks"
+#define CHUNK_VERSION 1
+#define MAX_CHUNK_PATH 2048
+#define MAX_CHUNK_DIRECTORY 1024    // Leaves room for the file names in a path
+#define CHUNK_MARGIN 1              // Tiles loaded around the view
+#define CHUNK_LOADS_PER_UPDATE 4    // Spreads a large pan over a few frames
+
+typedef struct {
+    int x;
+    int y;
+    int count;                  // Structures in the tile as of the last load or write
+    size_t bytes;               // Heap used by its structures while loaded
+    uint64_t hash;              // Of the file as last read or written, to skip unchanged writes
+    bool hasFile;
+    bool loaded;
+    bool failed;                // Its file could not be read; it is never written or evicted, so the file survives
+    bool required;              // Scratch flags of one update
+    bool evict;
+    float distance;
+} Chunk;
+
+// Loaded structures grouped by tile: items[start[c] .. start[c + 1]) are in chunk c
+typedef struct {
+    cJSON **items;
+    int *start;
+} TileGroups;
+
+static Chunk *_chunks = NULL;
+static int _chunkCount = 0;
+static int _chunkCapacity = 0;
+static int *_slots = NULL;          // Open addressing table of chunk indices by tile, -1 if empty
+static int _slotCount = 0;
+static char _directory[MAX_CHUNK_DIRECTORY] = { 0 };
+static int _chunkSize = DEFAULT_CHUNK_SIZE;
+static size_t _budget = (size_t)DEFAULT_CHUNK_BUDGET_MB * 1024 * 1024;
+static size_t _loadedBytes = 0;
+static bool _open = false;
+
+//------------------------------------------------------------------------------------
+// Files
+//------------------------------------------------------------------------------------
+static char *ReadWholeFile(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    char *text = NULL;
+    long size = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) text = MemAlloc((size_t)size + 1);
+    if (text != NULL && fread(text, 1, (size_t)size, file) == (size_t)size)
+    {
+        text[size] = '\0';
+        *length = (size_t)size;
+    }
+    else
+    {
+        MemFree(text);
+        text = NULL;
+    }
+    fclose(file);
+    return text;
+}
+
+static void ChunkPath(char *path, size_t size, const char *directory, int x, int y)
+{
+    snprintf(path, size, "%s/chunk_%d_%d.json", directory, x, y);
+}
+
+// FNV-1a
+static uint64_t HashBytes(const char *data, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------------
+// Tiles
+//------------------------------------------------------------------------------------
+static void TileOf(const cJSON *structure, int chunkSize, int *x, int *y)
+{
+    cJSON *location = cJSON_GetObjectItem(structure, "location");
+    cJSON *xItem = cJSON_GetArrayItem(location, 0);
+    cJSON *yItem = xItem ? xItem->next : NULL;
+    *x = (xItem && yItem) ? (int)floor(xItem->valuedouble / chunkSize) : 0;
+    *y = (xItem && yItem) ? (int)floor(yItem->valuedouble / chunkSize) : 0;
+}
+
+static uint32_t TileHash(int x, int y)
+{
+    return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+}
+
+static int FindChunk(int x, int y)
+{
+    if (_slotCount == 0) return -1;
+    for (uint32_t slot = TileHash(x, y) & (uint32_t)(_slotCount - 1); _slots[slot] >= 0; slot = (slot + 1) & (uint32_t)(_slotCount - 1))
+    {
+        if (_chunks[_slots[slot]].x == x && _chunks[_slots[slot]].y == y) return _slots[slot];
+    }
+    return -1;
+}
+
+static bool Rehash(int slotCount)
+{
+    int *slots = MemAlloc(sizeof(int) * slotCount);
+    if (slots == NULL) return false;
+    for (int i = 0; i < slotCount; i++) slots[i] = -1;
+    for (int c = 0; c < _chunkCount; c++)
+    {
+        uint32_t slot = TileHash(_chunks[c].x, _chunks[c].y) & (uint32_t)(slotCount - 1);
+        while (slots[slot] >= 0) slot = (slot + 1) & (uint32_t)(slotCount - 1);
+        slots[slot] = c;
+    }
+    MemFree(_slots);
+    _slots = slots;
+    _slotCount = slotCount;
+    return true;
+}
+
+// Returns the chunk of a tile, adding an empty one without a file if it is new
+static int GetChunk(int x, int y)
+{
+    int found = FindChunk(x, y);
+    if (found >= 0) return found;
+
+    if (_chunkCount == _chunkCapacity)
+    {
+        int capacity = _chunkCapacity > 0 ? _chunkCapacity * 2 : 64;
+        Chunk *chunks = MemRealloc(_chunks, sizeof(Chunk) * capacity);
+        if (chunks == NULL) return -1;
+        _chunks = chunks;
+        _chunkCapacity = capacity;
+    }
+    if ((_chunkCount + 1) * 2 > _slotCount && !Rehash(_slotCount > 0 ? _slotCount * 2 : 128)) return -1;
+
+    _chunks[_chunkCount] = (Chunk){ .x = x, .y = y };
+    uint32_t slot = TileHash(x, y) & (uint32_t)(_slotCount - 1);
+    while (_slots[slot] >= 0) slot = (slot + 1) & (uint32_t)(_slotCount - 1);
+    _slots[slot] = _chunkCount;
+    return _chunkCount++;
+}
+
+//------------------------------------------------------------------------------------
+// Loading and writing
+//------------------------------------------------------------------------------------
+// Moves all items of source to the end of target without copying them
+static int AppendItems(cJSON *target, cJSON *source)
+{
+    cJSON *first = source->child;
+    if (first == NULL) return 0;
+
+    int count = 0;
+    for (cJSON *item = first; item != NULL; item = item->next) count++;
+    cJSON *last = first->prev;
+    source->child = NULL;
+    if (target->child == NULL) target->child = first;
+    else
+    {
+        cJSON *tail = target->child->prev;
+        tail->next = first;
+        first->prev = tail;
+        target->child->prev = last;
+    }
+    return count;
+}
+
+static bool LoadChunk(int index)
+{
+    Chunk *chunk = &_chunks[index];
+    chunk->loaded = true;
+    chunk->bytes = 0;
+    if (!chunk->hasFile) return true;
+
+    char path[MAX_CHUNK_PATH];
+    ChunkPath(path, sizeof(path), _directory, chunk->x, chunk->y);
+    size_t before = MemGetStats(MEM_SUBSYSTEM_LOAD).liveBytes;
+
+    size_t length = 0;
+    char *text = ReadWholeFile(path, &length);
+    cJSON *root = text ? cJSON_ParseWithLength(text, length) : NULL;
+    cJSON *structures = cJSON_GetObjectItem(root, "structures");
+    if (root == NULL || !cJSON_IsArray(structures))
+    {
+        // Shown as empty, but the file is left as it is
+        printf("WARNING: Failed to load chunk %s, it will not be saved or unloaded\n", path);
+        chunk->failed = true;
+        MemFree(text);
+        cJSON_Delete(root);
+        return false;
+    }
+    chunk->hash = HashBytes(text, length);
+    MemFree(text);
+
+    chunk->count = AppendItems(GetLayerJSON(LAYER_STRUCTURES), structures);
+    cJSON_Delete(root);
+    if (chunk->count > 0) HandleLayerChanged(LAYER_STRUCTURES);
+
+    size_t after = MemGetStats(MEM_SUBSYSTEM_LOAD).liveBytes;
+    chunk->bytes = after > before ? after - before : 0;
+    _loadedBytes += chunk->bytes;
+    return true;
+}
+
+// Prints the structures as a tile file, {"structures":[...]} without whitespace
+static char *PrintTile(cJSON *const *items, int count)
+{
+    cJSON *tile = cJSON_CreateObject();
+    cJSON *array = cJSON_AddArrayToObject(tile, "structures");
+    for (int i = 0; i < count && array != NULL; i++)
+    {
+        if (!cJSON_AddItemReferenceToArray(array, items[i])) array = NULL;
+    }
+    char *text = array ? cJSON_PrintUnformatted(tile) : NULL;
+    cJSON_Delete(tile);
+    return text;
+}
+
+// Writes a tile if its structures differ from the file
+static bool WriteChunk(const char *directory, Chunk *chunk, cJSON *const *items, int count)
+{
+    if (chunk->failed) return false;
+    if (count == 0 && !chunk->hasFile) return true;
+
+    char *text = PrintTile(items, count);
+    if (text == NULL) return false;
+
+    size_t length = strlen(text);
+    uint64_t hash = HashBytes(text, length);
+    bool written = true;
+    if (!chunk->hasFile || hash != chunk->hash)
+    {
+        char path[MAX_CHUNK_PATH];
+        ChunkPath(path, sizeof(path), directory, chunk->x, chunk->y);
+        written = WriteFileAtomic(path, text, length);
+        if (written)
+        {
+            chunk->hash = hash;
+            chunk->hasFile = true;
+        }
+        else printf("WARNING: Failed to write chunk %s\n", path);
+    }
+    cJSON_free(text);
+    if (written) chunk->count = count;
+    return written;
+}
+
+static bool WriteManifest(const char *directory, const cJSON *config, int chunkSize, const Chunk *chunks, int chunkCount)
+{
+    cJSON *manifest = cJSON_CreateObject();
+    cJSON_AddStringToObject(manifest, "format", CHUNK_FORMAT);
+    cJSON_AddNumberToObject(manifest, "version", CHUNK_VERSION);
+    cJSON_AddNumberToObject(manifest, "chunk_size", chunkSize);
+
+    cJSON *list = cJSON_AddArrayToObject(manifest, "chunks");
+    for (int c = 0; c < chunkCount; c++)
+    {
+        if (!chunks[c].hasFile) continue;
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddNumberToObject(entry, "x", chunks[c].x);
+        cJSON_AddNumberToObject(entry, "y", chunks[c].y);
+        cJSON_AddNumberToObject(entry, "structures", chunks[c].count);
+        cJSON_AddItemToArray(list, entry);
+    }
+
+    // Everything but the structures, by reference so nothing is copied
+    cJSON *world = cJSON_AddObjectToObject(manifest, "world");
+    for (cJSON *section = config ? config->child : NULL; section != NULL; section = section->next)
+    {
+        if (section->string != NULL && strcmp(section->string, "structures") != 0) cJSON_AddItemReferenceToObject(world, section->string, section);
+    }
+
+    char *text = cJSON_Print(manifest);
+    cJSON_Delete(manifest);
+    if (text == NULL) return false;
+
+    char path[MAX_CHUNK_PATH];
+    snprintf(path, sizeof(path), "%s/%s", directory, CHUNK_MANIFEST_NAME);
+    bool written = WriteFileAtomic(path, text, strlen(text));
+    cJSON_free(text);
+    return written;
+}
+
+// Groups the loaded structures by tile. A structure that was moved into a tile that is not
+// loaded brings that tile in first, so the document stays the only copy of every tile it touches.
+static bool GroupByTile(TileGroups *groups)
+{
+    cJSON *structures = GetLayerJSON(LAYER_STRUCTURES);
+    int count = 0;
+    for (cJSON *item = structures ? structures->child : NULL; item != NULL; item = item->next)
+    {
+        int x, y;
+        TileOf(item, _chunkSize, &x, &y);
+        int index = GetChunk(x, y);
+        if (index < 0) return false;
+        if (!_chunks[index].loaded) LoadChunk(index);
+        count++;
+    }
+
+    int *chunkOf = MemAlloc(sizeof(int) * (count > 0 ? count : 1));
+    groups->items = MemAlloc(sizeof(cJSON *) * (count > 0 ? count : 1));
+    groups->start = MemCalloc(_chunkCount + 1, sizeof(int));
+    if (chunkOf == NULL || groups->items == NULL || groups->start == NULL)
+    {
+        MemFree(chunkOf);
+        MemFree(groups->items);
+        MemFree(groups->start);
+        return false;
+    }
+
+    int i = 0;
+    for (cJSON *item = structures ? structures->child : NULL; item != NULL; item = item->next, i++)
+    {
+        int x, y;
+        TileOf(item, _chunkSize, &x, &y);
+        chunkOf[i] = FindChunk(x, y);
+        groups->start[chunkOf[i] + 1]++;
+    }
+    for (int c = 0; c < _chunkCount; c++) groups->start[c + 1] += groups->start[c];
+
+    // Keeps document order within each tile, so an unchanged tile prints exactly as it was read
+    i = 0;
+    int *next = MemAlloc(sizeof(int) * (_chunkCount > 0 ? _chunkCount : 1));
+    if (next == NULL)
+    {
+        MemFree(chunkOf);
+        MemFree(groups->items);
+        MemFree(groups->start);
+        return false;
+    }
+    memcpy(next, groups->start, sizeof(int) * _chunkCount);
+    for (cJSON *item = structures ? structures->child : NULL; item != NULL; item = item->next, i++) groups->items[next[chunkOf[i]]++] = item;
+
+    MemFree(next);
+    MemFree(chunkOf);
+    return true;
+}
+
+static void FreeTileGroups(TileGroups *groups)
+{
+    MemFree(groups->items);
+    MemFree(groups->start);
+}
+
+// Writes back and frees the structures of every chunk flagged evict
+static bool EvictChunks(void)
+{
+    TileGroups groups;
+    if (!GroupByTile(&groups)) return false;
+
+    cJSON *structures = GetLayerJSON(LAYER_STRUCTURES);
+    bool evicted = false;
+    for (int c = 0; c < _chunkCount; c++)
+    {
+        Chunk *chunk = &_chunks[c];
+        if (!chunk->evict || !chunk->loaded || chunk->failed) continue;
+
+        cJSON **items = groups.items + groups.start[c];
+        int count = groups.start[c + 1] - groups.start[c];
+        if (!WriteChunk(_directory, chunk, items, count)) continue;
+
+        for (int i = 0; i < count; i++)
+        {
+            cJSON_DetachItemViaPointer(structures, items[i]);
+            HandleRelease(items[i]);
+            cJSON_Delete(items[i]);
+        }
+        chunk->loaded = false;
+        _loadedBytes = _loadedBytes > chunk->bytes ? _loadedBytes - chunk->bytes : 0;
+        chunk->bytes = 0;
+        evicted = true;
+    }
+
+    FreeTileGroups(&groups);
+    if (evicted) HandleLayerChanged(LAYER_STRUCTURES);
+    return evicted;
+}
+
+static int CompareFarthestFirst(const void *a, const void *b)
+{
+    float distanceA = _chunks[*(const int *)a].distance;
+    float distanceB = _chunks[*(const int *)b].distance;
+    return (distanceA < distanceB) - (distanceA > distanceB);
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+bool ChunkStoreIsManifest(const char *path)
+{
+    if (path == NULL) return false;
+    const char *name = strrchr(path, '/');
+    const char *windowsName = strrchr(path, '\\');
+    if (windowsName > name) name = windowsName;
+    name = name ? name + 1 : path;
+    return strcmp(name, CHUNK_MANIFEST_NAME) == 0;
+}
+
+cJSON *ChunkStoreOpen(const char *manifestPath)
+{
+    ChunkStoreClose();
+    MemPushSubsystem(MEM_SUBSYSTEM_LOAD);
+
+    size_t length = 0;
+    char *text = ReadWholeFile(manifestPath, &length);
+    cJSON *manifest = text ? cJSON_ParseWithLength(text, length) : NULL;
+    MemFree(text);
+
+    cJSON *format = cJSON_GetObjectItem(manifest, "format");
+    cJSON *version = cJSON_GetObjectItem(manifest, "version");
+    cJSON *chunkSize = cJSON_GetObjectItem(manifest, "chunk_size");
+    if (!cJSON_IsString(format) || strcmp(format->valuestring, CHUNK_FORMAT) != 0 || !cJSON_IsNumber(version) ||
+        version->valueint != CHUNK_VERSION || !cJSON_IsNumber(chunkSize) || chunkSize->valueint <= 0)
+    {
+        printf("ERROR: %s is not a chunk manifest this editor can read.\n", manifestPath);
+        cJSON_Delete(manifest);
+        MemPopSubsystem();
+        return NULL;
+    }
+    _chunkSize = chunkSize->valueint;
+
+    snprintf(_directory, sizeof(_directory), "%s", manifestPath);
+    char *separator = strrchr(_directory, '/');
+    char *windowsSeparator = strrchr(_directory, '\\');
+    if (windowsSeparator > separator) separator = windowsSeparator;
+    if (separator) *separator = '\0';
+    else snprintf(_directory, sizeof(_directory), ".");
+
+    cJSON *entry = NULL;
+    cJSON_ArrayForEach(entry, cJSON_GetObjectItem(manifest, "chunks"))
+    {
+        cJSON *x = cJSON_GetObjectItem(entry, "x");
+        cJSON *y = cJSON_GetObjectItem(entry, "y");
+        cJSON *count = cJSON_GetObjectItem(entry, "structures");
+        int index = (cJSON_IsNumber(x) && cJSON_IsNumber(y)) ? GetChunk(x->valueint, y->valueint) : -1;
+        if (index < 0) continue;
+        _chunks[index].hasFile = true;
+        _chunks[index].count = cJSON_IsNumber(count) ? count->valueint : 0;
+    }
+
+    cJSON *world = cJSON_DetachItemFromObject(manifest, "world");
+    cJSON_Delete(manifest);
+    if (world == NULL) world = cJSON_CreateObject();
+    cJSON_DeleteItemFromObject(world, "structures");
+    cJSON_AddArrayToObject(world, "structures");
+
+    _open = true;
+    MemPopSubsystem();
+    return world;
+}
+
+bool ChunkStoreIsOpen(void)
+{
+    return _open;
+}
+
+void ChunkStoreSetBudget(size_t bytes)
+{
+    _budget = bytes;
+}
+
+bool ChunkStoreUpdate(float minX, float minY, float maxX, float maxY, bool allowEvict)
+{
+    if (!_open) return false;
+
+    ProfileBegin("chunks");
+    MemPushSubsystem(MEM_SUBSYSTEM_LOAD);
+
+    // Tiles overlapping the view and its margin, measured from the view center
+    int firstX = (int)floorf(minX / _chunkSize) - CHUNK_MARGIN;
+    int lastX = (int)floorf(maxX / _chunkSize) + CHUNK_MARGIN;
+    int firstY = (int)floorf(minY / _chunkSize) - CHUNK_MARGIN;
+    int lastY = (int)floorf(maxY / _chunkSize) + CHUNK_MARGIN;
+    float centerX = (minX + maxX) * 0.5f / _chunkSize;
+    float centerY = (minY + maxY) * 0.5f / _chunkSize;
+    for (int c = 0; c < _chunkCount; c++)
+    {
+        Chunk *chunk = &_chunks[c];
+        chunk->required = chunk->x >= firstX && chunk->x <= lastX && chunk->y >= firstY && chunk->y <= lastY;
+        float dx = chunk->x + 0.5f - centerX;
+        float dy = chunk->y + 0.5f - centerY;
+        chunk->distance = dx * dx + dy * dy;
+        chunk->evict = false;
+    }
+
+    // Nearest missing tiles first, and none past the budget
+    for (int loads = 0; loads < CHUNK_LOADS_PER_UPDATE && _loadedBytes < _budget; loads++)
+    {
+        int nearest = -1;
+        for (int c = 0; c < _chunkCount; c++)
+        {
+            if (_chunks[c].required && !_chunks[c].loaded && (nearest < 0 || _chunks[c].distance < _chunks[nearest].distance)) nearest = c;
+        }
+        if (nearest < 0) break;
+        LoadChunk(nearest);
+    }
+
+    bool evicted = false;
+    if (allowEvict && _loadedBytes > _budget)
+    {
+        int *candidates = MemAlloc(sizeof(int) * (_chunkCount > 0 ? _chunkCount : 1));
+        int candidateCount = 0;
+        for (int c = 0; candidates != NULL && c < _chunkCount; c++)
+        {
+            if (_chunks[c].loaded && !_chunks[c].required && !_chunks[c].failed) candidates[candidateCount++] = c;
+        }
+        if (candidateCount > 0)
+        {
+            qsort(candidates, candidateCount, sizeof(int), CompareFarthestFirst);
+            size_t remaining = _loadedBytes;
+            for (int i = 0; i < candidateCount && remaining > _budget; i++)
+            {
+                _chunks[candidates[i]].evict = true;
+                remaining -= _chunks[candidates[i]].bytes;
+            }
+            evicted = EvictChunks();
+        }
+        MemFree(candidates);
+    }
+
+    MemPopSubsystem();
+    ProfileEnd();
+    return evicted;
+}
+
+bool ChunkStoreSave(void)
+{
+    if (!_open) return false;
+
+    TileGroups groups;
+    if (!GroupByTile(&groups)) return false;
+
+    bool saved = true;
+    for (int c = 0; c < _chunkCount; c++)
+    {
+        if (!_chunks[c].loaded) continue;
+        if (_chunks[c].failed)
+        {
+            char path[MAX_CHUNK_PATH];
+            ChunkPath(path, sizeof(path), _directory, _chunks[c].x, _chunks[c].y);
+            printf("WARNING: Chunk %s was not saved, as it could not be read\n", path);
+            saved = false;
+            continue;
+        }
+        saved = WriteChunk(_directory, &_chunks[c], groups.items + groups.start[c], groups.start[c + 1] - groups.start[c]) && saved;
+    }
+    FreeTileGroups(&groups);
+
+    return WriteManifest(_directory, _configJson, _chunkSize, _chunks, _chunkCount) && saved;
+}
+
+ChunkStoreStats ChunkStoreGetStats(void)
+{
+    ChunkStoreStats stats = { 0 };
+    stats.loadedBytes = _loadedBytes;
+    stats.budgetBytes = _budget;
+    for (int c = 0; c < _chunkCount; c++)
+    {
+        if (_chunks[c].hasFile) stats.chunkCount++;
+        if (_chunks[c].loaded) stats.loadedCount++;
+        if (_chunks[c].failed) stats.failedCount++;
+        stats.structureCount += _chunks[c].count;
+    }
+    return stats;
+}
+
+void ChunkStoreClose(void)
+{
+    MemFree(_chunks);
+    MemFree(_slots);
+    _chunks = NULL;
+    _slots = NULL;
+    _chunkCount = _chunkCapacity = _slotCount = 0;
+    _loadedBytes = 0;
+    _open = false;
+}
+
+typedef struct {
+    int x;
+    int y;
+    int order;
+    cJSON *item;
+} TiledStructure;
+
+static int CompareTiles(const void *a, const void *b)
+{
+    const TiledStructure *left = a;
+    const TiledStructure *right = b;
+    if (left->x != right->x) return (left->x > right->x) - (left->x < right->x);
+    if (left->y != right->y) return (left->y > right->y) - (left->y < right->y);
+    return (left->order > right->order) - (left->order < right->order);
+}
+
+bool ChunkStoreSplit(const cJSON *config, const char *directory, int chunkSize)
+{
+    if (config == NULL || chunkSize <= 0 || MakeDirectory(directory) != 0) return false;
+
+    cJSON *structures = cJSON_GetObjectItem(config, "structures");
+    int count = cJSON_GetArraySize(structures);
+    TiledStructure *tiled = MemAlloc(sizeof(TiledStructure) * (count > 0 ? count : 1));
+    cJSON **items = MemAlloc(sizeof(cJSON *) * (count > 0 ? count : 1));
+    Chunk *chunks = MemAlloc(sizeof(Chunk) * (count > 0 ? count : 1));
+    if (tiled == NULL || items == NULL || chunks == NULL)
+    {
+        MemFree(tiled);
+        MemFree(items);
+        MemFree(chunks);
+        return false;
+    }
+
+    int i = 0;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, structures)
+    {
+        tiled[i] = (TiledStructure){ 0, 0, i, item };
+        TileOf(item, chunkSize, &tiled[i].x, &tiled[i].y);
+        i++;
+    }
+    qsort(tiled, count, sizeof(TiledStructure), CompareTiles);
+
+    bool written = true;
+    int chunkCount = 0;
+    for (int first = 0; first < count && written;)
+    {
+        int last = first;
+        while (last < count && tiled[last].x == tiled[first].x && tiled[last].y == tiled[first].y)
+        {
+            items[last - first] = tiled[last].item;
+            last++;
+        }
+        Chunk *chunk = &chunks[chunkCount++];
+        *chunk = (Chunk){ .x = tiled[first].x, .y = tiled[first].y };
+        written = WriteChunk(directory, chunk, items, last - first);
+        first = last;
+    }
+
+    written = written && WriteManifest(directory, config, chunkSize, chunks, chunkCount);
+    MemFree(tiled);
+    MemFree(items);
+    MemFree(chunks);
+    return written;
+}
@@ -0,0 +1,94 @@
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+#include <stddef.h>
+
+#define CHUNK_MANIFEST_NAME "manifest.json"
+#define DEFAULT_CHUNK_SIZE 2048
+#define DEFAULT_CHUNK_BUDGET_MB 512
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Chunked world layout: a directory with a manifest.json and one file per square tile of
+// world space. The manifest holds every section except the structures (regions, gates,
+// portals and world areas are small) and lists the tiles that have a file; each tile file
+// holds the structures located in that tile as {"structures": [...]}.
+//
+// While a chunked world is open the document only holds the structures of the loaded tiles,
+// appended to the structures array as their tiles come into view. A structure belongs to the
+// tile its location is in, so moving one across a tile border moves it to the other file.
+
+typedef struct {
+    int chunkCount;             // Tiles listed in the manifest
+    int loadedCount;
+    int failedCount;            // Tiles whose file could not be read, which are left untouched
+    size_t loadedBytes;         // Heap used by the structures of the loaded tiles
+    size_t budgetBytes;
+    int structureCount;         // Structures in the whole world, as of the last save or load
+} ChunkStoreStats;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns true if path names a chunk manifest.
+ */
+bool ChunkStoreIsManifest(const char *path);
+
+/**
+ * @brief Opens a chunked world without loading any tile.
+ * @return The document to edit, holding the manifest sections and an empty structures array,
+ *         or NULL if the manifest could not be read. The caller owns it.
+ */
+cJSON *ChunkStoreOpen(const char *manifestPath);
+
+/**
+ * @brief Returns true while a chunked world is open.
+ */
+bool ChunkStoreIsOpen(void);
+
+/**
+ * @brief Sets how much heap the loaded tiles may use before far tiles are evicted.
+ */
+void ChunkStoreSetBudget(size_t bytes);
+
+/**
+ * @brief Loads the tiles that overlap the view plus one tile of margin, nearest first and a
+ *        few per call, and evicts the farthest tiles outside it while over the memory budget.
+ *        Evicted tiles are written back first if their structures changed. Nothing is evicted
+ *        while allowEvict is false (e.g. during a drag). A tile whose file cannot be read is
+ *        shown empty and never written or evicted.
+ * @param minX, minY, maxX, maxY The view in config coordinates.
+ * @return true if structures were evicted, which ends the undo history like a reload.
+ */
+bool ChunkStoreUpdate(float minX, float minY, float maxX, float maxY, bool allowEvict);
+
+/**
+ * @brief Writes every loaded tile whose structures changed, then the manifest. Tiles that
+ *        could not be read are skipped.
+ * @return true if everything was written, false if a tile was skipped or a write failed.
+ */
+bool ChunkStoreSave(void);
+
+/**
+ * @brief Returns the tile counts and memory use.
+ */
+ChunkStoreStats ChunkStoreGetStats(void);
+
+/**
+ * @brief Forgets the open world and frees the tile table. The document is freed by its owner.
+ */
+void ChunkStoreClose(void);
+
+/**
+ * @brief Writes a whole config as a chunked world into directory, creating it if needed.
+ * @param chunkSize Width and height of a tile in world units.
+ * @return true if every file was written.
+ */
+bool ChunkStoreSplit(const cJSON *config, const char *directory, int chunkSize);
+
+#endif // CHUNK_STORE_H
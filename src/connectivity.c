@@ -0,0 +1,1256 @@
+#include "connectivity.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "point_cache.h"
+#include "profiler.h"
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_LABEL -1
+#define NO_CELL -1
+#define NO_SLOT -1
+#define MIN_CELLS 1024
+#define CELL_SPAN 2                 // Cells around a point that can hold points within range of it
+#define SEARCH_BUDGET (1 << 14)     // Cells the checks of one frame may visit before the labels are left to settle
+#define PATH_PORTAL_LIMIT 64        // Portal ends above which routes are searched without an estimate
+#define GRAPH_LAYER_COUNT 3
+#define PATH_COLOR DARKBLUE
+
+static const EditLayer _graphLayers[GRAPH_LAYER_COUNT] = { LAYER_STRUCTURES, LAYER_BOOST_GATES, LAYER_PORTALS };
+
+// A grid cell is range / sqrt(2) wide, so every two points in it are connected and the labels
+// can be kept per cell. The points of a cell lie side by side in the packed arrays, apart from
+// those moved in since the grid was packed, which are linked through _next. Cells are never
+// taken out of the hash, only left empty.
+typedef struct {
+    int x;
+    int y;
+    int start;                      // Packed points, moved out ones left as holes
+    int packed;
+    int head;                       // First point moved in
+    int endHead;                    // First gate or portal end, linked through _endNext
+    int count;
+    int structures;
+    int ends;
+    int label;
+    int labelPrev;                  // Cells of the same label
+    int labelNext;
+    uint32_t visited;               // Stamps of the split checks
+    uint32_t target;
+} Cell;
+
+// Walks the packed points of a cell, then the ones moved in
+typedef struct {
+    int slot;
+    int end;
+    int node;
+} CellCursor;
+
+// A point or cell by the row and column of its cell, for sorting
+typedef struct {
+    int y;
+    int x;
+    int id;
+} CellKey;
+
+typedef struct {
+    int cells;
+    int structures;
+    int head;                       // First cell, linked through labelNext
+} Label;
+
+typedef struct {
+    double estimate;                // Distance so far plus the least distance still to go
+    double distance;
+    int node;
+} HeapEntry;
+
+static float _range = DEFAULT_REACH_RANGE;
+static float _cellSize = DEFAULT_REACH_RANGE * 0.7071f;
+
+// Points: structures first, then the a and b ends of each boost gate, then those of each portal
+static int _nodeCount = 0;
+static int _structureCount = 0;
+static int _gateStart = 0;
+static int _portalStart = 0;
+static float *_xs = NULL;
+static float *_ys = NULL;
+static int *_cellOf = NULL;
+static int *_slotOf = NULL;                 // Packed slot, or NO_SLOT once moved
+static int *_next = NULL;
+static int *_prev = NULL;
+static int *_endNext = NULL;                // By point, from _gateStart on
+static int *_endPrev = NULL;
+static float *_packedXs = NULL;
+static float *_packedYs = NULL;
+static int *_packedNodes = NULL;
+static int _movedCount = 0;
+
+static Cell *_cells = NULL;
+static int _cellCount = 0;
+static int _cellCapacity = 0;
+static int _filledCells = 0;
+static int *_slots = NULL;                  // Open addressed hash of cell coordinates
+static uint32_t _slotMask = 0;
+static int *_queue = NULL;                  // Cells, for the searches
+static int *_parents = NULL;                // Union-find over the cells while labelling
+static CellKey *_cellKeys = NULL;
+static uint32_t _stamp = 0;
+
+static Label *_labels = NULL;               // As many as there are cells, as no label is left without one
+static int *_freeLabels = NULL;             // Labels of components that were merged away or emptied
+static int _freeLabelCount = 0;
+static int _labelCount = 0;
+static int _mainLabel = NO_LABEL;
+static bool _counted = false;
+
+static int *_neighbors = NULL;              // Scratch for Gather() and LinkedCells()
+static int _neighborCapacity = 0;
+static int *_touched = NULL;                // Cells a moved point left or joined
+static int _touchedCapacity = 0;
+static int _budget = 0;
+
+static ConnectivityStats _stats = { 0 };
+static bool _built = false;
+static bool _stale = false;                 // Labels may join points that are no longer connected
+static const cJSON *_builtJSON[GRAPH_LAYER_COUNT] = { 0 };
+static uint64_t _syncedVersion = 0;
+static uint64_t _graphVersion = 0;          // Counts rebuilds and moves, for the cached path
+
+static ConnectivityPath _path = { 0 };
+static int _pathCapacity = 0;
+static int _pathFrom = -1;
+static int _pathTo = -1;
+static uint64_t _pathVersion = 0;
+static bool _pathKnown = false;
+
+//------------------------------------------------------------------------------------
+// Grid
+//------------------------------------------------------------------------------------
+static bool Reserve(int **array, int *capacity, int count)
+{
+    if (count <= *capacity) return true;
+    int grown = *capacity ? *capacity * 2 : 256;
+    while (grown < count) grown *= 2;
+    int *resized = (int *)MemRealloc(*array, (size_t)grown * sizeof(int));
+    if (resized == NULL) return false;
+    *array = resized;
+    *capacity = grown;
+    return true;
+}
+
+static int PartnerOf(int node)
+{
+    return (node < _gateStart) ? -1 : _gateStart + ((node - _gateStart) ^ 1);
+}
+
+static bool IsPortal(int node)
+{
+    return node >= _portalStart;
+}
+
+static uint32_t HashCell(int cx, int cy)
+{
+    uint32_t hash = (uint32_t)cx * 0x9E3779B1u ^ (uint32_t)cy * 0x85EBCA77u;
+    return hash ^ (hash >> 15);
+}
+
+static int FindCell(int cx, int cy)
+{
+    for (uint32_t slot = HashCell(cx, cy) & _slotMask; _slots[slot] != NO_CELL; slot = (slot + 1) & _slotMask)
+    {
+        const Cell *cell = &_cells[_slots[slot]];
+        if (cell->x == cx && cell->y == cy) return _slots[slot];
+    }
+    return NO_CELL;
+}
+
+// Sizes the cells, labels and hash for capacity cells and forgets every cell
+static bool ResetCells(int capacity)
+{
+    uint32_t slots = MIN_CELLS;
+    while (slots < 2 * (uint32_t)capacity) slots *= 2;
+    Cell *cells = (Cell *)MemRealloc(_cells, (size_t)capacity * sizeof(Cell));
+    if (cells != NULL) _cells = cells;
+    Label *labels = (Label *)MemRealloc(_labels, (size_t)capacity * sizeof(Label));
+    if (labels != NULL) _labels = labels;
+    int *freeLabels = (int *)MemRealloc(_freeLabels, (size_t)capacity * sizeof(int));
+    if (freeLabels != NULL) _freeLabels = freeLabels;
+    int *queue = (int *)MemRealloc(_queue, (size_t)capacity * sizeof(int));
+    if (queue != NULL) _queue = queue;
+    int *parents = (int *)MemRealloc(_parents, (size_t)capacity * sizeof(int));
+    if (parents != NULL) _parents = parents;
+    CellKey *cellKeys = (CellKey *)MemRealloc(_cellKeys, (size_t)capacity * sizeof(CellKey));
+    if (cellKeys != NULL) _cellKeys = cellKeys;
+    MemFree(_slots);
+    _slots = (int *)MemAlloc(slots * sizeof(int));
+    if (cells == NULL || labels == NULL || freeLabels == NULL || queue == NULL || parents == NULL || cellKeys == NULL || _slots == NULL) return false;
+
+    memset(_slots, 0xFF, slots * sizeof(int));
+    _slotMask = slots - 1;
+    _cellCapacity = capacity;
+    _cellCount = 0;
+    _filledCells = 0;
+    _labelCount = 0;
+    _freeLabelCount = 0;
+    _stamp = 0;
+    return true;
+}
+
+static CellCursor CellBegin(int cell)
+{
+    const Cell *c = &_cells[cell];
+    return (CellCursor){ c->start, c->start + c->packed, c->head };
+}
+
+// Returns the next point of the cell and its location, -1 after the last
+static int CellNext(CellCursor *cursor, float *x, float *y)
+{
+    while (cursor->slot < cursor->end)
+    {
+        int slot = cursor->slot++;
+        if (_packedNodes[slot] < 0) continue;
+        *x = _packedXs[slot];
+        *y = _packedYs[slot];
+        return _packedNodes[slot];
+    }
+    int node = cursor->node;
+    if (node < 0) return -1;
+    cursor->node = _next[node];
+    *x = _xs[node];
+    *y = _ys[node];
+    return node;
+}
+
+static int AddCell(int cx, int cy)
+{
+    uint32_t slot = HashCell(cx, cy) & _slotMask;
+    while (_slots[slot] != NO_CELL) slot = (slot + 1) & _slotMask;
+    int cell = _slots[slot] = _cellCount++;
+    _cells[cell] = (Cell){ cx, cy, 0, 0, -1, -1, 0, 0, 0, NO_LABEL, NO_CELL, NO_CELL, 0, 0 };
+    return cell;
+}
+
+static void CountPoint(int node, int cell)
+{
+    Cell *c = &_cells[cell];
+    _cellOf[node] = cell;
+    c->count++;
+    c->structures += (node < _structureCount);
+    _filledCells += (c->count == 1);
+    if (node < _gateStart) return;
+
+    int end = node - _gateStart;
+    _endNext[end] = c->endHead;
+    _endPrev[end] = -1;
+    if (c->endHead >= 0) _endPrev[c->endHead - _gateStart] = node;
+    c->endHead = node;
+    c->ends++;
+}
+
+static int CompareKeys(const void *a, const void *b)
+{
+    const CellKey *ka = (const CellKey *)a;
+    const CellKey *kb = (const CellKey *)b;
+    if (ka->y != kb->y) return (ka->y > kb->y) - (ka->y < kb->y);
+    return (ka->x > kb->x) - (ka->x < kb->x);
+}
+
+static uint64_t KeyRank(const CellKey *key, int minX, int minY, uint64_t columns)
+{
+    return (uint64_t)((int64_t)key->y - minY) * columns + (uint64_t)((int64_t)key->x - minX);
+}
+
+// Sorts keys by row, then column. A radix sort over the bits the rows and columns span takes a
+// few passes where qsort takes most of a second on a million points.
+static void SortKeys(CellKey *keys, int count)
+{
+    bool sorted = true;
+    int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+    for (int i = 0; i < count; i++)
+    {
+        if (keys[i].x < minX) minX = keys[i].x;
+        if (keys[i].x > maxX) maxX = keys[i].x;
+        if (keys[i].y < minY) minY = keys[i].y;
+        if (keys[i].y > maxY) maxY = keys[i].y;
+        sorted = sorted && (i == 0 || CompareKeys(&keys[i - 1], &keys[i]) <= 0);
+    }
+    if (sorted) return;
+
+    CellKey *scratch = (CellKey *)MemAlloc((size_t)count * sizeof(CellKey));
+    if (scratch == NULL)
+    {
+        qsort(keys, (size_t)count, sizeof(CellKey), CompareKeys);
+        return;
+    }
+    uint64_t columns = (uint64_t)((int64_t)maxX - minX) + 1;
+    uint64_t last = (uint64_t)((int64_t)maxY - minY) * columns + (columns - 1);
+    CellKey *from = keys, *to = scratch;
+    for (int shift = 0; shift < 64 && (last >> shift) != 0; shift += 8)
+    {
+        int offsets[256] = { 0 };
+        for (int i = 0; i < count; i++) offsets[(KeyRank(&from[i], minX, minY, columns) >> shift) & 0xFF]++;
+        for (int d = 0, sum = 0; d < 256; d++)
+        {
+            int digits = offsets[d];
+            offsets[d] = sum;
+            sum += digits;
+        }
+        for (int i = 0; i < count; i++) to[offsets[(KeyRank(&from[i], minX, minY, columns) >> shift) & 0xFF]++] = from[i];
+        CellKey *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != keys) memcpy(keys, from, (size_t)count * sizeof(CellKey));
+    MemFree(scratch);
+}
+
+// Puts every point into a fresh grid, packed by cell with the cells in row order; the labels
+// have to be worked out again after
+static bool Regrid(int capacity)
+{
+    CellKey *keys = (CellKey *)MemAlloc((size_t)(_nodeCount > 0 ? _nodeCount : 1) * sizeof(CellKey));
+    if (keys == NULL || !ResetCells(capacity))
+    {
+        MemFree(keys);
+        return false;
+    }
+
+    int count = 0;
+    for (int node = 0; node < _nodeCount; node++)
+    {
+        _cellOf[node] = NO_CELL;
+        _slotOf[node] = NO_SLOT;
+        if (isnan(_xs[node]) || isnan(_ys[node])) continue;
+        keys[count++] = (CellKey){ (int)floorf(_ys[node] / _cellSize), (int)floorf(_xs[node] / _cellSize), node };
+    }
+    SortKeys(keys, count);
+
+    // A cell per point at most, so the capacity is never exceeded here
+    int cell = NO_CELL;
+    for (int slot = 0; slot < count; slot++)
+    {
+        int node = keys[slot].id;
+        if (slot == 0 || keys[slot].y != keys[slot - 1].y || keys[slot].x != keys[slot - 1].x)
+        {
+            cell = AddCell(keys[slot].x, keys[slot].y);
+            _cells[cell].start = slot;
+        }
+        CountPoint(node, cell);
+        _cells[cell].packed++;
+        _slotOf[node] = slot;
+        _packedXs[slot] = _xs[node];
+        _packedYs[slot] = _ys[node];
+        _packedNodes[slot] = node;
+    }
+    _movedCount = 0;
+    MemFree(keys);
+    return true;
+}
+
+static void Relabel(void);
+
+// Returns the cell at (cx, cy), adding it if needed. When the cells run out, the grid is
+// compacted or grown with every point in it, node included, and labelled again.
+static int TakeCell(int cx, int cy, bool *regridded)
+{
+    int cell = FindCell(cx, cy);
+    if (cell != NO_CELL) return cell;
+    if (_cellCount < _cellCapacity) return AddCell(cx, cy);
+
+    int capacity = (_filledCells < _cellCapacity / 2) ? _cellCapacity : 2 * _cellCapacity;
+    if (!Regrid(capacity)) return NO_CELL;
+    Relabel();
+    *regridded = true;
+    return FindCell(cx, cy);
+}
+
+// Squared distance from a point to the square of the cell at (cx, cy)
+static float CellGap(int cx, int cy, float x, float y)
+{
+    float minX = cx * _cellSize, minY = cy * _cellSize;
+    float gx = (x < minX) ? minX - x : (x > minX + _cellSize) ? x - minX - _cellSize : 0.0f;
+    float gy = (y < minY) ? minY - y : (y > minY + _cellSize) ? y - minY - _cellSize : 0.0f;
+    return gx * gx + gy * gy;
+}
+
+// Whether a point of cell a and one of cell b are within range of each other, or are the two ends of a gate or portal
+static bool CellsLinked(int a, int b)
+{
+    float x, y, ox, oy;
+    const Cell *ca = &_cells[a];
+    const Cell *cb = &_cells[b];
+    if (ca->count == 0 || cb->count == 0) return false;
+    if (ca->ends > 0 && cb->ends > 0)
+    {
+        int from = (ca->ends <= cb->ends) ? a : b;
+        int to = (from == a) ? b : a;
+        for (int node = _cells[from].endHead; node >= 0; node = _endNext[node - _gateStart])
+        {
+            if (_cellOf[PartnerOf(node)] == to) return true;
+        }
+    }
+    if (abs(ca->x - cb->x) > CELL_SPAN || abs(ca->y - cb->y) > CELL_SPAN) return false;
+
+    // Only points of the smaller cell that are within range of the other cell's square are tried
+    if (ca->count > cb->count)
+    {
+        int swap = a;
+        a = b;
+        b = swap;
+        cb = &_cells[b];
+    }
+    float rangeSquared = _range * _range;
+    CellCursor cursor = CellBegin(a);
+    for (int node = CellNext(&cursor, &x, &y); node >= 0; node = CellNext(&cursor, &x, &y))
+    {
+        if (CellGap(cb->x, cb->y, x, y) > rangeSquared) continue;
+        CellCursor other = CellBegin(b);
+        while (CellNext(&other, &ox, &oy) >= 0)
+        {
+            if ((ox - x) * (ox - x) + (oy - y) * (oy - y) <= rangeSquared) return true;
+        }
+    }
+    return false;
+}
+
+// Collects into _neighbors the cells linked to cell that carry label and were not visited in this check
+static int LinkedCells(int cell, int label, bool checkVisited)
+{
+    int count = 0;
+    const Cell *c = &_cells[cell];
+    for (int dy = -CELL_SPAN; dy <= CELL_SPAN; dy++)
+    {
+        for (int dx = -CELL_SPAN; dx <= CELL_SPAN; dx++)
+        {
+            int other = (dx == 0 && dy == 0) ? NO_CELL : FindCell(c->x + dx, c->y + dy);
+            if (other == NO_CELL || _cells[other].label != label || (checkVisited && _cells[other].visited == _stamp)) continue;
+            if (!CellsLinked(cell, other) || !Reserve(&_neighbors, &_neighborCapacity, count + 1)) continue;
+            _neighbors[count++] = other;
+        }
+    }
+    if (c->ends == 0) return count;
+
+    // Gates and portals link cells that are far apart
+    for (int node = c->endHead; node >= 0; node = _endNext[node - _gateStart])
+    {
+        int other = _cellOf[PartnerOf(node)];
+        if (other == NO_CELL || other == cell || _cells[other].label != label || (checkVisited && _cells[other].visited == _stamp)) continue;
+        if (!Reserve(&_neighbors, &_neighborCapacity, count + 1)) break;
+        _neighbors[count++] = other;
+    }
+    return count;
+}
+
+// Collects into _touched the cells holding a point within range of (x, y) or the other end
+// of node's gate or portal, node itself left out
+static int TouchedCells(float x, float y, int node)
+{
+    int count = 0;
+    if (!isnan(x) && !isnan(y))
+    {
+        float ox, oy;
+        float rangeSquared = _range * _range;
+        int cx = (int)floorf(x / _cellSize);
+        int cy = (int)floorf(y / _cellSize);
+        for (int dy = -CELL_SPAN; dy <= CELL_SPAN; dy++)
+        {
+            for (int dx = -CELL_SPAN; dx <= CELL_SPAN; dx++)
+            {
+                int cell = (CellGap(cx + dx, cy + dy, x, y) > rangeSquared) ? NO_CELL : FindCell(cx + dx, cy + dy);
+                if (cell == NO_CELL) continue;
+                CellCursor cursor = CellBegin(cell);
+                for (int other = CellNext(&cursor, &ox, &oy); other >= 0; other = CellNext(&cursor, &ox, &oy))
+                {
+                    if (other == node || (ox - x) * (ox - x) + (oy - y) * (oy - y) > rangeSquared) continue;
+                    if (Reserve(&_touched, &_touchedCapacity, count + 1)) _touched[count++] = cell;
+                    break;
+                }
+            }
+        }
+    }
+    int partner = PartnerOf(node);
+    if (partner >= 0 && _cellOf[partner] != NO_CELL && Reserve(&_touched, &_touchedCapacity, count + 1)) _touched[count++] = _cellOf[partner];
+    return count;
+}
+
+// Collects into _neighbors the points within range of node plus the other end of its gate or portal
+static int Gather(int node)
+{
+    int count = 0;
+    float x = _xs[node], y = _ys[node], ox, oy;
+    float rangeSquared = _range * _range;
+    int cx = (int)floorf(x / _cellSize);
+    int cy = (int)floorf(y / _cellSize);
+    for (int dy = -CELL_SPAN; dy <= CELL_SPAN; dy++)
+    {
+        for (int dx = -CELL_SPAN; dx <= CELL_SPAN; dx++)
+        {
+            int cell = (CellGap(cx + dx, cy + dy, x, y) > rangeSquared) ? NO_CELL : FindCell(cx + dx, cy + dy);
+            if (cell == NO_CELL) continue;
+            CellCursor cursor = CellBegin(cell);
+            for (int other = CellNext(&cursor, &ox, &oy); other >= 0; other = CellNext(&cursor, &ox, &oy))
+            {
+                if (other == node || (ox - x) * (ox - x) + (oy - y) * (oy - y) > rangeSquared) continue;
+                if (!Reserve(&_neighbors, &_neighborCapacity, count + 1)) return count;
+                _neighbors[count++] = other;
+            }
+        }
+    }
+
+    int partner = PartnerOf(node);
+    if (partner >= 0 && _cellOf[partner] != NO_CELL && Reserve(&_neighbors, &_neighborCapacity, count + 1)) _neighbors[count++] = partner;
+    return count;
+}
+
+//------------------------------------------------------------------------------------
+// Labels
+//------------------------------------------------------------------------------------
+static int NewLabel(void)
+{
+    int label = (_freeLabelCount > 0) ? _freeLabels[--_freeLabelCount] : _labelCount++;
+    _labels[label] = (Label){ 0, 0, NO_CELL };
+    return label;
+}
+
+static void AttachCell(int cell, int label)
+{
+    Cell *c = &_cells[cell];
+    Label *l = &_labels[label];
+    c->label = label;
+    c->labelPrev = NO_CELL;
+    c->labelNext = l->head;
+    if (l->head != NO_CELL) _cells[l->head].labelPrev = cell;
+    l->head = cell;
+    l->cells++;
+    l->structures += c->structures;
+}
+
+static void DetachCell(int cell)
+{
+    Cell *c = &_cells[cell];
+    Label *l = &_labels[c->label];
+    if (c->labelPrev != NO_CELL) _cells[c->labelPrev].labelNext = c->labelNext;
+    else l->head = c->labelNext;
+    if (c->labelNext != NO_CELL) _cells[c->labelNext].labelPrev = c->labelPrev;
+    l->cells--;
+    l->structures -= c->structures;
+    if (l->cells == 0) _freeLabels[_freeLabelCount++] = c->label;
+    c->label = NO_LABEL;
+}
+
+static int FindRoot(int cell)
+{
+    while (_parents[cell] != cell)
+    {
+        _parents[cell] = _parents[_parents[cell]];
+        cell = _parents[cell];
+    }
+    return cell;
+}
+
+static void Join(int a, int b)
+{
+    a = FindRoot(a);
+    b = FindRoot(b);
+    if (a != b) _parents[(a < b) ? b : a] = (a < b) ? a : b;
+}
+
+// Joins two cells unless they already share a root or have no points within range of each other
+static void JoinIfLinked(int a, int b)
+{
+    if (FindRoot(a) != FindRoot(b) && CellsLinked(a, b)) Join(a, b);
+}
+
+// Labels every component from scratch. The filled cells are sorted by row, so each is tried
+// against the cells right of it and in the two rows above by walking the order rather than
+// asking the hash, and the components are gathered with union-find.
+static void Relabel(void)
+{
+    ProfileBegin("connectivity labels");
+    _labelCount = 0;
+    _freeLabelCount = 0;
+    int count = 0;
+    for (int i = 0; i < _cellCount; i++)
+    {
+        _cells[i].label = NO_LABEL;
+        _parents[i] = i;
+        if (_cells[i].count > 0) _cellKeys[count++] = (CellKey){ _cells[i].y, _cells[i].x, i };
+    }
+    SortKeys(_cellKeys, count);
+
+    const CellKey *keys = _cellKeys;
+    int above[CELL_SPAN] = { 0 };
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = i + 1; j < count && keys[j].y == keys[i].y && keys[j].x <= keys[i].x + CELL_SPAN; j++) JoinIfLinked(keys[i].id, keys[j].id);
+
+        // Rows only move forward, so the first candidate of each row above does too
+        for (int d = 0; d < CELL_SPAN; d++)
+        {
+            int row = keys[i].y + d + 1;
+            int j = above[d];
+            while (j < count && (keys[j].y < row || (keys[j].y == row && keys[j].x < keys[i].x - CELL_SPAN))) j++;
+            above[d] = j;
+            for (; j < count && keys[j].y == row && keys[j].x <= keys[i].x + CELL_SPAN; j++) JoinIfLinked(keys[i].id, keys[j].id);
+        }
+    }
+    for (int node = _gateStart; node < _nodeCount; node++)
+    {
+        if (_cellOf[node] != NO_CELL && _cellOf[PartnerOf(node)] != NO_CELL) Join(_cellOf[node], _cellOf[PartnerOf(node)]);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        int cell = keys[i].id;
+        int root = FindRoot(cell);
+        if (_cells[root].label == NO_LABEL) AttachCell(root, NewLabel());
+        if (cell != root) AttachCell(cell, _cells[root].label);
+    }
+    _stale = false;
+    _counted = false;
+    ProfileEnd();
+}
+
+static void NextStamp(void)
+{
+    if (++_stamp != 0) return;
+    for (int i = 0; i < _cellCount; i++) _cells[i].visited = _cells[i].target = 0;
+    _stamp = 1;
+}
+
+// The first touchedCount entries of _touched are cells a point was linked to before it left,
+// all labelled label. Searches from one of them until it has found the others; a search that
+// runs out of cells has walked a whole piece that fell apart, which gets a label of its own.
+static bool SplitCheck(int touchedCount, int label)
+{
+    NextStamp();
+    int remaining = 0;
+    for (int t = 0; t < touchedCount; t++)
+    {
+        Cell *cell = &_cells[_touched[t]];
+        if (cell->label != label || cell->target == _stamp) continue;
+        cell->target = _stamp;
+        remaining++;
+    }
+
+    for (int t = 0; t < touchedCount && remaining > 1; t++)
+    {
+        int start = _touched[t];
+        if (_cells[start].label != label || _cells[start].visited == _stamp) continue;
+
+        int head = 0, tail = 0;
+        _cells[start].visited = _stamp;
+        _queue[tail++] = start;
+        int found = 1;
+        while (head < tail && found < remaining)
+        {
+            if (--_budget < 0) return false;
+            int count = LinkedCells(_queue[head++], label, true);
+            for (int n = 0; n < count; n++)
+            {
+                Cell *other = &_cells[_neighbors[n]];
+                if (other->visited == _stamp) continue;
+                other->visited = _stamp;
+                _queue[tail++] = _neighbors[n];
+                found += (other->target == _stamp);
+            }
+        }
+        if (found == remaining) return true;
+
+        // Everything reachable from start was visited without finding the rest
+        int piece = NewLabel();
+        for (int i = 0; i < tail; i++)
+        {
+            DetachCell(_queue[i]);
+            AttachCell(_queue[i], piece);
+        }
+        remaining -= found;
+    }
+    return true;
+}
+
+// Gives the cells of the smaller of two labels the larger one
+static void Merge(int a, int b)
+{
+    int small = (_labels[a].cells < _labels[b].cells) ? a : b;
+    int large = (small == a) ? b : a;
+    int cell = _labels[small].head;
+    while (cell != NO_CELL)
+    {
+        int next = _cells[cell].labelNext;
+        DetachCell(cell);
+        AttachCell(cell, large);
+        cell = next;
+    }
+}
+
+static void RemovePoint(int node)
+{
+    int cell = _cellOf[node];
+    if (cell == NO_CELL) return;
+    Cell *c = &_cells[cell];
+    if (_slotOf[node] != NO_SLOT)
+    {
+        _packedNodes[_slotOf[node]] = -1;
+        _slotOf[node] = NO_SLOT;
+    }
+    else
+    {
+        if (_prev[node] >= 0) _next[_prev[node]] = _next[node];
+        else c->head = _next[node];
+        if (_next[node] >= 0) _prev[_next[node]] = _prev[node];
+        _movedCount--;
+    }
+    _cellOf[node] = NO_CELL;
+
+    if (node >= _gateStart)
+    {
+        int end = node - _gateStart;
+        if (_endPrev[end] >= 0) _endNext[_endPrev[end] - _gateStart] = _endNext[end];
+        else c->endHead = _endNext[end];
+        if (_endNext[end] >= 0) _endPrev[_endNext[end] - _gateStart] = _endPrev[end];
+        c->ends--;
+    }
+
+    bool structure = node < _structureCount;
+    if (c->label != NO_LABEL) _labels[c->label].structures -= structure;
+    c->count--;
+    c->structures -= structure;
+    if (c->count > 0) return;
+    _filledCells--;
+    if (c->label != NO_LABEL) DetachCell(cell);
+}
+
+static void AddMovedPoint(int node, int cell)
+{
+    Cell *c = &_cells[cell];
+    _next[node] = c->head;
+    _prev[node] = -1;
+    if (c->head >= 0) _prev[c->head] = node;
+    c->head = node;
+    _movedCount++;
+    CountPoint(node, cell);
+}
+
+// A moved point leaves its component as if removed, then joins the ones it touches now
+static void MoveNode(int node, float x, float y)
+{
+    bool placed = _cellOf[node] != NO_CELL;
+    if ((_xs[node] == x && _ys[node] == y) || (!placed && (isnan(x) || isnan(y)))) return;
+    _graphVersion++;
+    _counted = false;
+
+    // The cells the point linked, which may have been held together by it alone
+    int label = placed ? _cells[_cellOf[node]].label : NO_LABEL;
+    int leftCount = 0;
+    if (!_stale && placed)
+    {
+        leftCount = TouchedCells(_xs[node], _ys[node], node);
+        if (Reserve(&_touched, &_touchedCapacity, leftCount + 1)) _touched[leftCount++] = _cellOf[node];
+    }
+    RemovePoint(node);
+    if (leftCount >= 2 && label != NO_LABEL && !SplitCheck(leftCount, label)) _stale = true;
+
+    _xs[node] = x;
+    _ys[node] = y;
+    if (isnan(x) || isnan(y)) return;
+    bool regridded = false;
+    int cell = TakeCell((int)floorf(x / _cellSize), (int)floorf(y / _cellSize), &regridded);
+    if (cell == NO_CELL)
+    {
+        _built = false;
+        return;
+    }
+    if (regridded) return;
+    AddMovedPoint(node, cell);
+    if (_cells[cell].count == 1) AttachCell(cell, NewLabel());
+    else if (_cells[cell].label != NO_LABEL) _labels[_cells[cell].label].structures += (node < _structureCount);
+    if (_stale) return;
+
+    int joinedCount = TouchedCells(x, y, node);
+    for (int t = 0; t < joinedCount; t++)
+    {
+        int other = _cells[_touched[t]].label;
+        if (other != NO_LABEL && other != _cells[cell].label) Merge(other, _cells[cell].label);
+    }
+}
+
+static void CountComponents(void)
+{
+    _mainLabel = NO_LABEL;
+    _stats.componentCount = 0;
+    _stats.structureCount = 0;
+    for (int l = 0; l < _labelCount; l++)
+    {
+        if (_labels[l].cells == 0 || _labels[l].structures <= 0) continue;
+        _stats.componentCount++;
+        _stats.structureCount += _labels[l].structures;
+        if (_mainLabel == NO_LABEL || _labels[l].structures > _labels[_mainLabel].structures) _mainLabel = l;
+    }
+    _stats.unreachableCount = (_mainLabel == NO_LABEL) ? 0 : _stats.structureCount - _labels[_mainLabel].structures;
+    _stats.settled = !_stale;
+    _counted = true;
+}
+
+//------------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------------
+static void FreeGraph(void)
+{
+    MemFree(_xs);
+    MemFree(_ys);
+    MemFree(_cellOf);
+    MemFree(_slotOf);
+    MemFree(_packedXs);
+    MemFree(_packedYs);
+    MemFree(_packedNodes);
+    MemFree(_next);
+    MemFree(_prev);
+    MemFree(_endNext);
+    MemFree(_endPrev);
+    MemFree(_cells);
+    MemFree(_slots);
+    MemFree(_queue);
+    MemFree(_parents);
+    MemFree(_cellKeys);
+    MemFree(_labels);
+    MemFree(_freeLabels);
+    MemFree(_neighbors);
+    MemFree(_touched);
+    _xs = _ys = _packedXs = _packedYs = NULL;
+    _cellOf = _slotOf = _packedNodes = _next = _prev = _endNext = _endPrev = _slots = _queue = _parents = _freeLabels = _neighbors = _touched = NULL;
+    _cells = NULL;
+    _cellKeys = NULL;
+    _labels = NULL;
+    _nodeCount = _structureCount = _gateStart = _portalStart = 0;
+    _cellCount = _cellCapacity = _filledCells = _movedCount = 0;
+    _labelCount = _freeLabelCount = _neighborCapacity = _touchedCapacity = 0;
+    _stamp = 0;
+    _stats = (ConnectivityStats){ 0 };
+    _built = false;
+    _stale = false;
+    _counted = false;
+}
+
+static void ReadPoint(const cJSON *element, PointField field, float *x, float *y)
+{
+    cJSON *xItem = NULL, *yItem = NULL;
+    bool found = GetPointItemsJSON((cJSON *)element, field, &xItem, &yItem);
+    *x = found ? (float)xItem->valuedouble : NAN;
+    *y = found ? (float)yItem->valuedouble : NAN;
+}
+
+// Reads both ends of every gate or portal of a layer into the points from first on
+static void ReadEnds(EditLayer layer, int first)
+{
+    int node = first;
+    cJSON *element = NULL;
+    cJSON_ArrayForEach(element, GetLayerJSON(layer))
+    {
+        ReadPoint(element, POINT_FIELD_A, &_xs[node], &_ys[node]);
+        ReadPoint(element, POINT_FIELD_B, &_xs[node + 1], &_ys[node + 1]);
+        node += 2;
+    }
+}
+
+static void Build(void)
+{
+    ProfileBegin("connectivity");
+    MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+    FreeGraph();
+
+    const PointSet *structures = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+    _structureCount = structures->count;
+    _gateStart = _structureCount;
+    _portalStart = _gateStart + 2 * cJSON_GetArraySize(GetLayerJSON(LAYER_BOOST_GATES));
+    _nodeCount = _portalStart + 2 * cJSON_GetArraySize(GetLayerJSON(LAYER_PORTALS));
+    _cellSize = _range * 0.7071f;
+
+    size_t nodes = (_nodeCount > 0) ? (size_t)_nodeCount : 1;
+    _xs = (float *)MemAlloc(nodes * sizeof(float));
+    _ys = (float *)MemAlloc(nodes * sizeof(float));
+    _cellOf = (int *)MemAlloc(nodes * sizeof(int));
+    _slotOf = (int *)MemAlloc(nodes * sizeof(int));
+    _packedXs = (float *)MemAlloc(nodes * sizeof(float));
+    _packedYs = (float *)MemAlloc(nodes * sizeof(float));
+    _packedNodes = (int *)MemAlloc(nodes * sizeof(int));
+    _next = (int *)MemAlloc(nodes * sizeof(int));
+    _prev = (int *)MemAlloc(nodes * sizeof(int));
+    size_t ends = (_nodeCount > _gateStart) ? (size_t)(_nodeCount - _gateStart) : 1;
+    _endNext = (int *)MemAlloc(ends * sizeof(int));
+    _endPrev = (int *)MemAlloc(ends * sizeof(int));
+
+    bool ok = _xs != NULL && _ys != NULL && _cellOf != NULL && _slotOf != NULL && _packedXs != NULL && _packedYs != NULL &&
+              _packedNodes != NULL && _next != NULL && _prev != NULL && _endNext != NULL && _endPrev != NULL;
+    if (ok)
+    {
+        memcpy(_xs, structures->xs, (size_t)_structureCount * sizeof(float));
+        memcpy(_ys, structures->ys, (size_t)_structureCount * sizeof(float));
+        ReadEnds(LAYER_BOOST_GATES, _gateStart);
+        ReadEnds(LAYER_PORTALS, _portalStart);
+        ok = Regrid((_nodeCount > MIN_CELLS) ? _nodeCount : MIN_CELLS);
+    }
+    if (ok)
+    {
+        Relabel();
+        _built = true;
+    }
+    else
+    {
+        FreeGraph();
+    }
+
+    for (int l = 0; l < GRAPH_LAYER_COUNT; l++) _builtJSON[l] = GetLayerJSON(_graphLayers[l]);
+    _syncedVersion = ChangesGetVersion();
+    _graphVersion++;
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+// Moves the points of the elements edited since the last sync, or builds the graph again
+// if elements were added, removed or reloaded. Labels left unsettled by a drag are worked
+// out again once a sync finds nothing moved.
+static void Sync(void)
+{
+    bool rebuild = !_built || !ChangesComplete(_syncedVersion);
+    for (int l = 0; l < GRAPH_LAYER_COUNT && !rebuild; l++)
+    {
+        rebuild = _builtJSON[l] != GetLayerJSON(_graphLayers[l]) || ChangesGetStructureVersion(_graphLayers[l]) > _syncedVersion;
+    }
+
+    if (rebuild) Build();
+    else if (ChangesGetVersion() != _syncedVersion)
+    {
+        ProfileBegin("connectivity update");
+        MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+        _budget = SEARCH_BUDGET;
+        float x, y;
+        ElementChange change;
+        ChangeIterator it = ChangesBegin(_syncedVersion);
+        while (ChangesNext(&it, &change) && _built)
+        {
+            if (change.layer == LAYER_STRUCTURES && change.index < _structureCount)
+            {
+                ReadPoint(change.element, POINT_FIELD_LOCATION, &x, &y);
+                MoveNode(change.index, x, y);
+            }
+            else if (change.layer == LAYER_BOOST_GATES || change.layer == LAYER_PORTALS)
+            {
+                int node = ((change.layer == LAYER_BOOST_GATES) ? _gateStart : _portalStart) + 2 * change.index;
+                if (node + 1 >= ((change.layer == LAYER_BOOST_GATES) ? _portalStart : _nodeCount)) continue;
+                ReadPoint(change.element, POINT_FIELD_A, &x, &y);
+                MoveNode(node, x, y);
+                ReadPoint(change.element, POINT_FIELD_B, &x, &y);
+                MoveNode(node + 1, x, y);
+            }
+        }
+        _syncedVersion = ChangesGetVersion();
+
+        // Moved points are walked one by one, so the grid is packed again once there are many
+        if (_built && _movedCount > _nodeCount / 4 + MIN_CELLS)
+        {
+            if (Regrid(_cellCapacity)) Relabel();
+            else _built = false;
+        }
+        MemPopSubsystem();
+        ProfileEnd();
+        if (!_built) Build();
+    }
+    else if (_stale)
+    {
+        Relabel();
+    }
+
+    if (!_counted) CountComponents();
+}
+
+// Queries that answer for two particular structures cannot wait for the drag to end
+static void Settle(void)
+{
+    Sync();
+    if (!_stale) return;
+    Relabel();
+    CountComponents();
+}
+
+static int LabelOf(int node)
+{
+    return (_cellOf[node] == NO_CELL) ? NO_LABEL : _cells[_cellOf[node]].label;
+}
+
+//------------------------------------------------------------------------------------
+// Shortest path
+//------------------------------------------------------------------------------------
+// Of entries with the same estimate the one further along comes first, which keeps the search
+// from fanning out over the many points that lie about as close to the straight line
+static bool Before(HeapEntry a, HeapEntry b)
+{
+    return a.estimate < b.estimate || (a.estimate == b.estimate && a.distance > b.distance);
+}
+
+static void HeapPush(HeapEntry *heap, int *count, HeapEntry entry)
+{
+    int i = (*count)++;
+    while (i > 0 && Before(entry, heap[(i - 1) / 2]))
+    {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = entry;
+}
+
+static HeapEntry HeapPop(HeapEntry *heap, int *count)
+{
+    HeapEntry top = heap[0];
+    HeapEntry last = heap[--(*count)];
+    int i = 0;
+    while (2 * i + 1 < *count)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < *count && Before(heap[child + 1], heap[child])) child++;
+        if (!Before(heap[child], last)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+static double Distance(float ax, float ay, float bx, float by)
+{
+    double dx = (double)ax - bx;
+    double dy = (double)ay - by;
+    return sqrt(dx * dx + dy * dy);
+}
+
+// Works out for every portal end a least distance on to the target: straight, or to some
+// portal end and through it, as if open water lay everywhere
+static void BoundPortals(int to, double *bounds, bool *done)
+{
+    int ends = _nodeCount - _portalStart;
+    for (int i = 0; i < ends; i++)
+    {
+        int end = _portalStart + i;
+        bounds[i] = (_cellOf[end] == NO_CELL) ? INFINITY : Distance(_xs[end], _ys[end], _xs[to], _ys[to]);
+        done[i] = false;
+    }
+    for (int round = 0; round < ends; round++)
+    {
+        int best = -1;
+        for (int i = 0; i < ends; i++)
+        {
+            if (!done[i] && (best < 0 || bounds[i] < bounds[best])) best = i;
+        }
+        if (bounds[best] == INFINITY) break;
+        done[best] = true;
+        if (bounds[best] < bounds[best ^ 1]) bounds[best ^ 1] = bounds[best];
+        int from = _portalStart + best;
+        for (int i = 0; i < ends; i++)
+        {
+            int end = _portalStart + i;
+            if (done[i] || _cellOf[end] == NO_CELL) continue;
+            double through = Distance(_xs[end], _ys[end], _xs[from], _ys[from]) + bounds[best];
+            if (through < bounds[i]) bounds[i] = through;
+        }
+    }
+}
+
+// Least distance left from node to the target: straight there, or to a portal end and on from
+// it. Never more than the true distance, and never more than an edge plus the estimate on its
+// far side, so the first time the target is taken it is final. With many portals it is left at
+// zero, which makes the search a plain Dijkstra.
+static double Estimate(int node, int to, const double *bounds)
+{
+    if (bounds == NULL) return 0.0;
+    double estimate = Distance(_xs[node], _ys[node], _xs[to], _ys[to]);
+    for (int end = _portalStart; end < _nodeCount; end++)
+    {
+        if (_cellOf[end] == NO_CELL) continue;
+        double viaPortal = Distance(_xs[node], _ys[node], _xs[end], _ys[end]) + bounds[end - _portalStart];
+        if (viaPortal < estimate) estimate = viaPortal;
+    }
+    return estimate;
+}
+
+// A* from one structure to the other; a portal jump costs nothing
+static void FindPath(int from, int to)
+{
+    ProfileBegin("connectivity path");
+    MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+    _path.stepCount = 0;
+    _path.length = 0.0;
+    _path.portalCount = 0;
+    _path.found = false;
+
+    int portalEnds = _nodeCount - _portalStart;
+    double *bounds = NULL;
+    bool *done = NULL;
+    if (portalEnds <= PATH_PORTAL_LIMIT)
+    {
+        bounds = (double *)MemAlloc((size_t)(portalEnds + 1) * sizeof(double));
+        done = (bool *)MemAlloc((size_t)(portalEnds + 1) * sizeof(bool));
+        if (bounds != NULL && done != NULL) BoundPortals(to, bounds, done);
+        else
+        {
+            MemFree(bounds);
+            bounds = NULL;
+        }
+    }
+
+    double *distance = (double *)MemAlloc((size_t)_nodeCount * sizeof(double));
+    int *previous = (int *)MemAlloc((size_t)_nodeCount * sizeof(int));
+    int heapCapacity = 1024;
+    int heapCount = 0;
+    HeapEntry *heap = (HeapEntry *)MemAlloc((size_t)heapCapacity * sizeof(HeapEntry));
+    if (distance != NULL && previous != NULL && heap != NULL)
+    {
+        for (int i = 0; i < _nodeCount; i++) distance[i] = INFINITY;
+        distance[from] = 0.0;
+        previous[from] = -1;
+        HeapPush(heap, &heapCount, (HeapEntry){ Estimate(from, to, bounds), 0.0, from });
+
+        while (heapCount > 0)
+        {
+            HeapEntry entry = HeapPop(heap, &heapCount);
+            int node = entry.node;
+            if (node == to) break;
+            if (entry.distance > distance[node]) continue;
+
+            int partner = PartnerOf(node);
+            int count = Gather(node);
+            for (int n = 0; n < count; n++)
+            {
+                int other = _neighbors[n];
+                double cost = (other == partner && IsPortal(node)) ? 0.0 : Distance(_xs[node], _ys[node], _xs[other], _ys[other]);
+                if (distance[node] + cost >= distance[other]) continue;
+                if (heapCount == heapCapacity)
+                {
+                    HeapEntry *grown = (HeapEntry *)MemRealloc(heap, (size_t)heapCapacity * 2 * sizeof(HeapEntry));
+                    if (grown == NULL) continue;
+                    heap = grown;
+                    heapCapacity *= 2;
+                }
+                distance[other] = distance[node] + cost;
+                previous[other] = node;
+                HeapPush(heap, &heapCount, (HeapEntry){ distance[other] + Estimate(other, to, bounds), distance[other], other });
+            }
+        }
+
+        if (distance[to] < INFINITY)
+        {
+            int steps = 0;
+            for (int node = to; node >= 0; node = previous[node]) steps++;
+            if (steps > _pathCapacity)
+            {
+                PathStep *grown = (PathStep *)MemRealloc(_path.steps, (size_t)steps * sizeof(PathStep));
+                if (grown != NULL)
+                {
+                    _path.steps = grown;
+                    _pathCapacity = steps;
+                }
+            }
+            if (steps <= _pathCapacity)
+            {
+                int i = steps;
+                for (int node = to; node >= 0; node = previous[node])
+                {
+                    int before = previous[node];
+                    bool jump = before >= 0 && before == PartnerOf(node) && IsPortal(node);
+                    _path.steps[--i] = (PathStep){ _xs[node], _ys[node], jump };
+                    _path.portalCount += jump;
+                }
+                _path.stepCount = steps;
+                _path.length = distance[to];
+                _path.found = true;
+            }
+        }
+    }
+    MemFree(distance);
+    MemFree(previous);
+    MemFree(heap);
+    MemFree(bounds);
+    MemFree(done);
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+void ConnectivitySetRange(float range)
+{
+    _range = (range > 0.0f) ? range : DEFAULT_REACH_RANGE;
+    _built = false;
+}
+
+const ConnectivityStats *ConnectivityGetStats(void)
+{
+    Sync();
+    return &_stats;
+}
+
+bool ConnectivityIsUnreachable(int structure)
+{
+    Sync();
+    if (structure < 0 || structure >= _structureCount || LabelOf(structure) == NO_LABEL) return false;
+    return LabelOf(structure) != _mainLabel;
+}
+
+bool ConnectivityIsReachable(int fromStructure, int toStructure)
+{
+    Settle();
+    if (fromStructure < 0 || fromStructure >= _structureCount || toStructure < 0 || toStructure >= _structureCount) return false;
+    return LabelOf(fromStructure) != NO_LABEL && LabelOf(fromStructure) == LabelOf(toStructure);
+}
+
+const ConnectivityPath *ConnectivityGetPath(int fromStructure, int toStructure)
+{
+    Sync();
+    if (_pathKnown && _pathFrom == fromStructure && _pathTo == toStructure && _pathVersion == _graphVersion && !_stale) return &_path;
+
+    _pathFrom = fromStructure;
+    _pathTo = toStructure;
+    _pathKnown = true;
+    if (ConnectivityIsReachable(fromStructure, toStructure)) FindPath(fromStructure, toStructure);
+    else _path = (ConnectivityPath){ _path.steps, 0, 0.0, 0, false };
+    _pathVersion = _graphVersion;
+    return &_path;
+}
+
+void ConnectivityDrawPath(const ConnectivityPath *path, Vector2 cameraOffset, float displayScale)
+{
+    for (int i = 1; i < path->stepCount; i++)
+    {
+        Vector2 from = { path->steps[i - 1].x * displayScale + cameraOffset.x, -path->steps[i - 1].y * displayScale + cameraOffset.y };
+        Vector2 to = { path->steps[i].x * displayScale + cameraOffset.x, -path->steps[i].y * displayScale + cameraOffset.y };
+        if (!path->steps[i].jump)
+        {
+            DrawLineEx(from, to, 3, PATH_COLOR);
+            continue;
+        }
+
+        // Dashes of 10 pixels for a portal jump
+        float length = sqrtf((to.x - from.x) * (to.x - from.x) + (to.y - from.y) * (to.y - from.y));
+        int dashes = (int)(length / 20.0f) + 1;
+        for (int d = 0; d < dashes; d++)
+        {
+            float t0 = (float)d / dashes;
+            float t1 = t0 + 0.5f / dashes;
+            DrawLineEx((Vector2){ from.x + (to.x - from.x) * t0, from.y + (to.y - from.y) * t0 },
+                       (Vector2){ from.x + (to.x - from.x) * t1, from.y + (to.y - from.y) * t1 }, 2, PATH_COLOR);
+        }
+    }
+}
+
+void ConnectivityClear(void)
+{
+    FreeGraph();
+    MemFree(_path.steps);
+    _path = (ConnectivityPath){ 0 };
+    _pathCapacity = 0;
+    _pathKnown = false;
+}
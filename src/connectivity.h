@@ -0,0 +1,85 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include "raylib.h"
+#include "map_editor.h"
+
+#define DEFAULT_REACH_RANGE 1000.0f // World units a boat covers between two points without help
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// A graph over structures, boost gate ends and portal ends. Two points are connected when
+// they are at most the reach range apart; the two ends of a boost gate are connected by its
+// length and those of a portal at no cost. Points sit in a hashed grid with cells of side
+// range / sqrt(2), so all points of one cell are connected to each other and labels are kept per
+// cell. Structures outside the component holding the most structures count as unreachable.
+//
+// A dragged point only moves between cells and joins the components its new neighbours are in.
+// Whether the cells it left are still connected is checked with a search over cells that stops
+// once it has found them all; when a frame's searches run too long, the labels are worked out
+// again as soon as the points stop moving. Routes are found with A*, guided past portals by the
+// shortest portal-to-portal distances to the target.
+
+typedef struct {
+    float x;
+    float y;
+    bool jump;                  // Reached through a portal from the step before
+} PathStep;
+
+typedef struct {
+    PathStep *steps;            // From the first structure to the second
+    int stepCount;
+    double length;              // World units sailed, portal jumps excluded
+    int portalCount;
+    bool found;
+} ConnectivityPath;
+
+typedef struct {
+    int componentCount;         // Components with at least one structure
+    int structureCount;         // Structures with a location
+    int unreachableCount;
+    bool settled;               // False while labels wait for the points to stop moving
+} ConnectivityStats;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Sets the reach range. The graph is built again on the next query.
+ */
+void ConnectivitySetRange(float range);
+
+/**
+ * @brief Returns the component counts, bringing the graph up to date with the edits first.
+ */
+const ConnectivityStats *ConnectivityGetStats(void);
+
+/**
+ * @brief Whether a structure lies outside the component holding the most structures.
+ */
+bool ConnectivityIsUnreachable(int structure);
+
+/**
+ * @brief Whether a boat can get from one structure to another.
+ */
+bool ConnectivityIsReachable(int fromStructure, int toStructure);
+
+/**
+ * @brief Finds the shortest route between two structures. The result is kept until the graph
+ *        changes or other structures are asked for.
+ */
+const ConnectivityPath *ConnectivityGetPath(int fromStructure, int toStructure);
+
+/**
+ * @brief Draws a route, sailed parts as lines and portal jumps dashed.
+ */
+void ConnectivityDrawPath(const ConnectivityPath *path, Vector2 cameraOffset, float displayScale);
+
+/**
+ * @brief Frees the graph. Call when the document is replaced.
+ */
+void ConnectivityClear(void);
+
+#endif // CONNECTIVITY_H
@@ -0,0 +1,575 @@
+#include "diff.h"
+#include "memtrack.h"
+#include "pointer_map.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_COLLECTIONS 256
+#define MAX_PATH_LENGTH 128
+#define MAX_PRINTED_VALUE 60
+
+// An array whose elements are matched by identity, or an object whose members are matched by key
+typedef struct {
+    char path[MAX_PATH_LENGTH]; // Dotted path, "" for the root object
+    cJSON *container;
+} Collection;
+
+typedef struct {
+    uint64_t identity;
+    uint64_t content;
+    cJSON *item;
+    int collection;
+    int position;
+} DiffEntry;
+
+struct FlatConfig {
+    Collection collections[MAX_COLLECTIONS];
+    int collectionCount;
+    DiffEntry *entries;
+    int count;
+    int capacity;
+    PointerMap index; // Identity to entry
+};
+
+//------------------------------------------------------------------------------------
+// Hashing
+//------------------------------------------------------------------------------------
+static uint64_t Mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t HashString(const char *text, uint64_t hash)
+{
+    for (const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++) hash = (hash ^ *c) * 0x100000001b3ULL;
+    return hash;
+}
+
+// Hash as a map key, since 0 marks an empty slot
+static uint64_t MapKey(uint64_t hash)
+{
+    return (hash == 0) ? 1 : hash;
+}
+
+// Content hash that agrees with cJSON_Compare(): object members are combined order-independently
+static uint64_t HashValue(const cJSON *item)
+{
+    uint64_t hash = Mix((uint64_t)(item->type & 0xFF) + 1);
+    switch (item->type & 0xFF)
+    {
+        case cJSON_Number: {
+            double value = (item->valuedouble == 0.0) ? 0.0 : item->valuedouble;
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return Mix(hash ^ bits);
+        }
+        case cJSON_String:
+        case cJSON_Raw:
+            return HashString(item->valuestring ? item->valuestring : "", hash);
+        case cJSON_Array: {
+            const cJSON *child = NULL;
+            cJSON_ArrayForEach(child, item) hash = Mix(hash * 31 + HashValue(child));
+            return hash;
+        }
+        case cJSON_Object: {
+            uint64_t sum = 0;
+            const cJSON *child = NULL;
+            cJSON_ArrayForEach(child, item) sum += Mix(HashString(child->string, 0xcbf29ce484222325ULL) ^ HashValue(child));
+            return Mix(hash + sum);
+        }
+        default:
+            return hash;
+    }
+}
+
+static bool SameValue(const cJSON *a, const cJSON *b)
+{
+    if (a == NULL || b == NULL) return a == b;
+    return HashValue(a) == HashValue(b);
+}
+
+//------------------------------------------------------------------------------------
+// Flattening a config into identified entries
+//------------------------------------------------------------------------------------
+static int AddCollection(FlatConfig *flat, const char *path, cJSON *container)
+{
+    if (flat->collectionCount == MAX_COLLECTIONS) return -1;
+    Collection *collection = &flat->collections[flat->collectionCount];
+    snprintf(collection->path, sizeof(collection->path), "%s", path);
+    collection->container = container;
+    return flat->collectionCount++;
+}
+
+static bool AddEntry(FlatConfig *flat, int collection, cJSON *item, int position, uint64_t identity)
+{
+    if (flat->count == flat->capacity)
+    {
+        int newCapacity = (flat->capacity == 0) ? 1024 : flat->capacity * 2;
+        DiffEntry *entries = MemRealloc(flat->entries, sizeof(DiffEntry) * newCapacity);
+        if (entries == NULL) return false;
+        flat->entries = entries;
+        flat->capacity = newCapacity;
+    }
+    flat->entries[flat->count++] = (DiffEntry){ identity, HashValue(item), item, collection, position };
+    return true;
+}
+
+// Identity of an array element: its id, else its name, else its position. Repeated ids or names are numbered.
+static uint64_t ElementIdentity(const char *path, const cJSON *element, int position, PointerMap *occurrences)
+{
+    uint64_t hash = HashString(path, 0xcbf29ce484222325ULL);
+    const cJSON *id = cJSON_IsObject(element) ? cJSON_GetObjectItemCaseSensitive(element, "id") : NULL;
+    const cJSON *name = cJSON_IsObject(element) ? cJSON_GetObjectItemCaseSensitive(element, "name") : NULL;
+
+    if (cJSON_IsNumber(id) || cJSON_IsString(id)) hash = Mix(hash ^ 'i') ^ HashValue(id);
+    else if (cJSON_IsString(name)) hash = HashString(name->valuestring, Mix(hash ^ 'n'));
+    else return Mix(Mix(hash ^ 'p') + (uint64_t)position);
+
+    int64_t *occurrence = PointerMapFind(occurrences, MapKey(hash));
+    if (occurrence == NULL) return PointerMapPut(occurrences, MapKey(hash), 1) ? Mix(hash) : hash;
+    return Mix(hash + (uint64_t)(*occurrence)++);
+}
+
+static bool FlattenObject(FlatConfig *flat, cJSON *object, const char *path, int depth, PointerMap *occurrences)
+{
+    int self = AddCollection(flat, path, object);
+    if (self < 0) return false;
+
+    cJSON *member = NULL;
+    cJSON_ArrayForEach(member, object)
+    {
+        char memberPath[MAX_PATH_LENGTH];
+        snprintf(memberPath, sizeof(memberPath), "%s%s%s", path, (path[0] != '\0') ? "." : "", member->string);
+
+        if (cJSON_IsArray(member))
+        {
+            int collection = AddCollection(flat, memberPath, member);
+            if (collection < 0) return false;
+
+            int position = 0;
+            cJSON *element = NULL;
+            cJSON_ArrayForEach(element, member)
+            {
+                if (!AddEntry(flat, collection, element, position, ElementIdentity(memberPath, element, position, occurrences))) return false;
+                position++;
+            }
+        }
+        else if (cJSON_IsObject(member) && depth == 0)
+        {
+            // One level down so nested arrays like portals.locations are matched per element too
+            if (!FlattenObject(flat, member, memberPath, depth + 1, occurrences)) return false;
+        }
+        else if (!AddEntry(flat, self, member, -1, Mix(HashString(memberPath, 0xcbf29ce484222325ULL) ^ 'v'))) return false;
+    }
+    return true;
+}
+
+void DiffFreeFlat(FlatConfig *flat)
+{
+    if (flat == NULL) return;
+    MemFree(flat->entries);
+    PointerMapFree(&flat->index);
+    MemFree(flat);
+}
+
+FlatConfig *DiffFlatten(const cJSON *root)
+{
+    FlatConfig *flat = MemCalloc(1, sizeof(FlatConfig));
+    if (flat == NULL || !cJSON_IsObject(root)) { MemFree(flat); return NULL; }
+
+    PointerMap occurrences = { 0 };
+    bool flattened = FlattenObject(flat, (cJSON *)root, "", 0, &occurrences);
+    PointerMapFree(&occurrences);
+
+    // Index by identity; should two entries still share one, the first wins
+    for (int i = 0; i < flat->count && flattened; i++)
+    {
+        uint64_t key = MapKey(flat->entries[i].identity);
+        if (PointerMapFind(&flat->index, key) == NULL) flattened = PointerMapPut(&flat->index, key, i);
+    }
+
+    if (!flattened)
+    {
+        DiffFreeFlat(flat);
+        return NULL;
+    }
+    return flat;
+}
+
+static DiffEntry *FindEntry(const FlatConfig *flat, uint64_t identity)
+{
+    int index = (int)PointerMapGet(&flat->index, MapKey(identity), -1);
+    return (index >= 0) ? &flat->entries[index] : NULL;
+}
+
+//------------------------------------------------------------------------------------
+// Printing
+//------------------------------------------------------------------------------------
+static void DescribeEntry(const FlatConfig *flat, const DiffEntry *entry, char *buffer, size_t size)
+{
+    const Collection *collection = &flat->collections[entry->collection];
+    if (entry->position < 0)
+    {
+        snprintf(buffer, size, "%s%s%s", collection->path, (collection->path[0] != '\0') ? "." : "", entry->item->string);
+        return;
+    }
+
+    const cJSON *id = cJSON_IsObject(entry->item) ? cJSON_GetObjectItemCaseSensitive(entry->item, "id") : NULL;
+    const cJSON *name = cJSON_IsObject(entry->item) ? cJSON_GetObjectItemCaseSensitive(entry->item, "name") : NULL;
+    if (cJSON_IsNumber(id)) snprintf(buffer, size, "%s id=%g", collection->path, id->valuedouble);
+    else if (cJSON_IsString(id)) snprintf(buffer, size, "%s id=\"%s\"", collection->path, id->valuestring);
+    else if (cJSON_IsString(name)) snprintf(buffer, size, "%s \"%s\"", collection->path, name->valuestring);
+    else snprintf(buffer, size, "%s[%d]", collection->path, entry->position);
+}
+
+static void PrintValue(const cJSON *item)
+{
+    if (item == NULL) { printf("(none)"); return; }
+
+    char *text = cJSON_PrintUnformatted(item);
+    if (text == NULL) return;
+    if (strlen(text) > MAX_PRINTED_VALUE) printf("%.*s...", MAX_PRINTED_VALUE, text);
+    else printf("%s", text);
+    cJSON_free(text);
+}
+
+static void PrintChangedField(const char *field, const cJSON *before, const cJSON *after)
+{
+    printf("    %s: ", field);
+    PrintValue(before);
+    printf(" -> ");
+    PrintValue(after);
+    printf("\n");
+}
+
+static void PrintModification(const cJSON *before, const cJSON *after)
+{
+    if (!cJSON_IsObject(before) || !cJSON_IsObject(after))
+    {
+        PrintChangedField("value", before, after);
+        return;
+    }
+
+    const cJSON *member = NULL;
+    cJSON_ArrayForEach(member, before)
+    {
+        const cJSON *other = cJSON_GetObjectItemCaseSensitive(after, member->string);
+        if (!SameValue(member, other)) PrintChangedField(member->string, member, other);
+    }
+    cJSON_ArrayForEach(member, after)
+    {
+        if (cJSON_GetObjectItemCaseSensitive(before, member->string) == NULL) PrintChangedField(member->string, NULL, member);
+    }
+}
+
+//------------------------------------------------------------------------------------
+// Diff
+//------------------------------------------------------------------------------------
+DiffSummary DiffConfigs(const cJSON *before, const cJSON *after, bool print)
+{
+    DiffSummary summary = { 0 };
+    FlatConfig *a = DiffFlatten(before);
+    FlatConfig *b = DiffFlatten(after);
+    bool *matched = (b != NULL) ? MemCalloc(b->count > 0 ? b->count : 1, sizeof(bool)) : NULL;
+    if (a == NULL || b == NULL || matched == NULL)
+    {
+        printf("ERROR: Not enough memory to diff configs.\n");
+        DiffFreeFlat(a);
+        DiffFreeFlat(b);
+        MemFree(matched);
+        return summary;
+    }
+
+    char description[256];
+    for (int i = 0; i < a->count; i++)
+    {
+        DiffEntry *entry = &a->entries[i];
+        DiffEntry *other = FindEntry(b, entry->identity);
+        if (other == NULL)
+        {
+            summary.removed++;
+            if (print) { DescribeEntry(a, entry, description, sizeof(description)); printf("- %s\n", description); }
+            continue;
+        }
+
+        matched[other - b->entries] = true;
+        if (other->content == entry->content) continue;
+
+        summary.modified++;
+        if (print)
+        {
+            DescribeEntry(a, entry, description, sizeof(description));
+            printf("~ %s\n", description);
+            PrintModification(entry->item, other->item);
+        }
+    }
+
+    for (int i = 0; i < b->count; i++)
+    {
+        if (matched[i]) continue;
+        summary.added++;
+        if (print) { DescribeEntry(b, &b->entries[i], description, sizeof(description)); printf("+ %s\n", description); }
+    }
+
+    MemFree(matched);
+    DiffFreeFlat(a);
+    DiffFreeFlat(b);
+    return summary;
+}
+
+static int FindCollection(const FlatConfig *flat, const char *path)
+{
+    for (int i = 0; i < flat->collectionCount; i++)
+    {
+        if (strcmp(flat->collections[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+static bool AppendChange(DiffChangeList *list, int *capacity, DiffChange change)
+{
+    if (list->count == *capacity)
+    {
+        int newCapacity = (*capacity == 0) ? 64 : *capacity * 2;
+        DiffChange *changes = MemRealloc(list->changes, sizeof(DiffChange) * newCapacity);
+        if (changes == NULL) return false;
+        list->changes = changes;
+        *capacity = newCapacity;
+    }
+    list->changes[list->count++] = change;
+    return true;
+}
+
+DiffChangeList DiffCollectChanges(const cJSON *before, const FlatConfig *after)
+{
+    DiffChangeList list = { 0 };
+    const FlatConfig *b = after;
+    FlatConfig *a = DiffFlatten(before);
+    int *partners = (b != NULL) ? MemAlloc(sizeof(int) * (b->count > 0 ? b->count : 1)) : NULL;
+    if (a == NULL || b == NULL || partners == NULL)
+    {
+        DiffFreeFlat(a);
+        MemFree(partners);
+        return list;
+    }
+
+    list.sameLayout = (a->collectionCount == b->collectionCount);
+    for (int i = 0; i < a->collectionCount && list.sameLayout; i++)
+    {
+        list.sameLayout = strcmp(a->collections[i].path, b->collections[i].path) == 0 &&
+                          cJSON_IsArray(a->collections[i].container) == cJSON_IsArray(b->collections[i].container);
+    }
+
+    int capacity = 0;
+    bool collected = true;
+    for (int i = 0; i < b->count; i++) partners[i] = -1;
+    for (int i = 0; i < a->count && collected; i++)
+    {
+        DiffEntry *entry = &a->entries[i];
+        const DiffEntry *other = FindEntry(b, entry->identity);
+        cJSON *container = a->collections[entry->collection].container;
+        if (other == NULL)
+        {
+            collected = AppendChange(&list, &capacity, (DiffChange){ DIFF_REMOVED, container, entry->item, NULL, entry->position, -1 });
+            continue;
+        }
+
+        partners[other - b->entries] = i;
+        if (other->content == entry->content) continue;
+        collected = AppendChange(&list, &capacity, (DiffChange){ DIFF_MODIFIED, container, entry->item, other->item, entry->position, other->position });
+    }
+
+    // Kept array elements have to appear in the same order on both sides, or applying the changes in place would not give after
+    int lastPositions[MAX_COLLECTIONS];
+    for (int i = 0; i < b->collectionCount; i++) lastPositions[i] = -1;
+    for (int i = 0; i < b->count && collected; i++)
+    {
+        const DiffEntry *entry = &b->entries[i];
+        if (partners[i] >= 0)
+        {
+            int position = a->entries[partners[i]].position;
+            if (entry->position >= 0 && position <= lastPositions[entry->collection]) list.sameLayout = false;
+            if (entry->position >= 0) lastPositions[entry->collection] = position;
+            continue;
+        }
+
+        int collection = FindCollection(a, b->collections[entry->collection].path);
+        if (collection < 0) list.sameLayout = false;
+        cJSON *container = (collection >= 0) ? a->collections[collection].container : NULL;
+        collected = AppendChange(&list, &capacity, (DiffChange){ DIFF_ADDED, container, NULL, entry->item, -1, entry->position });
+    }
+
+    if (!collected) DiffFreeChanges(&list);
+    MemFree(partners);
+    DiffFreeFlat(a);
+    return list;
+}
+
+void DiffFreeChanges(DiffChangeList *list)
+{
+    MemFree(list->changes);
+    *list = (DiffChangeList){ 0 };
+}
+
+//------------------------------------------------------------------------------------
+// Merge
+//------------------------------------------------------------------------------------
+static void ReplaceEntryItem(FlatConfig *flat, DiffEntry *entry, const cJSON *source)
+{
+    cJSON *container = flat->collections[entry->collection].container;
+    cJSON *copy = cJSON_Duplicate(source, true);
+    if (copy == NULL) return;
+
+    if (cJSON_IsArray(container)) cJSON_ReplaceItemViaPointer(container, entry->item, copy);
+    else cJSON_ReplaceItemInObjectCaseSensitive(container, entry->item->string, copy);
+    entry->item = copy;
+}
+
+static void RemoveEntryItem(FlatConfig *flat, DiffEntry *entry)
+{
+    cJSON_Delete(cJSON_DetachItemViaPointer(flat->collections[entry->collection].container, entry->item));
+    entry->item = NULL;
+}
+
+// Adds an element that only theirs has to the same collection of the merged config
+static bool AddEntryItem(FlatConfig *merged, const FlatConfig *theirs, const DiffEntry *entry)
+{
+    const char *path = theirs->collections[entry->collection].path;
+    for (int i = 0; i < merged->collectionCount; i++)
+    {
+        cJSON *container = merged->collections[i].container;
+        if (strcmp(merged->collections[i].path, path) != 0) continue;
+        if (cJSON_IsArray(container) != (entry->position >= 0)) return false;
+
+        cJSON *copy = cJSON_Duplicate(entry->item, true);
+        if (copy == NULL) return false;
+        if (cJSON_IsArray(container)) cJSON_AddItemToArray(container, copy);
+        else cJSON_AddItemToObject(container, entry->item->string, copy);
+        return true;
+    }
+    return false;
+}
+
+static bool FieldMergeable(const cJSON *base, const cJSON *ours, const cJSON *theirs, const char *field)
+{
+    const cJSON *o = cJSON_GetObjectItemCaseSensitive(base, field);
+    const cJSON *a = cJSON_GetObjectItemCaseSensitive(ours, field);
+    const cJSON *t = cJSON_GetObjectItemCaseSensitive(theirs, field);
+    return SameValue(t, o) || SameValue(a, o) || SameValue(a, t);
+}
+
+static void MergeField(const cJSON *base, cJSON *ours, const cJSON *theirs, const char *field)
+{
+    const cJSON *o = cJSON_GetObjectItemCaseSensitive(base, field);
+    cJSON *a = cJSON_GetObjectItemCaseSensitive(ours, field);
+    const cJSON *t = cJSON_GetObjectItemCaseSensitive(theirs, field);
+    if (SameValue(t, o) || !SameValue(a, o)) return;
+
+    if (t == NULL) cJSON_DeleteItemFromObjectCaseSensitive(ours, field);
+    else if (a == NULL) cJSON_AddItemToObject(ours, field, cJSON_Duplicate(t, true));
+    else cJSON_ReplaceItemInObjectCaseSensitive(ours, field, cJSON_Duplicate(t, true));
+}
+
+// Merges an element both sides changed, field by field. Fails if any field was changed differently on both sides.
+static bool MergeFields(const cJSON *base, cJSON *ours, const cJSON *theirs, const char *description)
+{
+    if (!cJSON_IsObject(base) || !cJSON_IsObject(ours) || !cJSON_IsObject(theirs))
+    {
+        printf("! %s: changed on both sides\n", description);
+        return false;
+    }
+
+    // Every field name once: base's, then those ours added, then those only theirs added
+    const cJSON *objects[3] = { base, ours, theirs };
+    bool mergeable = true;
+    for (int i = 0; i < 3; i++)
+    {
+        const cJSON *member = NULL;
+        cJSON_ArrayForEach(member, objects[i])
+        {
+            if (i > 0 && cJSON_GetObjectItemCaseSensitive(base, member->string) != NULL) continue;
+            if (i > 1 && cJSON_GetObjectItemCaseSensitive(ours, member->string) != NULL) continue;
+            if (FieldMergeable(base, ours, theirs, member->string)) continue;
+
+            if (mergeable) printf("! %s: changed on both sides\n", description);
+            printf("    %s\n", member->string);
+            mergeable = false;
+        }
+    }
+    if (!mergeable) return false;
+
+    // Fields only ours has are kept as they are, so base's and theirs' names cover every change
+    const cJSON *sources[2] = { base, theirs };
+    for (int i = 0; i < 2; i++)
+    {
+        const cJSON *member = NULL;
+        cJSON_ArrayForEach(member, sources[i]) MergeField(base, ours, theirs, member->string);
+    }
+    return true;
+}
+
+cJSON *MergeConfigs(const cJSON *base, const cJSON *ours, const cJSON *theirs, MergeSummary *summary)
+{
+    *summary = (MergeSummary){ 0 };
+    cJSON *merged = cJSON_Duplicate(ours, true);
+    FlatConfig *o = DiffFlatten(base);
+    FlatConfig *m = DiffFlatten(merged);
+    FlatConfig *t = DiffFlatten(theirs);
+    if (merged == NULL || o == NULL || m == NULL || t == NULL)
+    {
+        printf("ERROR: Not enough memory to merge configs.\n");
+        cJSON_Delete(merged);
+        DiffFreeFlat(o);
+        DiffFreeFlat(m);
+        DiffFreeFlat(t);
+        return NULL;
+    }
+
+    // The merge is ours plus whatever theirs changed relative to base
+    char description[256];
+    for (int i = 0; i < o->count; i++)
+    {
+        DiffEntry *baseEntry = &o->entries[i];
+        DiffEntry *theirsEntry = FindEntry(t, baseEntry->identity);
+        if (theirsEntry != NULL && theirsEntry->content == baseEntry->content) continue;
+
+        DiffEntry *oursEntry = FindEntry(m, baseEntry->identity);
+        DescribeEntry(o, baseEntry, description, sizeof(description));
+        if (theirsEntry == NULL)
+        {
+            if (oursEntry == NULL) continue;
+            if (oursEntry->content == baseEntry->content) { RemoveEntryItem(m, oursEntry); summary->applied++; }
+            else { printf("! %s: changed in ours, removed in theirs\n", description); summary->conflicts++; }
+        }
+        else if (oursEntry == NULL) { printf("! %s: removed in ours, changed in theirs\n", description); summary->conflicts++; }
+        else if (oursEntry->content == baseEntry->content) { ReplaceEntryItem(m, oursEntry, theirsEntry->item); summary->applied++; }
+        else if (oursEntry->content == theirsEntry->content) continue;
+        else if (MergeFields(baseEntry->item, oursEntry->item, theirsEntry->item, description)) summary->merged++;
+        else summary->conflicts++;
+    }
+
+    for (int i = 0; i < t->count; i++)
+    {
+        DiffEntry *theirsEntry = &t->entries[i];
+        if (FindEntry(o, theirsEntry->identity) != NULL) continue;
+
+        DiffEntry *oursEntry = FindEntry(m, theirsEntry->identity);
+        if (oursEntry != NULL && oursEntry->content == theirsEntry->content) continue;
+
+        DescribeEntry(t, theirsEntry, description, sizeof(description));
+        if (oursEntry != NULL) { printf("! %s: added differently on both sides\n", description); summary->conflicts++; }
+        else if (AddEntryItem(m, t, theirsEntry)) summary->applied++;
+        else { printf("! %s: added in theirs to a collection ours does not have\n", description); summary->conflicts++; }
+    }
+
+    DiffFreeFlat(o);
+    DiffFreeFlat(m);
+    DiffFreeFlat(t);
+    return merged;
+}
@@ -0,0 +1,95 @@
+#ifndef DIFF_H
+#define DIFF_H
+
+#include "cJSON.h"
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Element-level diff and three-way merge of configs. Elements of top-level arrays (and of
+// arrays one object deeper, like portals.locations) are matched by identity: their "id"
+// field, else their "name", else their position. Everything else is matched by its path.
+// Matching and comparison use 64-bit hashes, so both are linear in the number of elements.
+
+typedef struct {
+    int added;
+    int removed;
+    int modified;
+} DiffSummary;
+
+typedef struct {
+    int applied;   // Changes from theirs that applied cleanly
+    int merged;    // Elements changed on both sides whose fields merged without overlap
+    int conflicts; // Elements changed incompatibly on both sides; ours was kept
+} MergeSummary;
+
+// A config flattened into hashed elements, the expensive half of a diff
+typedef struct FlatConfig FlatConfig;
+
+typedef enum {
+    DIFF_ADDED = 0,
+    DIFF_REMOVED,
+    DIFF_MODIFIED
+} DiffChangeKind;
+
+// One element that differs. Containers and items point into the two compared documents.
+typedef struct {
+    DiffChangeKind kind;
+    cJSON *beforeContainer;     // The array or object of before that holds the element, or receives it
+    cJSON *before;              // NULL when added
+    cJSON *after;               // NULL when removed
+    int beforePosition;         // Array index, -1 for object members and additions
+    int afterPosition;          // Array index, -1 for object members and removals
+} DiffChange;
+
+// Removals and modifications in the order of before, then additions in the order of after
+typedef struct {
+    DiffChange *changes;
+    int count;
+    bool sameLayout;            // Same collections on both sides, and no kept element changed its order
+} DiffChangeList;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Computes the element-level changes that turn before into after.
+ * @param print Print every change to stdout, with the fields that differ for modified elements.
+ */
+DiffSummary DiffConfigs(const cJSON *before, const cJSON *after, bool print);
+
+/**
+ * @brief Three-way merge: applies the changes between base and theirs on top of ours.
+ *        Conflicts are printed and resolved in favour of ours.
+ * @return A new document owned by the caller, or NULL if out of memory.
+ */
+cJSON *MergeConfigs(const cJSON *base, const cJSON *ours, const cJSON *theirs, MergeSummary *summary);
+
+/**
+ * @brief Flattens and hashes a config for DiffCollectChanges(). Touches nothing but the config,
+ *        so it can run on another thread. The config must not change until it has been used.
+ * @return The flattened config, to be freed with DiffFreeFlat(), or NULL if out of memory.
+ */
+FlatConfig *DiffFlatten(const cJSON *config);
+
+/**
+ * @brief Frees a flattened config.
+ */
+void DiffFreeFlat(FlatConfig *flat);
+
+/**
+ * @brief Lists the element-level changes that turn before into after, for applying them to before
+ *        in place. Additions go to before's collection with the same path.
+ * @param after The flattened new config; its items are what the changes point to.
+ * @return The changes, to be freed with DiffFreeChanges(). changes is NULL if out of memory.
+ */
+DiffChangeList DiffCollectChanges(const cJSON *before, const FlatConfig *after);
+
+/**
+ * @brief Frees a change list.
+ */
+void DiffFreeChanges(DiffChangeList *list);
+
+#endif // DIFF_H
@@ -0,0 +1,478 @@
+#include "duplicates.h"
+#include "changes.h"
+#include "edit_ops.h"
+#include "memtrack.h"
+#include "point_cache.h"
+#include "profiler.h"
+#include "structure_cache.h"
+#include "undo.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MARK_RADIUS 14.0f
+
+// The points of one layer's elements, NaN where an element has none. Only structures carry a key.
+typedef struct {
+    int count;
+    float *ax;
+    float *ay;
+    float *bx;                  // NULL for layers with one point per element
+    float *by;
+    const uint32_t *keys;       // Elements only match when their keys match; NULL for no key
+} LayerPoints;
+
+// An element with what a comparison needs, sorted by the rank of its cell in row order so the
+// elements of a cell sit next to each other
+typedef struct {
+    uint64_t rank;
+    float x;
+    float y;
+    uint32_t key;
+    int element;
+} GridNode;
+
+// The nodes of three neighbouring cells of one row
+typedef struct {
+    int begin;
+    int end;
+} NodeRange;
+
+typedef struct {
+    GridNode *nodes;            // Placed elements in cell order
+    int nodeCount;
+    int *cellStarts;            // First node of each cell, then nodeCount
+    int cellCount;
+    NodeRange *neighbours;      // Three runs per cell: the rows below, at and above it
+} Grid;
+
+// An element that matches an earlier one, so whether it is kept depends on the earlier one
+typedef struct {
+    int element;
+    int node;
+    int cell;
+} Candidate;
+
+static float _distance = DEFAULT_DUPLICATE_DISTANCE;
+
+static Duplicate *_duplicates = NULL;
+static int _duplicateCount = 0;
+static int _duplicateCapacity = 0;
+static DuplicateStats _stats = { 0 };
+static bool _showing = false;
+static uint64_t _foundVersion = 0;
+static const cJSON *_foundStructures = NULL;
+
+//------------------------------------------------------------------------------------
+// Reading points
+//------------------------------------------------------------------------------------
+static void FreePoints(LayerPoints *points)
+{
+    MemFree(points->ax);
+    MemFree(points->ay);
+    MemFree(points->bx);
+    MemFree(points->by);
+    *points = (LayerPoints){ 0 };
+}
+
+static bool ReadPoint(cJSON *element, PointField field, float *x, float *y)
+{
+    cJSON *xItem = NULL, *yItem = NULL;
+    bool found = GetPointItemsJSON(element, field, &xItem, &yItem);
+    *x = found ? (float)xItem->valuedouble : NAN;
+    *y = found ? (float)yItem->valuedouble : NAN;
+    return found;
+}
+
+// Copies two points per element out of the document; portals and regions are too few to be cached
+static bool ReadLayer(EditLayer layer, PointField first, PointField second, LayerPoints *points)
+{
+    cJSON *array = GetLayerJSON(layer);
+    int count = cJSON_GetArraySize(array);
+    size_t size = sizeof(float) * (count > 0 ? count : 1);
+    *points = (LayerPoints){ count, MemAlloc(size), MemAlloc(size), MemAlloc(size), MemAlloc(size), NULL };
+    if (points->ax == NULL || points->ay == NULL || points->bx == NULL || points->by == NULL)
+    {
+        FreePoints(points);
+        return false;
+    }
+
+    int i = 0;
+    cJSON *element = NULL;
+    cJSON_ArrayForEach(element, array)
+    {
+        if (!ReadPoint(element, first, &points->ax[i], &points->ay[i]) || !ReadPoint(element, second, &points->bx[i], &points->by[i])) points->ax[i] = NAN;
+        i++;
+    }
+    return true;
+}
+
+// Structures and boost gates come from the point cache, which draw and picking keep up to date anyway
+static bool GetLayerPoints(EditLayer layer, LayerPoints *points, LayerPoints *owned)
+{
+    *owned = (LayerPoints){ 0 };
+    if (layer == LAYER_STRUCTURES)
+    {
+        const StructureCache *cache = GetStructureCache();
+        const PointSet *set = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+        *points = (LayerPoints){ (set->count < cache->count) ? set->count : cache->count, set->xs, set->ys, NULL, NULL, cache->names };
+        return true;
+    }
+    if (layer == LAYER_BOOST_GATES)
+    {
+        const PointSet *a = GetPointSet(ELEMENT_TYPE_BOOST_GATE_A);
+        const PointSet *b = GetPointSet(ELEMENT_TYPE_BOOST_GATE_B);
+        *points = (LayerPoints){ (a->count < b->count) ? a->count : b->count, a->xs, a->ys, b->xs, b->ys, NULL };
+        return true;
+    }
+
+    bool read = (layer == LAYER_PORTALS) ? ReadLayer(layer, POINT_FIELD_A, POINT_FIELD_B, owned)
+                                         : ReadLayer(layer, POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX, owned);
+    *points = *owned;
+    return read;
+}
+
+//------------------------------------------------------------------------------------
+// Sorted grid
+//------------------------------------------------------------------------------------
+static int32_t CellCoordinate(float value, float cellSize)
+{
+    double cell = floor((double)value / cellSize);
+    if (cell < -1073741824.0) return -1073741824;
+    if (cell > 1073741824.0) return 1073741824;
+    return (int32_t)cell;
+}
+
+// Stable LSD radix sort on the bytes the largest rank uses, so each cell keeps its elements in index order
+static bool SortNodes(GridNode *nodes, int count, uint64_t last)
+{
+    GridNode *scratch = MemAlloc(sizeof(GridNode) * (count > 0 ? count : 1));
+    if (scratch == NULL) return false;
+
+    GridNode *from = nodes, *to = scratch;
+    for (int shift = 0; shift < 64 && (last >> shift) != 0; shift += 8)
+    {
+        int offsets[256] = { 0 };
+        for (int i = 0; i < count; i++) offsets[(from[i].rank >> shift) & 0xFF]++;
+        for (int d = 0, sum = 0; d < 256; d++)
+        {
+            int digits = offsets[d];
+            offsets[d] = sum;
+            sum += digits;
+        }
+        for (int i = 0; i < count; i++) to[offsets[(from[i].rank >> shift) & 0xFF]++] = from[i];
+        GridNode *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != nodes) memcpy(nodes, from, sizeof(GridNode) * count);
+    MemFree(scratch);
+    return true;
+}
+
+static bool Near(float ax, float ay, float bx, float by, double distanceSquared)
+{
+    double dx = (double)ax - bx;
+    double dy = (double)ay - by;
+    return dx * dx + dy * dy <= distanceSquared;
+}
+
+static uint32_t KeyOf(const LayerPoints *points, int i)
+{
+    return (points->keys != NULL) ? points->keys[i] : 0;
+}
+
+static bool SecondNear(const LayerPoints *points, int i, int j, double distanceSquared)
+{
+    return points->bx == NULL || Near(points->bx[i], points->by[i], points->bx[j], points->by[j], distanceSquared);
+}
+
+static bool AddDuplicate(Duplicate duplicate)
+{
+    if (_duplicateCount == _duplicateCapacity)
+    {
+        int newCapacity = (_duplicateCapacity == 0) ? 64 : _duplicateCapacity * 2;
+        Duplicate *grown = MemRealloc(_duplicates, sizeof(Duplicate) * newCapacity);
+        if (grown == NULL) return false;
+        _duplicates = grown;
+        _duplicateCapacity = newCapacity;
+    }
+    _duplicates[_duplicateCount++] = duplicate;
+    return true;
+}
+
+static bool IsPlaced(const LayerPoints *points, int i)
+{
+    return !isnan(points->ax[i]) && !isnan(points->ay[i]) && (points->bx == NULL || (!isnan(points->bx[i]) && !isnan(points->by[i])));
+}
+
+static void FreeGrid(Grid *grid)
+{
+    MemFree(grid->nodes);
+    MemFree(grid->cellStarts);
+    MemFree(grid->neighbours);
+    *grid = (Grid){ 0 };
+}
+
+// Puts the placed elements in cell order, cells as wide as the distance in row order. Ranks leave
+// a margin of one cell around the used ones so neighbouring ranks never wrap to another row.
+static bool BuildGrid(const LayerPoints *points, Grid *grid)
+{
+    int count = points->count;
+    *grid = (Grid){ MemAlloc(sizeof(GridNode) * count), 0, MemAlloc(sizeof(int) * (count + 1)), 0, MemAlloc(sizeof(NodeRange) * 3 * count) };
+    uint64_t *cellRanks = MemAlloc(sizeof(uint64_t) * count);
+    bool built = grid->nodes != NULL && grid->cellStarts != NULL && grid->neighbours != NULL && cellRanks != NULL;
+
+    float cellSize = (_distance > 1.0f) ? _distance : 1.0f;
+    int32_t minX = INT32_MAX, maxX = INT32_MIN, minY = INT32_MAX, maxY = INT32_MIN;
+    for (int i = 0; built && i < count; i++)
+    {
+        if (!IsPlaced(points, i)) continue;
+        int32_t cx = CellCoordinate(points->ax[i], cellSize);
+        int32_t cy = CellCoordinate(points->ay[i], cellSize);
+        if (cx < minX) minX = cx;
+        if (cx > maxX) maxX = cx;
+        if (cy < minY) minY = cy;
+        if (cy > maxY) maxY = cy;
+        grid->nodes[grid->nodeCount++] = (GridNode){ ((uint64_t)cy << 32) | (uint32_t)cx, points->ax[i], points->ay[i], KeyOf(points, i), i };
+    }
+
+    uint64_t columns = (uint64_t)((int64_t)maxX - minX) + 3;
+    for (int n = 0; built && n < grid->nodeCount; n++)
+    {
+        int32_t cx = (int32_t)(uint32_t)grid->nodes[n].rank;
+        int32_t cy = (int32_t)(grid->nodes[n].rank >> 32);
+        grid->nodes[n].rank = (uint64_t)((int64_t)cy - minY + 1) * columns + (uint64_t)((int64_t)cx - minX + 1);
+    }
+    built = built && SortNodes(grid->nodes, grid->nodeCount, ((uint64_t)((int64_t)maxY - minY) + 2) * columns + columns - 1);
+
+    for (int n = 0; built && n < grid->nodeCount; n++)
+    {
+        if (n > 0 && grid->nodes[n].rank == grid->nodes[n - 1].rank) continue;
+        cellRanks[grid->cellCount] = grid->nodes[n].rank;
+        grid->cellStarts[grid->cellCount++] = n;
+    }
+    if (built) grid->cellStarts[grid->cellCount] = grid->nodeCount;
+
+    // The runs of each neighbouring row only move forward from cell to cell, so one pass finds them all
+    for (int row = 0; built && row < 3; row++)
+    {
+        int begin = 0, end = 0;
+        for (int c = 0; c < grid->cellCount; c++)
+        {
+            uint64_t first = cellRanks[c] + (uint64_t)row * columns - columns - 1;
+            while (begin < grid->cellCount && cellRanks[begin] < first) begin++;
+            if (end < begin) end = begin;
+            while (end < grid->cellCount && cellRanks[end] <= first + 2) end++;
+            grid->neighbours[c * 3 + row] = (NodeRange){ grid->cellStarts[begin], grid->cellStarts[end] };
+        }
+    }
+
+    MemFree(cellRanks);
+    if (!built) FreeGrid(grid);
+    return built;
+}
+
+static bool NodesMatch(const LayerPoints *points, const GridNode *a, const GridNode *b, double distanceSquared)
+{
+    return a->key == b->key && Near(a->x, a->y, b->x, b->y, distanceSquared) && SecondNear(points, a->element, b->element, distanceSquared);
+}
+
+static int CompareCandidates(const void *a, const void *b)
+{
+    return ((const Candidate *)a)->element - ((const Candidate *)b)->element;
+}
+
+// Finds the elements that match an earlier element, in cell order so the neighbours compared
+// with are close in memory. As matching is symmetric, all other elements are kept for sure.
+static Candidate *FindCandidates(const LayerPoints *points, const Grid *grid, bool *kept, int *count)
+{
+    Candidate *candidates = NULL;
+    int capacity = 0;
+    *count = 0;
+    double distanceSquared = (double)_distance * _distance;
+    for (int c = 0; c < grid->cellCount; c++)
+    {
+        for (int n = grid->cellStarts[c]; n < grid->cellStarts[c + 1]; n++)
+        {
+            const GridNode *node = &grid->nodes[n];
+            bool matched = false;
+            for (int row = 0; row < 3 && !matched; row++)
+            {
+                NodeRange range = grid->neighbours[c * 3 + row];
+                for (int m = range.begin; m < range.end && !matched; m++)
+                {
+                    matched = grid->nodes[m].element < node->element && NodesMatch(points, node, &grid->nodes[m], distanceSquared);
+                }
+            }
+
+            kept[n] = !matched;
+            if (!matched) continue;
+            if (*count == capacity)
+            {
+                capacity = (capacity == 0) ? 64 : capacity * 2;
+                Candidate *grown = MemRealloc(candidates, sizeof(Candidate) * capacity);
+                if (grown == NULL) { MemFree(candidates); *count = 0; return NULL; }
+                candidates = grown;
+            }
+            candidates[(*count)++] = (Candidate){ node->element, n, c };
+        }
+    }
+    if (*count > 1) qsort(candidates, (size_t)*count, sizeof(Candidate), CompareCandidates);
+    return candidates;
+}
+
+// Keeps the first of every group of copies and records the others. Only the candidates are
+// walked in index order, each compared with the kept elements of the 3x3 cells around it.
+static void FindInLayer(EditLayer layer, const LayerPoints *points)
+{
+    _stats.elementCounts[layer] = points->count;
+    Grid grid;
+    if (points->count == 0 || !BuildGrid(points, &grid)) return;
+
+    int candidateCount = 0;
+    bool *kept = MemAlloc(sizeof(bool) * (grid.nodeCount > 0 ? grid.nodeCount : 1));
+    Candidate *candidates = (kept != NULL) ? FindCandidates(points, &grid, kept, &candidateCount) : NULL;
+
+    double distanceSquared = (double)_distance * _distance;
+    for (int k = 0; k < candidateCount; k++)
+    {
+        const GridNode *node = &grid.nodes[candidates[k].node];
+        int original = -1;
+        for (int row = 0; row < 3 && original < 0; row++)
+        {
+            NodeRange range = grid.neighbours[candidates[k].cell * 3 + row];
+            for (int m = range.begin; m < range.end; m++)
+            {
+                if (kept[m] && NodesMatch(points, node, &grid.nodes[m], distanceSquared)) { original = grid.nodes[m].element; break; }
+            }
+        }
+
+        if (original < 0)
+        {
+            kept[candidates[k].node] = true;
+            continue;
+        }
+
+        bool exact = node->x == points->ax[original] && node->y == points->ay[original] && SecondNear(points, node->element, original, 0.0);
+        if (!AddDuplicate((Duplicate){ layer, node->element, original, exact, node->x, node->y })) break;
+        _stats.counts[layer]++;
+        if (exact) _stats.exactCounts[layer]++;
+        _stats.total++;
+    }
+
+    MemFree(candidates);
+    MemFree(kept);
+    FreeGrid(&grid);
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+void DuplicatesSetDistance(float distance)
+{
+    _distance = (distance > 0.0f) ? distance : 0.0f;
+    DuplicatesCancel();
+}
+
+const DuplicateStats *DuplicatesFind(void)
+{
+    DuplicatesCancel();
+
+    ProfileBegin("find duplicates");
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    static const EditLayer layers[] = { LAYER_STRUCTURES, LAYER_BOOST_GATES, LAYER_PORTALS, LAYER_SNOW_REGIONS, LAYER_RAIN_REGIONS, LAYER_STAR_REGIONS };
+    for (int l = 0; l < (int)(sizeof(layers) / sizeof(layers[0])); l++)
+    {
+        LayerPoints points, owned;
+        if (!GetLayerPoints(layers[l], &points, &owned)) continue;
+        FindInLayer(layers[l], &points);
+        FreePoints(&owned);
+    }
+
+    _showing = true;
+    _foundVersion = ChangesGetVersion();
+    _foundStructures = _structures;
+    MemPopSubsystem();
+    ProfileEnd();
+    return &_stats;
+}
+
+bool DuplicatesIsShowing(void)
+{
+    if (_showing && (_foundVersion != ChangesGetVersion() || _foundStructures != _structures)) DuplicatesCancel();
+    return _showing;
+}
+
+const Duplicate *DuplicatesGet(int *count)
+{
+    *count = DuplicatesIsShowing() ? _duplicateCount : 0;
+    return _duplicates;
+}
+
+const DuplicateStats *DuplicatesGetStats(void)
+{
+    DuplicatesIsShowing();
+    return &_stats;
+}
+
+void DuplicatesDraw(Vector2 cameraOffset, float displayScale)
+{
+    if (!DuplicatesIsShowing()) return;
+
+    for (int i = 0; i < _duplicateCount; i++)
+    {
+        Vector2 pos = { _duplicates[i].x * displayScale + cameraOffset.x, -_duplicates[i].y * displayScale + cameraOffset.y };
+        if (pos.x < -MARK_RADIUS || pos.y < -MARK_RADIUS || pos.x > SCREEN_WIDTH + MARK_RADIUS || pos.y > SCREEN_HEIGHT + MARK_RADIUS) continue;
+        DrawCircleLines((int)pos.x, (int)pos.y, MARK_RADIUS, _duplicates[i].exact ? MAGENTA : ORANGE);
+    }
+}
+
+int DuplicatesRemove(void)
+{
+    if (!DuplicatesIsShowing() || _duplicateCount == 0)
+    {
+        DuplicatesCancel();
+        return 0;
+    }
+
+    // Duplicates are sorted by layer and index, so each layer's run is removed with one walk
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    int *indices = MemAlloc(sizeof(int) * _duplicateCount);
+    cJSON **detached = MemAlloc(sizeof(cJSON *) * _duplicateCount);
+    int removed = 0;
+    if (indices != NULL && detached != NULL)
+    {
+        UndoBeginTransaction();
+        for (int start = 0, end; start < _duplicateCount; start = end)
+        {
+            EditLayer layer = _duplicates[start].layer;
+            for (end = start; end < _duplicateCount && _duplicates[end].layer == layer; end++) indices[end - start] = _duplicates[end].index;
+            EditDetachElements(layer, indices, end - start, detached);
+            UndoRecordRemoveMany(layer, indices, detached, end - start);
+            removed += end - start;
+        }
+        UndoEndTransaction();
+    }
+    MemFree(indices);
+    MemFree(detached);
+    MemPopSubsystem();
+    DuplicatesCancel();
+    return removed;
+}
+
+void DuplicatesCancel(void)
+{
+    _duplicateCount = 0;
+    _stats = (DuplicateStats){ 0 };
+    _showing = false;
+}
+
+void DuplicatesClear(void)
+{
+    DuplicatesCancel();
+    MemFree(_duplicates);
+    _duplicates = NULL;
+    _duplicateCapacity = 0;
+}
@@ -0,0 +1,86 @@
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+
+#include "raylib.h"
+#include "map_editor.h"
+
+#define DEFAULT_DUPLICATE_DISTANCE 10.0f // World units two copies of an element may be apart
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Finds elements placed twice, typically by a paste or merge gone wrong. An element is a
+// duplicate of an earlier element of the same layer when all its points are within the
+// distance of the earlier one's: the location of a structure, which must also have the same
+// name, both ends of a boost gate or portal, both corners of a region. Each layer's elements
+// are radix sorted into a grid of cells as wide as the distance, then walked in index order,
+// each compared only with the kept elements of the 3x3 cells around it, which lie in three
+// runs of memory. The earliest copy is always the one kept.
+
+typedef struct {
+    EditLayer layer;
+    int index;
+    int original;               // Index of the copy that is kept
+    bool exact;                 // At exactly the same place
+    float x;                    // First point, for drawing
+    float y;
+} Duplicate;
+
+typedef struct {
+    int counts[LAYER_COUNT];    // Duplicates per layer
+    int exactCounts[LAYER_COUNT];
+    int elementCounts[LAYER_COUNT];
+    int total;
+} DuplicateStats;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Sets how far apart two copies may be. 0 only finds exact duplicates.
+ */
+void DuplicatesSetDistance(float distance);
+
+/**
+ * @brief Searches all layers and starts showing the result. Replaces an earlier result.
+ */
+const DuplicateStats *DuplicatesFind(void);
+
+/**
+ * @brief Whether a result is shown. Any edit to the document ends it, as it would be stale.
+ */
+bool DuplicatesIsShowing(void);
+
+/**
+ * @brief Returns the duplicates of the shown result, by layer and index.
+ */
+const Duplicate *DuplicatesGet(int *count);
+
+/**
+ * @brief Returns the counts of the shown result, all zero when none is shown.
+ */
+const DuplicateStats *DuplicatesGetStats(void);
+
+/**
+ * @brief Marks the duplicates of the shown result on the map.
+ */
+void DuplicatesDraw(Vector2 cameraOffset, float displayScale);
+
+/**
+ * @brief Removes every duplicate of the shown result as one undo step and ends showing it.
+ * @return Number of elements removed.
+ */
+int DuplicatesRemove(void);
+
+/**
+ * @brief Stops showing the result without changing anything.
+ */
+void DuplicatesCancel(void);
+
+/**
+ * @brief Frees the result. Call when the document is replaced.
+ */
+void DuplicatesClear(void);
+
+#endif // DUPLICATES_H
@@ -0,0 +1,215 @@
+#include "edit_ops.h"
+#include "changes.h"
+#include "handles.h"
+#include "point_cache.h"
+#include "live_push.h"
+#include "memtrack.h"
+
+// Resolved element pointers of one layer, so a group move costs one array walk instead of one per item
+typedef struct {
+    cJSON **items;
+    int count;
+    bool built;
+} LayerTable;
+
+static cJSON *ResolveElement(LayerTable *tables, PointRef ref)
+{
+    LayerTable *table = &tables[ref.layer];
+    if (!table->built)
+    {
+        cJSON *array = GetLayerJSON(ref.layer);
+        table->count = cJSON_GetArraySize(array);
+        table->items = MemAlloc(sizeof(cJSON *) * (table->count > 0 ? table->count : 1));
+        int i = 0;
+        cJSON *element = NULL;
+        if (table->items) cJSON_ArrayForEach(element, array) table->items[i++] = element;
+        table->built = true;
+    }
+    if (table->items == NULL || ref.index < 0 || ref.index >= table->count) return NULL;
+
+    return table->items[ref.index];
+}
+
+cJSON *EditGetElement(EditLayer layer, int index)
+{
+    if (IsWorldAreaLayer(layer)) return GetLayerJSON(layer);
+    return cJSON_GetArrayItem(GetLayerJSON(layer), index);
+}
+
+void EditMovePoints(const PointRef *refs, int count, int dx, int dy)
+{
+    LayerTable tables[LAYER_COUNT] = { 0 };
+
+    for (int i = 0; i < count; i++)
+    {
+        cJSON *element = ResolveElement(tables, refs[i]);
+        cJSON *xItem = NULL, *yItem = NULL;
+        if (!GetPointItemsJSON(element, refs[i].field, &xItem, &yItem)) continue;
+
+        cJSON_SetNumberValue(xItem, xItem->valuedouble + dx);
+        cJSON_SetNumberValue(yItem, yItem->valuedouble + dy);
+        PointCacheSet(refs[i], (float)xItem->valuedouble, (float)yItem->valuedouble);
+        ChangesMarkElement(refs[i].layer, refs[i].index, element);
+    }
+
+    for (int i = 0; i < LAYER_COUNT; i++) MemFree(tables[i].items);
+}
+
+void EditSetPoint(PointRef ref, int x, int y)
+{
+    cJSON *element = EditGetElement(ref.layer, ref.index);
+    cJSON *xItem = NULL, *yItem = NULL;
+    if (!GetPointItemsJSON(element, ref.field, &xItem, &yItem)) return;
+
+    cJSON_SetNumberValue(xItem, x);
+    cJSON_SetNumberValue(yItem, y);
+    PointCacheSet(ref, (float)x, (float)y);
+    ChangesMarkElement(ref.layer, ref.index, element);
+}
+
+void EditSetBounds(EditLayer layer, int index, const int bounds[4])
+{
+    cJSON *element = EditGetElement(layer, index);
+    cJSON *bounds_obj = cJSON_GetObjectItem(element, "bounds");
+    SetPointJSON(cJSON_GetObjectItem(bounds_obj, "min"), bounds[0], bounds[1]);
+    SetPointJSON(cJSON_GetObjectItem(bounds_obj, "max"), bounds[2], bounds[3]);
+    PointCacheSet((PointRef){ layer, index, POINT_FIELD_MIN_MIN }, (float)bounds[0], (float)bounds[1]);
+    PointCacheSet((PointRef){ layer, index, POINT_FIELD_MAX_MAX }, (float)bounds[2], (float)bounds[3]);
+    ChangesMarkElement(layer, index, element);
+}
+
+void EditSetRegionIds(const int *indices, const int *regionIds, int count, cJSON **previousItems)
+{
+    LayerTable tables[LAYER_COUNT] = { 0 };
+
+    for (int i = 0; i < count; i++)
+    {
+        cJSON *element = ResolveElement(tables, (PointRef){ LAYER_STRUCTURES, indices[i], POINT_FIELD_LOCATION });
+        cJSON *regionId = cJSON_GetObjectItem(element, "region_id");
+        if (previousItems != NULL) previousItems[i] = (regionId != NULL) ? cJSON_Duplicate(regionId, true) : NULL;
+        if (element == NULL) continue;
+
+        if (regionIds[i] < 0) cJSON_DeleteItemFromObject(element, "region_id");
+        else if (cJSON_IsNumber(regionId)) cJSON_SetNumberValue(regionId, regionIds[i]);
+        else if (regionId != NULL) cJSON_ReplaceItemInObject(element, "region_id", cJSON_CreateNumber(regionIds[i]));
+        else cJSON_AddNumberToObject(element, "region_id", regionIds[i]);
+        ChangesMarkElement(LAYER_STRUCTURES, indices[i], element);
+
+        // Not a point, so running games get the whole structure
+        LivePushElement(LAYER_STRUCTURES, indices[i], element);
+    }
+
+    for (int i = 0; i < LAYER_COUNT; i++) MemFree(tables[i].items);
+}
+
+void EditSetRegionIdItems(const int *indices, cJSON *const *items, int count)
+{
+    LayerTable tables[LAYER_COUNT] = { 0 };
+
+    for (int i = 0; i < count; i++)
+    {
+        cJSON *element = ResolveElement(tables, (PointRef){ LAYER_STRUCTURES, indices[i], POINT_FIELD_LOCATION });
+        if (element == NULL) continue;
+
+        cJSON *copy = (items[i] != NULL) ? cJSON_Duplicate(items[i], true) : NULL;
+        if (items[i] != NULL && copy == NULL) continue;
+        if (copy == NULL) cJSON_DeleteItemFromObject(element, "region_id");
+        else if (cJSON_GetObjectItem(element, "region_id") != NULL) cJSON_ReplaceItemInObject(element, "region_id", copy);
+        else cJSON_AddItemToObject(element, "region_id", copy);
+        ChangesMarkElement(LAYER_STRUCTURES, indices[i], element);
+        LivePushElement(LAYER_STRUCTURES, indices[i], element);
+    }
+
+    for (int i = 0; i < LAYER_COUNT; i++) MemFree(tables[i].items);
+}
+
+void EditInsertElement(EditLayer layer, int index, cJSON *element)
+{
+    if (element == NULL) return;
+    if (IsWorldAreaLayer(layer) || !cJSON_InsertItemInArray(GetLayerJSON(layer), index, element))
+    {
+        HandleRelease(element);
+        cJSON_Delete(element);
+        return;
+    }
+    HandleLayerChanged(layer);
+}
+
+cJSON *EditDetachElement(EditLayer layer, int index)
+{
+    if (IsWorldAreaLayer(layer)) return NULL;
+
+    // A detached element may be freed and its address reused, so it never counts as clean again
+    cJSON *element = cJSON_DetachItemFromArray(GetLayerJSON(layer), index);
+    ChangesMarkElement(layer, index, element);
+    HandleLayerChanged(layer);
+    return element;
+}
+
+void EditGetElements(EditLayer layer, const int *indices, int count, cJSON **elements)
+{
+    cJSON *array = IsWorldAreaLayer(layer) ? NULL : GetLayerJSON(layer);
+    cJSON *element = (array != NULL) ? array->child : NULL;
+    int position = 0;
+    for (int i = 0; i < count; i++)
+    {
+        while (element != NULL && position < indices[i]) { element = element->next; position++; }
+        elements[i] = element;
+    }
+}
+
+void EditInsertElements(EditLayer layer, const int *indices, cJSON **elements, int count)
+{
+    cJSON *array = IsWorldAreaLayer(layer) ? NULL : GetLayerJSON(layer);
+    if (array == NULL)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            HandleRelease(elements[i]);
+            cJSON_Delete(elements[i]);
+        }
+        return;
+    }
+
+    // Each element goes in front of the one now holding its index; cJSON keeps the tail in child->prev
+    cJSON *next = array->child;
+    int position = 0;
+    for (int i = 0; i < count; i++)
+    {
+        cJSON *element = elements[i];
+        if (element == NULL) continue;
+        while (next != NULL && position < indices[i]) { next = next->next; position++; }
+
+        if (next == NULL) cJSON_AddItemToArray(array, element);
+        else
+        {
+            element->next = next;
+            element->prev = next->prev;
+            if (next == array->child) array->child = element;
+            else next->prev->next = element;
+            next->prev = element;
+        }
+        position++;
+    }
+    HandleLayerChanged(layer);
+}
+
+void EditDetachElements(EditLayer layer, const int *indices, int count, cJSON **detached)
+{
+    cJSON *array = IsWorldAreaLayer(layer) ? NULL : GetLayerJSON(layer);
+    cJSON *element = (array != NULL) ? array->child : NULL;
+    int position = 0;
+    for (int i = 0; i < count; i++)
+    {
+        while (element != NULL && position < indices[i]) { element = element->next; position++; }
+        detached[i] = NULL;
+        if (element == NULL) continue;
+
+        cJSON *next = element->next;
+        detached[i] = cJSON_DetachItemViaPointer(array, element);
+        ChangesMarkElement(layer, indices[i], detached[i]);
+        element = next;
+        position++;
+    }
+    if (array != NULL) HandleLayerChanged(layer);
+}
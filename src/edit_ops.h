@@ -0,0 +1,78 @@
+#ifndef EDIT_OPS_H
+#define EDIT_OPS_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Low level document mutations shared by undo/redo and journal replay.
+// Elements are addressed by layer and array index.
+
+/**
+ * @brief Returns the element at index in a layer (the object itself for world areas).
+ */
+cJSON *EditGetElement(EditLayer layer, int index);
+
+/**
+ * @brief Moves a set of points by the same delta, resolving all of them with one walk per layer.
+ */
+void EditMovePoints(const PointRef *refs, int count, int dx, int dy);
+
+/**
+ * @brief Sets a single point.
+ */
+void EditSetPoint(PointRef ref, int x, int y);
+
+/**
+ * @brief Sets the bounds of a region or world area.
+ * @param bounds { min_x, min_y, max_x, max_y }.
+ */
+void EditSetBounds(EditLayer layer, int index, const int bounds[4]);
+
+/**
+ * @brief Sets the region_id of a set of structures, resolving all of them with one walk.
+ * @param regionIds New id per structure; a negative id removes region_id.
+ * @param previousItems Receives a copy of the region_id each structure had, whatever its type,
+ *        or NULL if it had none. The caller owns the copies. May be NULL.
+ */
+void EditSetRegionIds(const int *indices, const int *regionIds, int count, cJSON **previousItems);
+
+/**
+ * @brief Gives a set of structures a copy of exactly these region_id items, e.g. to restore
+ *        what EditSetRegionIds() replaced. A NULL item removes region_id.
+ */
+void EditSetRegionIdItems(const int *indices, cJSON *const *items, int count);
+
+/**
+ * @brief Inserts an element at index. The document takes ownership of it.
+ */
+void EditInsertElement(EditLayer layer, int index, cJSON *element);
+
+/**
+ * @brief Detaches the element at index. The caller takes ownership of the returned element.
+ */
+cJSON *EditDetachElement(EditLayer layer, int index);
+
+/**
+ * @brief Returns the elements at a set of indices with one walk.
+ * @param indices Ascending, without repeats.
+ * @param elements Receives the element at each index, NULL past the end.
+ */
+void EditGetElements(EditLayer layer, const int *indices, int count, cJSON **elements);
+
+/**
+ * @brief Inserts a set of elements with one walk. The document takes ownership of them.
+ * @param indices Ascending indices the elements have once all of them are inserted.
+ */
+void EditInsertElements(EditLayer layer, const int *indices, cJSON **elements, int count);
+
+/**
+ * @brief Detaches the elements at a set of indices with one walk. The caller takes ownership of them.
+ * @param indices Ascending, without repeats.
+ * @param detached Receives the element detached from each index, NULL past the end.
+ */
+void EditDetachElements(EditLayer layer, const int *indices, int count, cJSON **detached);
+
+#endif // EDIT_OPS_H
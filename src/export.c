@@ -0,0 +1,669 @@
+#include "export.h"
+#include "json_scan.h"
+#include "changes.h"
+#include "file_util.h"
+#include "pointer_map.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EXPORT_PATH 2048
+#define MAX_INDENT 64
+#define COPY_BUFFER_SIZE (4 * 1024 * 1024)
+#define PRINT_PREBUFFER 256         // With MemAlloc hooks cJSON grows by copying, which reads past an empty buffer
+
+// Where each layer lives in the config, matching LoadJsonData()
+static const char *_layerKeys[LAYER_COUNT][2] = {
+    [LAYER_STRUCTURES] = { "structures", NULL },
+    [LAYER_BOOST_GATES] = { "boost_gates", NULL },
+    [LAYER_PORTALS] = { "portals", "locations" },
+    [LAYER_SNOW_REGIONS] = { "snow_regions", NULL },
+    [LAYER_RAIN_REGIONS] = { "rain_regions", NULL },
+    [LAYER_STAR_REGIONS] = { "star_regions", NULL },
+    [LAYER_OCEAN_WORLD_AREA] = { "ocean_world_area", NULL },
+    [LAYER_SPACE_WORLD_AREA] = { "space_world_area", NULL },
+};
+
+// Byte layout of one layer in the source file
+typedef struct {
+    cJSON *json;              // GetLayerJSON() at index time, NULL if the layer is absent
+    JsonSpan span;            // The layer's array, or the object itself for world areas
+    cJSON **elements;         // Elements in source order
+    JsonSpan *spans;
+    int count;
+    char indent[MAX_INDENT];  // Leading whitespace of the first element's line
+    bool formatted;           // Elements span several lines
+} LayerIndex;
+
+// A changed element of a layer that kept its element order
+typedef struct {
+    EditLayer layer;
+    int index;
+    char *text;
+    size_t length;
+    JsonSpan newSpan;
+} Patch;
+
+// Where a layer ends up in the written file
+typedef struct {
+    bool structural;          // Elements were added, removed or reordered
+    JsonSpan newSpan;
+    cJSON **elements;         // Rebuilt index of a structural layer
+    JsonSpan *spans;
+    int count;
+    int capacity;
+} LayerOutput;
+
+// Copies source ranges and new text into the target, merging adjacent source ranges
+// so untouched parts of the file move in large sequential blocks
+typedef struct {
+    FILE *source;
+    FILE *target;
+    unsigned char *buffer;
+    size_t sourcePos;         // Read position of the source file
+    size_t pendingStart;      // Source range that still has to be copied
+    size_t pendingEnd;
+    size_t written;           // Output size, including the pending range
+    bool failed;
+} SpliceWriter;
+
+// Element spans of a source text, found before they are paired with the parsed elements
+struct ExportSourceScan {
+    bool valid;
+    bool found[LAYER_COUNT];
+    bool scanned[LAYER_COUNT];
+    LayerIndex layers[LAYER_COUNT];
+};
+
+static LayerIndex _layers[LAYER_COUNT] = { 0 };
+static bool _indexed = false;
+static char _sourcePath[MAX_EXPORT_PATH] = { 0 };
+static int64_t _sourceSize = 0;
+static int64_t _sourceModTime = 0;
+static uint64_t _baseVersion = 0;  // Changes after this version are not in the source file yet
+
+//------------------------------------------------------------------------------------
+// Source index
+//------------------------------------------------------------------------------------
+static void FreeLayerIndex(LayerIndex *layer)
+{
+    MemFree(layer->elements);
+    MemFree(layer->spans);
+    *layer = (LayerIndex){ 0 };
+}
+
+// Finds the element spans of one layer; the elements are paired with them later by BindLayer()
+static bool ScanLayer(LayerIndex *layer, EditLayer id, const char *text, size_t length, JsonSpan span)
+{
+    if (_layerKeys[id][1] != NULL && !JsonFindMember(text, length, span, _layerKeys[id][1], &span)) return false;
+    layer->span = span;
+
+    int capacity = 0;
+    if (IsWorldAreaLayer(id))
+    {
+        if (text[span.start] != '{') return false;
+        layer->spans = MemAlloc(sizeof(JsonSpan));
+        if (layer->spans == NULL) return false;
+        layer->spans[0] = span;
+        layer->count = 1;
+    }
+    else
+    {
+        JsonIterator it;
+        if (text[span.start] != '[' || !JsonIterBegin(&it, text, length, span)) return false;
+
+        JsonSpan value;
+        while (JsonIterNext(&it, NULL, &value))
+        {
+            if (layer->count == capacity)
+            {
+                capacity = (capacity == 0) ? 256 : capacity * 2;
+                JsonSpan *spans = MemRealloc(layer->spans, sizeof(JsonSpan) * capacity);
+                if (spans == NULL) return false;
+                layer->spans = spans;
+            }
+            layer->spans[layer->count++] = value;
+        }
+    }
+
+    // Re-serialized elements are indented like the first one so the file keeps its layout
+    layer->formatted = true;
+    if (layer->count > 0)
+    {
+        size_t start = layer->spans[0].start;
+        size_t lineStart = start;
+        while (lineStart > 0 && text[lineStart - 1] != '\n') lineStart--;
+        size_t indentEnd = lineStart;
+        while (indentEnd < start && indentEnd - lineStart < MAX_INDENT - 1 && (text[indentEnd] == ' ' || text[indentEnd] == '\t')) indentEnd++;
+        memcpy(layer->indent, text + lineStart, indentEnd - lineStart);
+        layer->indent[indentEnd - lineStart] = '\0';
+        layer->formatted = memchr(text + start, '\n', layer->spans[0].end - start) != NULL;
+    }
+    return true;
+}
+
+// Pairs the scanned spans with the parsed elements; any disagreement disables splicing
+static bool BindLayer(EditLayer id, LayerIndex *scanned)
+{
+    LayerIndex *layer = &_layers[id];
+    *layer = *scanned;
+    *scanned = (LayerIndex){ 0 };
+    layer->json = GetLayerJSON(id);
+
+    int count = IsWorldAreaLayer(id) ? 1 : cJSON_GetArraySize(layer->json);
+    if (count != layer->count) return false;
+    layer->elements = MemAlloc(sizeof(cJSON *) * (count > 0 ? count : 1));
+    if (layer->elements == NULL) return false;
+
+    if (IsWorldAreaLayer(id)) layer->elements[0] = layer->json;
+    else
+    {
+        int i = 0;
+        cJSON *element = NULL;
+        cJSON_ArrayForEach(element, layer->json) layer->elements[i++] = element;
+    }
+    return true;
+}
+
+ExportSourceScan *ExportScanSource(const char *text, size_t length)
+{
+    ExportSourceScan *scan = MemCalloc(1, sizeof(ExportSourceScan));
+    if (scan == NULL) return NULL;
+
+    JsonSpan root;
+    JsonIterator it;
+    scan->valid = JsonScanValue(text, length, JsonSkipWhitespace(text, length, 0), &root) && JsonIterBegin(&it, text, length, root) && it.object;
+
+    // One pass over the top-level members; the first matching key wins, as in cJSON_GetObjectItem()
+    JsonSpan key, value;
+    while (scan->valid && JsonIterNext(&it, &key, &value))
+    {
+        for (int i = 0; i < LAYER_COUNT; i++)
+        {
+            if (scan->found[i] || !JsonKeyEquals(text, key, _layerKeys[i][0])) continue;
+            scan->found[i] = true;
+            scan->scanned[i] = ScanLayer(&scan->layers[i], (EditLayer)i, text, length, value);
+        }
+    }
+    return scan;
+}
+
+void ExportFreeScan(ExportSourceScan *scan)
+{
+    if (scan == NULL) return;
+    for (int i = 0; i < LAYER_COUNT; i++) FreeLayerIndex(&scan->layers[i]);
+    MemFree(scan);
+}
+
+void ExportIndexScanned(const char *path, ExportSourceScan *scan, size_t length)
+{
+    ExportClear();
+    snprintf(_sourcePath, sizeof(_sourcePath), "%s", path);
+    _baseVersion = ChangesGetVersion();
+
+    bool valid = scan != NULL && scan->valid && GetFileIdentity(path, &_sourceSize, &_sourceModTime) && _sourceSize == (int64_t)length;
+    for (int i = 0; i < LAYER_COUNT && valid; i++)
+    {
+        if (GetLayerJSON((EditLayer)i) != NULL) valid = scan->found[i] && scan->scanned[i] && BindLayer((EditLayer)i, &scan->layers[i]);
+    }
+    ExportFreeScan(scan);
+
+    if (valid) _indexed = true;
+    else ExportClear();
+}
+
+void ExportIndexSource(const char *path, const char *text, size_t length)
+{
+    ProfileBegin("index spans");
+    ExportIndexScanned(path, ExportScanSource(text, length), length);
+    ProfileEnd();
+}
+
+uint64_t ExportGetSavedVersion(void)
+{
+    return _baseVersion;
+}
+
+void ExportClear(void)
+{
+    for (int i = 0; i < LAYER_COUNT; i++) FreeLayerIndex(&_layers[i]);
+    _indexed = false;
+}
+
+//------------------------------------------------------------------------------------
+// Splicing
+//------------------------------------------------------------------------------------
+static void FlushPending(SpliceWriter *writer)
+{
+    size_t pos = writer->pendingStart;
+    if (pos < writer->pendingEnd && !writer->failed)
+    {
+        if (writer->sourcePos != pos && fseek(writer->source, (long)pos, SEEK_SET) != 0) writer->failed = true;
+        while (!writer->failed && pos < writer->pendingEnd)
+        {
+            size_t chunk = writer->pendingEnd - pos;
+            if (chunk > COPY_BUFFER_SIZE) chunk = COPY_BUFFER_SIZE;
+            if (fread(writer->buffer, 1, chunk, writer->source) != chunk || fwrite(writer->buffer, 1, chunk, writer->target) != chunk) writer->failed = true;
+            pos += chunk;
+        }
+        writer->sourcePos = pos;
+    }
+    writer->pendingStart = 0;
+    writer->pendingEnd = 0;
+}
+
+static void CopySource(SpliceWriter *writer, size_t start, size_t end)
+{
+    if (end <= start) return;
+    if (writer->pendingEnd != start || writer->pendingEnd == writer->pendingStart)
+    {
+        FlushPending(writer);
+        writer->pendingStart = start;
+    }
+    writer->pendingEnd = end;
+    writer->written += end - start;
+}
+
+static void WriteText(SpliceWriter *writer, const char *text, size_t length)
+{
+    FlushPending(writer);
+    if (!writer->failed && length > 0 && fwrite(text, 1, length, writer->target) != length) writer->failed = true;
+    writer->written += length;
+}
+
+// Serializes an element like a full export would and indents it to its place in the file
+static char *SerializeElement(const LayerIndex *layer, const cJSON *element, size_t *length)
+{
+    char *printed = layer->formatted ? cJSON_Print(element) : cJSON_PrintUnformatted(element);
+    if (printed == NULL) return NULL;
+
+    size_t indentLength = strlen(layer->indent);
+    size_t printedLength = 0;
+    size_t lines = 0;
+    for (const char *c = printed; *c != '\0'; c++, printedLength++)
+    {
+        if (*c == '\n') lines++;
+    }
+
+    char *text = MemAlloc(printedLength + lines * indentLength + 1);
+    if (text != NULL)
+    {
+        char *out = text;
+        for (const char *c = printed; *c != '\0'; c++)
+        {
+            *out++ = *c;
+            if (*c == '\n')
+            {
+                memcpy(out, layer->indent, indentLength);
+                out += indentLength;
+            }
+        }
+        *out = '\0';
+        *length = (size_t)(out - text);
+    }
+    cJSON_free(printed);
+    return text;
+}
+
+// Elements still in source order means indices and spans line up one to one
+static bool SequenceMatches(EditLayer id)
+{
+    const LayerIndex *layer = &_layers[id];
+    if (IsWorldAreaLayer(id)) return true;
+
+    int i = 0;
+    cJSON *element = layer->json->child;
+    for (; element != NULL && i < layer->count; element = element->next, i++)
+    {
+        if (element != layer->elements[i]) return false;
+    }
+    return element == NULL && i == layer->count;
+}
+
+static bool AppendOutput(LayerOutput *out, cJSON *element, JsonSpan span)
+{
+    if (out->count == out->capacity)
+    {
+        int newCapacity = (out->capacity == 0) ? 1024 : out->capacity * 2;
+        cJSON **elements = MemRealloc(out->elements, sizeof(cJSON *) * newCapacity);
+        if (elements == NULL) return false;
+        out->elements = elements;
+        JsonSpan *spans = MemRealloc(out->spans, sizeof(JsonSpan) * newCapacity);
+        if (spans == NULL) return false;
+        out->spans = spans;
+        out->capacity = newCapacity;
+    }
+    out->elements[out->count] = element;
+    out->spans[out->count] = span;
+    out->count++;
+    return true;
+}
+
+// Re-emits an array whose elements were added, removed or reordered. Clean elements are
+// still copied from the source, along with the separator before them whenever their
+// source predecessor also precedes them in the output.
+static void EmitStructuralLayer(SpliceWriter *writer, EditLayer id, LayerOutput *out)
+{
+    const LayerIndex *layer = &_layers[id];
+    size_t contentStart = layer->span.start + 1;
+    size_t contentEnd = layer->span.end - 1;
+    CopySource(writer, layer->span.start, contentStart);
+
+    PointerMap sourceIndex = { 0 };
+    for (int j = 0; j < layer->count && !writer->failed; j++)
+    {
+        if (!PointerMapPut(&sourceIndex, PointerKey(layer->elements[j]), j)) writer->failed = true;
+    }
+
+    int previous = -2;
+    cJSON *element = NULL;
+    cJSON_ArrayForEach(element, layer->json)
+    {
+        if (writer->failed) break;
+
+        int j = (int)PointerMapGet(&sourceIndex, PointerKey(element), -1);
+        bool clean = (j >= 0) && ChangesGetElementVersion(element) <= _baseVersion;
+
+        // Whitespace before the first element doubles as the separator after a comma
+        if (out->count == 0) CopySource(writer, contentStart, layer->spans[0].start);
+        else if (j >= 0 && j == previous + 1) CopySource(writer, layer->spans[previous].end, layer->spans[j].start);
+        else
+        {
+            WriteText(writer, ",", 1);
+            CopySource(writer, contentStart, layer->spans[0].start);
+        }
+
+        size_t start = writer->written;
+        if (clean) CopySource(writer, layer->spans[j].start, layer->spans[j].end);
+        else
+        {
+            size_t length = 0;
+            char *text = SerializeElement(layer, element, &length);
+            if (text == NULL) { writer->failed = true; break; }
+            WriteText(writer, text, length);
+            MemFree(text);
+        }
+        if (!AppendOutput(out, element, (JsonSpan){ start, writer->written })) writer->failed = true;
+        previous = (j >= 0) ? j : -2;
+    }
+
+    if (out->count > 0) CopySource(writer, layer->spans[layer->count - 1].end, contentEnd);
+    CopySource(writer, contentEnd, layer->span.end);
+    PointerMapFree(&sourceIndex);
+}
+
+static bool Splice(const char *path, const EditLayer *order, int orderCount, LayerOutput *outputs, Patch *patches, int patchCount)
+{
+    char tempPath[MAX_EXPORT_PATH + 8];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    SpliceWriter writer = { 0 };
+    writer.source = fopen(_sourcePath, "rb");
+    writer.target = fopen(tempPath, "wb");
+    writer.buffer = MemAlloc(COPY_BUFFER_SIZE);
+    writer.failed = (writer.source == NULL || writer.target == NULL || writer.buffer == NULL);
+
+    size_t cursor = 0;
+    int p = 0;
+    for (int o = 0; o < orderCount && !writer.failed; o++)
+    {
+        EditLayer id = order[o];
+        const LayerIndex *layer = &_layers[id];
+        LayerOutput *out = &outputs[id];
+
+        CopySource(&writer, cursor, layer->span.start);
+        out->newSpan.start = writer.written;
+        if (out->structural) EmitStructuralLayer(&writer, id, out);
+        else
+        {
+            cursor = layer->span.start;
+            for (; p < patchCount && patches[p].layer == id; p++)
+            {
+                JsonSpan old = layer->spans[patches[p].index];
+                CopySource(&writer, cursor, old.start);
+                patches[p].newSpan.start = writer.written;
+                WriteText(&writer, patches[p].text, patches[p].length);
+                patches[p].newSpan.end = writer.written;
+                cursor = old.end;
+            }
+            CopySource(&writer, cursor, layer->span.end);
+        }
+        cursor = layer->span.end;
+        out->newSpan.end = writer.written;
+    }
+    CopySource(&writer, cursor, (size_t)_sourceSize);
+    FlushPending(&writer);
+
+    if (!writer.failed) SyncFile(writer.target);
+    if (writer.source) fclose(writer.source);
+    if (writer.target && fclose(writer.target) != 0) writer.failed = true;
+    MemFree(writer.buffer);
+
+    if (writer.failed)
+    {
+        remove(tempPath);
+        return false;
+    }
+    printf("Spliced %zu bytes, %d elements re-serialized.\n", writer.written, patchCount);
+    return ReplaceFile(tempPath, path);
+}
+
+static bool PatchInPlace(const char *path, const EditLayer *order, int orderCount, LayerOutput *outputs, Patch *patches, int patchCount)
+{
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL) return false;
+
+    bool written = true;
+    for (int p = 0; p < patchCount && written; p++)
+    {
+        patches[p].newSpan = _layers[patches[p].layer].spans[patches[p].index];
+        written = fseek(file, (long)patches[p].newSpan.start, SEEK_SET) == 0 && fwrite(patches[p].text, 1, patches[p].length, file) == patches[p].length;
+    }
+    if (written) SyncFile(file);
+    written = (fclose(file) == 0) && written;
+
+    for (int o = 0; o < orderCount; o++) outputs[order[o]].newSpan = _layers[order[o]].span;
+    if (written) printf("Patched %d elements in place.\n", patchCount);
+    return written;
+}
+
+// Moves the index over to the file that was just written
+static void ApplyOutputs(const EditLayer *order, int orderCount, LayerOutput *outputs, const Patch *patches, int patchCount)
+{
+    int p = 0;
+    for (int o = 0; o < orderCount; o++)
+    {
+        LayerIndex *layer = &_layers[order[o]];
+        LayerOutput *out = &outputs[order[o]];
+
+        if (out->structural)
+        {
+            MemFree(layer->elements);
+            MemFree(layer->spans);
+            layer->elements = out->elements;
+            layer->spans = out->spans;
+            layer->count = out->count;
+            out->elements = NULL;
+            out->spans = NULL;
+        }
+        else
+        {
+            // Clean elements shift by the size change of everything written before them
+            long long delta = (long long)out->newSpan.start - (long long)layer->span.start;
+            bool patched = (p < patchCount && patches[p].layer == order[o]);
+            for (int j = 0; j < layer->count && (delta != 0 || patched); j++)
+            {
+                if (p < patchCount && patches[p].layer == order[o] && patches[p].index == j)
+                {
+                    delta = (long long)patches[p].newSpan.end - (long long)layer->spans[j].end;
+                    layer->spans[j] = patches[p].newSpan;
+                    p++;
+                }
+                else
+                {
+                    layer->spans[j].start = (size_t)((long long)layer->spans[j].start + delta);
+                    layer->spans[j].end = (size_t)((long long)layer->spans[j].end + delta);
+                }
+                patched = (p < patchCount && patches[p].layer == order[o]);
+            }
+        }
+        layer->span = out->newSpan;
+    }
+}
+
+static bool AddPatch(Patch **patches, int *count, int *capacity, EditLayer id, int j)
+{
+    if (*count == *capacity)
+    {
+        int newCapacity = (*capacity == 0) ? 16 : *capacity * 2;
+        Patch *resized = MemRealloc(*patches, sizeof(Patch) * newCapacity);
+        if (resized == NULL) return false;
+        *patches = resized;
+        *capacity = newCapacity;
+    }
+    Patch *patch = &(*patches)[*count];
+    *patch = (Patch){ id, j, NULL, 0, { 0, 0 } };
+    patch->text = SerializeElement(&_layers[id], _layers[id].elements[j], &patch->length);
+    if (patch->text == NULL) return false;
+    (*count)++;
+    return true;
+}
+
+static int ComparePatches(const void *a, const void *b)
+{
+    const Patch *left = a;
+    const Patch *right = b;
+    return (left->index > right->index) - (left->index < right->index);
+}
+
+static bool ExportIncremental(const char *path)
+{
+    // Without every change since the source was read, splicing could lose edits
+    if (!_indexed || !ChangesComplete(_baseVersion)) return false;
+
+    // The source must still be the file the spans were taken from
+    int64_t size = 0, modTime = 0;
+    if (!GetFileIdentity(_sourcePath, &size, &modTime) || size != _sourceSize || modTime != _sourceModTime) return false;
+
+    EditLayer order[LAYER_COUNT];
+    int orderCount = 0;
+    for (int i = 0; i < LAYER_COUNT; i++)
+    {
+        if (GetLayerJSON((EditLayer)i) != _layers[i].json) return false;
+        if (_layers[i].json == NULL) continue;
+
+        int o = orderCount++;
+        while (o > 0 && _layers[order[o - 1]].span.start > _layers[i].span.start) { order[o] = order[o - 1]; o--; }
+        order[o] = (EditLayer)i;
+    }
+
+    LayerOutput outputs[LAYER_COUNT] = { 0 };
+    Patch *patches = NULL;
+    int patchCount = 0, patchCapacity = 0;
+    bool valid = true, sameLength = true, structural = false;
+
+    for (int o = 0; o < orderCount && valid; o++)
+    {
+        EditLayer id = order[o];
+        LayerIndex *layer = &_layers[id];
+        bool restructured = ChangesGetStructureVersion(id) > _baseVersion;
+        outputs[id].structural = restructured && !SequenceMatches(id);
+        structural |= outputs[id].structural;
+
+        // An array that was empty in the source has no whitespace to copy around new elements
+        if (outputs[id].structural && layer->count == 0) valid = false;
+        if (outputs[id].structural || ChangesGetLayerVersion(id) <= _baseVersion) continue;
+
+        int first = patchCount;
+        if (restructured)
+        {
+            // Elements came and went but the order is back to the source's, so the recorded
+            // indices may be stale; check every element instead
+            for (int j = 0; j < layer->count && valid; j++)
+            {
+                if (ChangesGetElementVersion(layer->elements[j]) > _baseVersion) valid = AddPatch(&patches, &patchCount, &patchCapacity, id, j);
+            }
+        }
+        else
+        {
+            // Indices are unchanged since the source was indexed, so the change log names the patches
+            ChangeIterator it = ChangesBegin(_baseVersion);
+            ElementChange change;
+            while (valid && ChangesNext(&it, &change))
+            {
+                if (change.layer != id) continue;
+                valid = change.index >= 0 && change.index < layer->count && layer->elements[change.index] == change.element &&
+                        AddPatch(&patches, &patchCount, &patchCapacity, id, change.index);
+            }
+            if (valid) qsort(patches + first, patchCount - first, sizeof(Patch), ComparePatches);
+        }
+        for (int p = first; p < patchCount; p++)
+        {
+            sameLength &= (patches[p].length == layer->spans[patches[p].index].end - layer->spans[patches[p].index].start);
+        }
+    }
+
+    bool written = false;
+    bool isSource = strcmp(path, _sourcePath) == 0;
+    if (valid)
+    {
+        if (isSource && !structural && patchCount == 0)
+        {
+            printf("No changes since the last export.\n");
+            written = true;
+        }
+        else if (isSource && !structural && sameLength) written = PatchInPlace(path, order, orderCount, outputs, patches, patchCount);
+        else written = Splice(path, order, orderCount, outputs, patches, patchCount);
+    }
+
+    if (written && isSource)
+    {
+        ApplyOutputs(order, orderCount, outputs, patches, patchCount);
+        GetFileIdentity(_sourcePath, &_sourceSize, &_sourceModTime);
+        _baseVersion = ChangesGetVersion();
+    }
+
+    for (int i = 0; i < patchCount; i++) MemFree(patches[i].text);
+    MemFree(patches);
+    for (int i = 0; i < LAYER_COUNT; i++)
+    {
+        MemFree(outputs[i].elements);
+        MemFree(outputs[i].spans);
+    }
+    return written;
+}
+
+static bool ExportFull(const char *path)
+{
+    ProfileBegin("serialize");
+    char *jsonString = cJSON_PrintBuffered(_configJson, PRINT_PREBUFFER, 1);
+    ProfileEnd();
+    if (jsonString == NULL)
+    {
+        printf("ERROR: Failed to generate JSON string.\n");
+        return false;
+    }
+
+    size_t length = strlen(jsonString);
+    ProfileBegin("write file");
+    bool written = WriteFileAtomic(path, jsonString, length);
+    ProfileEnd();
+
+    // The new file becomes the source for the next incremental export
+    if (written && strcmp(path, _sourcePath) == 0) ExportIndexSource(path, jsonString, length);
+    cJSON_free(jsonString);
+    return written;
+}
+
+bool ExportDocument(const char *path)
+{
+    if (_configJson == NULL) return false;
+
+    ProfileBegin("splice");
+    bool written = ExportIncremental(path);
+    ProfileEnd();
+    return written || ExportFull(path);
+}
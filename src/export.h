@@ -0,0 +1,65 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+typedef struct ExportSourceScan ExportSourceScan;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Incremental export. The loader records where every layer element sits in the config file;
+// the exporter then copies untouched byte ranges verbatim and only re-serializes elements
+// that changed since the file was read or written, as told by the change versions. It falls
+// back to a full serialization when the file changed on disk or the layout could not be indexed.
+
+/**
+ * @brief Records the byte span of every layer element in the text the document was parsed from.
+ *        Call after the layer pointers have been resolved and before any edit is applied.
+ * @param path Path of the file the text was read from.
+ * @param text The exact bytes of the file.
+ * @param length Size of text in bytes.
+ */
+void ExportIndexSource(const char *path, const char *text, size_t length);
+
+/**
+ * @brief The part of ExportIndexSource() that only reads the text, so it can run on another thread.
+ * @return The element spans for ExportIndexScanned(), or NULL if out of memory.
+ */
+ExportSourceScan *ExportScanSource(const char *text, size_t length);
+
+/**
+ * @brief Finishes ExportIndexSource() with the spans of ExportScanSource(). Takes ownership of scan.
+ * @param length Size of the text that was scanned.
+ */
+void ExportIndexScanned(const char *path, ExportSourceScan *scan, size_t length);
+
+/**
+ * @brief Frees a scan that is not passed on to ExportIndexScanned().
+ */
+void ExportFreeScan(ExportSourceScan *scan);
+
+/**
+ * @brief Writes the document to path. Only changed elements are re-serialized, everything else is
+ *        copied from the indexed source. When path is the source itself and every changed element
+ *        keeps its length, the file is patched in place instead of rewritten.
+ * @return true if the file was written.
+ */
+bool ExportDocument(const char *path);
+
+/**
+ * @brief Returns the change version the source file was last read or written at. Changes after
+ *        it are not saved yet.
+ */
+uint64_t ExportGetSavedVersion(void);
+
+/**
+ * @brief Frees the source index.
+ */
+void ExportClear(void);
+
+#endif // EXPORT_H
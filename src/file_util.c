@@ -0,0 +1,71 @@
+#include "file_util.h"
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <io.h>
+// Declared here instead of including windows.h, which clashes with raylib names
+__declspec(dllimport) int __stdcall MoveFileExA(const char *existingName, const char *newName, unsigned long flags);
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define MOVEFILE_WRITE_THROUGH 0x8
+#else
+#include <unistd.h>
+#endif
+
+#define MAX_TEMP_PATH 4096
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+void SyncFile(FILE *file)
+{
+    fflush(file);
+#if defined(_WIN32)
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+bool GetFileIdentity(const char *path, int64_t *size, int64_t *modTime)
+{
+    struct stat info;
+    if (stat(path, &info) != 0) return false;
+    *size = (int64_t)info.st_size;
+#if defined(__linux__)
+    *modTime = (int64_t)info.st_mtim.tv_sec * 1000000000 + (int64_t)info.st_mtim.tv_nsec;
+#else
+    *modTime = (int64_t)info.st_mtime;
+#endif
+    return true;
+}
+
+bool ReplaceFile(const char *tempPath, const char *path)
+{
+    // One step that either replaces the file or leaves it alone; rename() does not overwrite on Windows
+#if defined(_WIN32)
+    bool replaced = MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool replaced = rename(tempPath, path) == 0;
+#endif
+    // The original is still in place when this fails, so only the copy is lost
+    if (!replaced) remove(tempPath);
+    return replaced;
+}
+
+bool WriteFileAtomic(const char *path, const char *data, size_t length)
+{
+    char tempPath[MAX_TEMP_PATH];
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", path) >= (int)sizeof(tempPath)) return false;
+
+    FILE *file = fopen(tempPath, "wb");
+    if (file == NULL) return false;
+    bool written = fwrite(data, 1, length, file) == length;
+    if (written) SyncFile(file);
+    written = (fclose(file) == 0) && written;
+    if (!written)
+    {
+        remove(tempPath);
+        return false;
+    }
+    return ReplaceFile(tempPath, path);
+}
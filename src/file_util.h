@@ -0,0 +1,39 @@
+#ifndef FILE_UTIL_H
+#define FILE_UTIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// File helpers shared by everything that writes the config or files next to it.
+
+/**
+ * @brief Flushes a file and waits until its data is on disk.
+ */
+void SyncFile(FILE *file);
+
+/**
+ * @brief Gets the size and modification time that tell one version of a file from another.
+ *        The time is in nanoseconds where the platform has them, so a rewrite within the
+ *        same second is still told apart.
+ * @return false if the file does not exist.
+ */
+bool GetFileIdentity(const char *path, int64_t *size, int64_t *modTime);
+
+/**
+ * @brief Moves a fully written and synced temporary file over path in one step. If that
+ *        fails the original is left as it was and the temporary file is removed.
+ */
+bool ReplaceFile(const char *tempPath, const char *path);
+
+/**
+ * @brief Writes data to <path>.tmp, syncs it and moves it over path, so a crash leaves
+ *        either the old file or the new one.
+ */
+bool WriteFileAtomic(const char *path, const char *data, size_t length);
+
+#endif // FILE_UTIL_H
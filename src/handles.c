@@ -0,0 +1,199 @@
+#include "handles.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "pointer_map.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    const cJSON *element;  // NULL while the slot is free
+    uint32_t generation;
+    EditLayer layer;
+    int index;             // Array index, valid while indexEpoch matches the layer's epoch
+    uint32_t indexEpoch;
+    uint32_t nextFree;     // Free list link, 0 ends the list
+} HandleSlot;
+
+// Dense position -> element table of one layer
+typedef struct {
+    cJSON **elements;
+    int count;
+    int capacity;
+    uint32_t epoch;        // Bumped on every structural change
+    uint32_t builtEpoch;   // Epoch the table and the slot indices were last rebuilt for
+} LayerTable;
+
+static HandleSlot *_slots = NULL;
+static uint32_t _slotCount = 1; // Slot 0 is reserved for the zeroed handle
+static uint32_t _slotCapacity = 0;
+static uint32_t _freeSlots = 0;
+static LayerTable _tables[LAYER_COUNT] = { 0 };
+static PointerMap _map = { 0 };  // Element pointer to its slot
+
+//------------------------------------------------------------------------------------
+// Layer tables
+//------------------------------------------------------------------------------------
+
+// Rebuilds the position table of a layer and the index of every slot in it
+static LayerTable *GetLayerTable(EditLayer layer)
+{
+    LayerTable *table = &_tables[layer];
+    if (table->epoch == 0) table->epoch = 1;
+    if (table->builtEpoch == table->epoch) return table;
+
+    cJSON *json = GetLayerJSON(layer);
+    int count = IsWorldAreaLayer(layer) ? (json != NULL) : cJSON_GetArraySize(json);
+    if (count > table->capacity)
+    {
+        cJSON **elements = MemRealloc(table->elements, sizeof(cJSON *) * count);
+        if (elements == NULL) return NULL;
+        table->elements = elements;
+        table->capacity = count;
+    }
+
+    table->count = 0;
+    if (IsWorldAreaLayer(layer))
+    {
+        if (json) table->elements[table->count++] = json;
+    }
+    else
+    {
+        cJSON *element = NULL;
+        cJSON_ArrayForEach(element, json) table->elements[table->count++] = element;
+    }
+
+    if (_map.count > 0)
+    {
+        for (int i = 0; i < table->count; i++)
+        {
+            uint32_t slot = (uint32_t)PointerMapGet(&_map, PointerKey(table->elements[i]), 0);
+            if (slot == 0) continue;
+            _slots[slot].index = i;
+            _slots[slot].indexEpoch = table->epoch;
+        }
+    }
+    table->builtEpoch = table->epoch;
+    return table;
+}
+
+static uint32_t AllocateSlot(void)
+{
+    if (_freeSlots != 0)
+    {
+        uint32_t slot = _freeSlots;
+        _freeSlots = _slots[slot].nextFree;
+        return slot;
+    }
+
+    if (_slotCount >= _slotCapacity)
+    {
+        uint32_t capacity = (_slotCapacity == 0) ? 256 : _slotCapacity * 2;
+        HandleSlot *slots = MemRealloc(_slots, sizeof(HandleSlot) * capacity);
+        if (slots == NULL) return 0;
+        _slots = slots;
+        _slotCapacity = capacity;
+        if (_slotCount == 1) _slots[0] = (HandleSlot){ 0 };
+    }
+    _slots[_slotCount] = (HandleSlot){ .generation = 1 };
+    return _slotCount++;
+}
+
+// Returns the slot of a handle if it is current and its element is in the document
+static HandleSlot *ResolveSlot(ElementHandle handle)
+{
+    if (handle.slot == 0 || handle.slot >= _slotCount) return NULL;
+
+    HandleSlot *slot = &_slots[handle.slot];
+    if (slot->element == NULL || slot->generation != handle.generation) return NULL;
+
+    LayerTable *table = GetLayerTable(slot->layer);
+    if (table == NULL || slot->indexEpoch != table->epoch) return NULL;
+    return slot;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+ElementHandle HandleAt(EditLayer layer, int index)
+{
+    LayerTable *table = GetLayerTable(layer);
+    if (table == NULL || index < 0 || index >= table->count) return (ElementHandle){ 0 };
+
+    cJSON *element = table->elements[index];
+    uint32_t slot = (uint32_t)PointerMapGet(&_map, PointerKey(element), 0);
+    if (slot == 0)
+    {
+        slot = AllocateSlot();
+        if (slot == 0) return (ElementHandle){ 0 };
+        if (!PointerMapPut(&_map, PointerKey(element), slot))
+        {
+            _slots[slot].nextFree = _freeSlots;
+            _freeSlots = slot;
+            return (ElementHandle){ 0 };
+        }
+        _slots[slot].element = element;
+        _slots[slot].layer = layer;
+    }
+    _slots[slot].index = index;
+    _slots[slot].indexEpoch = table->epoch;
+    return (ElementHandle){ slot, _slots[slot].generation };
+}
+
+cJSON *HandleResolve(ElementHandle handle)
+{
+    HandleSlot *slot = ResolveSlot(handle);
+    return slot ? (cJSON *)slot->element : NULL;
+}
+
+int HandleGetIndex(ElementHandle handle)
+{
+    HandleSlot *slot = ResolveSlot(handle);
+    return slot ? slot->index : -1;
+}
+
+bool HandleEquals(ElementHandle a, ElementHandle b)
+{
+    return a.slot == b.slot && a.generation == b.generation;
+}
+
+void HandleLayerChanged(EditLayer layer)
+{
+    if (layer < 0 || layer >= LAYER_COUNT) return;
+    if (_tables[layer].epoch == 0) _tables[layer].epoch = 1;
+    _tables[layer].epoch++;
+    ChangesMarkStructure(layer);
+}
+
+void HandleRelease(const cJSON *element)
+{
+    if (element == NULL) return;
+
+    uint32_t slot = (uint32_t)PointerMapGet(&_map, PointerKey(element), 0);
+    if (slot == 0) return;
+
+    PointerMapRemove(&_map, PointerKey(element));
+    _slots[slot].element = NULL;
+    _slots[slot].generation++;
+    _slots[slot].nextFree = _freeSlots;
+    _freeSlots = slot;
+}
+
+void HandlesClear(void)
+{
+    // Slots keep their generations so handles from the previous document stay stale
+    for (uint32_t i = 1; i < _slotCount; i++)
+    {
+        if (_slots[i].element == NULL) continue;
+        _slots[i].element = NULL;
+        _slots[i].generation++;
+        _slots[i].nextFree = _freeSlots;
+        _freeSlots = i;
+    }
+    PointerMapFree(&_map);
+
+    for (int i = 0; i < LAYER_COUNT; i++)
+    {
+        MemFree(_tables[i].elements);
+        _tables[i] = (LayerTable){ .epoch = _tables[i].epoch + 1 };
+    }
+}
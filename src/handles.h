@@ -0,0 +1,53 @@
+#ifndef HANDLES_H
+#define HANDLES_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Generation-checked element handles. A handle names a slot in a table that holds the
+// element pointer, its layer and its current array index. Slots are reused after the
+// element is freed, with a new generation, so a stale handle never resolves to the wrong
+// element. Indices are rebuilt lazily, once per layer after each structural change.
+
+/**
+ * @brief Returns the handle of the element at index in a layer, creating one on first use.
+ * @return A zeroed handle if there is no such element.
+ */
+ElementHandle HandleAt(EditLayer layer, int index);
+
+/**
+ * @brief Returns the element a handle refers to, or NULL if it was freed or is currently
+ *        detached from the document (e.g. removed and held by the undo history).
+ */
+cJSON *HandleResolve(ElementHandle handle);
+
+/**
+ * @brief Returns the current array index of the element (0 for world areas), or -1 like HandleResolve().
+ */
+int HandleGetIndex(ElementHandle handle);
+
+/**
+ * @brief Returns true if both handles refer to the same slot and generation.
+ */
+bool HandleEquals(ElementHandle a, ElementHandle b);
+
+/**
+ * @brief Must be called after elements were inserted into or detached from a layer's array.
+ *        Also bumps the layer's structure version, see ChangesGetStructureVersion().
+ */
+void HandleLayerChanged(EditLayer layer);
+
+/**
+ * @brief Must be called before a top-level element is freed. Invalidates its handle.
+ */
+void HandleRelease(const cJSON *element);
+
+/**
+ * @brief Invalidates every handle and frees the tables, e.g. when the document is reloaded.
+ */
+void HandlesClear(void);
+
+#endif // HANDLES_H
@@ -0,0 +1,689 @@
+#include "headless.h"
+#include "map_editor.h"
+#include "export.h"
+#include "handles.h"
+#include "diff.h"
+#include "parallel_parse.h"
+#include "simd_scan.h"
+#include "hit_test.h"
+#include "memtrack.h"
+#include "chunk_store.h"
+#include "connectivity.h"
+#include "duplicates.h"
+#include "region_check.h"
+#include "region_index.h"
+#include "schema.h"
+#include "search.h"
+#include "point_cache.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_DRAG_ITEMS 512
+#define BENCH_DRAG_FRAMES 60
+#define BENCH_HIT_POINTS (1 << 20)
+#define BENCH_HIT_QUERIES 16
+#define RANDOM_SEED 0x9E3779B9u
+#define REPORT_LAYER_COUNT 3
+#define REPORT_INITIAL_HITS 64      // Grown when a point lies in more regions
+#define PRINT_PREBUFFER 256         // Same as cJSON_Print(); cJSON must not grow an empty buffer
+
+static uint32_t _randomState = RANDOM_SEED;
+
+static uint32_t NextRandom(void)
+{
+    // xorshift32, so a failing iteration can be reproduced
+    _randomState ^= _randomState << 13;
+    _randomState ^= _randomState >> 17;
+    _randomState ^= _randomState << 5;
+    return _randomState;
+}
+
+static float RandomCoordinate(float range)
+{
+    return ((float)(NextRandom() >> 8) / (float)(1 << 24) * 2.0f - 1.0f) * range;
+}
+
+// Hover and marquee queries against a fixed number of random points with every SIMD level,
+// so the kernels are measured at the same size whatever the config
+static bool BenchHitTests(int iterations, double nearestTime[], double rectTime[], bool available[])
+{
+    float *xs = MemAlloc(sizeof(float) * BENCH_HIT_POINTS);
+    float *ys = MemAlloc(sizeof(float) * BENCH_HIT_POINTS);
+    uint32_t *mask = MemAlloc(sizeof(uint32_t) * HitTestMaskWords(BENCH_HIT_POINTS));
+    bool match = true;
+    if (xs && ys && mask)
+    {
+        _randomState = RANDOM_SEED;
+        for (int i = 0; i < BENCH_HIT_POINTS; i++)
+        {
+            xs[i] = RandomCoordinate(100000.0f);
+            ys[i] = RandomCoordinate(100000.0f);
+        }
+
+        SimdLevel scanLevel = SimdScanGetLevel();
+        uint64_t expected = 0;
+        for (int level = 0; level < SIMD_LEVEL_COUNT; level++)
+        {
+            available[level] = (SimdScanSetLevel((SimdLevel)level) == (SimdLevel)level);
+            if (!available[level]) continue;
+
+            // Same queries for every level, and the same answers expected
+            uint64_t checksum = 0;
+            for (int i = 0; i < iterations; i++)
+            {
+                _randomState = RANDOM_SEED + (uint32_t)i;
+                for (int q = 0; q < BENCH_HIT_QUERIES; q++)
+                {
+                    float x = RandomCoordinate(100000.0f);
+                    float y = RandomCoordinate(100000.0f);
+                    double start = ProfilerGetTime();
+                    int nearest = HitTestNearest(xs, ys, BENCH_HIT_POINTS, x, y, 500.0f);
+                    double tested = ProfilerGetTime();
+                    int inside = HitTestRect(xs, ys, BENCH_HIT_POINTS, x, y, x + 5000.0f, y + 5000.0f, mask);
+                    rectTime[level] += ProfilerGetTime() - tested;
+                    nearestTime[level] += tested - start;
+                    checksum = checksum * 31 + (uint64_t)nearest * 7 + (uint64_t)inside;
+                    for (int w = 0; w < HitTestMaskWords(BENCH_HIT_POINTS); w++) checksum = checksum * 31 + mask[w];
+                }
+            }
+            if (level == SIMD_LEVEL_SCALAR) expected = checksum;
+            else if (checksum != expected) match = false;
+        }
+        SimdScanSetLevel(scanLevel);
+    }
+    MemFree(xs);
+    MemFree(ys);
+    MemFree(mask);
+    return match;
+}
+
+static void PrintStepTime(const char *step, double totalMs, int iterations)
+{
+    printf("%-12s %10.3f ms avg over %d\n", step, totalMs / iterations, iterations);
+}
+
+int RunBenchmark(int iterations)
+{
+    double loadTime = 0.0, parseTime = 0.0, serialParseTime = 0.0, dragTime = 0.0, serializeTime = 0.0, spliceTime = 0.0;
+    double scanParseTime[SIMD_LEVEL_COUNT] = { 0 }, scanPrintTime[SIMD_LEVEL_COUNT] = { 0 };
+    double nearestTime[SIMD_LEVEL_COUNT] = { 0 }, rectTime[SIMD_LEVEL_COUNT] = { 0 };
+    bool scanLevelAvailable[SIMD_LEVEL_COUNT] = { false }, hitLevelAvailable[SIMD_LEVEL_COUNT] = { false };
+    size_t dragAllocations = 0, exportBytes = 0;
+
+    for (int i = 0; i < iterations; i++)
+    {
+        MemTrackBeginFrame();
+        ProfilerBeginFrame();
+        LoadJsonData();
+        ProfilerEndFrame();
+        loadTime += ProfilerGetScopeTime("load");
+        parseTime += ProfilerGetScopeTime("parse");
+    }
+    if (_configJson == NULL) return 1;
+
+    // Single-threaded cJSON parse of the same bytes, the baseline for the parallel parse above
+    int dataSize = 0;
+    unsigned char *fileData = LoadFileData(_filePath, &dataSize);
+    for (int i = 0; i < iterations && fileData; i++)
+    {
+        double start = ProfilerGetTime();
+        cJSON *config = cJSON_ParseWithLength((const char *)fileData, (size_t)dataSize);
+        serialParseTime += ProfilerGetTime() - start;
+        cJSON_Delete(config);
+    }
+
+    // The same parse and a formatted print with each byte scanner cJSON can use
+    SimdLevel scanLevel = SimdScanGetLevel();
+    for (int level = 0; level < SIMD_LEVEL_COUNT && fileData; level++)
+    {
+        scanLevelAvailable[level] = (SimdScanSetLevel((SimdLevel)level) == (SimdLevel)level);
+        for (int i = 0; i < iterations && scanLevelAvailable[level]; i++)
+        {
+            double start = ProfilerGetTime();
+            cJSON *config = cJSON_ParseWithLength((const char *)fileData, (size_t)dataSize);
+            double parsed = ProfilerGetTime();
+            char *jsonString = cJSON_Print(config);
+            scanPrintTime[level] += ProfilerGetTime() - parsed;
+            scanParseTime[level] += parsed - start;
+            cJSON_free(jsonString);
+            cJSON_Delete(config);
+        }
+    }
+    SimdScanSetLevel(scanLevel);
+    UnloadFileData(fileData);
+
+    bool hitTestsMatch = BenchHitTests(iterations, nearestTime, rectTime, hitLevelAvailable);
+
+    // Drag the first structures around like a group drag in Update() does, one frame at a time
+    int dragCount = cJSON_GetArraySize(_structures);
+    if (dragCount > BENCH_DRAG_ITEMS) dragCount = BENCH_DRAG_ITEMS;
+    for (int i = 0; i < iterations; i++)
+    {
+        for (int frame = 0; frame < BENCH_DRAG_FRAMES; frame++)
+        {
+            MemTrackBeginFrame();
+            ProfilerBeginFrame();
+            ProfileBegin("drag");
+            MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+            int index = 0;
+            cJSON *structure = NULL;
+            cJSON_ArrayForEach(structure, _structures)
+            {
+                if (index == dragCount) break;
+                cJSON *xItem = NULL, *yItem = NULL;
+                if (GetPointItemsJSON(structure, POINT_FIELD_LOCATION, &xItem, &yItem))
+                {
+                    SelectedItem item = { index, ELEMENT_TYPE_STRUCTURE, { 0 }, HandleAt(LAYER_STRUCTURES, index) };
+                    float step = (frame < BENCH_DRAG_FRAMES / 2) ? 1.0f : -1.0f;
+                    UpdateSelectedItemPosition(item, xItem->valuedouble + step, yItem->valuedouble);
+                }
+                index++;
+            }
+            MemPopSubsystem();
+            ProfileEnd();
+            ProfilerEndFrame();
+            MemTrackBeginFrame();
+            dragTime += ProfilerGetScopeTime("drag");
+            dragAllocations += MemGetStats(MEM_SUBSYSTEM_EDIT).frameAllocations;
+        }
+    }
+
+    for (int i = 0; i < iterations; i++)
+    {
+        ProfilerBeginFrame();
+        ProfileBegin("serialize");
+        MemPushSubsystem(MEM_SUBSYSTEM_EXPORT);
+        char *jsonString = cJSON_PrintBuffered(_configJson, PRINT_PREBUFFER, 1);
+        MemPopSubsystem();
+        ProfileEnd();
+        ProfilerEndFrame();
+        serializeTime += ProfilerGetScopeTime("serialize");
+        if (jsonString) exportBytes = MemGetStats(MEM_SUBSYSTEM_EXPORT).liveBytes;
+        cJSON_free(jsonString);
+    }
+
+    // The drag above left its structures dirty, so this splices them into a copy of the config
+    char splicePath[2048];
+    snprintf(splicePath, sizeof(splicePath), "%s.bench", _filePath);
+    for (int i = 0; i < iterations; i++)
+    {
+        ProfilerBeginFrame();
+        ProfileBegin("splice export");
+        MemPushSubsystem(MEM_SUBSYSTEM_EXPORT);
+        ExportDocument(splicePath);
+        MemPopSubsystem();
+        ProfileEnd();
+        ProfilerEndFrame();
+        spliceTime += ProfilerGetScopeTime("splice export");
+    }
+    remove(splicePath);
+
+    printf("Benchmark: %d structures, %d parse threads, %s scanner\n", cJSON_GetArraySize(_structures),
+           (_parseThreads > 0) ? _parseThreads : GetProcessorCount(), SimdLevelName(scanLevel));
+    PrintStepTime("load", loadTime, iterations);
+    PrintStepTime("parse", parseTime, iterations);
+    PrintStepTime("parse 1t", serialParseTime, iterations);
+    for (int level = 0; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (!scanLevelAvailable[level]) continue;
+        char step[32];
+        snprintf(step, sizeof(step), "parse %s", SimdLevelName((SimdLevel)level));
+        PrintStepTime(step, scanParseTime[level], iterations);
+        snprintf(step, sizeof(step), "print %s", SimdLevelName((SimdLevel)level));
+        PrintStepTime(step, scanPrintTime[level], iterations);
+    }
+    for (int level = 0; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (!hitLevelAvailable[level]) continue;
+        char step[32];
+        snprintf(step, sizeof(step), "hover %s", SimdLevelName((SimdLevel)level));
+        PrintStepTime(step, nearestTime[level], iterations * BENCH_HIT_QUERIES);
+        snprintf(step, sizeof(step), "rect %s", SimdLevelName((SimdLevel)level));
+        PrintStepTime(step, rectTime[level], iterations * BENCH_HIT_QUERIES);
+    }
+    if (!hitTestsMatch) printf("ERROR: SIMD hit tests differ from the scalar loop\n");
+    printf("hit tests: %d points per query\n", BENCH_HIT_POINTS);
+    PrintStepTime("drag frame", dragTime, iterations * BENCH_DRAG_FRAMES);
+    PrintStepTime("serialize", serializeTime, iterations);
+    PrintStepTime("splice", spliceTime, iterations);
+    printf("drag allocations per frame: %.1f (%d items)\n", (double)dragAllocations / (iterations * BENCH_DRAG_FRAMES), dragCount);
+    printf("export buffer: %zu bytes\n", exportBytes);
+    MemPrintStats();
+    return hitTestsMatch ? 0 : 1;
+}
+
+// Parses a config without making it the editor's document
+static cJSON *LoadConfigFile(const char *path)
+{
+    int size = 0;
+    unsigned char *data = LoadFileData(path, &size);
+    if (data == NULL) return NULL;
+
+    cJSON *config = ParseConfig((const char *)data, (size_t)size, _parseThreads);
+    UnloadFileData(data);
+    if (config == NULL) printf("ERROR: Failed to parse %s\n", path);
+    return config;
+}
+
+int RunDiff(const char *beforePath, const char *afterPath)
+{
+    double start = ProfilerGetTime();
+    cJSON *before = LoadConfigFile(beforePath);
+    cJSON *after = LoadConfigFile(afterPath);
+    double loaded = ProfilerGetTime();
+    if (before == NULL || after == NULL)
+    {
+        cJSON_Delete(before);
+        cJSON_Delete(after);
+        return 2;
+    }
+
+    DiffSummary summary = DiffConfigs(before, after, true);
+    double finished = ProfilerGetTime();
+    printf("%d added, %d removed, %d modified (load %.1f ms, diff %.1f ms)\n", summary.added, summary.removed, summary.modified, loaded - start, finished - loaded);
+
+    cJSON_Delete(before);
+    cJSON_Delete(after);
+    return (summary.added + summary.removed + summary.modified > 0) ? 1 : 0;
+}
+
+int RunMerge(const char *basePath, const char *oursPath, const char *theirsPath, const char *outputPath)
+{
+    double start = ProfilerGetTime();
+    cJSON *base = LoadConfigFile(basePath);
+    cJSON *ours = LoadConfigFile(oursPath);
+    cJSON *theirs = LoadConfigFile(theirsPath);
+    double loaded = ProfilerGetTime();
+
+    int result = 2;
+    if (base != NULL && ours != NULL && theirs != NULL)
+    {
+        MergeSummary summary = { 0 };
+        cJSON *merged = MergeConfigs(base, ours, theirs, &summary);
+        double finished = ProfilerGetTime();
+        char *jsonString = merged ? cJSON_PrintBuffered(merged, PRINT_PREBUFFER, 1) : NULL;
+        if (jsonString && SaveFileText(outputPath, jsonString))
+        {
+            printf("%d changes applied, %d merged field by field, %d conflicts kept ours (load %.1f ms, merge %.1f ms)\n",
+                   summary.applied, summary.merged, summary.conflicts, loaded - start, finished - loaded);
+            printf("Merged config written to %s\n", outputPath);
+            result = (summary.conflicts > 0) ? 1 : 0;
+        }
+        else printf("ERROR: Failed to write %s\n", outputPath);
+        cJSON_free(jsonString);
+        cJSON_Delete(merged);
+    }
+
+    cJSON_Delete(base);
+    cJSON_Delete(ours);
+    cJSON_Delete(theirs);
+    return result;
+}
+
+int RunSplitChunks(const char *directory, int chunkSize)
+{
+    if (_configJson == NULL) return 1;
+
+    double start = ProfilerGetTime();
+    if (!ChunkStoreSplit(_configJson, directory, chunkSize))
+    {
+        printf("ERROR: Failed to write chunks to %s\n", directory);
+        return 1;
+    }
+    printf("%d structures split into %d unit chunks in %s (%.1f ms)\n", cJSON_GetArraySize(_structures), chunkSize, directory, ProfilerGetTime() - start);
+    printf("Open %s/%s to edit it\n", directory, CHUNK_MANIFEST_NAME);
+    return 0;
+}
+
+int RunSchemaCheck(void)
+{
+    if (_configJson == NULL) return 2;
+
+    // Loading checked the config already; time a pass of its own
+    SchemaClear();
+    double start = ProfilerGetTime();
+    const SchemaReport *report = SchemaGetReport();
+    double finished = ProfilerGetTime();
+
+    char issue[SCHEMA_ISSUE_TEXT_SIZE];
+    for (int i = 0; i < report->issueCount; i++)
+    {
+        SchemaDescribeIssue(i, issue, sizeof(issue));
+        printf("invalid: %s\n", issue);
+    }
+
+    printf("%d elements: %d issues in %d elements, %d quarantined (%.2f ms)\n", report->elementCount, report->issueCount, report->invalidCount,
+           report->quarantinedCount, finished - start);
+    return (report->issueCount > 0) ? 1 : 0;
+}
+
+int RunRegionCheck(void)
+{
+    if (_configJson == NULL) return 2;
+
+    double start = ProfilerGetTime();
+    const RegionCheckResult *result = RegionCheckGet();
+    double finished = ProfilerGetTime();
+
+    for (int i = 0; i < result->overlapCount; i++)
+    {
+        const RegionOverlap *overlap = &result->overlaps[i];
+        printf("overlap: %s[%d] and %s[%d] share [%g, %g] to [%g, %g]\n", RegionLayerName(overlap->a.layer), overlap->a.index,
+               RegionLayerName(overlap->b.layer), overlap->b.index, overlap->minX, overlap->minY, overlap->maxX, overlap->maxY);
+    }
+    for (int i = 0; i < result->outsideCount; i++)
+    {
+        const RegionBox *box = &result->outside[i];
+        printf("outside the world: %s[%d] spans [%g, %g] to [%g, %g]\n", RegionLayerName(box->layer), box->index, box->minX, box->minY, box->maxX, box->maxY);
+    }
+    if (!result->hasWorld) printf("WARNING: The config has no world area, so nothing is checked for lying outside it.\n");
+
+    printf("%d regions: %d overlapping pairs, %d outside the world (%.2f ms)\n", result->regionCount, result->overlapCount, result->outsideCount, finished - start);
+    return (result->overlapCount + result->outsideCount > 0) ? 1 : 0;
+}
+
+int RunReachCheck(void)
+{
+    if (_configJson == NULL) return 2;
+
+    double start = ProfilerGetTime();
+    const ConnectivityStats *stats = ConnectivityGetStats();
+    double finished = ProfilerGetTime();
+
+    const PointSet *set = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+    for (int i = 0; i < set->count; i++)
+    {
+        if (ConnectivityIsUnreachable(i)) printf("unreachable: structure[%d] at [%g, %g]\n", i, set->xs[i], set->ys[i]);
+    }
+
+    printf("%d structures in %d components: %d unreachable (%.2f ms)\n", stats->structureCount, stats->componentCount, stats->unreachableCount, finished - start);
+    return (stats->unreachableCount > 0) ? 1 : 0;
+}
+
+static const char *LayerKey(EditLayer layer)
+{
+    switch (layer)
+    {
+        case LAYER_STRUCTURES: return "structures";
+        case LAYER_BOOST_GATES: return "boost_gates";
+        case LAYER_PORTALS: return "portals";
+        default: return RegionLayerName(layer);
+    }
+}
+
+int RunDuplicateCheck(void)
+{
+    if (_configJson == NULL) return 2;
+
+    double start = ProfilerGetTime();
+    const DuplicateStats *stats = DuplicatesFind();
+    double finished = ProfilerGetTime();
+
+    int count = 0;
+    const Duplicate *duplicates = DuplicatesGet(&count);
+    for (int i = 0; i < count; i++)
+    {
+        const Duplicate *duplicate = &duplicates[i];
+        printf("duplicate: %s[%d] of %s[%d]%s\n", LayerKey(duplicate->layer), duplicate->index, LayerKey(duplicate->layer), duplicate->original,
+               duplicate->exact ? " (exact)" : "");
+    }
+
+    int elementCount = 0;
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+    {
+        elementCount += stats->elementCounts[layer];
+        if (stats->elementCounts[layer] == 0) continue;
+        printf("%s: %d duplicates, %d exact, of %d\n", LayerKey((EditLayer)layer), stats->counts[layer], stats->exactCounts[layer], stats->elementCounts[layer]);
+    }
+    printf("%d elements: %d duplicates (%.2f ms)\n", elementCount, stats->total, finished - start);
+    return (stats->total > 0) ? 1 : 0;
+}
+
+int RunFind(const char *text)
+{
+    if (_configJson == NULL) return 2;
+
+    // The first search builds the index, the prefixes are the keystrokes of typing the text
+    double start = ProfilerGetTime();
+    int count = 0;
+    SearchFind("", &count, NULL);
+    double built = ProfilerGetTime();
+    char typed[SEARCH_QUERY_SIZE];
+    int length = 0;
+    for (; text[length] != '\0' && length < SEARCH_QUERY_SIZE - 1; length++)
+    {
+        typed[length] = text[length];
+        typed[length + 1] = '\0';
+        SearchFind(typed, &count, NULL);
+    }
+    double typedAll = ProfilerGetTime();
+
+    bool truncated = false;
+    const SearchResult *results = SearchFind(text, &count, &truncated);
+    for (int i = 0; i < count; i++)
+    {
+        Vector2 position = { 0 };
+        bool located = SearchResultPosition(results[i], &position);
+        printf("%s[%d]: %s", results[i].kind == SEARCH_REGION ? "regions" : "structures", results[i].index, SearchResultName(results[i]));
+        if (located) printf(" (%.0f, %.0f)", position.x, position.y);
+        printf("\n");
+    }
+    printf("%d%s matches (index %.2f ms, %.3f ms per keystroke)\n", count, truncated ? "+" : "", built - start, length > 0 ? (typedAll - built) / length : 0.0);
+    return (count > 0) ? 0 : 1;
+}
+
+int RunRegionReport(void)
+{
+    if (_configJson == NULL) return 2;
+
+    static const EditLayer layers[REPORT_LAYER_COUNT] = { LAYER_SNOW_REGIONS, LAYER_RAIN_REGIONS, LAYER_STAR_REGIONS };
+    int *counts[REPORT_LAYER_COUNT] = { 0 };
+    int regionCounts[REPORT_LAYER_COUNT] = { 0 };
+    int covered[REPORT_LAYER_COUNT] = { 0 };
+    int uncovered = 0;
+    int located = 0;
+    bool ok = true;
+    for (int l = 0; l < REPORT_LAYER_COUNT; l++)
+    {
+        regionCounts[l] = cJSON_GetArraySize(GetLayerJSON(layers[l]));
+        counts[l] = (int *)MemCalloc(regionCounts[l] > 0 ? (size_t)regionCounts[l] : 1, sizeof(int));
+        ok = ok && counts[l] != NULL;
+    }
+    if (!ok)
+    {
+        for (int l = 0; l < REPORT_LAYER_COUNT; l++) MemFree(counts[l]);
+        return 2;
+    }
+
+    double start = ProfilerGetTime();
+    const PointSet *set = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+    double gathered = ProfilerGetTime();
+    RegionIndexQueryPoint(0.0f, 0.0f, NULL, 0);
+    double indexed = ProfilerGetTime();
+
+    // Each structure is one point query down the region index
+    int hitCapacity = REPORT_INITIAL_HITS;
+    RegionBox *hits = (RegionBox *)MemAlloc(sizeof(RegionBox) * hitCapacity);
+    for (int i = 0; ok && i < set->count; i++)
+    {
+        if (isnan(set->xs[i]) || isnan(set->ys[i])) continue;
+        located++;
+        int found = RegionIndexQueryPoint(set->xs[i], set->ys[i], hits, hitCapacity);
+        if (found > hitCapacity)
+        {
+            RegionBox *grown = (RegionBox *)MemRealloc(hits, sizeof(RegionBox) * found);
+            if (grown != NULL)
+            {
+                hits = grown;
+                hitCapacity = found;
+                found = RegionIndexQueryPoint(set->xs[i], set->ys[i], hits, hitCapacity);
+            }
+        }
+        ok = hits != NULL && found <= hitCapacity;
+        bool in[REPORT_LAYER_COUNT] = { false };
+        for (int h = 0; ok && h < found; h++)
+        {
+            for (int l = 0; l < REPORT_LAYER_COUNT; l++)
+            {
+                if (hits[h].layer != layers[l]) continue;
+                counts[l][hits[h].index]++;
+                in[l] = true;
+            }
+        }
+        for (int l = 0; l < REPORT_LAYER_COUNT; l++) covered[l] += in[l];
+        uncovered += !(in[0] || in[1] || in[2]);
+    }
+    double finished = ProfilerGetTime();
+    MemFree(hits);
+    if (!ok)
+    {
+        printf("ERROR: Not enough memory for the region report.\n");
+        for (int l = 0; l < REPORT_LAYER_COUNT; l++) MemFree(counts[l]);
+        return 2;
+    }
+
+    for (int l = 0; l < REPORT_LAYER_COUNT; l++)
+    {
+        for (int r = 0; r < regionCounts[l]; r++) printf("%s[%d]: %d structures\n", RegionLayerName(layers[l]), r, counts[l][r]);
+        MemFree(counts[l]);
+    }
+    printf("%d structures: %d under snow, %d under rain, %d under star, %d under none (locations %.2f ms, index %.2f ms, queries %.2f ms)\n",
+           located, covered[0], covered[1], covered[2], uncovered, gathered - start, indexed - gathered, finished - indexed);
+    return 0;
+}
+
+//------------------------------------------------------------------------------------
+// Byte scanner check
+//------------------------------------------------------------------------------------
+#define SCAN_CHECK_MAX_LENGTH 1024
+
+// Bytes weighted towards the ones the scanners look for, including the edges of each class
+static unsigned char ScanCheckByte(void)
+{
+    static const unsigned char special[] = { ' ', '\t', '\n', '\r', 0x01, 0x1F, 0x20, 0x21, '"', '\\', '/', 'u', 'n', 0x7F, 0x80, 0xC3, 0xFF };
+    uint32_t r = NextRandom();
+    switch (r % 4)
+    {
+        case 0: return special[(r >> 8) % sizeof(special)];
+        case 1: return (unsigned char)(r >> 8);
+        default: return (unsigned char)('a' + (r >> 8) % 26);
+    }
+}
+
+// Random JSON-like text: runs of whitespace, tokens and strings with escapes, plus the odd stray byte
+static size_t ScanCheckText(char *text, size_t capacity)
+{
+    static const char *tokens[] = { "{", "}", "[", "]", ",", ":", "1", "-2.5e3", "true", "null", "\"", "\\\"", "\\u00e9", "\\n", "\\", "\"key\":" };
+    size_t length = 0;
+    size_t target = NextRandom() % capacity;
+    while (length < target)
+    {
+        uint32_t r = NextRandom();
+        size_t run = 1 + (r >> 8) % 40;
+        for (size_t i = 0; i < run && length < target; i++)
+        {
+            switch (r % 3)
+            {
+                case 0: text[length++] = " \t\n\r"[(NextRandom() >> 8) % 4]; break;
+                case 1: text[length++] = (char)('a' + (NextRandom() >> 8) % 26); break;
+                default: text[length++] = (char)ScanCheckByte(); break;
+            }
+        }
+        const char *token = tokens[(r >> 16) % (sizeof(tokens) / sizeof(tokens[0]))];
+        for (size_t i = 0; token[i] != '\0' && length < target; i++) text[length++] = token[i];
+    }
+    text[length] = '\0';
+    return length;
+}
+
+// Parses text and prints the result, so two levels can be compared on the same input
+static char *ScanCheckParsePrint(const char *text, size_t length, size_t *parseEnd)
+{
+    const char *end = NULL;
+    cJSON *json = cJSON_ParseWithLengthOpts(text, length, &end, false);
+    *parseEnd = (json != NULL && end != NULL) ? (size_t)(end - text) : (size_t)-1;
+    char *printed = json ? cJSON_Print(json) : NULL;
+    cJSON_Delete(json);
+    return printed;
+}
+
+int RunScanCheck(int iterations)
+{
+    static unsigned char bytes[SCAN_CHECK_MAX_LENGTH + 1];
+    static char text[4 * SCAN_CHECK_MAX_LENGTH + 1];
+    SimdLevel scanLevel = SimdScanGetLevel();
+    int failures = 0;
+    int checkedLevels = 0;
+
+    for (int level = SIMD_LEVEL_SCALAR + 1; level < SIMD_LEVEL_COUNT; level++)
+    {
+        if (SimdScanSetLevel((SimdLevel)level) != (SimdLevel)level) continue;
+        checkedLevels++;
+        _randomState = RANDOM_SEED;
+
+        for (int iteration = 0; iteration < iterations && failures < 10; iteration++)
+        {
+            // The primitives, at every start offset so each load alignment and tail length is covered
+            size_t length = NextRandom() % (SCAN_CHECK_MAX_LENGTH + 1);
+            uint32_t style = NextRandom();
+            for (size_t i = 0; i < length; i++)
+            {
+                // Long plain runs so matches also land deep inside a vector
+                bool plain = (style & 1) ? (NextRandom() % 64 != 0) : false;
+                bytes[i] = plain ? (unsigned char)(((style >> 1) & 1) ? ' ' : 'x') : ScanCheckByte();
+            }
+            for (size_t offset = 0; offset <= length; offset++)
+            {
+                const unsigned char *start = bytes + offset;
+                size_t remaining = length - offset;
+                size_t results[3] = { SimdSkipSpace(start, remaining), SimdFindQuoteOrBackslash(start, remaining), SimdFindEscape(start, remaining) };
+                SimdScanSetLevel(SIMD_LEVEL_SCALAR);
+                size_t expected[3] = { SimdSkipSpace(start, remaining), SimdFindQuoteOrBackslash(start, remaining), SimdFindEscape(start, remaining) };
+                SimdScanSetLevel((SimdLevel)level);
+                if (memcmp(results, expected, sizeof(results)) != 0)
+                {
+                    printf("FAIL %s iteration %d offset %zu: scan %zu/%zu/%zu, scalar %zu/%zu/%zu\n", SimdLevelName((SimdLevel)level), iteration, offset,
+                           results[0], results[1], results[2], expected[0], expected[1], expected[2]);
+                    failures++;
+                    break;
+                }
+            }
+
+            // Whole parse and print through cJSON, including malformed input and where parsing stops
+            size_t textLength = ScanCheckText(text, sizeof(text) - 1);
+            size_t parseEnd = 0, expectedEnd = 0;
+            char *printed = ScanCheckParsePrint(text, textLength, &parseEnd);
+            SimdScanSetLevel(SIMD_LEVEL_SCALAR);
+            char *expectedPrinted = ScanCheckParsePrint(text, textLength, &expectedEnd);
+            SimdScanSetLevel((SimdLevel)level);
+            bool match = (parseEnd == expectedEnd) && ((printed == NULL) == (expectedPrinted == NULL)) && (printed == NULL || strcmp(printed, expectedPrinted) == 0);
+            if (!match)
+            {
+                printf("FAIL %s iteration %d: parse or print of %zu bytes differs from scalar\n", SimdLevelName((SimdLevel)level), iteration, textLength);
+                failures++;
+            }
+            cJSON_free(printed);
+            cJSON_free(expectedPrinted);
+
+            // A string holding every kind of byte, printed and parsed back
+            bytes[length] = '\0';
+            cJSON *string = cJSON_CreateString((const char *)bytes);
+            char *escaped = cJSON_PrintUnformatted(string);
+            cJSON *parsed = escaped ? cJSON_Parse(escaped) : NULL;
+            if (parsed == NULL || strcmp(cJSON_GetStringValue(parsed), (const char *)bytes) != 0)
+            {
+                printf("FAIL %s iteration %d: string of %zu bytes does not round-trip\n", SimdLevelName((SimdLevel)level), iteration, strlen((const char *)bytes));
+                failures++;
+            }
+            cJSON_Delete(parsed);
+            cJSON_free(escaped);
+            cJSON_Delete(string);
+        }
+    }
+    SimdScanSetLevel(scanLevel);
+
+    printf("Scanner check: %d iterations against scalar on %d level(s), %d failures\n", iterations, checkedLevels, failures);
+    return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Benchmarks load, drag and export on the loaded config without opening a window.
+ *        Prints per-step timings and the allocation counters of every subsystem.
+ * @param iterations How many times each step is repeated.
+ * @return Process exit code.
+ */
+int RunBenchmark(int iterations);
+
+/**
+ * @brief Prints the element-level changes between two configs.
+ * @return 0 if they match, 1 if they differ, 2 on error (like diff(1)).
+ */
+int RunDiff(const char *beforePath, const char *afterPath);
+
+/**
+ * @brief Three-way merges two edited copies of a base config and writes the result.
+ * @param outputPath Where the merged config is written.
+ * @return 0 on a clean merge, 1 if there were conflicts, 2 on error.
+ */
+int RunMerge(const char *basePath, const char *oursPath, const char *theirsPath, const char *outputPath);
+
+/**
+ * @brief Writes the loaded config as a chunked world: a manifest plus one file per tile of structures.
+ * @param directory Created if it does not exist.
+ * @param chunkSize Tile width and height in world units.
+ * @return Process exit code.
+ */
+int RunSplitChunks(const char *directory, int chunkSize);
+
+/**
+ * @brief Prints every element of the loaded config that does not match the schema, with the
+ *        JSON path of each problem and whether the element is quarantined.
+ * @return 0 if there are none, 1 if there are, 2 on error.
+ */
+int RunSchemaCheck(void);
+
+/**
+ * @brief Prints every pair of overlapping snow, rain and star regions of the loaded config and
+ *        every region that is not inside the ocean or the space world area.
+ * @return 0 if there are none, 1 if there are, 2 on error.
+ */
+int RunRegionCheck(void);
+
+/**
+ * @brief Lists the structures of the loaded config that a boat cannot reach from the largest
+ *        group of connected structures, given the reach range, boost gates and portals.
+ * @return 0 if there are none, 1 if there are, 2 on error.
+ */
+int RunReachCheck(void);
+
+/**
+ * @brief Lists the elements of the loaded config that repeat an earlier element of the same
+ *        kind within the duplicate distance, and the counts per kind.
+ * @return 0 if there are none, 1 if there are, 2 on error.
+ */
+int RunDuplicateCheck(void);
+
+/**
+ * @brief Lists the structures and regions of the loaded config whose name contains text, and
+ *        times the index build and the query as it would run on each keystroke of typing it.
+ * @return 0 if there are matches, 1 if there are none, 2 on error.
+ */
+int RunFind(const char *text);
+
+/**
+ * @brief Prints how many structures lie inside each snow, rain and star region of the loaded
+ *        config, and how many lie under each kind of weather or under none.
+ * @return Process exit code.
+ */
+int RunRegionReport(void);
+
+/**
+ * @brief Differential check of the SIMD byte scanners against the scalar ones: the scan
+ *        primitives on random bytes at every offset, and cJSON parse/print on random JSON-like text.
+ * @param iterations Number of random inputs per scanner level.
+ * @return 0 if every result matched, 1 otherwise.
+ */
+int RunScanCheck(int iterations);
+
+#endif // HEADLESS_H
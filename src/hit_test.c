@@ -0,0 +1,250 @@
+#include "hit_test.h"
+#include "simd_scan.h"
+#include "memtrack.h"
+#include <stdbool.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define HIT_TEST_SSE2 1
+#include <emmintrin.h>
+#if defined(__x86_64__) || defined(__i386__)
+#define HIT_TEST_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+static uint32_t *_mask = NULL;
+static int _maskWords = 0;
+
+//------------------------------------------------------------------------------------
+// Scalar
+//------------------------------------------------------------------------------------
+// Continues a nearest search from start, keeping the earlier index on equal distances
+static int NearestScalar(const float *xs, const float *ys, int start, int count, float x, float y, int bestIndex, float bestDistance)
+{
+    for (int i = start; i < count; i++)
+    {
+        float dx = xs[i] - x;
+        float dy = ys[i] - y;
+        float distance = dx * dx + dy * dy;
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+static uint32_t RectWordScalar(const float *xs, const float *ys, int count, const float bounds[4])
+{
+    uint32_t word = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bool inside = xs[i] >= bounds[0] && xs[i] < bounds[2] && ys[i] >= bounds[1] && ys[i] < bounds[3];
+        word |= (uint32_t)inside << i;
+    }
+    return word;
+}
+
+static int CountBits(uint32_t word)
+{
+    word = word - ((word >> 1) & 0x55555555u);
+    word = (word & 0x33333333u) + ((word >> 2) & 0x33333333u);
+    return (int)((((word + (word >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// Picks the nearest of the per-lane winners, the lowest index on a tie
+static int MergeLanes(const float *distances, const int *indices, int lanes, float *bestDistance)
+{
+    int bestIndex = -1;
+    for (int lane = 0; lane < lanes; lane++)
+    {
+        if (indices[lane] < 0) continue;
+        if (bestIndex < 0 || distances[lane] < *bestDistance || (distances[lane] == *bestDistance && indices[lane] < bestIndex))
+        {
+            *bestDistance = distances[lane];
+            bestIndex = indices[lane];
+        }
+    }
+    return bestIndex;
+}
+
+//------------------------------------------------------------------------------------
+// SSE2, 4 points per step
+//------------------------------------------------------------------------------------
+#if defined(HIT_TEST_SSE2)
+static int NearestSse2(const float *xs, const float *ys, int count, float x, float y, float radiusSq)
+{
+    const __m128 px = _mm_set1_ps(x);
+    const __m128 py = _mm_set1_ps(y);
+    const __m128i step = _mm_set1_epi32(4);
+    __m128 best = _mm_set1_ps(radiusSq);
+    __m128i bestIndex = _mm_set1_epi32(-1);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+        __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+        best = _mm_min_ps(distance, best);
+        bestIndex = _mm_or_si128(_mm_and_si128(closer, index), _mm_andnot_si128(closer, bestIndex));
+        index = _mm_add_epi32(index, step);
+    }
+
+    float distances[4];
+    int indices[4];
+    _mm_storeu_ps(distances, best);
+    _mm_storeu_si128((__m128i *)indices, bestIndex);
+    float bestDistance = radiusSq;
+    int found = MergeLanes(distances, indices, 4, &bestDistance);
+    return NearestScalar(xs, ys, i, count, x, y, found, bestDistance);
+}
+
+static uint32_t RectWordSse2(const float *xs, const float *ys, const float bounds[4])
+{
+    const __m128 minX = _mm_set1_ps(bounds[0]);
+    const __m128 minY = _mm_set1_ps(bounds[1]);
+    const __m128 maxX = _mm_set1_ps(bounds[2]);
+    const __m128 maxY = _mm_set1_ps(bounds[3]);
+    uint32_t word = 0;
+    for (int i = 0; i < 32; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(xs + i);
+        __m128 vy = _mm_loadu_ps(ys + i);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vx, minX), _mm_cmplt_ps(vx, maxX)),
+                                   _mm_and_ps(_mm_cmpge_ps(vy, minY), _mm_cmplt_ps(vy, maxY)));
+        word |= (uint32_t)_mm_movemask_ps(inside) << i;
+    }
+    return word;
+}
+#endif
+
+//------------------------------------------------------------------------------------
+// AVX2, 8 points per step, chosen at runtime
+//------------------------------------------------------------------------------------
+#if defined(HIT_TEST_AVX2)
+__attribute__((target("avx2")))
+static int NearestAvx2(const float *xs, const float *ys, int count, float x, float y, float radiusSq)
+{
+    const __m256 px = _mm256_set1_ps(x);
+    const __m256 py = _mm256_set1_ps(y);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256 best = _mm256_set1_ps(radiusSq);
+    __m256i bestIndex = _mm256_set1_epi32(-1);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+        __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 closer = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);
+        best = _mm256_min_ps(distance, best);
+        bestIndex = _mm256_blendv_epi8(bestIndex, index, _mm256_castps_si256(closer));
+        index = _mm256_add_epi32(index, step);
+    }
+
+    float distances[8];
+    int indices[8];
+    _mm256_storeu_ps(distances, best);
+    _mm256_storeu_si256((__m256i *)indices, bestIndex);
+    float bestDistance = radiusSq;
+    int found = MergeLanes(distances, indices, 8, &bestDistance);
+    return NearestScalar(xs, ys, i, count, x, y, found, bestDistance);
+}
+
+__attribute__((target("avx2")))
+static uint32_t RectWordAvx2(const float *xs, const float *ys, const float bounds[4])
+{
+    const __m256 minX = _mm256_set1_ps(bounds[0]);
+    const __m256 minY = _mm256_set1_ps(bounds[1]);
+    const __m256 maxX = _mm256_set1_ps(bounds[2]);
+    const __m256 maxY = _mm256_set1_ps(bounds[3]);
+    uint32_t word = 0;
+    for (int i = 0; i < 32; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(xs + i);
+        __m256 vy = _mm256_loadu_ps(ys + i);
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(vx, minX, _CMP_GE_OQ), _mm256_cmp_ps(vx, maxX, _CMP_LT_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(vy, minY, _CMP_GE_OQ), _mm256_cmp_ps(vy, maxY, _CMP_LT_OQ)));
+        word |= (uint32_t)_mm256_movemask_ps(inside) << i;
+    }
+    return word;
+}
+
+__attribute__((target("avx2")))
+static void RectWordsAvx2(const float *xs, const float *ys, int words, const float bounds[4], uint32_t *mask)
+{
+    for (int w = 0; w < words; w++) mask[w] = RectWordAvx2(xs + w * 32, ys + w * 32, bounds);
+}
+#endif
+
+//------------------------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------------------------
+int HitTestNearest(const float *xs, const float *ys, int count, float x, float y, float radius)
+{
+    float radiusSq = radius * radius;
+    SimdLevel level = SimdScanGetLevel();
+    (void)level;
+#if defined(HIT_TEST_AVX2)
+    if (level == SIMD_LEVEL_AVX2) return NearestAvx2(xs, ys, count, x, y, radiusSq);
+#endif
+#if defined(HIT_TEST_SSE2)
+    if (level == SIMD_LEVEL_SSE2) return NearestSse2(xs, ys, count, x, y, radiusSq);
+#endif
+    return NearestScalar(xs, ys, 0, count, x, y, -1, radiusSq);
+}
+
+int HitTestRect(const float *xs, const float *ys, int count, float minX, float minY, float maxX, float maxY, uint32_t *mask)
+{
+    const float bounds[4] = { minX, minY, maxX, maxY };
+    int fullWords = count / 32;
+    SimdLevel level = SimdScanGetLevel();
+    (void)level;
+
+    int w = 0;
+#if defined(HIT_TEST_AVX2)
+    if (level == SIMD_LEVEL_AVX2)
+    {
+        RectWordsAvx2(xs, ys, fullWords, bounds, mask);
+        w = fullWords;
+    }
+#endif
+#if defined(HIT_TEST_SSE2)
+    if (level == SIMD_LEVEL_SSE2)
+    {
+        for (; w < fullWords; w++) mask[w] = RectWordSse2(xs + w * 32, ys + w * 32, bounds);
+    }
+#endif
+    for (; w < fullWords; w++) mask[w] = RectWordScalar(xs + w * 32, ys + w * 32, 32, bounds);
+    if (count % 32 != 0) mask[fullWords] = RectWordScalar(xs + fullWords * 32, ys + fullWords * 32, count % 32, bounds);
+
+    int hits = 0;
+    for (w = 0; w < HitTestMaskWords(count); w++) hits += CountBits(mask[w]);
+    return hits;
+}
+
+uint32_t *HitTestGetMask(int count)
+{
+    int words = HitTestMaskWords(count);
+    if (words > _maskWords || _mask == NULL)
+    {
+        uint32_t *mask = MemRealloc(_mask, sizeof(uint32_t) * (words > 0 ? words : 1));
+        if (mask == NULL) return NULL;
+        _mask = mask;
+        _maskWords = words;
+    }
+    return _mask;
+}
+
+void HitTestFreeMask(void)
+{
+    MemFree(_mask);
+    _mask = NULL;
+    _maskWords = 0;
+}
@@ -0,0 +1,59 @@
+#ifndef HIT_TEST_H
+#define HIT_TEST_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Batch hit tests of one point or one rectangle against points stored as separate x and y
+// float arrays. Every SIMD level gives the same result as the scalar loop; the level is
+// the one selected through simd_scan.h. Points with a NaN coordinate never hit.
+
+/**
+ * @brief Finds the point nearest to (x, y) that is closer than radius.
+ * @return Its index, the lowest one on a tie, or -1 if no point is that close.
+ */
+int HitTestNearest(const float *xs, const float *ys, int count, float x, float y, float radius);
+
+/**
+ * @brief Marks the points with minX <= x < maxX and minY <= y < maxY.
+ * @param mask Receives bit (i % 32) of word (i / 32) for point i; needs HitTestMaskWords(count) words.
+ * @return Number of points inside.
+ */
+int HitTestRect(const float *xs, const float *ys, int count, float minX, float minY, float maxX, float maxY, uint32_t *mask);
+
+/**
+ * @brief Number of mask words HitTestRect() writes for count points.
+ */
+static inline int HitTestMaskWords(int count)
+{
+    return (count + 31) / 32;
+}
+
+/**
+ * @brief Returns a scratch mask with room for count points, valid until the next call.
+ * @return NULL if it could not be allocated.
+ */
+uint32_t *HitTestGetMask(int count);
+
+/**
+ * @brief Frees the scratch mask.
+ */
+void HitTestFreeMask(void);
+
+/**
+ * @brief Index of the lowest set bit of a non-zero mask word.
+ */
+static inline int HitTestLowestBit(uint32_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(bits);
+#else
+    int bit = 0;
+    while ((bits & 1u) == 0) { bits >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+#endif // HIT_TEST_H
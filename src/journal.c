@@ -0,0 +1,503 @@
+#include "journal.h"
+#include "edit_ops.h"
+#include "file_util.h"
+#include "handles.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_MAGIC 0x314A4257 // "WBJ1"
+#define JOURNAL_VERSION 1
+#define JOURNAL_SYNC_INTERVAL_MS 1000.0
+#define MAX_JOURNAL_PATH 2048
+
+// The header pins the journal to one version of the config: replay only happens when
+// the config still has the size and modification time it had when the journal started.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t configSize;
+    int64_t configModTime;
+} JournalHeader;
+
+// Record layout: u32 payload length, u32 FNV-1a checksum of the payload, payload.
+// The payload starts with a type byte. Integers are stored in native byte order.
+typedef enum {
+    RECORD_MOVE = 1,
+    RECORD_POINT,
+    RECORD_BOUNDS,
+    RECORD_INSERT,
+    RECORD_REMOVE,
+    RECORD_REGION_IDS,
+    RECORD_INSERT_MANY,
+    RECORD_REMOVE_MANY
+} JournalRecordType;
+
+static FILE *_journal = NULL;
+static char _journalPath[MAX_JOURNAL_PATH] = { 0 };
+static char _configPath[MAX_JOURNAL_PATH] = { 0 };
+static bool _unsynced = false;
+static double _lastSyncTime = 0.0;
+
+static unsigned char *_record = NULL;
+static size_t _recordSize = 0;
+static size_t _recordCapacity = 0;
+
+//------------------------------------------------------------------------------------
+// File helpers
+//------------------------------------------------------------------------------------
+static uint32_t Checksum(const unsigned char *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+static void TruncateFile(FILE *file, long size)
+{
+    fflush(file);
+#if defined(_WIN32)
+    _chsize(_fileno(file), size);
+#else
+    if (ftruncate(fileno(file), size) != 0) printf("WARNING: Failed to truncate journal.\n");
+#endif
+}
+
+// Starts an empty journal for the config as it is on disk right now
+static bool CreateJournal(void)
+{
+    JournalHeader header = { JOURNAL_MAGIC, JOURNAL_VERSION, 0, 0 };
+    if (!GetFileIdentity(_configPath, &header.configSize, &header.configModTime)) return false;
+
+    FILE *file = fopen(_journalPath, "wb");
+    if (file == NULL) return false;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    SyncFile(file);
+    fclose(file);
+    return written;
+}
+
+//------------------------------------------------------------------------------------
+// Record encoding
+//------------------------------------------------------------------------------------
+static bool Reserve(size_t extra)
+{
+    if (_recordSize + extra <= _recordCapacity) return true;
+
+    size_t newCapacity = (_recordCapacity == 0) ? 256 : _recordCapacity;
+    while (newCapacity < _recordSize + extra) newCapacity *= 2;
+    unsigned char *record = MemRealloc(_record, newCapacity);
+    if (record == NULL) return false;
+    _record = record;
+    _recordCapacity = newCapacity;
+    return true;
+}
+
+static void PutBytes(const void *data, size_t size)
+{
+    if (!Reserve(size)) return;
+    memcpy(_record + _recordSize, data, size);
+    _recordSize += size;
+}
+
+static void PutU8(uint8_t value) { PutBytes(&value, 1); }
+static void PutI32(int32_t value) { PutBytes(&value, 4); }
+
+static bool BeginRecord(JournalRecordType type)
+{
+    if (_journal == NULL) return false;
+    _recordSize = 0;
+    PutU8((uint8_t)type);
+    return true;
+}
+
+static void EndRecord(void)
+{
+    uint32_t header[2] = { (uint32_t)_recordSize, Checksum(_record, _recordSize) };
+    fwrite(header, sizeof(header), 1, _journal);
+    fwrite(_record, 1, _recordSize, _journal);
+    _unsynced = true;
+}
+
+//------------------------------------------------------------------------------------
+// Replay
+//------------------------------------------------------------------------------------
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+    bool failed;
+} RecordReader;
+
+static void GetBytes(RecordReader *reader, void *out, size_t size)
+{
+    if (reader->failed || reader->offset + size > reader->size) { reader->failed = true; memset(out, 0, size); return; }
+    memcpy(out, reader->data + reader->offset, size);
+    reader->offset += size;
+}
+
+static uint8_t GetU8(RecordReader *reader) { uint8_t value; GetBytes(reader, &value, 1); return value; }
+static int32_t GetI32(RecordReader *reader) { int32_t value; GetBytes(reader, &value, 4); return value; }
+
+static EditLayer GetLayer(RecordReader *reader)
+{
+    uint8_t layer = GetU8(reader);
+    if (layer >= LAYER_COUNT) reader->failed = true;
+    return (EditLayer)layer;
+}
+
+static bool ReplayRecord(RecordReader *reader)
+{
+    switch ((JournalRecordType)GetU8(reader))
+    {
+        case RECORD_MOVE: {
+            int dx = GetI32(reader);
+            int dy = GetI32(reader);
+            int count = GetI32(reader);
+            if (reader->failed || count < 0 || (size_t)count * 6 > reader->size - reader->offset) return false;
+            PointRef *refs = MemAlloc(sizeof(PointRef) * (count > 0 ? count : 1));
+            if (refs == NULL) return false;
+            for (int i = 0; i < count; i++)
+            {
+                refs[i].index = GetI32(reader);
+                refs[i].layer = GetLayer(reader);
+                refs[i].field = (PointField)GetU8(reader);
+            }
+            if (!reader->failed) EditMovePoints(refs, count, dx, dy);
+            MemFree(refs);
+            break;
+        }
+        case RECORD_POINT: {
+            PointRef ref;
+            ref.layer = GetLayer(reader);
+            ref.field = (PointField)GetU8(reader);
+            ref.index = GetI32(reader);
+            int x = GetI32(reader);
+            int y = GetI32(reader);
+            if (!reader->failed) EditSetPoint(ref, x, y);
+            break;
+        }
+        case RECORD_BOUNDS: {
+            EditLayer layer = GetLayer(reader);
+            int index = GetI32(reader);
+            int bounds[4];
+            for (int i = 0; i < 4; i++) bounds[i] = GetI32(reader);
+            if (!reader->failed) EditSetBounds(layer, index, bounds);
+            break;
+        }
+        case RECORD_INSERT: {
+            EditLayer layer = GetLayer(reader);
+            int index = GetI32(reader);
+            int length = GetI32(reader);
+            if (reader->failed || length < 0 || (size_t)length > reader->size - reader->offset) return false;
+            cJSON *element = cJSON_ParseWithLength((const char *)reader->data + reader->offset, (size_t)length);
+            reader->offset += (size_t)length;
+            if (element == NULL) return false;
+            EditInsertElement(layer, index, element);
+            break;
+        }
+        case RECORD_REMOVE: {
+            EditLayer layer = GetLayer(reader);
+            int index = GetI32(reader);
+            if (reader->failed) break;
+            cJSON *element = EditDetachElement(layer, index);
+            HandleRelease(element);
+            cJSON_Delete(element);
+            break;
+        }
+        case RECORD_REGION_IDS: {
+            int count = GetI32(reader);
+            if (reader->failed || count < 0 || (size_t)count * 8 > reader->size - reader->offset) return false;
+            int *indices = MemAlloc(sizeof(int) * (count > 0 ? count : 1));
+            cJSON **items = MemCalloc(count > 0 ? count : 1, sizeof(cJSON *));
+            bool parsed = indices != NULL && items != NULL;
+            for (int i = 0; parsed && i < count; i++)
+            {
+                indices[i] = GetI32(reader);
+                int length = GetI32(reader); // -1 when the structure has no region_id
+                if (reader->failed || length < -1 || (length > 0 && (size_t)length > reader->size - reader->offset)) { parsed = false; break; }
+                if (length < 0) continue;
+                items[i] = cJSON_ParseWithLength((const char *)reader->data + reader->offset, (size_t)length);
+                reader->offset += (size_t)length;
+                parsed = items[i] != NULL;
+            }
+            if (parsed) EditSetRegionIdItems(indices, items, count);
+            for (int i = 0; items != NULL && i < count; i++) cJSON_Delete(items[i]);
+            MemFree(indices);
+            MemFree(items);
+            if (!parsed) return false;
+            break;
+        }
+        case RECORD_INSERT_MANY: {
+            EditLayer layer = GetLayer(reader);
+            int count = GetI32(reader);
+            if (reader->failed || count < 0 || (size_t)count * 8 > reader->size - reader->offset) return false;
+            int *indices = MemAlloc(sizeof(int) * (count > 0 ? count : 1));
+            cJSON **elements = MemCalloc(count > 0 ? count : 1, sizeof(cJSON *));
+            bool parsed = indices != NULL && elements != NULL;
+            for (int i = 0; parsed && i < count; i++)
+            {
+                indices[i] = GetI32(reader);
+                int length = GetI32(reader);
+                if (reader->failed || length < 0 || (size_t)length > reader->size - reader->offset) { parsed = false; break; }
+                elements[i] = cJSON_ParseWithLength((const char *)reader->data + reader->offset, (size_t)length);
+                reader->offset += (size_t)length;
+                parsed = elements[i] != NULL;
+            }
+            if (parsed) EditInsertElements(layer, indices, elements, count);
+            else if (elements != NULL)
+            {
+                for (int i = 0; i < count; i++) cJSON_Delete(elements[i]);
+            }
+            MemFree(indices);
+            MemFree(elements);
+            if (!parsed) return false;
+            break;
+        }
+        case RECORD_REMOVE_MANY: {
+            EditLayer layer = GetLayer(reader);
+            int count = GetI32(reader);
+            if (reader->failed || count < 0 || (size_t)count * 4 > reader->size - reader->offset) return false;
+            int *indices = MemAlloc(sizeof(int) * (count > 0 ? count : 1));
+            cJSON **elements = MemAlloc(sizeof(cJSON *) * (count > 0 ? count : 1));
+            if (indices == NULL || elements == NULL) { MemFree(indices); MemFree(elements); return false; }
+            for (int i = 0; i < count; i++) indices[i] = GetI32(reader);
+            if (!reader->failed)
+            {
+                EditDetachElements(layer, indices, count, elements);
+                for (int i = 0; i < count; i++)
+                {
+                    HandleRelease(elements[i]);
+                    cJSON_Delete(elements[i]);
+                }
+            }
+            MemFree(indices);
+            MemFree(elements);
+            break;
+        }
+        default:
+            return false;
+    }
+    return !reader->failed;
+}
+
+// Replays all intact records and returns the file offset just past the last one
+static long ReplayJournal(FILE *file, int *replayed)
+{
+    long goodEnd = (long)sizeof(JournalHeader);
+    uint32_t header[2];
+    unsigned char *payload = NULL;
+    size_t payloadCapacity = 0;
+
+    while (fread(header, sizeof(header), 1, file) == 1)
+    {
+        if (header[0] > payloadCapacity)
+        {
+            unsigned char *grown = MemRealloc(payload, header[0]);
+            if (grown == NULL) break;
+            payload = grown;
+            payloadCapacity = header[0];
+        }
+        if (fread(payload, 1, header[0], file) != header[0]) break; // Torn write at the end
+        if (Checksum(payload, header[0]) != header[1]) break;
+
+        RecordReader reader = { payload, header[0], 0, false };
+        if (!ReplayRecord(&reader)) break;
+
+        goodEnd += (long)(sizeof(header) + header[0]);
+        (*replayed)++;
+    }
+
+    MemFree(payload);
+    return goodEnd;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+int JournalOpen(const char *configPath)
+{
+    JournalClose();
+    snprintf(_configPath, sizeof(_configPath), "%s", configPath);
+    snprintf(_journalPath, sizeof(_journalPath), "%s.journal", configPath);
+
+    int64_t configSize = 0, configModTime = 0;
+    if (!GetFileIdentity(_configPath, &configSize, &configModTime)) return 0;
+
+    int replayed = 0;
+    bool keepExisting = false;
+    FILE *file = fopen(_journalPath, "r+b");
+    if (file)
+    {
+        JournalHeader header;
+        if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == JOURNAL_MAGIC && header.version == JOURNAL_VERSION &&
+            header.configSize == configSize && header.configModTime == configModTime)
+        {
+            long goodEnd = ReplayJournal(file, &replayed);
+            // Drop a partially written tail so new records follow the last intact one
+            fseek(file, 0, SEEK_END);
+            if (ftell(file) != goodEnd) TruncateFile(file, goodEnd);
+            keepExisting = true;
+        }
+        fclose(file);
+    }
+
+    if (!keepExisting && !CreateJournal()) { printf("WARNING: Could not create journal %s\n", _journalPath); return replayed; }
+
+    _journal = fopen(_journalPath, "ab");
+    _lastSyncTime = ProfilerGetTime();
+    if (replayed > 0) printf("Replayed %d journaled edits from %s\n", replayed, _journalPath);
+    return replayed;
+}
+
+void JournalClose(void)
+{
+    if (_journal == NULL) return;
+    SyncFile(_journal);
+    fclose(_journal);
+    _journal = NULL;
+    _unsynced = false;
+
+    MemFree(_record);
+    _record = NULL;
+    _recordSize = 0;
+    _recordCapacity = 0;
+}
+
+void JournalReset(void)
+{
+    if (_journal == NULL) return;
+    fclose(_journal);
+    _journal = NULL;
+
+    if (CreateJournal()) _journal = fopen(_journalPath, "ab");
+    _unsynced = false;
+}
+
+void JournalUpdate(void)
+{
+    if (_journal == NULL || !_unsynced) return;
+
+    double now = ProfilerGetTime();
+    if (now - _lastSyncTime < JOURNAL_SYNC_INTERVAL_MS) return;
+
+    SyncFile(_journal);
+    _unsynced = false;
+    _lastSyncTime = now;
+}
+
+void JournalAppendMove(const PointRef *refs, int count, int dx, int dy)
+{
+    if (!BeginRecord(RECORD_MOVE)) return;
+    PutI32(dx);
+    PutI32(dy);
+    PutI32(count);
+    for (int i = 0; i < count; i++)
+    {
+        PutI32(refs[i].index);
+        PutU8((uint8_t)refs[i].layer);
+        PutU8((uint8_t)refs[i].field);
+    }
+    EndRecord();
+}
+
+void JournalAppendPoint(PointRef ref, int x, int y)
+{
+    if (!BeginRecord(RECORD_POINT)) return;
+    PutU8((uint8_t)ref.layer);
+    PutU8((uint8_t)ref.field);
+    PutI32(ref.index);
+    PutI32(x);
+    PutI32(y);
+    EndRecord();
+}
+
+void JournalAppendBounds(EditLayer layer, int index, const int bounds[4])
+{
+    if (!BeginRecord(RECORD_BOUNDS)) return;
+    PutU8((uint8_t)layer);
+    PutI32(index);
+    for (int i = 0; i < 4; i++) PutI32(bounds[i]);
+    EndRecord();
+}
+
+void JournalAppendInsert(EditLayer layer, int index, cJSON *element)
+{
+    if (_journal == NULL || element == NULL) return;
+
+    char *text = cJSON_PrintUnformatted(element);
+    if (text == NULL) return;
+    int length = (int)strlen(text);
+
+    if (BeginRecord(RECORD_INSERT))
+    {
+        PutU8((uint8_t)layer);
+        PutI32(index);
+        PutI32(length);
+        PutBytes(text, (size_t)length);
+        EndRecord();
+    }
+    cJSON_free(text);
+}
+
+void JournalAppendRemove(EditLayer layer, int index)
+{
+    if (!BeginRecord(RECORD_REMOVE)) return;
+    PutU8((uint8_t)layer);
+    PutI32(index);
+    EndRecord();
+}
+
+void JournalAppendInsertMany(EditLayer layer, const int *indices, cJSON **elements, int count)
+{
+    if (!BeginRecord(RECORD_INSERT_MANY)) return;
+    PutU8((uint8_t)layer);
+    PutI32(count);
+    for (int i = 0; i < count; i++)
+    {
+        char *text = cJSON_PrintUnformatted(elements[i]);
+        if (text == NULL) return; // Dropped whole; a partial record would replay the wrong indices
+        int length = (int)strlen(text);
+        PutI32(indices[i]);
+        PutI32(length);
+        PutBytes(text, (size_t)length);
+        cJSON_free(text);
+    }
+    EndRecord();
+}
+
+void JournalAppendRemoveMany(EditLayer layer, const int *indices, int count)
+{
+    if (!BeginRecord(RECORD_REMOVE_MANY)) return;
+    PutU8((uint8_t)layer);
+    PutI32(count);
+    for (int i = 0; i < count; i++) PutI32(indices[i]);
+    EndRecord();
+}
+
+void JournalAppendRegionIds(const int *indices, cJSON *const *items, int count)
+{
+    if (!BeginRecord(RECORD_REGION_IDS)) return;
+    PutI32(count);
+    for (int i = 0; i < count; i++)
+    {
+        PutI32(indices[i]);
+        if (items[i] == NULL) { PutI32(-1); continue; }
+
+        char *text = cJSON_PrintUnformatted(items[i]);
+        if (text == NULL) return; // Dropped whole, like a failed insert
+        int length = (int)strlen(text);
+        PutI32(length);
+        PutBytes(text, (size_t)length);
+        cJSON_free(text);
+    }
+    EndRecord();
+}
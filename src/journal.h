@@ -0,0 +1,48 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Append-only binary log of committed edits, stored next to the config as <config>.journal.
+// Records are checksummed so a write torn by a crash is detected and dropped on replay.
+
+/**
+ * @brief Opens the journal of a freshly loaded config. If the journal was started from this
+ *        exact version of the file, its edits are replayed onto the document first.
+ * @param configPath Path of the config that was just loaded.
+ * @return Number of replayed edits.
+ */
+int JournalOpen(const char *configPath);
+
+/**
+ * @brief Flushes and closes the journal file.
+ */
+void JournalClose(void);
+
+/**
+ * @brief Empties the journal after the config itself has been saved.
+ */
+void JournalReset(void);
+
+/**
+ * @brief Forces buffered records to disk once the sync interval has passed. Call once per frame.
+ */
+void JournalUpdate(void);
+
+/**
+ * @brief Appends one committed edit. Each mirrors an operation from edit_ops.h.
+ */
+void JournalAppendMove(const PointRef *refs, int count, int dx, int dy);
+void JournalAppendPoint(PointRef ref, int x, int y);
+void JournalAppendBounds(EditLayer layer, int index, const int bounds[4]);
+void JournalAppendInsert(EditLayer layer, int index, cJSON *element);
+void JournalAppendRemove(EditLayer layer, int index);
+void JournalAppendInsertMany(EditLayer layer, const int *indices, cJSON **elements, int count);
+void JournalAppendRemoveMany(EditLayer layer, const int *indices, int count);
+void JournalAppendRegionIds(const int *indices, cJSON *const *items, int count);
+
+#endif // JOURNAL_H
@@ -0,0 +1,134 @@
+#include "json_scan.h"
+#include <ctype.h>
+#include <string.h>
+
+static bool IsWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Returns the position just past the closing quote of the string starting at pos
+static bool SkipString(const char *text, size_t length, size_t pos, size_t *end)
+{
+    pos++;
+    while (pos < length)
+    {
+        const char *quote = memchr(text + pos, '"', length - pos);
+        if (quote == NULL) return false;
+        pos = (size_t)(quote - text);
+
+        // The quote is escaped when an odd number of backslashes precede it
+        size_t backslashes = 0;
+        while (backslashes < pos && text[pos - 1 - backslashes] == '\\') backslashes++;
+        pos++;
+        if ((backslashes & 1) == 0) { *end = pos; return true; }
+    }
+    return false;
+}
+
+size_t JsonSkipWhitespace(const char *text, size_t length, size_t pos)
+{
+    while (pos < length && IsWhitespace(text[pos])) pos++;
+    return pos;
+}
+
+bool JsonScanValue(const char *text, size_t length, size_t pos, JsonSpan *span)
+{
+    if (pos >= length) return false;
+    span->start = pos;
+
+    char c = text[pos];
+    if (c == '"') return SkipString(text, length, pos, &span->end);
+
+    if (c != '[' && c != '{')
+    {
+        // Numbers and literals end at the next delimiter
+        while (pos < length && text[pos] != ',' && text[pos] != ']' && text[pos] != '}' && !IsWhitespace(text[pos])) pos++;
+        span->end = pos;
+        return true;
+    }
+
+    int depth = 0;
+    while (pos < length)
+    {
+        c = text[pos];
+        if (c == '"')
+        {
+            if (!SkipString(text, length, pos, &pos)) return false;
+            continue;
+        }
+        if (c == '[' || c == '{') depth++;
+        else if ((c == ']' || c == '}') && --depth == 0)
+        {
+            span->end = pos + 1;
+            return true;
+        }
+        pos++;
+    }
+    return false;
+}
+
+bool JsonIterBegin(JsonIterator *it, const char *text, size_t length, JsonSpan container)
+{
+    if (container.end - container.start < 2) return false;
+    char open = text[container.start];
+    if (open != '[' && open != '{') return false;
+
+    *it = (JsonIterator){ text, length, container.start + 1, container.end - 1, true, open == '{' };
+    return true;
+}
+
+bool JsonIterNext(JsonIterator *it, JsonSpan *key, JsonSpan *value)
+{
+    size_t pos = JsonSkipWhitespace(it->text, it->end, it->pos);
+    if (pos >= it->end) return false;
+
+    if (!it->first)
+    {
+        if (it->text[pos] != ',') return false;
+        pos = JsonSkipWhitespace(it->text, it->end, pos + 1);
+    }
+    it->first = false;
+
+    // Object members are a string key and a colon before the value
+    if (it->object)
+    {
+        JsonSpan keySpan;
+        if (it->text[pos] != '"' || !JsonScanValue(it->text, it->end, pos, &keySpan)) return false;
+        size_t colon = JsonSkipWhitespace(it->text, it->end, keySpan.end);
+        if (colon >= it->end || it->text[colon] != ':') return false;
+        if (key) *key = keySpan;
+        pos = JsonSkipWhitespace(it->text, it->end, colon + 1);
+    }
+
+    if (!JsonScanValue(it->text, it->end, pos, value)) return false;
+    it->pos = value->end;
+    return true;
+}
+
+bool JsonKeyEquals(const char *text, JsonSpan key, const char *name)
+{
+    size_t nameLength = strlen(name);
+    if (key.end - key.start != nameLength + 2) return false;
+
+    for (size_t i = 0; i < nameLength; i++)
+    {
+        if (tolower((unsigned char)text[key.start + 1 + i]) != tolower((unsigned char)name[i])) return false;
+    }
+    return true;
+}
+
+bool JsonFindMember(const char *text, size_t length, JsonSpan object, const char *name, JsonSpan *value)
+{
+    if (text[object.start] != '{') return false;
+
+    JsonIterator it;
+    if (!JsonIterBegin(&it, text, length, object)) return false;
+
+    JsonSpan key = { 0, 0 };
+    while (JsonIterNext(&it, &key, value))
+    {
+        if (JsonKeyEquals(text, key, name)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Structural scanner that finds where values are in JSON text without building a tree.
+// It only tracks strings and nesting, so values are assumed to be valid JSON.
+
+// Byte range [start, end) of a value in the text
+typedef struct {
+    size_t start;
+    size_t end;
+} JsonSpan;
+
+// Walks the elements of an array or the members of an object
+typedef struct {
+    const char *text;
+    size_t length;
+    size_t pos;
+    size_t end;
+    bool first;
+    bool object;
+} JsonIterator;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the position of the first non-whitespace byte at or after pos.
+ */
+size_t JsonSkipWhitespace(const char *text, size_t length, size_t pos);
+
+/**
+ * @brief Finds the end of the value that starts at pos.
+ * @param span Receives the value's byte range.
+ * @return false if the text ends before the value does.
+ */
+bool JsonScanValue(const char *text, size_t length, size_t pos, JsonSpan *span);
+
+/**
+ * @brief Starts iterating the array or object whose span is given.
+ */
+bool JsonIterBegin(JsonIterator *it, const char *text, size_t length, JsonSpan container);
+
+/**
+ * @brief Advances to the next element or member.
+ * @param key Receives the member's key including quotes. Unused for arrays, may be NULL.
+ * @param value Receives the element or member value.
+ * @return false at the end of the container or on malformed input.
+ */
+bool JsonIterNext(JsonIterator *it, JsonSpan *key, JsonSpan *value);
+
+/**
+ * @brief Compares a member key (including its quotes) case-insensitively with name.
+ */
+bool JsonKeyEquals(const char *text, JsonSpan key, const char *name);
+
+/**
+ * @brief Finds the first member of an object whose key matches case-insensitively, like cJSON_GetObjectItem().
+ */
+bool JsonFindMember(const char *text, size_t length, JsonSpan object, const char *name, JsonSpan *value);
+
+#endif // JSON_SCAN_H
@@ -0,0 +1,415 @@
+#include "live_push.h"
+#include "push_protocol.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+
+bool LivePushStart(const char *socketPath)
+{
+    printf("WARNING: Pushing edits to %s needs Unix domain sockets, which this build does not use.\n", socketPath);
+    return false;
+}
+
+void LivePushStop(void) { }
+void LivePushElement(EditLayer layer, int index, const cJSON *element) { (void)layer; (void)index; (void)element; }
+void LivePushUpdate(void) { }
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MAX_PUSH_CLIENTS 8
+#define MAX_PENDING_BYTES (256 * 1024 * 1024)   // A game this far behind is disconnected
+#define PENDING_KEEP_BYTES (1024 * 1024)
+
+#if defined(MSG_NOSIGNAL)
+#define SEND_FLAGS MSG_NOSIGNAL                 // A game that went away must not raise SIGPIPE
+#else
+#define SEND_FLAGS 0
+#endif
+
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} PushBuffer;
+
+typedef struct {
+    int fd;
+    PushBuffer pending;                         // Encoded but not accepted by the socket yet
+    size_t sent;                                // Bytes of pending already sent
+} PushConnection;
+
+typedef struct {
+    EditLayer layer;
+    int index;
+    const cJSON *element;
+} QueuedElement;
+
+static int _listenFd = -1;
+static char _socketPath[256] = { 0 };
+static PushConnection _clients[MAX_PUSH_CLIENTS];
+static int _clientCount = 0;
+static uint64_t _pushedVersion = 0;
+static PushBuffer _frame = { 0 };
+static QueuedElement *_queued = NULL;
+static int _queuedCount = 0;
+static int _queuedCapacity = 0;
+
+// Fields sent for the elements of each layer; regions and world areas send both bounds corners
+static const PointField _layerFields[LAYER_COUNT][2] = {
+    { POINT_FIELD_LOCATION, POINT_FIELD_LOCATION },
+    { POINT_FIELD_A, POINT_FIELD_B },
+    { POINT_FIELD_A, POINT_FIELD_B },
+    { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX },
+    { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX },
+    { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX },
+    { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX },
+    { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX },
+};
+
+//------------------------------------------------------------------------------------
+// Encoding
+//------------------------------------------------------------------------------------
+static PushField WireField(PointField field)
+{
+    switch (field)
+    {
+        case POINT_FIELD_LOCATION: return PUSH_FIELD_LOCATION;
+        case POINT_FIELD_A: return PUSH_FIELD_A;
+        case POINT_FIELD_B: return PUSH_FIELD_B;
+        case POINT_FIELD_MIN_MIN: return PUSH_FIELD_BOUNDS_MIN;
+        default: return PUSH_FIELD_BOUNDS_MAX;
+    }
+}
+
+// Makes room for size more bytes and returns where they go
+static unsigned char *Reserve(PushBuffer *buffer, size_t size)
+{
+    if (buffer->length + size > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->length + size) capacity *= 2;
+        unsigned char *data = (unsigned char *)MemRealloc(buffer->data, capacity);
+        if (data == NULL) return NULL;
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    unsigned char *at = buffer->data + buffer->length;
+    buffer->length += size;
+    return at;
+}
+
+static void FreeBuffer(PushBuffer *buffer)
+{
+    MemFree(buffer->data);
+    *buffer = (PushBuffer){ 0 };
+}
+
+static unsigned char *AppendHeader(PushBuffer *buffer, PushMessageType type, EditLayer layer, size_t size, uint64_t sentNs)
+{
+    unsigned char *at = Reserve(buffer, size);
+    if (at == NULL) return NULL;
+    PushPutU32(at, (uint32_t)size);
+    at[4] = (unsigned char)type;
+    at[5] = (unsigned char)layer;
+    PushPutU16(at + 6, 0);
+    PushPutU64(at + 8, sentNs);
+    return at + PUSH_HEADER_SIZE;
+}
+
+// An element or a whole layer as JSON text, after the index for an element
+static void AppendJSON(PushBuffer *buffer, PushMessageType type, EditLayer layer, int index, const cJSON *json, uint64_t sentNs)
+{
+    char *text = cJSON_PrintUnformatted(json);
+    if (text == NULL) return;
+    size_t textLength = strlen(text);
+    size_t prefix = (type == PUSH_MESSAGE_ELEMENT) ? 4 : 0;
+    unsigned char *payload = AppendHeader(buffer, type, layer, PUSH_HEADER_SIZE + prefix + textLength, sentNs);
+    if (payload != NULL)
+    {
+        if (prefix) PushPutU32(payload, (uint32_t)index);
+        memcpy(payload + prefix, text, textLength);
+    }
+    cJSON_free(text);
+}
+
+static void AppendPoints(PushBuffer *buffer, EditLayer layer, int index, const cJSON *element, uint64_t sentNs)
+{
+    int fieldCount = (layer == LAYER_STRUCTURES) ? 1 : 2;
+    for (int i = 0; i < fieldCount; i++)
+    {
+        cJSON *xItem = NULL, *yItem = NULL;
+        if (!GetPointItemsJSON((cJSON *)element, _layerFields[layer][i], &xItem, &yItem)) continue;
+
+        unsigned char *payload = AppendHeader(buffer, PUSH_MESSAGE_POINT, layer, PUSH_POINT_SIZE, sentNs);
+        if (payload == NULL) return;
+        PushPutU32(payload, (uint32_t)index);
+        PushPutU16(payload + 4, (uint16_t)WireField(_layerFields[layer][i]));
+        PushPutU16(payload + 6, 0);
+        PushPutF64(payload + 8, xItem->valuedouble);
+        PushPutF64(payload + 16, yItem->valuedouble);
+    }
+}
+
+static void AppendFrameEnd(PushBuffer *buffer, uint64_t sentNs)
+{
+    AppendHeader(buffer, PUSH_MESSAGE_FRAME, LAYER_STRUCTURES, PUSH_HEADER_SIZE, sentNs);
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+//------------------------------------------------------------------------------------
+// Connections
+//------------------------------------------------------------------------------------
+static void Disconnect(int i)
+{
+    close(_clients[i].fd);
+    FreeBuffer(&_clients[i].pending);
+    _clients[i] = _clients[--_clientCount];
+}
+
+// Writes as much of a game's pending bytes as its socket takes without blocking
+static bool Flush(PushConnection *client)
+{
+    while (client->sent < client->pending.length)
+    {
+        ssize_t count = send(client->fd, client->pending.data + client->sent, client->pending.length - client->sent, SEND_FLAGS);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0) return false;
+        client->sent += (size_t)count;
+    }
+
+    if (client->sent == client->pending.length)
+    {
+        // The snapshot of a large document is not kept around once it is out
+        if (client->pending.capacity > PENDING_KEEP_BYTES) FreeBuffer(&client->pending);
+        client->pending.length = 0;
+        client->sent = 0;
+    }
+    else if (client->sent > client->pending.capacity / 2)
+    {
+        memmove(client->pending.data, client->pending.data + client->sent, client->pending.length - client->sent);
+        client->pending.length -= client->sent;
+        client->sent = 0;
+    }
+    return true;
+}
+
+// Sends bytes to a game, keeping what its socket does not take yet behind what is still pending
+static bool Send(PushConnection *client, const PushBuffer *bytes)
+{
+    size_t offset = 0;
+    while (client->pending.length == 0 && offset < bytes->length)
+    {
+        ssize_t count = send(client->fd, bytes->data + offset, bytes->length - offset, SEND_FLAGS);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0) return false;
+        offset += (size_t)count;
+    }
+    if (offset == bytes->length) return true;
+
+    size_t rest = bytes->length - offset;
+    if (client->pending.length - client->sent + rest > MAX_PENDING_BYTES) return false;
+    unsigned char *at = Reserve(&client->pending, rest);
+    if (at == NULL) return false;
+    memcpy(at, bytes->data + offset, rest);
+    return Flush(client);
+}
+
+// Sends a newly connected game the whole document
+static bool SendSnapshot(PushConnection *client)
+{
+    ProfileBegin("push snapshot");
+    MemPushSubsystem(MEM_SUBSYSTEM_EXPORT);
+    uint64_t now = NowNs();
+    PushBuffer *snapshot = &client->pending;
+    unsigned char *payload = AppendHeader(snapshot, PUSH_MESSAGE_HELLO, LAYER_STRUCTURES, PUSH_HEADER_SIZE + 4, now);
+    if (payload != NULL) PushPutU32(payload, PUSH_PROTOCOL_VERSION);
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+    {
+        cJSON *json = GetLayerJSON((EditLayer)layer);
+        if (json != NULL) AppendJSON(snapshot, PUSH_MESSAGE_LAYER, (EditLayer)layer, 0, json, now);
+    }
+    AppendFrameEnd(snapshot, now);
+    MemPopSubsystem();
+    ProfileEnd();
+    return payload != NULL && Flush(client);
+}
+
+static void AcceptClients(void)
+{
+    for (;;)
+    {
+        int fd = accept(_listenFd, NULL, NULL);
+        if (fd < 0) return;
+        if (_clientCount == MAX_PUSH_CLIENTS)
+        {
+            close(fd);
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#if defined(SO_NOSIGPIPE)
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        _clients[_clientCount] = (PushConnection){ fd, { 0 }, 0 };
+        _clientCount++;
+        if (SendSnapshot(&_clients[_clientCount - 1])) printf("Game connected to %s\n", _socketPath);
+        else Disconnect(_clientCount - 1);
+    }
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+bool LivePushStart(const char *socketPath)
+{
+    LivePushStop();
+
+    struct sockaddr_un address = { 0 };
+    if (strlen(socketPath) >= sizeof(address.sun_path) || strlen(socketPath) >= sizeof(_socketPath))
+    {
+        printf("WARNING: Push socket path %s is too long.\n", socketPath);
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    // A socket file nobody answers on is left over from an editor that did not exit cleanly
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+    {
+        printf("WARNING: Another editor is already pushing edits on %s.\n", socketPath);
+        close(fd);
+        return false;
+    }
+    close(fd);
+    unlink(socketPath);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, MAX_PUSH_CLIENTS) != 0)
+    {
+        printf("WARNING: Could not listen for games on %s: %s\n", socketPath, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    _listenFd = fd;
+    strcpy(_socketPath, socketPath);
+    _pushedVersion = ChangesGetVersion();
+    printf("Pushing edits to games connecting to %s\n", _socketPath);
+    return true;
+}
+
+void LivePushStop(void)
+{
+    while (_clientCount > 0) Disconnect(_clientCount - 1);
+    if (_listenFd >= 0)
+    {
+        close(_listenFd);
+        unlink(_socketPath);
+        _listenFd = -1;
+    }
+    FreeBuffer(&_frame);
+    MemFree(_queued);
+    _queued = NULL;
+    _queuedCount = _queuedCapacity = 0;
+}
+
+void LivePushElement(EditLayer layer, int index, const cJSON *element)
+{
+    if (_clientCount == 0) return;
+    if (_queuedCount == _queuedCapacity)
+    {
+        int capacity = _queuedCapacity ? _queuedCapacity * 2 : 64;
+        QueuedElement *queued = (QueuedElement *)MemRealloc(_queued, (size_t)capacity * sizeof(QueuedElement));
+        if (queued == NULL) return;
+        _queued = queued;
+        _queuedCapacity = capacity;
+    }
+    _queued[_queuedCount++] = (QueuedElement){ layer, index, element };
+}
+
+void LivePushUpdate(void)
+{
+    if (_listenFd < 0) return;
+
+    uint64_t version = ChangesGetVersion();
+    if (_clientCount > 0 && (version != _pushedVersion || _queuedCount > 0))
+    {
+        ProfileBegin("push");
+        MemPushSubsystem(MEM_SUBSYSTEM_EXPORT);
+        uint64_t now = NowNs();
+        _frame.length = 0;
+
+        // A layer that had elements added or removed goes whole; the indices of its deltas would not line up
+        bool complete = ChangesComplete(_pushedVersion);
+        bool whole[LAYER_COUNT];
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+        {
+            whole[layer] = !complete || ChangesGetStructureVersion((EditLayer)layer) > _pushedVersion;
+            cJSON *json = GetLayerJSON((EditLayer)layer);
+            if (whole[layer] && json != NULL) AppendJSON(&_frame, PUSH_MESSAGE_LAYER, (EditLayer)layer, 0, json, now);
+        }
+
+        for (int i = 0; i < _queuedCount; i++)
+        {
+            const QueuedElement *queued = &_queued[i];
+            if (!whole[queued->layer]) AppendJSON(&_frame, PUSH_MESSAGE_ELEMENT, queued->layer, queued->index, queued->element, now);
+        }
+
+        ElementChange change;
+        ChangeIterator it = ChangesBegin(_pushedVersion);
+        while (complete && ChangesNext(&it, &change))
+        {
+            if (!whole[change.layer]) AppendPoints(&_frame, change.layer, change.index, change.element, now);
+        }
+        AppendFrameEnd(&_frame, now);
+
+        for (int i = _clientCount - 1; i >= 0; i--)
+        {
+            if (Send(&_clients[i], &_frame)) continue;
+            printf("Game on %s disconnected or fell too far behind\n", _socketPath);
+            Disconnect(i);
+        }
+        if (_frame.capacity > PENDING_KEEP_BYTES) FreeBuffer(&_frame);
+        MemPopSubsystem();
+        ProfileEnd();
+    }
+    else
+    {
+        // Games that could not take everything last frame get the rest
+        for (int i = _clientCount - 1; i >= 0; i--)
+        {
+            if (_clients[i].pending.length > 0 && !Flush(&_clients[i])) Disconnect(i);
+        }
+    }
+    _pushedVersion = version;
+    _queuedCount = 0;
+
+    // New games get the current document, which already includes this frame
+    AcceptClients();
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef LIVE_PUSH_H
+#define LIVE_PUSH_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Sends edits to running game instances over a Unix domain socket (see push_protocol.h for
+// the format and push_client.h for the receiving side). Once per frame the elements changed
+// since the last frame are read from the change log and each of their points goes out as a
+// 40 byte POINT delta; layers that had elements added or removed are sent whole. With no game
+// connected nothing is encoded.
+
+/**
+ * @brief Listens for games on a socket path, replacing a stale socket file left behind.
+ * @return false if the socket could not be created or another editor listens on it.
+ */
+bool LivePushStart(const char *socketPath);
+
+/**
+ * @brief Disconnects every game and removes the socket file.
+ */
+void LivePushStop(void);
+
+/**
+ * @brief Queues an element whose fields other than its points changed, to be sent whole
+ *        with the next update. Point moves are picked up from the change log by themselves.
+ */
+void LivePushElement(EditLayer layer, int index, const cJSON *element);
+
+/**
+ * @brief Sends the changes of this frame and accepts new games. Call once per frame after editing.
+ */
+void LivePushUpdate(void);
+
+#endif // LIVE_PUSH_H
@@ -0,0 +1,588 @@
+#include "live_reload.h"
+#include "diff.h"
+#include "changes.h"
+#include "handles.h"
+#include "point_cache.h"
+#include "structure_cache.h"
+#include "export.h"
+#include "file_util.h"
+#include "journal.h"
+#include "live_push.h"
+#include "parallel_parse.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define MAX_WATCH_PATH 2048
+#define POLL_INTERVAL_MS 1000.0     // Where there is no inotify
+#define SETTLE_MS 200.0             // Quiet time after the last write before the file is read
+
+// Work on the background thread: reading, parsing and preparing the diff and export index of the
+// new file, or freeing what is left of it afterwards. The main thread looks at the results once done is set.
+typedef struct {
+    pthread_t thread;
+    bool running;                   // Started and not joined yet
+    bool done;
+    bool disposing;
+    char path[MAX_WATCH_PATH];
+    char *text;
+    size_t length;
+    cJSON *document;
+    FlatConfig *flat;
+    ExportSourceScan *scan;
+    int64_t size;                   // Identity of the file that was read
+    int64_t modTime;
+} ReloadJob;
+
+static char _path[MAX_WATCH_PATH] = { 0 };
+static bool _watching = false;
+static bool _known = false;         // The identity below is that of the file the document matches
+static int64_t _knownSize = 0;
+static int64_t _knownModTime = 0;
+static double _changedAt = -1.0;    // Time of the last change not acted on yet
+static double _lastPoll = 0.0;
+static ReloadJob _job = { 0 };
+static pthread_mutex_t _jobLock = PTHREAD_MUTEX_INITIALIZER;
+#if defined(__linux__)
+static int _notifyFd = -1;
+#endif
+
+//------------------------------------------------------------------------------------
+// File helpers
+//------------------------------------------------------------------------------------
+static const char *FileName(const char *path)
+{
+    const char *name = path;
+    for (const char *c = path; *c != '\0'; c++)
+    {
+        if (*c == '/' || *c == '\\') name = c + 1;
+    }
+    return name;
+}
+
+static char *ReadFile(const char *path, size_t *length, int64_t *size, int64_t *modTime)
+{
+    if (!GetFileIdentity(path, size, modTime)) return NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    char *text = MemAlloc((size_t)*size + 1);
+    if (text != NULL)
+    {
+        *length = fread(text, 1, (size_t)*size, file);
+        text[*length] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+//------------------------------------------------------------------------------------
+// Background parse
+//------------------------------------------------------------------------------------
+static void FreeJobData(ReloadJob *job)
+{
+    DiffFreeFlat(job->flat);
+    ExportFreeScan(job->scan);
+    if (job->document != NULL) cJSON_Delete(job->document);
+    MemFree(job->text);
+    job->flat = NULL;
+    job->scan = NULL;
+    job->document = NULL;
+    job->text = NULL;
+}
+
+static void *JobMain(void *argument)
+{
+    ReloadJob *job = argument;
+    MemWorkerBegin(MEM_SUBSYSTEM_LOAD);
+
+    if (job->disposing) FreeJobData(job);
+    else
+    {
+        // One thread: the parser's own workers would merge their counts while the main thread allocates
+        job->text = ReadFile(job->path, &job->length, &job->size, &job->modTime);
+        if (job->text != NULL) job->document = ParseConfig(job->text, job->length, 1);
+        if (job->document != NULL)
+        {
+            job->flat = DiffFlatten(job->document);
+            job->scan = ExportScanSource(job->text, job->length);
+        }
+    }
+
+    MemWorkerHandOff();
+    pthread_mutex_lock(&_jobLock);
+    job->done = true;
+    pthread_mutex_unlock(&_jobLock);
+    return NULL;
+}
+
+static bool StartJob(void)
+{
+    _job = (ReloadJob){ 0 };
+    snprintf(_job.path, sizeof(_job.path), "%s", _path);
+    _job.running = pthread_create(&_job.thread, NULL, JobMain, &_job) == 0;
+    return _job.running;
+}
+
+// Freeing a parsed config takes about as long as parsing it, so what the reload did not take over goes to the background too
+static void StartDisposing(void)
+{
+    _job.done = false;
+    _job.disposing = true;
+    _job.running = pthread_create(&_job.thread, NULL, JobMain, &_job) == 0;
+    if (!_job.running) FreeJobData(&_job);
+}
+
+static bool JobDone(void)
+{
+    pthread_mutex_lock(&_jobLock);
+    bool done = _job.done;
+    pthread_mutex_unlock(&_jobLock);
+    return done;
+}
+
+static void EndJob(void)
+{
+    if (_job.running) pthread_join(_job.thread, NULL);
+    MemMergeWorkers();
+    FreeJobData(&_job);
+    _job = (ReloadJob){ 0 };
+}
+
+//------------------------------------------------------------------------------------
+// Applying a diff in place
+//------------------------------------------------------------------------------------
+// The layer whose array (or world area object) holds a changed item, LAYER_COUNT for other sections
+static EditLayer ContainerLayer(const cJSON *container)
+{
+    for (int i = 0; i < LAYER_COUNT && container != NULL; i++)
+    {
+        if (GetLayerJSON((EditLayer)i) == container) return (EditLayer)i;
+    }
+    return LAYER_COUNT;
+}
+
+// The layer element a change touches: the item itself, or the world area it is a member of
+static cJSON *ChangedElement(const DiffChange *change, EditLayer layer, int *index)
+{
+    *index = IsWorldAreaLayer(layer) ? 0 : change->beforePosition;
+    return IsWorldAreaLayer(layer) ? change->beforeContainer : change->before;
+}
+
+// Gives before the value of after. Objects and arrays keep their node and take over after's
+// members, so pointers to the element stay valid.
+static bool ReplaceValue(cJSON *container, cJSON *before, cJSON *after)
+{
+    if ((before->type & 0xFF) == (after->type & 0xFF) && (cJSON_IsObject(before) || cJSON_IsArray(before)))
+    {
+        cJSON *old = before->child;
+        before->child = after->child;
+        after->child = NULL;
+        cJSON_Delete(old);
+        return true;
+    }
+
+    cJSON *copy = cJSON_Duplicate(after, true);
+    if (copy == NULL) return false;
+    return cJSON_ReplaceItemViaPointer(container, before, copy);
+}
+
+// Moves the cached points of an element to its new values
+static void RefreshPoints(EditLayer layer, int index, cJSON *element)
+{
+    PointField fields[2] = { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX };
+    int fieldCount = 2;
+    if (layer == LAYER_STRUCTURES) { fields[0] = POINT_FIELD_LOCATION; fieldCount = 1; }
+    else if (layer == LAYER_BOOST_GATES || layer == LAYER_PORTALS) { fields[0] = POINT_FIELD_A; fields[1] = POINT_FIELD_B; }
+
+    for (int i = 0; i < fieldCount; i++)
+    {
+        cJSON *xItem = NULL, *yItem = NULL;
+        if (GetPointItemsJSON(element, fields[i], &xItem, &yItem)) PointCacheSet((PointRef){ layer, index, fields[i] }, (float)xItem->valuedouble, (float)yItem->valuedouble);
+    }
+}
+
+// A change that cannot be applied in place means loading the file again, unless that would lose edits
+static LiveReloadResult ReloadFully(bool unsaved)
+{
+    if (!unsaved) return LIVE_RELOAD_FULL;
+    printf("WARNING: %s changed on disk in a way that needs a full reload, which would lose the unsaved edits. Export or use Reload Config.\n", _path);
+    return LIVE_RELOAD_NONE;
+}
+
+typedef struct {
+    int index;
+    cJSON *element;
+} RebaseInsert;
+
+static int CompareInts(const void *a, const void *b)
+{
+    int left = *(const int *)a, right = *(const int *)b;
+    return (left > right) - (left < right);
+}
+
+static int CompareInserts(const void *a, const void *b)
+{
+    return CompareInts(&((const RebaseInsert *)a)->index, &((const RebaseInsert *)b)->index);
+}
+
+// Starts the journal over for the new file, with the edits that were kept over it, so a crash
+// replays them onto the file that is now on disk. A kept layer still holds the document's
+// elements, where the file's changes were removed, changed and added; elsewhere only kept
+// modifications differ, at the file's positions. Of a world area only the bounds are editable.
+static void RebaseJournal(const DiffChangeList *list, const bool *keptChanges, const bool keepLayer[LAYER_COUNT])
+{
+    JournalReset();
+
+    int capacity = list->count > 0 ? list->count : 1;
+    int *removed = MemAlloc(sizeof(int) * capacity);
+    RebaseInsert *inserted = MemAlloc(sizeof(RebaseInsert) * capacity);
+    int *indices = MemAlloc(sizeof(int) * capacity);
+    cJSON **elements = MemAlloc(sizeof(cJSON *) * capacity);
+    bool allocated = removed != NULL && inserted != NULL && indices != NULL && elements != NULL;
+    if (!allocated) printf("WARNING: Not enough memory to journal the edits kept over %s; export them soon.\n", _path);
+
+    for (int layer = 0; allocated && layer < LAYER_COUNT; layer++)
+    {
+        int removedCount = 0, insertedCount = 0;
+        bool boundsKept = false;
+        for (int i = 0; i < list->count; i++)
+        {
+            const DiffChange *change = &list->changes[i];
+            if (!keptChanges[i] || ContainerLayer(change->beforeContainer) != (EditLayer)layer) continue;
+            if (IsWorldAreaLayer((EditLayer)layer)) { boundsKept = true; continue; }
+
+            if (change->kind != DIFF_REMOVED) removed[removedCount++] = change->afterPosition;
+            if (change->kind != DIFF_ADDED)
+            {
+                int index = keepLayer[layer] ? change->beforePosition : change->afterPosition;
+                inserted[insertedCount++] = (RebaseInsert){ index, change->before };
+            }
+        }
+
+        if (boundsKept)
+        {
+            cJSON *minX = NULL, *minY = NULL, *maxX = NULL, *maxY = NULL;
+            cJSON *area = GetLayerJSON((EditLayer)layer);
+            if (GetPointItemsJSON(area, POINT_FIELD_MIN_MIN, &minX, &minY) && GetPointItemsJSON(area, POINT_FIELD_MAX_MAX, &maxX, &maxY))
+            {
+                int bounds[4] = { minX->valueint, minY->valueint, maxX->valueint, maxY->valueint };
+                JournalAppendBounds((EditLayer)layer, 0, bounds);
+            }
+        }
+        if (removedCount > 0)
+        {
+            qsort(removed, (size_t)removedCount, sizeof(int), CompareInts);
+            JournalAppendRemoveMany((EditLayer)layer, removed, removedCount);
+        }
+        if (insertedCount > 0)
+        {
+            qsort(inserted, (size_t)insertedCount, sizeof(RebaseInsert), CompareInserts);
+            for (int i = 0; i < insertedCount; i++)
+            {
+                indices[i] = inserted[i].index;
+                elements[i] = inserted[i].element;
+            }
+            JournalAppendInsertMany((EditLayer)layer, indices, elements, insertedCount);
+        }
+    }
+
+    MemFree(removed);
+    MemFree(inserted);
+    MemFree(indices);
+    MemFree(elements);
+}
+
+static LiveReloadResult ApplyDocument(const FlatConfig *fresh, ExportSourceScan **scan, size_t length)
+{
+    if (_configJson == NULL) return LIVE_RELOAD_FULL;
+
+    // Unsaved edits win over the file: edited elements are kept, and so are layers whose
+    // indices no longer line up with the file because elements were added or removed
+    uint64_t saved = ExportGetSavedVersion();
+    bool unsaved = ChangesGetVersion() > saved;
+
+    ProfileBegin("diff");
+    DiffChangeList list = DiffCollectChanges(_configJson, fresh);
+    ProfileEnd();
+    if (!list.sameLayout)
+    {
+        DiffFreeChanges(&list);
+        return ReloadFully(unsaved);
+    }
+
+    // A layer element that changed its type cannot be updated in place
+    for (int i = 0; i < list.count; i++)
+    {
+        const DiffChange *change = &list.changes[i];
+        EditLayer layer = ContainerLayer(change->beforeContainer);
+        bool element = layer != LAYER_COUNT && !IsWorldAreaLayer(layer);
+        if (element && change->kind == DIFF_MODIFIED && (change->before->type & 0xFF) != (change->after->type & 0xFF))
+        {
+            DiffFreeChanges(&list);
+            return ReloadFully(unsaved);
+        }
+    }
+
+    // Which changes were left out for the edits, to carry those edits over in the journal
+    bool *keptChanges = MemCalloc(list.count > 0 ? list.count : 1, sizeof(bool));
+    if (keptChanges == NULL)
+    {
+        DiffFreeChanges(&list);
+        return ReloadFully(unsaved);
+    }
+
+    bool keepLayer[LAYER_COUNT] = { 0 };
+    for (int i = 0; i < LAYER_COUNT; i++) keepLayer[i] = unsaved && (!ChangesComplete(saved) || ChangesGetStructureVersion((EditLayer)i) > saved);
+
+    bool restructured[LAYER_COUNT] = { 0 };
+    bool regionsChanged = false;
+    int added = 0, removed = 0, modified = 0, kept = 0;
+
+    // Modifications first, while the positions of before are still current
+    for (int i = 0; i < list.count; i++)
+    {
+        DiffChange *change = &list.changes[i];
+        if (change->kind != DIFF_MODIFIED) continue;
+
+        int index = 0;
+        EditLayer layer = ContainerLayer(change->beforeContainer);
+        cJSON *element = (layer != LAYER_COUNT) ? ChangedElement(change, layer, &index) : NULL;
+        if (element != NULL && (keepLayer[layer] || (unsaved && ChangesGetElementVersion(element) > saved))) { kept++; keptChanges[i] = true; continue; }
+        if (!ReplaceValue(change->beforeContainer, change->before, change->after)) continue;
+
+        modified++;
+        regionsChanged |= (change->beforeContainer == _regions);
+        if (element == NULL) continue;
+        ChangesMarkElement(layer, index, element);
+        RefreshPoints(layer, index, element);
+        LivePushElement(layer, index, element);
+    }
+
+    // Removals from the highest position down, so the positions of the rest stay valid
+    for (int i = list.count - 1; i >= 0; i--)
+    {
+        DiffChange *change = &list.changes[i];
+        if (change->kind != DIFF_REMOVED) continue;
+
+        int index = 0;
+        EditLayer layer = ContainerLayer(change->beforeContainer);
+        cJSON *element = (layer != LAYER_COUNT) ? ChangedElement(change, layer, &index) : NULL;
+        if (element != NULL && keepLayer[layer]) { kept++; keptChanges[i] = true; continue; }
+
+        cJSON *detached = cJSON_DetachItemViaPointer(change->beforeContainer, change->before);
+        removed++;
+        regionsChanged |= (change->beforeContainer == _regions);
+        if (element != NULL && IsWorldAreaLayer(layer))
+        {
+            ChangesMarkElement(layer, index, element);
+            RefreshPoints(layer, index, element);
+            LivePushElement(layer, index, element);
+        }
+        else if (element != NULL)
+        {
+            ChangesMarkElement(layer, index, detached);
+            HandleRelease(detached);
+            restructured[layer] = true;
+        }
+        cJSON_Delete(detached);
+    }
+
+    // Additions in the order of the file, each at its final position
+    for (int i = 0; i < list.count; i++)
+    {
+        DiffChange *change = &list.changes[i];
+        if (change->kind != DIFF_ADDED) continue;
+
+        EditLayer layer = ContainerLayer(change->beforeContainer);
+        if (layer != LAYER_COUNT && keepLayer[layer]) { kept++; keptChanges[i] = true; continue; }
+
+        cJSON *copy = cJSON_Duplicate(change->after, true);
+        if (copy == NULL) continue;
+        bool inserted = cJSON_IsArray(change->beforeContainer) ? cJSON_InsertItemInArray(change->beforeContainer, change->afterPosition, copy)
+                                                               : cJSON_AddItemToObject(change->beforeContainer, change->after->string, copy);
+        if (!inserted) { cJSON_Delete(copy); continue; }
+
+        added++;
+        regionsChanged |= (change->beforeContainer == _regions);
+        if (layer == LAYER_COUNT) continue;
+        if (IsWorldAreaLayer(layer))
+        {
+            ChangesMarkElement(layer, 0, change->beforeContainer);
+            RefreshPoints(layer, 0, change->beforeContainer);
+            LivePushElement(layer, 0, change->beforeContainer);
+        }
+        else restructured[layer] = true;
+    }
+
+    for (int i = 0; i < LAYER_COUNT; i++)
+    {
+        if (restructured[i]) HandleLayerChanged((EditLayer)i);
+    }
+    // Region names and colours are resolved by index when the structure cache is built
+    if (regionsChanged) StructureCacheClear();
+
+    // A document that matches the new file takes it as its export source; otherwise the next export writes everything
+    if (!unsaved)
+    {
+        ExportIndexScanned(_path, *scan, length);
+        *scan = NULL;
+        JournalReset();
+    }
+    else
+    {
+        ExportClear();
+        RebaseJournal(&list, keptChanges, keepLayer);
+    }
+    MemFree(keptChanges);
+    DiffFreeChanges(&list);
+
+    printf("Reloaded %s: %d added, %d removed, %d changed", _path, added, removed, modified);
+    if (kept > 0) printf(", %d kept with unsaved edits", kept);
+    printf("\n");
+    return (added + removed + modified > 0) ? LIVE_RELOAD_APPLIED : LIVE_RELOAD_NONE;
+}
+
+static LiveReloadResult FinishJob(void)
+{
+    pthread_join(_job.thread, NULL);
+    _job.running = false;
+    MemMergeWorkers();
+    if (_job.disposing)
+    {
+        _job = (ReloadJob){ 0 };
+        return LIVE_RELOAD_NONE;
+    }
+
+    LiveReloadResult result = LIVE_RELOAD_NONE;
+    if (_job.text == NULL) printf("WARNING: Could not read %s to reload it.\n", _path);
+    else if (_job.document == NULL) printf("WARNING: %s changed on disk but does not parse; keeping the loaded config.\n", _path);
+    else if (_job.flat == NULL) printf("WARNING: Not enough memory to reload %s.\n", _path);
+    else
+    {
+        ProfileBegin("live reload");
+        MemPushSubsystem(MEM_SUBSYSTEM_LOAD);
+        result = ApplyDocument(_job.flat, &_job.scan, _job.length);
+        MemPopSubsystem();
+        ProfileEnd();
+    }
+
+    // The version that was read counts as seen even if it could not be used, so it is not read again
+    if (_job.text != NULL)
+    {
+        _known = true;
+        _knownSize = _job.size;
+        _knownModTime = _job.modTime;
+    }
+    DiffFreeFlat(_job.flat);
+    _job.flat = NULL;
+    StartDisposing();
+    return result;
+}
+
+//------------------------------------------------------------------------------------
+// Watching
+//------------------------------------------------------------------------------------
+#if defined(__linux__)
+// Reads every pending event and reports whether one was about the config
+static bool ReadNotifications(void)
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const char *name = FileName(_path);
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(_notifyFd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *p = buffer; p < buffer + length; p += sizeof(struct inotify_event) + ((struct inotify_event *)p)->len)
+        {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0 && strcmp(event->name, name) == 0) changed = true;
+        }
+    }
+    return changed;
+}
+#endif
+
+static bool FileChanged(void)
+{
+    int64_t size, modTime;
+    if (!GetFileIdentity(_path, &size, &modTime)) return false;
+    return !_known || size != _knownSize || modTime != _knownModTime;
+}
+
+void LiveReloadWatch(const char *path)
+{
+    LiveReloadStop();
+    snprintf(_path, sizeof(_path), "%s", path);
+    _known = GetFileIdentity(_path, &_knownSize, &_knownModTime);
+    _changedAt = -1.0;
+    _lastPoll = ProfilerGetTime();
+    _watching = true;
+
+#if defined(__linux__)
+    // The directory is watched, since saving by renaming a new file over the old one replaces the watched inode
+    char directory[MAX_WATCH_PATH];
+    size_t directoryLength = (size_t)(FileName(_path) - _path);
+    snprintf(directory, sizeof(directory), "%.*s", (int)directoryLength, _path);
+    if (directoryLength == 0) snprintf(directory, sizeof(directory), ".");
+
+    _notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_notifyFd >= 0 && inotify_add_watch(_notifyFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(_notifyFd);
+        _notifyFd = -1;
+    }
+#endif
+}
+
+void LiveReloadStop(void)
+{
+    EndJob();
+    _watching = false;
+#if defined(__linux__)
+    if (_notifyFd >= 0) close(_notifyFd);
+    _notifyFd = -1;
+#endif
+}
+
+void LiveReloadNoteWrite(void)
+{
+    if (!_watching) return;
+    _known = GetFileIdentity(_path, &_knownSize, &_knownModTime);
+}
+
+LiveReloadResult LiveReloadUpdate(bool canApply)
+{
+    if (!_watching) return LIVE_RELOAD_NONE;
+    if (_job.running) return (canApply && JobDone()) ? FinishJob() : LIVE_RELOAD_NONE;
+
+    double now = ProfilerGetTime();
+    bool changed = false;
+#if defined(__linux__)
+    if (_notifyFd >= 0) changed = ReadNotifications();
+    else
+#endif
+    if (now - _lastPoll >= POLL_INTERVAL_MS)
+    {
+        _lastPoll = now;
+        changed = FileChanged();
+    }
+    if (changed) _changedAt = now;
+
+    // Generators often write a file in several steps, so it is read once it has been quiet for a moment.
+    // The editor's own exports leave the file as recorded and are skipped here.
+    if (_changedAt < 0.0 || now - _changedAt < SETTLE_MS) return LIVE_RELOAD_NONE;
+    _changedAt = -1.0;
+    if (!FileChanged()) return LIVE_RELOAD_NONE;
+
+    return StartJob() ? LIVE_RELOAD_NONE : LIVE_RELOAD_FULL;
+}
@@ -0,0 +1,50 @@
+#ifndef LIVE_RELOAD_H
+#define LIVE_RELOAD_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Picks up changes other programs make to the open config. The file is watched with inotify
+// (polled once a second where that is not available), read and parsed on a background thread,
+// and diffed against the document. Only the elements that differ are replaced, in place, so
+// handles, the selection and the view survive and the caches refresh just those elements.
+//
+// Elements with unsaved edits keep them: an element changed since the last export is left
+// alone, and so is every layer that had elements added or removed since then.
+
+typedef enum {
+    LIVE_RELOAD_NONE = 0,   // Nothing changed on disk, or the change is still being parsed
+    LIVE_RELOAD_APPLIED,    // Elements were changed in place; indices may have moved
+    LIVE_RELOAD_FULL        // The file cannot be applied element by element; load it again
+} LiveReloadResult;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Starts watching the config that was just loaded, replacing any previous watch.
+ * @param path Path of the config file.
+ */
+void LiveReloadWatch(const char *path);
+
+/**
+ * @brief Stops watching and waits for a background parse to finish, dropping its result.
+ */
+void LiveReloadStop(void);
+
+/**
+ * @brief Records the file as it is now, so the editor's own export is not reloaded.
+ */
+void LiveReloadNoteWrite(void);
+
+/**
+ * @brief Checks for changes on disk and starts parsing them in the background. Call once per frame.
+ * @param canApply Whether the document may change now; a finished parse waits until it can.
+ */
+LiveReloadResult LiveReloadUpdate(bool canApply);
+
+#endif // LIVE_RELOAD_H
@@ -7,6 +7,33 @@
 #include "raylib.h"
 #include "cJSON.h"
 #include "map_editor.h"
+#include "profiler.h"
+#include "memtrack.h"
+#include "headless.h"
+#include "undo.h"
+#include "journal.h"
+#include "export.h"
+#include "handles.h"
+#include "changes.h"
+#include "structure_cache.h"
+#include "point_cache.h"
+#include "hit_test.h"
+#include "picking.h"
+#include "string_pool.h"
+#include "parallel_parse.h"
+#include "simd_scan.h"
+#include "chunk_store.h"
+#include "minimap.h"
+#include "live_reload.h"
+#include "live_push.h"
+#include "region_check.h"
+#include "region_index.h"
+#include "region_assign.h"
+#include "connectivity.h"
+#include "duplicates.h"
+#include "schema.h"
+#include "snapping.h"
+#include "search.h"
 
 // Include headers for all editable element types
 #include "snow_region.h"
@@ -26,6 +53,13 @@
 #define MAX_FILEPATH_SIZE 2048
 #define SELECTED_STRUCTURE_FONT_SIZE 20
 #define MAX_SELECTED_ITEMS 512 // For multi-select
+#define SEARCH_LIST_SIZE 8 // Matches listed under the search box
+#define STRUCTURE_RADIUS 10
+#define STRUCTURE_LABEL_WIDTH 400 // Names are drawn to the right of the circle, region names below them
+#define STRUCTURE_LABEL_HEIGHT 40
+#define DEFAULT_TRACE_FRAMES 120
+#define DEFAULT_TRACE_FILE "map_editor_trace.json"
+#define MAX_LOAD_ISSUES 10 // Schema issues printed when a config is loaded
 
 //------------------------------------------------------------------------------------
 // Global Variables
@@ -64,6 +98,12 @@ SelectedItem _infoPanelItem = { -1, ELEMENT_TYPE_NONE };      // For displaying
 bool _isMarqueeSelecting = false;
 bool _isDraggingGroup = false;
 bool _potentialDrag = false;    // Flag to check if a drag should start
+int _dragDeltaX = 0;            // Integer delta applied to the dragged group, in world units
+int _dragDeltaY = 0;
+SelectedItem _dragAnchor = { -1, ELEMENT_TYPE_NONE }; // Item under the cursor at the press, the one snapped
+int _dragAnchorSlot = -1;       // Its place in the selection once the drag starts
+PointRef _draggedPoints[MAX_SELECTED_ITEMS]; // Never snapped to
+SnapResult _dragSnap = { 0 };
 Vector2 _marqueeStartPos = { 0 };
 Vector2 _mouseDownWorldPos = { 0 }; // Position where mouse was pressed, in world coords
 Rectangle _selectionMarquee = { 0 };
@@ -78,39 +118,185 @@ bool _showBoostGates = true;
 bool _showPortals = true;
 bool _showOceanWorldArea = true;
 bool _showSpaceWorldArea = true;
+bool _showRegionIssues = true;
+bool _showUnreachable = true;
+bool _showProfiler = false;
+bool _snapToGrid = false;
+bool _snapToPoints = true;
+bool _snapAlign = true;
+
+// Name search box
+char _searchText[SEARCH_QUERY_SIZE] = "";
+bool _searchEditing = false;    // Typing goes to the box instead of the shortcuts
+
+// Headless benchmark
+int _benchIterations = 0;
+
+// Headless diff (two paths) or merge (base, ours, theirs)
+const char *_diffPaths[3] = { NULL };
+int _diffPathCount = 0;
+const char *_mergeOutputPath = "merged.json";
+
+// Threads used to parse a config, 0 for one per processor
+int _parseThreads = 0;
+
+// Headless check of the SIMD byte scanners used by cJSON
+int _scanCheckIterations = 0;
+
+// Autosave journal, disabled for headless runs so they never touch files next to the config
+bool _journalEnabled = true;
+
+// Apply changes other programs make to the open config, off for headless runs
+bool _liveReloadEnabled = true;
+
+// Socket running games connect to for the edits as they happen, NULL to not push
+const char *_pushSocketPath = NULL;
+
+// Headless report of overlapping and out-of-world regions
+bool _checkRegions = false;
+
+// Headless report of the structures inside each weather region
+bool _regionReport = false;
+
+// Headless report of structures boats cannot reach
+bool _checkReach = false;
+
+// Headless report of elements that do not match the config schema
+bool _checkSchema = false;
+
+// Headless report of elements placed twice
+bool _checkDuplicates = false;
+
+// Headless name search, NULL for none
+const char *_findQuery = NULL;
+
+// Headless split of the loaded config into a chunked world, and the tile size it uses
+const char *_splitChunksDirectory = NULL;
+int _chunkSize = DEFAULT_CHUNK_SIZE;
 
 //------------------------------------------------------------------------------------
 // Helper function declarations
 //------------------------------------------------------------------------------------
 bool IsItemSelected(SelectedItem item);
 void ClearSelection(void);
+void RefreshSelection(void);
 void AddToSelection(SelectedItem item);
-cJSON* GetSelectedItemJSON(SelectedItem item);
+cJSON* GetSelectedElementJSON(SelectedItem item);
 void UpdateSelectedItemPosition(SelectedItem item, float x, float y);
 void Update();
 void Draw();
 void Cleanup();
 void LoadJsonData();
+void ReloadConfig(void);
 void CheckForDroppedFile();
 void ExportConfig();
 void AddStructure();
+void AssignRegions(void);
+void RemoveDuplicates(void);
+void JumpToSearchResult(SearchResult result);
+void JumpToNextSearchResult(void);
+void SelectSearchResults(void);
 void ControlCamera();
+uint32_t GetPickableLayers(void);
+void ParseCommandLine(int argc, char **argv);
+void DeleteSelection(void);
+void HandleUndoKeys(void);
 
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char **argv)
 {
+    MemTrackInit();
+    SimdScanInit();
+    _filePath = (char *)MemCalloc(MAX_FILEPATH_SIZE, 1);
+
+    ParseCommandLine(argc, argv);
+    if (_scanCheckIterations > 0)
+    {
+        int result = RunScanCheck(_scanCheckIterations);
+        Cleanup();
+        return result;
+    }
+    if (_diffPathCount > 0)
+    {
+        int result = (_diffPathCount == 2) ? RunDiff(_diffPaths[0], _diffPaths[1]) : RunMerge(_diffPaths[0], _diffPaths[1], _diffPaths[2], _mergeOutputPath);
+        Cleanup();
+        return result;
+    }
+    if (_splitChunksDirectory != NULL)
+    {
+        int result = _fileDropped ? RunSplitChunks(_splitChunksDirectory, _chunkSize) : 1;
+        if (!_fileDropped) printf("ERROR: --split-chunks needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_checkSchema)
+    {
+        int result = _fileDropped ? RunSchemaCheck() : 2;
+        if (!_fileDropped) printf("ERROR: --validate needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_checkRegions)
+    {
+        int result = _fileDropped ? RunRegionCheck() : 2;
+        if (!_fileDropped) printf("ERROR: --check-regions needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_checkReach)
+    {
+        int result = _fileDropped ? RunReachCheck() : 2;
+        if (!_fileDropped) printf("ERROR: --check-reach needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_checkDuplicates)
+    {
+        int result = _fileDropped ? RunDuplicateCheck() : 2;
+        if (!_fileDropped) printf("ERROR: --check-duplicates needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_findQuery != NULL)
+    {
+        int result = _fileDropped ? RunFind(_findQuery) : 2;
+        if (!_fileDropped) printf("ERROR: --find needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_regionReport)
+    {
+        int result = _fileDropped ? RunRegionReport() : 2;
+        if (!_fileDropped) printf("ERROR: --region-report needs a config path.\n");
+        Cleanup();
+        return result;
+    }
+    if (_benchIterations > 0)
+    {
+        int result = _fileDropped ? RunBenchmark(_benchIterations) : 1;
+        if (!_fileDropped) printf("ERROR: --bench needs a config path.\n");
+        ProfilerStopTrace();
+        Cleanup();
+        return result;
+    }
+
+    if (_pushSocketPath != NULL) LivePushStart(_pushSocketPath);
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Wee Boats Map Editor");
-    _filePath = (char *)RL_CALLOC(MAX_FILEPATH_SIZE, 1);
     SetTargetFPS(60);
 
     while (!WindowShouldClose())
     {
+        MemTrackBeginFrame();
+        ProfilerBeginFrame();
         Update();
         Draw();
+        ProfilerEndFrame();
     }
 
+    ProfilerStopTrace();
     Cleanup();
     CloseWindow();
     return 0;
@@ -121,70 +307,82 @@ int main(void)
 //------------------------------------------------------------------------------------
 void Update()
 {
+    // Profiling hotkeys work before a file is loaded too
+    if (IsKeyPressed(KEY_F3)) _showProfiler = !_showProfiler;
+    if (IsKeyPressed(KEY_F9)) ProfilerStartTrace(DEFAULT_TRACE_FILE, DEFAULT_TRACE_FRAMES);
+    if ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_F)) _searchEditing = true;
+
     CheckForDroppedFile();
     if (!_fileDropped) return;
 
+    ProfileBegin("update");
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+
     Vector2 mousePos = GetMousePosition();
     Vector2 worldMousePos = {(mousePos.x - _cameraOffset.x) / _displayScale, (mousePos.y - _cameraOffset.y) / _displayScale};
 
+    // Stream the tiles of a chunked world around the view. Evicting removes structures, so it
+    // waits until no drag or marquee holds indices into the structures array.
+    if (ChunkStoreIsOpen())
+    {
+        bool allowEvict = !_isDraggingGroup && !_isMarqueeSelecting && !IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+        float minX = -_cameraOffset.x / _displayScale;
+        float maxX = (SCREEN_WIDTH - _cameraOffset.x) / _displayScale;
+        float minY = (_cameraOffset.y - SCREEN_HEIGHT) / _displayScale;
+        float maxY = _cameraOffset.y / _displayScale;
+        if (ChunkStoreUpdate(minX, minY, maxX, maxY, allowEvict))
+        {
+            UndoClear();
+            RefreshSelection();
+        }
+    }
+
+    // Changes made to the config on disk are applied in place once no drag or marquee holds indices
+    bool canReload = !_isDraggingGroup && !_isMarqueeSelecting && !IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    LiveReloadResult reload = LiveReloadUpdate(canReload);
+    if (reload == LIVE_RELOAD_APPLIED)
+    {
+        UndoClear();
+        RefreshSelection();
+    }
+    else if (reload == LIVE_RELOAD_FULL) ReloadConfig();
+
     // Reset hover item
     _activeItem.index = -1;
     _activeItem.type = ELEMENT_TYPE_NONE;
+    _activeItem.handle = (ElementHandle){ 0 };
 
-    // --- Hover Detection ---
-    if (!_isDraggingGroup && !_isMarqueeSelecting)
+    // Clicks and drags on the minimap move the camera and never reach the map below it
+    if (!_isDraggingGroup && !_isMarqueeSelecting && !_potentialDrag && MinimapHandleMouse(mousePos, &_cameraOffset, _displayScale))
     {
-        // Check Structures
-        cJSON *structure = NULL;
-        int structureIndex = 0;
-        cJSON_ArrayForEach(structure, _structures)
-        {
-            cJSON *location = cJSON_GetObjectItem(structure, "location");
-            if(location)
-            {
-                Vector2 structureWorldPos = {cJSON_GetArrayItem(location, 0)->valuedouble, -cJSON_GetArrayItem(location, 1)->valuedouble};
-                if (CheckCollisionPointCircle(worldMousePos, structureWorldPos, 10.0f / _displayScale))
-                {
-                    _activeItem.index = structureIndex;
-                    _activeItem.type = ELEMENT_TYPE_STRUCTURE;
-                    goto hover_found; // Exit after finding one
-                }
-            }
-            structureIndex++;
-        }
+        HandleUndoKeys();
+        JournalUpdate();
+        LivePushUpdate();
+        ControlCamera();
+        MemPopSubsystem();
+        ProfileEnd();
+        return;
+    }
 
-        // Check Boost Gates
-        if (_showBoostGates)
-        {
-            cJSON *gate = NULL;
-            int gateIndex = 0;
-            cJSON_ArrayForEach(gate, _boost_gates)
-            {
-                cJSON *a = cJSON_GetObjectItem(gate, "a");
-                cJSON *b = cJSON_GetObjectItem(gate, "b");
-                Vector2 posA = { cJSON_GetArrayItem(a, 0)->valuedouble, -cJSON_GetArrayItem(a, 1)->valuedouble };
-                Vector2 posB = { cJSON_GetArrayItem(b, 0)->valuedouble, -cJSON_GetArrayItem(b, 1)->valuedouble };
-
-                if (CheckCollisionPointCircle(worldMousePos, posA, 10.0f / _displayScale)) {
-                    _activeItem.index = gateIndex;
-                    _activeItem.type = ELEMENT_TYPE_BOOST_GATE_A;
-                    goto hover_found;
-                }
-                if (CheckCollisionPointCircle(worldMousePos, posB, 10.0f / _displayScale)) {
-                    _activeItem.index = gateIndex;
-                    _activeItem.type = ELEMENT_TYPE_BOOST_GATE_B;
-                    goto hover_found;
-                }
-                gateIndex++;
-            }
-        }
+    // --- Hover Detection ---
+    // One pick over every visible handle, so overlapping handles resolve the same way each frame
+    ProfileBegin("hover");
+    PointRef picked;
+    if (!_isDraggingGroup && !_isMarqueeSelecting && PickNearest(worldMousePos.x, -worldMousePos.y, _displayScale, GetPickableLayers(), &picked))
+    {
+        _activeItem = SelectedItemFromPointRef(picked);
     }
-hover_found:; // Label to jump to after finding a hovered item
+    ProfileEnd();
 
     // --- Handle Mouse Input ---
+    HandleUndoKeys();
+
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
     {
+        // Everything edited until the button is released becomes one undo step
+        UndoBeginTransaction();
         _mouseDownWorldPos = worldMousePos;
+        _dragAnchor = _activeItem;
 
         if (_activeItem.index != -1) // Clicked on an item
         {
@@ -216,26 +414,51 @@ hover_found:; // Label to jump to after finding a hovered item
         if (_potentialDrag && !_isDraggingGroup && Vector2Distance(worldMousePos, _mouseDownWorldPos) > (5.0f / _displayScale))
         {
             _isDraggingGroup = true;
+            _dragDeltaX = 0;
+            _dragDeltaY = 0;
+            _dragAnchorSlot = -1;
+            _dragSnap = (SnapResult){ 0 };
             // Store original positions of all selected items
             for (int i = 0; i < _selectedItemCount; i++)
             {
-                cJSON* item_json = GetSelectedItemJSON(_selectedItems[i]);
-                if (item_json) {
-                    _selectedItems[i].dragStartPosition.x = cJSON_GetArrayItem(item_json, 0)->valuedouble;
-                    _selectedItems[i].dragStartPosition.y = cJSON_GetArrayItem(item_json, 1)->valuedouble;
+                _draggedPoints[i] = PointRefFromSelection(_selectedItems[i]);
+                PointRef anchor = PointRefFromSelection(_dragAnchor);
+                if (_draggedPoints[i].layer == anchor.layer && _draggedPoints[i].index == anchor.index && _draggedPoints[i].field == anchor.field) _dragAnchorSlot = i;
+                cJSON *xItem = NULL, *yItem = NULL;
+                if (GetPointItemsJSON(GetSelectedElementJSON(_selectedItems[i]), PointRefFromSelection(_selectedItems[i]).field, &xItem, &yItem)) {
+                    _selectedItems[i].dragStartPosition.x = xItem->valuedouble;
+                    _selectedItems[i].dragStartPosition.y = yItem->valuedouble;
                 }
             }
         }
 
         if (_isDraggingGroup)
         {
+            // Whole world units, so the group moves rigidly and the move can be undone exactly
             Vector2 dragDelta = Vector2Subtract(worldMousePos, _mouseDownWorldPos);
-            // Update positions of all selected items
-            for (int i = 0; i < _selectedItemCount; i++)
+            int deltaX = (int)dragDelta.x;
+            int deltaY = -(int)dragDelta.y; // Y is flipped
+
+            // The point that was grabbed snaps and takes the group with it; Alt drags freely
+            int snapModes = (_snapToGrid ? SNAP_GRID : 0) | (_snapToPoints ? SNAP_POINTS : 0) | (_snapAlign ? SNAP_ALIGN : 0);
+            _dragSnap = (SnapResult){ 0 };
+            if (_dragAnchorSlot >= 0 && snapModes != 0 && !IsKeyDown(KEY_LEFT_ALT) && !IsKeyDown(KEY_RIGHT_ALT))
+            {
+                ProfileBegin("snap");
+                Vector2 start = _selectedItems[_dragAnchorSlot].dragStartPosition;
+                _dragSnap = SnapPoint(start.x + dragDelta.x, start.y - dragDelta.y, _displayScale, GetPickableLayers(), _draggedPoints, _selectedItemCount, snapModes);
+                if (_dragSnap.snappedX) deltaX = (int)lroundf(_dragSnap.x - start.x);
+                if (_dragSnap.snappedY) deltaY = (int)lroundf(_dragSnap.y - start.y);
+                ProfileEnd();
+            }
+            if (deltaX != _dragDeltaX || deltaY != _dragDeltaY)
             {
-                float newX = _selectedItems[i].dragStartPosition.x + dragDelta.x;
-                float newY = _selectedItems[i].dragStartPosition.y - dragDelta.y; // Y is flipped
-                UpdateSelectedItemPosition(_selectedItems[i], newX, newY);
+                _dragDeltaX = deltaX;
+                _dragDeltaY = deltaY;
+                for (int i = 0; i < _selectedItemCount; i++)
+                {
+                    UpdateSelectedItemPosition(_selectedItems[i], _selectedItems[i].dragStartPosition.x + deltaX, _selectedItems[i].dragStartPosition.y + deltaY);
+                }
             }
         }
         else if (_isMarqueeSelecting)
@@ -254,44 +477,28 @@ hover_found:; // Label to jump to after finding a hovered item
         {
             _isMarqueeSelecting = false;
             
-            // Select structures within marquee
-            int structureIndex = 0;
-            cJSON* structure = NULL;
-            cJSON_ArrayForEach(structure, _structures)
+            // Select structures and boost gates within marquee, tested in world space in one batch per set
+            float minX = (_selectionMarquee.x - _cameraOffset.x) / _displayScale;
+            float maxX = (_selectionMarquee.x + _selectionMarquee.width - _cameraOffset.x) / _displayScale;
+            float minY = (_cameraOffset.y - _selectionMarquee.y - _selectionMarquee.height) / _displayScale;
+            float maxY = (_cameraOffset.y - _selectionMarquee.y) / _displayScale;
+            SelectableElementType types[] = { ELEMENT_TYPE_STRUCTURE, ELEMENT_TYPE_BOOST_GATE_A, ELEMENT_TYPE_BOOST_GATE_B };
+            for (int t = 0; t < 3; t++)
             {
-                cJSON* location = cJSON_GetObjectItem(structure, "location");
-                if (location)
-                {
-                    Vector2 screenPos = { (cJSON_GetArrayItem(location, 0)->valuedouble * _displayScale) + _cameraOffset.x, -(cJSON_GetArrayItem(location, 1)->valuedouble * _displayScale) + _cameraOffset.y };
-                    if (CheckCollisionPointRec(screenPos, _selectionMarquee))
-                    {
-                        AddToSelection((SelectedItem){structureIndex, ELEMENT_TYPE_STRUCTURE});
-                    }
-                }
-                structureIndex++;
-            }
+                if (types[t] != ELEMENT_TYPE_STRUCTURE && !_showBoostGates) continue;
 
-            // Select boost gates within marquee
-            if (_showBoostGates)
-            {
-                int gateIndex = 0;
-                cJSON* gate = NULL;
-                cJSON_ArrayForEach(gate, _boost_gates)
+                const PointSet *points = GetPointSet(types[t]);
+                uint32_t *mask = HitTestGetMask(points->count);
+                if (mask == NULL || HitTestRect(points->xs, points->ys, points->count, minX, minY, maxX, maxY, mask) == 0) continue;
+
+                EditLayer layer = PointRefFromSelection((SelectedItem){ 0, types[t] }).layer;
+                for (int w = 0; w < HitTestMaskWords(points->count); w++)
                 {
-                    cJSON* a = cJSON_GetObjectItem(gate, "a");
-                    cJSON* b = cJSON_GetObjectItem(gate, "b");
-                    Vector2 screenPosA = { (cJSON_GetArrayItem(a, 0)->valuedouble * _displayScale) + _cameraOffset.x, -(cJSON_GetArrayItem(a, 1)->valuedouble * _displayScale) + _cameraOffset.y };
-                    Vector2 screenPosB = { (cJSON_GetArrayItem(b, 0)->valuedouble * _displayScale) + _cameraOffset.x, -(cJSON_GetArrayItem(b, 1)->valuedouble * _displayScale) + _cameraOffset.y };
-                    
-                    if (CheckCollisionPointRec(screenPosA, _selectionMarquee))
-                    {
-                        AddToSelection((SelectedItem){gateIndex, ELEMENT_TYPE_BOOST_GATE_A});
-                    }
-                    if (CheckCollisionPointRec(screenPosB, _selectionMarquee))
+                    for (uint32_t bits = mask[w]; bits != 0; bits &= bits - 1)
                     {
-                        AddToSelection((SelectedItem){gateIndex, ELEMENT_TYPE_BOOST_GATE_B});
+                        int index = w * 32 + HitTestLowestBit(bits);
+                        AddToSelection((SelectedItem){ index, types[t], { 0 }, HandleAt(layer, index) });
                     }
-                    gateIndex++;
                 }
             }
             _selectionMarquee = (Rectangle){0,0,0,0};
@@ -306,24 +513,34 @@ hover_found:; // Label to jump to after finding a hovered item
             }
         }
         
+        if (_isDraggingGroup && _selectedItemCount > 0)
+        {
+            PointRef *refs = MemAlloc(sizeof(PointRef) * _selectedItemCount);
+            if (refs)
+            {
+                for (int i = 0; i < _selectedItemCount; i++) refs[i] = PointRefFromSelection(_selectedItems[i]);
+                UndoRecordMove(refs, _selectedItemCount, _dragDeltaX, _dragDeltaY);
+                MemFree(refs);
+            }
+        }
+
         _isDraggingGroup = false;
         _potentialDrag = false;
     }
 
-    // Update other elements
-    if (_showSnowRegions) UpdateSnowRegions(_snow_regions, _cameraOffset, &_displayScale);
-    if (_showRainRegions) UpdateSnowRegions(_rain_regions, _cameraOffset, &_displayScale);
-    if (_showStarRegions) UpdateSnowRegions(_star_regions, _cameraOffset, &_displayScale);
-    // Update for boost gates is now handled in the main update loop
-    if (_showPortals) UpdatePortals(_portals, _cameraOffset, &_displayScale);
-    if (_showOceanWorldArea) UpdateWorldArea(_ocean_world_area, _cameraOffset, &_displayScale);
-    if (_showSpaceWorldArea) UpdateWorldArea(_space_world_area, _cameraOffset, &_displayScale);
+    if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) UndoEndTransaction();
+    JournalUpdate();
+    LivePushUpdate();
 
     ControlCamera();
+    MemPopSubsystem();
+    ProfileEnd();
 }
 
 void Draw()
 {
+    ProfileBegin("draw");
+    MemPushSubsystem(MEM_SUBSYSTEM_DRAW);
     BeginDrawing();
     ClearBackground(RAYWHITE);
 
@@ -335,38 +552,54 @@ void Draw()
     else
     {
         // Draw grid lines and all editable elements
+        ProfileBegin("draw regions");
         DrawLineEx((Vector2){_cameraOffset.x, 0}, (Vector2){_cameraOffset.x, SCREEN_HEIGHT}, 2, LIGHTGRAY);
         DrawLineEx((Vector2){0, _cameraOffset.y}, (Vector2){SCREEN_WIDTH, _cameraOffset.y}, 2, LIGHTGRAY);
-        if (_showOceanWorldArea) DrawWorldArea(_ocean_world_area, _cameraOffset, &_displayScale, "Ocean World Area", (Color){0, 117, 117, 150});
-        if (_showSpaceWorldArea) DrawWorldArea(_space_world_area, _cameraOffset, &_displayScale, "Space World Area", (Color){75, 0, 130, 150});
-        if (_showSnowRegions) DrawSnowRegions(_snow_regions, _cameraOffset, &_displayScale, "Snow Region");
-        if (_showRainRegions) DrawSnowRegions(_rain_regions, _cameraOffset, &_displayScale, "Rain Region");
-        if (_showStarRegions) DrawSnowRegions(_star_regions, _cameraOffset, &_displayScale, "Star Region");
+        if (_showOceanWorldArea) DrawWorldArea(_ocean_world_area, LAYER_OCEAN_WORLD_AREA, _cameraOffset, &_displayScale, "Ocean World Area", (Color){0, 117, 117, 150});
+        if (_showSpaceWorldArea) DrawWorldArea(_space_world_area, LAYER_SPACE_WORLD_AREA, _cameraOffset, &_displayScale, "Space World Area", (Color){75, 0, 130, 150});
+        if (_showSnowRegions) DrawSnowRegions(_snow_regions, LAYER_SNOW_REGIONS, _cameraOffset, &_displayScale, "Snow Region");
+        if (_showRainRegions) DrawSnowRegions(_rain_regions, LAYER_RAIN_REGIONS, _cameraOffset, &_displayScale, "Rain Region");
+        if (_showStarRegions) DrawSnowRegions(_star_regions, LAYER_STAR_REGIONS, _cameraOffset, &_displayScale, "Star Region");
+        if (_showRegionIssues) RegionCheckDraw(_cameraOffset, _displayScale);
         if (_showBoostGates) DrawBoostGates(_boost_gates, _cameraOffset, &_displayScale);
         if (_showPortals) DrawPortals(_portals, _cameraOffset, &_displayScale);
 
+        // Route between two selected structures
+        const ConnectivityPath *route = NULL;
+        if (_selectedItemCount == 2 && _selectedItems[0].type == ELEMENT_TYPE_STRUCTURE && _selectedItems[1].type == ELEMENT_TYPE_STRUCTURE)
+        {
+            route = ConnectivityGetPath(_selectedItems[0].index, _selectedItems[1].index);
+            ConnectivityDrawPath(route, _cameraOffset, _displayScale);
+        }
+        ProfileEnd();
+
         // Draw Structures
-        cJSON *structure = NULL;
-        int structureIndex = 0;
-        Color regionColors[] = {PINK, ORANGE, SKYBLUE, PURPLE, BROWN, BEIGE, VIOLET, GOLD, LIME};
-        cJSON_ArrayForEach(structure, _structures)
+        // Names and regions come from the structure cache, so no object lookups happen per structure.
+        // Only the structures whose circle or labels can reach the screen are visited.
+        ProfileBegin("draw structures");
+        const StructureCache *cache = GetStructureCache();
+        const PointSet *points = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+        int drawCount = (points->count < cache->count) ? points->count : cache->count;
+        uint32_t *visible = HitTestGetMask(drawCount);
+        float minX = (-STRUCTURE_LABEL_WIDTH - _cameraOffset.x) / _displayScale;
+        float maxX = (SCREEN_WIDTH + STRUCTURE_RADIUS - _cameraOffset.x) / _displayScale;
+        float minY = (_cameraOffset.y - SCREEN_HEIGHT - STRUCTURE_LABEL_HEIGHT) / _displayScale;
+        float maxY = (_cameraOffset.y + STRUCTURE_RADIUS) / _displayScale;
+        if (visible == NULL || HitTestRect(points->xs, points->ys, drawCount, minX, minY, maxX, maxY, visible) == 0) drawCount = 0;
+        for (int w = 0; w < HitTestMaskWords(drawCount); w++)
         {
-            cJSON *location = cJSON_GetObjectItem(structure, "location");
-            if (location)
+            for (uint32_t bits = visible[w]; bits != 0; bits &= bits - 1)
             {
-                int x = cJSON_GetArrayItem(location, 0)->valueint;
-                int y = cJSON_GetArrayItem(location, 1)->valueint;
+                int structureIndex = w * 32 + HitTestLowestBit(bits);
+                const cJSON *location = cache->locations[structureIndex];
+                if (location == NULL) continue;
+
+                int x = location->child->valueint;
+                int y = location->child->next->valueint;
                 Vector2 pos = {(x * _displayScale) + _cameraOffset.x, -(y * _displayScale) + _cameraOffset.y};
 
-                Color structureColor = GREEN;
-                char *regionName = "No Region";
-                if (cJSON_HasObjectItem(structure, "region_id"))
-                {
-                    int regionId = cJSON_GetObjectItem(structure, "region_id")->valueint;
-                    if (regionId < (sizeof(regionColors) / sizeof(regionColors[0]))) structureColor = regionColors[regionId];
-                    cJSON *region = cJSON_GetArrayItem(_regions, regionId);
-                    if (region) regionName = cJSON_GetObjectItem(region, "name")->valuestring;
-                }
+                int region = RegionAssignPreviewRegion(structureIndex, cache->regions[structureIndex]);
+                Color structureColor = cache->regionColors[region];
 
                 // Determine draw color based on selection/hover state
                 Color drawColor = structureColor;
@@ -374,21 +607,46 @@ void Draw()
                 if (IsItemSelected(currentItem)) drawColor = RED;
                 else if (_activeItem.index == structureIndex && _activeItem.type == ELEMENT_TYPE_STRUCTURE) drawColor = YELLOW;
 
-                DrawCircleV(pos, 10, drawColor);
-                if (_showNames) DrawText(cJSON_GetObjectItem(structure, "name")->valuestring, pos.x + 15, pos.y, 15, DARKGRAY);
-                if (_showRegionNames) DrawText(regionName, pos.x + 15, pos.y + 20, 15, structureColor);
+                DrawCircleV(pos, STRUCTURE_RADIUS, drawColor);
+                if (_showUnreachable && ConnectivityIsUnreachable(structureIndex)) DrawCircleLines(pos.x, pos.y, STRUCTURE_RADIUS + 5, RED);
+                if (_showNames) DrawText(StringPoolGet(cache->names[structureIndex]), pos.x + 15, pos.y, 15, DARKGRAY);
+                if (_showRegionNames) DrawText(StringPoolGet(cache->regionNames[region]), pos.x + 15, pos.y + 20, 15, structureColor);
+            }
+        }
 
-                // Info panel shows the last single-clicked item
-                if (_infoPanelItem.index == structureIndex && _infoPanelItem.type == ELEMENT_TYPE_STRUCTURE)
-                {
-                    DrawRectangle(SCREEN_WIDTH - 330, SCREEN_HEIGHT - 200, 320, 190, Fade(LIGHTGRAY, 0.8f));
-                    DrawText(cJSON_GetObjectItem(structure, "name")->valuestring, SCREEN_WIDTH - 320, SCREEN_HEIGHT - 180, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
-                    DrawText(TextFormat("Location: (%d, %d)", x, y), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 150, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
-                    DrawText(TextFormat("Region: %s", regionName), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 120, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
-                }
+        // Info panel shows the last single-clicked item, wherever it is on the map
+        if (_infoPanelItem.type == ELEMENT_TYPE_STRUCTURE && _infoPanelItem.index >= 0 && _infoPanelItem.index < cache->count && cache->locations[_infoPanelItem.index])
+        {
+            const cJSON *location = cache->locations[_infoPanelItem.index];
+            const char *regionName = StringPoolGet(cache->regionNames[cache->regions[_infoPanelItem.index]]);
+            DrawRectangle(SCREEN_WIDTH - 330, SCREEN_HEIGHT - 200, 320, 190, Fade(LIGHTGRAY, 0.8f));
+            DrawText(StringPoolGet(cache->names[_infoPanelItem.index]), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 180, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
+            DrawText(TextFormat("Location: (%d, %d)", location->child->valueint, location->child->next->valueint), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 150, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
+            DrawText(TextFormat("Region: %s", regionName), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 120, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
+
+            // Weather regions over the structure, from the region index
+            RegionBox weather[3];
+            int weatherCount = RegionIndexQueryPoint((float)location->child->valuedouble, (float)location->child->next->valuedouble, weather, 3);
+            char weatherText[96] = "none";
+            int length = 0;
+            for (int i = 0; i < weatherCount && i < 3; i++)
+            {
+                length += snprintf(weatherText + length, sizeof(weatherText) - length, "%s%s %d", (i > 0) ? ", " : "", RegionKindName(weather[i].layer), weather[i].index);
             }
-            structureIndex++;
+            if (weatherCount > 3) snprintf(weatherText + length, sizeof(weatherText) - length, " +%d", weatherCount - 3);
+            DrawText(TextFormat("Weather: %s", weatherText), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 90, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
+        }
+        else if (_infoPanelItem.type == ELEMENT_TYPE_BOUNDS_CORNER && _infoPanelItem.index >= 0 &&
+                 (_infoPanelItem.layer == LAYER_SNOW_REGIONS || _infoPanelItem.layer == LAYER_RAIN_REGIONS || _infoPanelItem.layer == LAYER_STAR_REGIONS))
+        {
+            int inside = RegionIndexCountStructures(_infoPanelItem.layer, _infoPanelItem.index);
+            DrawRectangle(SCREEN_WIDTH - 330, SCREEN_HEIGHT - 200, 320, 190, Fade(LIGHTGRAY, 0.8f));
+            DrawText(TextFormat("%s Region %d", RegionKindName(_infoPanelItem.layer), _infoPanelItem.index), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 180, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
+            if (inside >= 0) DrawText(TextFormat("Structures inside: %d", inside), SCREEN_WIDTH - 320, SCREEN_HEIGHT - 150, SELECTED_STRUCTURE_FONT_SIZE, DARKGRAY);
         }
+        DuplicatesDraw(_cameraOffset, _displayScale);
+        if (_isDraggingGroup) SnapDrawGuides(&_dragSnap, _cameraOffset, _displayScale);
+        ProfileEnd();
         
         // Draw selection marquee
         if (_isMarqueeSelecting)
@@ -397,17 +655,46 @@ void Draw()
             DrawRectangleLinesEx(_selectionMarquee, 1, BLUE);
         }
 
+        MinimapDraw(_cameraOffset, _displayScale);
+
         // Draw GUI Controls
+        // Button actions are edits, not drawing
+        ProfileBegin("draw gui");
+        MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
         float panelX = SCREEN_WIDTH - 200;
         float panelY = 20;
         float panelWidth = 180;
         GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 120}, "File Options");
         if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Export Config")) ExportConfig();
         if (GuiButton((Rectangle){panelX + 10, panelY + 50, 160, 25}, "Add Structure")) AddStructure();
-        if (GuiButton((Rectangle){panelX + 10, panelY + 80, 160, 25}, "Reload Config")) LoadJsonData();
+        if (GuiButton((Rectangle){panelX + 10, panelY + 80, 160, 25}, "Reload Config")) ReloadConfig();
 
         panelY += 130;
-        GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 240}, "Visibility Controls");
+        GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Region Assignment");
+        if (RegionAssignIsPreviewing())
+        {
+            if (GuiButton((Rectangle){panelX + 10, panelY + 20, 100, 25}, TextFormat("Apply (%d)", RegionAssignChangeCount()))) RegionAssignApply();
+            if (GuiButton((Rectangle){panelX + 115, panelY + 20, 55, 25}, "Cancel")) RegionAssignCancel();
+        }
+        else if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Assign Regions")) AssignRegions();
+
+        panelY += 70;
+        GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Duplicates");
+        if (DuplicatesIsShowing())
+        {
+            if (GuiButton((Rectangle){panelX + 10, panelY + 20, 100, 25}, TextFormat("Remove (%d)", DuplicatesGetStats()->total))) RemoveDuplicates();
+            if (GuiButton((Rectangle){panelX + 115, panelY + 20, 55, 25}, "Cancel")) DuplicatesCancel();
+        }
+        else if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Find Duplicates")) DuplicatesFind();
+        panelY += 70;
+
+        GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 45}, "Snapping");
+        GuiCheckBox((Rectangle){panelX + 10, panelY + 15, 20, 20}, "Grid", &_snapToGrid);
+        GuiCheckBox((Rectangle){panelX + 65, panelY + 15, 20, 20}, "Points", &_snapToPoints);
+        GuiCheckBox((Rectangle){panelX + 125, panelY + 15, 20, 20}, "Align", &_snapAlign);
+
+        panelY += 55;
+        GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 290}, "Visibility Controls");
         GuiCheckBox((Rectangle){panelX + 10, panelY + 20, 20, 20}, "Names", &_showNames);
         GuiCheckBox((Rectangle){panelX + 10, panelY + 45, 20, 20}, "Region Names", &_showRegionNames);
         GuiCheckBox((Rectangle){panelX + 10, panelY + 70, 20, 20}, "Snow Regions", &_showSnowRegions);
@@ -417,17 +704,71 @@ void Draw()
         GuiCheckBox((Rectangle){panelX + 10, panelY + 170, 20, 20}, "Portals", &_showPortals);
         GuiCheckBox((Rectangle){panelX + 10, panelY + 195, 20, 20}, "Ocean Area", &_showOceanWorldArea);
         GuiCheckBox((Rectangle){panelX + 10, panelY + 215, 20, 20}, "Space Area", &_showSpaceWorldArea);
+        const RegionCheckResult *regionCheck = RegionCheckGet();
+        GuiCheckBox((Rectangle){panelX + 10, panelY + 240, 20, 20}, TextFormat("Region Issues (%d)", regionCheck->overlapCount + regionCheck->outsideCount), &_showRegionIssues);
+        GuiCheckBox((Rectangle){panelX + 10, panelY + 265, 20, 20}, TextFormat("Unreachable (%d)", ConnectivityGetStats()->unreachableCount), &_showUnreachable);
 
-        panelY += 250;
-        if (_showSnowRegions) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Snow Region"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Snow Region")) AddSnowRegion(_snow_regions); panelY += 70; }
-        if (_showRainRegions) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Rain Region"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Rain Region")) AddSnowRegion(_rain_regions); panelY += 70; }
-        if (_showStarRegions) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Star Region"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Star Region")) AddSnowRegion(_star_regions); panelY += 70; }
+        panelY += 300;
+        if (_showSnowRegions) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Snow Region"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Snow Region")) AddSnowRegion(_snow_regions, LAYER_SNOW_REGIONS); panelY += 70; }
+        if (_showRainRegions) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Rain Region"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Rain Region")) AddSnowRegion(_rain_regions, LAYER_RAIN_REGIONS); panelY += 70; }
+        if (_showStarRegions) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Star Region"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Star Region")) AddSnowRegion(_star_regions, LAYER_STAR_REGIONS); panelY += 70; }
         if (_showBoostGates) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Boost Gate"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Boost Gate")) AddBoostGate(_boost_gates, _cameraOffset, _displayScale); panelY += 70; }
         if (_showPortals) { GuiGroupBox((Rectangle){panelX, panelY, panelWidth, 60}, "Portal"); if (GuiButton((Rectangle){panelX + 10, panelY + 20, 160, 25}, "Add Portal")) AddPortal(_portals, _cameraOffset, _displayScale); }
 
+        // Name search: Enter jumps to the next match, a click on a match jumps to it
+        float searchX = SCREEN_WIDTH * 0.5f - 250;
+        if (GuiTextBox((Rectangle){searchX, 10, 300, 30}, _searchText, SEARCH_QUERY_SIZE, _searchEditing))
+        {
+            _searchEditing = !_searchEditing;
+            if (!_searchEditing && IsKeyPressed(KEY_ENTER)) JumpToNextSearchResult();
+        }
+        else if (!_searchEditing && _searchText[0] != '\0' && IsKeyPressed(KEY_ENTER)) JumpToNextSearchResult();
+        if (_searchText[0] == '\0' && !_searchEditing) DrawText("Search names (Ctrl+F)", searchX + 8, 17, 18, GRAY);
+        if (_searchText[0] != '\0')
+        {
+            int resultCount = 0;
+            bool truncated = false;
+            const SearchResult *results = SearchFind(_searchText, &resultCount, &truncated);
+            if (GuiButton((Rectangle){searchX + 305, 10, 95, 30}, "Select All")) SelectSearchResults();
+            DrawText(TextFormat(truncated ? "%d+ matches" : "%d matches", resultCount), searchX + 410, 17, 18, DARKGRAY);
+            for (int i = 0; i < resultCount && i < SEARCH_LIST_SIZE; i++)
+            {
+                const char *label = (results[i].kind == SEARCH_REGION) ? TextFormat("Region: %s", SearchResultName(results[i])) : SearchResultName(results[i]);
+                if (GuiButton((Rectangle){searchX, 45 + i * 27, 300, 25}, label)) JumpToSearchResult(results[i]);
+            }
+        }
+
         // Draw Help Text
-        DrawText("Commands: Move Camera: Arrow Keys, Zoom: Mouse Wheel/I-O, Multi-Select: Ctrl+Click/Drag", 10, SCREEN_HEIGHT - 30, 20, DARKGRAY);
+        if (route != NULL && route->found) DrawText(TextFormat("Route: %.0f units, %d portals", route->length, route->portalCount), MINIMAP_SIZE + 30, SCREEN_HEIGHT - 80, 20, DARKBLUE);
+        else if (route != NULL) DrawText("No route between the selected structures", MINIMAP_SIZE + 30, SCREEN_HEIGHT - 80, 20, RED);
+        if (DuplicatesIsShowing())
+        {
+            const DuplicateStats *duplicates = DuplicatesGetStats();
+            int regionDuplicates = duplicates->counts[LAYER_SNOW_REGIONS] + duplicates->counts[LAYER_RAIN_REGIONS] + duplicates->counts[LAYER_STAR_REGIONS];
+            DrawText(TextFormat("Duplicates: %d structures, %d boost gates, %d portals, %d regions (exact ones in magenta)", duplicates->counts[LAYER_STRUCTURES],
+                                duplicates->counts[LAYER_BOOST_GATES], duplicates->counts[LAYER_PORTALS], regionDuplicates), MINIMAP_SIZE + 30, SCREEN_HEIGHT - 130, 20, ORANGE);
+        }
+        int quarantined = SchemaGetReport()->quarantinedCount;
+        if (quarantined > 0) DrawText(TextFormat("%d invalid elements hidden, --validate lists them", quarantined), MINIMAP_SIZE + 30, SCREEN_HEIGHT - 105, 20, RED);
+        if (ChunkStoreIsOpen())
+        {
+            ChunkStoreStats chunks = ChunkStoreGetStats();
+            DrawText(TextFormat("Chunks: %d of %d loaded, %d MB of %d MB", chunks.loadedCount, chunks.chunkCount,
+                                (int)(chunks.loadedBytes >> 20), (int)(chunks.budgetBytes >> 20)), 10, SCREEN_HEIGHT - 55, 20, DARKGRAY);
+            if (chunks.failedCount > 0) DrawText(TextFormat("%d chunks could not be read and are left unchanged", chunks.failedCount), 520, SCREEN_HEIGHT - 55, 20, RED);
+        }
+        DrawText("Commands: Move Camera: Arrow Keys, Zoom: Mouse Wheel/I-O, Multi-Select: Ctrl+Click/Drag, Delete: Del, Undo/Redo: Ctrl+Z/Y, Jump: Minimap Click/Drag, Search: Ctrl+F, Profiler: F3, Trace: F9", 10, SCREEN_HEIGHT - 30, 20, DARKGRAY);
+        MemPopSubsystem();
+        ProfileEnd();
+    }
+
+    if (_showProfiler)
+    {
+        int profilerHeight = DrawProfilerOverlay(10, 10);
+        DrawMemoryOverlay(10, 20 + profilerHeight);
     }
+    MemPopSubsystem();
+    ProfileEnd();
     EndDrawing();
 }
 
@@ -436,21 +777,80 @@ void Draw()
 //------------------------------------------------------------------------------------
 void Cleanup()
 {
-    RL_FREE(_filePath);
+    LiveReloadStop();
+    LivePushStop();
+    UndoClear();
+    JournalClose();
+    ExportClear();
+    HandlesClear();
+    ChangesClear();
+    StructureCacheClear();
+    PointCacheClear();
+    PickingClear();
+    MinimapClear();
+    RegionCheckClear();
+    RegionIndexClear();
+    RegionAssignClear();
+    ConnectivityClear();
+    DuplicatesClear();
+    SearchClear();
+    SchemaClear();
+    ChunkStoreClose();
+    HitTestFreeMask();
+    MemFree(_filePath);
     if (_configJson != NULL) cJSON_Delete(_configJson);
 }
 
 void LoadJsonData()
 {
+    ProfileBegin("load");
+    MemPushSubsystem(MEM_SUBSYSTEM_LOAD);
+    // Undo steps refer to the old document by index, selections by handle
+    UndoClear();
+    ClearSelection();
+    HandlesClear();
+    ChangesClear();
+    StructureCacheClear();
+    PointCacheClear();
+    PickingClear();
+    MinimapClear();
+    RegionCheckClear();
+    RegionIndexClear();
+    RegionAssignClear();
+    ConnectivityClear();
+    DuplicatesClear();
+    SearchClear();
+    SchemaClear();
     if (_configJson != NULL) cJSON_Delete(_configJson);
+    _configJson = NULL;
 
-    char *jsonString = LoadFileText(_filePath);
-    if (jsonString == NULL) return;
+    // A chunked world starts without structures; Update() streams them in around the view
+    bool chunked = ChunkStoreIsManifest(_filePath);
+    unsigned char *fileData = NULL;
+    int dataSize = 0;
+    if (chunked)
+    {
+        ExportClear();
+        JournalClose();
+        _configJson = ChunkStoreOpen(_filePath);
+        if (_configJson == NULL) { MemPopSubsystem(); ProfileEnd(); return; }
+    }
+    else
+    {
+        ChunkStoreClose();
 
-    _configJson = cJSON_Parse(jsonString);
-    UnloadFileText(jsonString);
+        // Read as raw bytes so the export index sees the same offsets as the file on disk
+        ProfileBegin("read file");
+        fileData = LoadFileData(_filePath, &dataSize);
+        ProfileEnd();
+        if (fileData == NULL) { ExportClear(); MemPopSubsystem(); ProfileEnd(); return; }
 
-    if (_configJson == NULL) { printf("Error parsing JSON: %s\n", cJSON_GetErrorPtr()); return; }
+        ProfileBegin("parse");
+        _configJson = ParseConfig((const char *)fileData, (size_t)dataSize, _parseThreads);
+        ProfileEnd();
+
+        if (_configJson == NULL) { printf("Error parsing JSON: %s\n", cJSON_GetErrorPtr()); UnloadFileData(fileData); ExportClear(); MemPopSubsystem(); ProfileEnd(); return; }
+    }
 
     _structures = cJSON_GetObjectItem(_configJson, "structures");
     _regions = cJSON_GetObjectItem(_configJson, "regions");
@@ -464,7 +864,43 @@ void LoadJsonData()
     cJSON *portals_obj = cJSON_GetObjectItem(_configJson, "portals");
     if (portals_obj) _portals = cJSON_GetObjectItem(portals_obj, "locations");
 
+    if (!chunked)
+    {
+        ExportIndexSource(_filePath, (const char *)fileData, (size_t)dataSize);
+        UnloadFileData(fileData);
+    }
+
     printf("JSON data loaded successfully.\n");
+
+    // Broken elements are kept out of drawing and editing rather than trusted
+    const SchemaReport *schema = SchemaGetReport();
+    if (schema->issueCount > 0)
+    {
+        char issue[SCHEMA_ISSUE_TEXT_SIZE];
+        for (int i = 0; i < schema->issueCount && i < MAX_LOAD_ISSUES; i++)
+        {
+            SchemaDescribeIssue(i, issue, sizeof(issue));
+            printf("WARNING: %s\n", issue);
+        }
+        printf("WARNING: %d schema issues in %d elements, %d quarantined%s\n", schema->issueCount, schema->invalidCount, schema->quarantinedCount,
+               (schema->issueCount > MAX_LOAD_ISSUES) ? "; --validate lists them all" : "");
+    }
+
+    // Recover edits that were made after the last export but never saved. The journal replays
+    // edits by index, which streaming changes, so chunked worlds go without it.
+    if (_journalEnabled && !chunked) JournalOpen(_filePath);
+    if (_liveReloadEnabled && !chunked) LiveReloadWatch(_filePath);
+    else LiveReloadStop();
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+// Loads the config again from disk. Unlike opening a file after a crash, the unsaved edits
+// are dropped with the journal rather than replayed, so this is how edits are thrown away.
+void ReloadConfig(void)
+{
+    JournalReset();
+    LoadJsonData();
 }
 
 void CheckForDroppedFile()
@@ -474,9 +910,11 @@ void CheckForDroppedFile()
         FilePathList dropped = LoadDroppedFiles();
         if (dropped.count > 0)
         {
+            bool reload = _fileDropped && strcmp(_filePath, dropped.paths[0]) == 0;
             TextCopy(_filePath, dropped.paths[0]);
             _fileDropped = true;
-            LoadJsonData();
+            if (reload) ReloadConfig();
+            else LoadJsonData();
         }
         UnloadDroppedFiles(dropped);
     }
@@ -484,28 +922,207 @@ void CheckForDroppedFile()
 
 void ExportConfig()
 {
-    char *jsonString = cJSON_PrintBuffered(_configJson, 0, 1);
-    if (jsonString)
+    ProfileBegin("export");
+    MemPushSubsystem(MEM_SUBSYSTEM_EXPORT);
+    if (ChunkStoreIsOpen())
+    {
+        if (ChunkStoreSave()) printf("Changed chunks saved next to %s\n", _filePath);
+        else printf("ERROR: Failed to save chunks.\n");
+    }
+    else if (ExportDocument(_filePath))
     {
-        if (SaveFileText(_filePath, jsonString)) printf("Configuration exported to %s\n", _filePath);
-        else printf("ERROR: Failed to save file.\n");
-        free(jsonString);
+        printf("Configuration exported to %s\n", _filePath);
+        JournalReset();
+        LiveReloadNoteWrite();
     }
-    else printf("ERROR: Failed to generate JSON string.\n");
+    else printf("ERROR: Failed to save file.\n");
+    MemPopSubsystem();
+    ProfileEnd();
 }
 
 void AddStructure()
 {
+    if (!_structures) return;
+
     cJSON *new_structure = cJSON_CreateObject();
     cJSON_AddItemToObject(new_structure, "name", cJSON_CreateString("New Structure"));
     cJSON_AddItemToObject(new_structure, "location", cJSON_CreateIntArray((int[]){0, 0}, 2));
+    int regionId = RegionAssignNearest(0.0f, 0.0f);
+    if (regionId >= 0) cJSON_AddNumberToObject(new_structure, "region_id", regionId);
     cJSON_AddItemToArray(_structures, new_structure);
+    UndoRecordAdd(LAYER_STRUCTURES, cJSON_GetArraySize(_structures) - 1);
+}
+
+// Previews the nearest region of the selected structures, or of all of them if none is selected
+void AssignRegions(void)
+{
+    int structures[MAX_SELECTED_ITEMS];
+    int count = 0;
+    for (int i = 0; i < _selectedItemCount; i++)
+    {
+        if (_selectedItems[i].type == ELEMENT_TYPE_STRUCTURE) structures[count++] = _selectedItems[i].index;
+    }
+    if (!RegionAssignPreview(count > 0 ? structures : NULL, count)) printf("WARNING: No region has a location or structures to assign by.\n");
+}
+
+void RemoveDuplicates(void)
+{
+    // Indices shift when elements come and go; handles find the selected elements again
+    if (DuplicatesRemove() > 0) RefreshSelection();
+}
+
+// Removes the selected structures and boost gates as a single undo step
+void DeleteSelection(void)
+{
+    if (_selectedItemCount == 0) return;
+
+    // Remove from the highest index down so the remaining indices stay valid
+    EditLayer layers[] = { LAYER_STRUCTURES, LAYER_BOOST_GATES };
+    UndoBeginTransaction();
+    for (int l = 0; l < 2; l++)
+    {
+        cJSON *array = GetLayerJSON(layers[l]);
+        for (int index = cJSON_GetArraySize(array) - 1; index >= 0; index--)
+        {
+            bool selected = false;
+            for (int i = 0; i < _selectedItemCount && !selected; i++)
+            {
+                PointRef ref = PointRefFromSelection(_selectedItems[i]);
+                selected = (ref.layer == layers[l] && ref.index == index);
+            }
+            if (!selected) continue;
+
+            cJSON *detached = cJSON_DetachItemFromArray(array, index);
+            ChangesMarkElement(layers[l], index, detached);
+            UndoRecordRemove(layers[l], index, detached);
+        }
+    }
+    UndoEndTransaction();
+    ClearSelection();
+}
+
+void JumpToSearchResult(SearchResult result)
+{
+    Vector2 position;
+    if (!SearchResultPosition(result, &position)) return;
+    _cameraOffset.x = SCREEN_WIDTH * 0.5f - position.x * _displayScale;
+    _cameraOffset.y = SCREEN_HEIGHT * 0.5f + position.y * _displayScale;
+    if (result.kind != SEARCH_STRUCTURE) return;
+
+    SelectedItem item = { result.index, ELEMENT_TYPE_STRUCTURE, { 0 }, HandleAt(LAYER_STRUCTURES, result.index) };
+    ClearSelection();
+    AddToSelection(item);
+    _infoPanelItem = item;
+}
+
+// Steps through the matches from the one shown in the info panel
+void JumpToNextSearchResult(void)
+{
+    int count = 0;
+    const SearchResult *results = SearchFind(_searchText, &count, NULL);
+    if (count == 0) return;
+
+    int next = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (results[i].kind == SEARCH_STRUCTURE && _infoPanelItem.type == ELEMENT_TYPE_STRUCTURE && results[i].index == _infoPanelItem.index) next = (i + 1) % count;
+    }
+    JumpToSearchResult(results[next]);
+}
+
+// Regions are not elements that can be selected, so only the matching structures are
+void SelectSearchResults(void)
+{
+    int count = 0;
+    const SearchResult *results = SearchFind(_searchText, &count, NULL);
+    ClearSelection();
+    for (int i = 0; i < count; i++)
+    {
+        if (results[i].kind == SEARCH_STRUCTURE) AddToSelection((SelectedItem){ results[i].index, ELEMENT_TYPE_STRUCTURE, { 0 }, HandleAt(LAYER_STRUCTURES, results[i].index) });
+    }
+}
+
+void HandleUndoKeys(void)
+{
+    if (_isDraggingGroup || _isMarqueeSelecting || _searchEditing || IsMouseButtonDown(MOUSE_LEFT_BUTTON)) return;
+
+    bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    UndoResult result = UNDO_RESULT_NOTHING;
+
+    if (control && IsKeyPressed(KEY_Z)) result = shift ? Redo() : Undo();
+    else if (control && IsKeyPressed(KEY_Y)) result = Redo();
+    else if (IsKeyPressed(KEY_DELETE)) DeleteSelection();
+
+    // Indices shift when elements come and go; handles find the selected elements again
+    if (result == UNDO_RESULT_APPLIED_STRUCTURAL) RefreshSelection();
+}
+
+// Usage: map_editor [config.json] [--trace <frames>] [--trace-file <path>] [--bench <iterations>] [--no-journal] [--no-watch] [--parse-threads <n>]
+//                   [--push <socket>] [--reach-range <units>] [--duplicate-distance <units>] [--snap-grid <units>] [--chunk-budget <MB>] [--chunk-size <units>] [--split-chunks <directory>]
+//        map_editor <config.json> --validate
+//        map_editor <config.json> --check-regions
+//        map_editor <config.json> --region-report
+//        map_editor <config.json> --check-reach [--reach-range <units>]
+//        map_editor <config.json> --check-duplicates [--duplicate-distance <units>]
+//        map_editor <config.json> --find <text>
+//        map_editor --scan-check <iterations>
+//        map_editor --diff <before.json> <after.json>
+//        map_editor --merge <base.json> <ours.json> <theirs.json> [--out <merged.json>]
+void ParseCommandLine(int argc, char **argv)
+{
+    const char *configPath = NULL;
+    const char *traceFile = DEFAULT_TRACE_FILE;
+    int traceFrames = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) traceFrames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace-file") == 0 && i + 1 < argc) traceFile = argv[++i];
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) { _benchIterations = atoi(argv[++i]); _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--no-journal") == 0) _journalEnabled = false;
+        else if (strcmp(argv[i], "--no-watch") == 0) _liveReloadEnabled = false;
+        else if (strcmp(argv[i], "--push") == 0 && i + 1 < argc) _pushSocketPath = argv[++i];
+        else if (strcmp(argv[i], "--validate") == 0) { _checkSchema = true; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--check-regions") == 0) { _checkRegions = true; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--check-reach") == 0) { _checkReach = true; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--reach-range") == 0 && i + 1 < argc) ConnectivitySetRange((float)atof(argv[++i]));
+        else if (strcmp(argv[i], "--check-duplicates") == 0) { _checkDuplicates = true; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--find") == 0 && i + 1 < argc) { _findQuery = argv[++i]; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--duplicate-distance") == 0 && i + 1 < argc) DuplicatesSetDistance((float)atof(argv[++i]));
+        else if (strcmp(argv[i], "--snap-grid") == 0 && i + 1 < argc) SnapSetGrid((float)atof(argv[++i]));
+        else if (strcmp(argv[i], "--region-report") == 0) { _regionReport = true; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc) _parseThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scan-check") == 0 && i + 1 < argc) _scanCheckIterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--diff") == 0 && i + 2 < argc) { _diffPaths[0] = argv[++i]; _diffPaths[1] = argv[++i]; _diffPathCount = 2; }
+        else if (strcmp(argv[i], "--merge") == 0 && i + 3 < argc)
+        {
+            for (int p = 0; p < 3; p++) _diffPaths[p] = argv[++i];
+            _diffPathCount = 3;
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) _mergeOutputPath = argv[++i];
+        else if (strcmp(argv[i], "--split-chunks") == 0 && i + 1 < argc) { _splitChunksDirectory = argv[++i]; _journalEnabled = false; _liveReloadEnabled = false; }
+        else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) _chunkSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--chunk-budget") == 0 && i + 1 < argc) ChunkStoreSetBudget((size_t)atoi(argv[++i]) * 1024 * 1024);
+        else if (argv[i][0] != '-') configPath = argv[i];
+        else printf("WARNING: Unknown argument %s\n", argv[i]);
+    }
+
+    // Start tracing before loading so the initial load and parse are captured
+    if (traceFrames > 0) ProfilerStartTrace(traceFile, traceFrames);
+
+    if (configPath)
+    {
+        TextCopy(_filePath, configPath);
+        _fileDropped = true;
+        LoadJsonData();
+    }
 }
 
 void ControlCamera()
 {
-    // Pan with arrow keys only if not dragging a group or selecting
-    if (!_isDraggingGroup && !_isMarqueeSelecting)
+    // Pan with arrow keys only if not dragging a group, selecting or typing a search
+    if (!_isDraggingGroup && !_isMarqueeSelecting && !_searchEditing)
     {
         if (IsKeyDown(KEY_LEFT)) _cameraOffset.x += 10.0f;
         if (IsKeyDown(KEY_RIGHT)) _cameraOffset.x -= 10.0f;
@@ -516,31 +1133,81 @@ void ControlCamera()
     // Zoom with mouse wheel or keys
     float wheel = GetMouseWheelMove();
     if (wheel != 0) _displayScale += wheel * 0.05f;
-    if (IsKeyDown(KEY_I)) _displayScale += 0.01f;
-    if (IsKeyDown(KEY_O)) _displayScale -= 0.01f;
+    if (IsKeyDown(KEY_I) && !_searchEditing) _displayScale += 0.01f;
+    if (IsKeyDown(KEY_O) && !_searchEditing) _displayScale -= 0.01f;
     if (_displayScale < 0.05f) _displayScale = 0.05f;
     if (_displayScale > 2.0f) _displayScale = 2.0f;
 }
 
+// Layers whose handles can be hovered and dragged, as a mask of (1 << layer)
+uint32_t GetPickableLayers(void)
+{
+    uint32_t layers = 1u << LAYER_STRUCTURES;
+    if (_showBoostGates) layers |= 1u << LAYER_BOOST_GATES;
+    if (_showPortals) layers |= 1u << LAYER_PORTALS;
+    if (_showSnowRegions) layers |= 1u << LAYER_SNOW_REGIONS;
+    if (_showRainRegions) layers |= 1u << LAYER_RAIN_REGIONS;
+    if (_showStarRegions) layers |= 1u << LAYER_STAR_REGIONS;
+    if (_showOceanWorldArea) layers |= 1u << LAYER_OCEAN_WORLD_AREA;
+    if (_showSpaceWorldArea) layers |= 1u << LAYER_SPACE_WORLD_AREA;
+    return layers;
+}
+
 //------------------------------------------------------------------------------------
 // Selection Helper Functions
 //------------------------------------------------------------------------------------
 bool IsItemSelected(SelectedItem item)
 {
+    PointRef ref = PointRefFromSelection(item);
     for (int i = 0; i < _selectedItemCount; i++)
     {
-        if (_selectedItems[i].index == item.index && _selectedItems[i].type == item.type) {
+        PointRef selected = PointRefFromSelection(_selectedItems[i]);
+        if (selected.layer == ref.layer && selected.index == ref.index && selected.field == ref.field) {
             return true;
         }
     }
     return false;
 }
 
+// Selected handles are drawn red and the hovered one yellow
+Color GetHandleColor(SelectedItem item, Color color)
+{
+    if (IsItemSelected(item)) return RED;
+
+    PointRef ref = PointRefFromSelection(item);
+    PointRef hovered = PointRefFromSelection(_activeItem);
+    if (_activeItem.type != ELEMENT_TYPE_NONE && hovered.layer == ref.layer && hovered.index == ref.index && hovered.field == ref.field) return YELLOW;
+    return color;
+}
+
 void ClearSelection(void)
 {
     _selectedItemCount = 0;
     _infoPanelItem.index = -1;
     _infoPanelItem.type = ELEMENT_TYPE_NONE;
+    _infoPanelItem.handle = (ElementHandle){ 0 };
+}
+
+// Re-derives the cached indices of selected and inspected items from their handles and
+// drops the ones whose element is no longer in the document
+void RefreshSelection(void)
+{
+    int kept = 0;
+    for (int i = 0; i < _selectedItemCount; i++)
+    {
+        SelectedItem item = _selectedItems[i];
+        item.index = HandleGetIndex(item.handle);
+        if (item.index >= 0) _selectedItems[kept++] = item;
+    }
+    _selectedItemCount = kept;
+
+    if (_infoPanelItem.type != ELEMENT_TYPE_NONE)
+    {
+        _infoPanelItem.index = HandleGetIndex(_infoPanelItem.handle);
+        if (_infoPanelItem.index < 0) _infoPanelItem.type = ELEMENT_TYPE_NONE;
+    }
+    _activeItem.index = -1;
+    _activeItem.type = ELEMENT_TYPE_NONE;
 }
 
 void AddToSelection(SelectedItem item)
@@ -552,47 +1219,105 @@ void AddToSelection(SelectedItem item)
     }
 }
 
-// Gets the JSON array item for a given selected item's point
-cJSON* GetSelectedItemJSON(SelectedItem item) {
-    switch (item.type) {
-        case ELEMENT_TYPE_STRUCTURE: {
-            cJSON* structure = cJSON_GetArrayItem(_structures, item.index);
-            return cJSON_GetObjectItem(structure, "location");
-        }
-        case ELEMENT_TYPE_BOOST_GATE_A: {
-            cJSON* gate = cJSON_GetArrayItem(_boost_gates, item.index);
-            return cJSON_GetObjectItem(gate, "a");
-        }
-        case ELEMENT_TYPE_BOOST_GATE_B: {
-            cJSON* gate = cJSON_GetArrayItem(_boost_gates, item.index);
-            return cJSON_GetObjectItem(gate, "b");
-        }
-        default:
-            return NULL;
-    }
+// Gets the structure or boost gate a selected item belongs to
+cJSON* GetSelectedElementJSON(SelectedItem item) {
+    // O(1) through the handle instead of walking the array to the index
+    if (item.type == ELEMENT_TYPE_NONE) return NULL;
+    return HandleResolve(item.handle);
 }
 
 // Updates the position of a selected item in the main cJSON object
 void UpdateSelectedItemPosition(SelectedItem item, float x, float y) {
-    cJSON *new_pos = cJSON_CreateIntArray((int[]){(int)x, (int)y}, 2);
+    // Written in place so dragging does not allocate a new array every frame
+    cJSON *element = GetSelectedElementJSON(item);
+    PointRef ref = PointRefFromSelection(item);
+    cJSON *xItem = NULL, *yItem = NULL;
+    if (!GetPointItemsJSON(element, ref.field, &xItem, &yItem)) return;
+
+    cJSON_SetNumberValue(xItem, (int)x);
+    cJSON_SetNumberValue(yItem, (int)y);
+    PointCacheSet(ref, (float)(int)x, (float)(int)y);
+    ChangesMarkElement(ref.layer, ref.index, element);
+}
+
+// Sets an [x, y] array in place
+void SetPointJSON(cJSON *point, int x, int y) {
+    cJSON *xItem = cJSON_GetArrayItem(point, 0);
+    cJSON *yItem = xItem ? xItem->next : NULL;
+    if (xItem == NULL || yItem == NULL) return;
+
+    cJSON_SetNumberValue(xItem, x);
+    cJSON_SetNumberValue(yItem, y);
+}
+
+// Gets the top-level JSON collection behind a layer (the object itself for world areas)
+cJSON *GetLayerJSON(EditLayer layer) {
+    switch (layer) {
+        case LAYER_STRUCTURES: return _structures;
+        case LAYER_BOOST_GATES: return _boost_gates;
+        case LAYER_PORTALS: return _portals;
+        case LAYER_SNOW_REGIONS: return _snow_regions;
+        case LAYER_RAIN_REGIONS: return _rain_regions;
+        case LAYER_STAR_REGIONS: return _star_regions;
+        case LAYER_OCEAN_WORLD_AREA: return _ocean_world_area;
+        case LAYER_SPACE_WORLD_AREA: return _space_world_area;
+        default: return NULL;
+    }
+}
+
+// World area layers are a single object instead of an array of elements
+bool IsWorldAreaLayer(EditLayer layer) {
+    return layer == LAYER_OCEAN_WORLD_AREA || layer == LAYER_SPACE_WORLD_AREA;
+}
+
+PointRef PointRefFromSelection(SelectedItem item) {
     switch (item.type) {
-        case ELEMENT_TYPE_STRUCTURE: {
-            cJSON* structure = cJSON_GetArrayItem(_structures, item.index);
-            if(structure) cJSON_ReplaceItemInObjectCaseSensitive(structure, "location", new_pos);
-            break;
-        }
-        case ELEMENT_TYPE_BOOST_GATE_A: {
-            cJSON* gate = cJSON_GetArrayItem(_boost_gates, item.index);
-            if(gate) cJSON_ReplaceItemInObjectCaseSensitive(gate, "a", new_pos);
-            break;
-        }
-        case ELEMENT_TYPE_BOOST_GATE_B: {
-            cJSON* gate = cJSON_GetArrayItem(_boost_gates, item.index);
-            if(gate) cJSON_ReplaceItemInObjectCaseSensitive(gate, "b", new_pos);
-            break;
-        }
-        default:
-            cJSON_Delete(new_pos); // Clean up if not used
-            break;
+        case ELEMENT_TYPE_BOOST_GATE_A: return (PointRef){ LAYER_BOOST_GATES, item.index, POINT_FIELD_A };
+        case ELEMENT_TYPE_BOOST_GATE_B: return (PointRef){ LAYER_BOOST_GATES, item.index, POINT_FIELD_B };
+        case ELEMENT_TYPE_PORTAL_A: return (PointRef){ LAYER_PORTALS, item.index, POINT_FIELD_A };
+        case ELEMENT_TYPE_PORTAL_B: return (PointRef){ LAYER_PORTALS, item.index, POINT_FIELD_B };
+        case ELEMENT_TYPE_BOUNDS_CORNER: return (PointRef){ item.layer, item.index, item.corner };
+        default: return (PointRef){ LAYER_STRUCTURES, item.index, POINT_FIELD_LOCATION };
+    }
+}
+
+SelectedItem SelectedItemFromPointRef(PointRef ref) {
+    SelectedItem item = { ref.index, ELEMENT_TYPE_STRUCTURE, { 0 }, HandleAt(ref.layer, ref.index), ref.layer, ref.field };
+    switch (ref.layer) {
+        case LAYER_STRUCTURES: break;
+        case LAYER_BOOST_GATES: item.type = (ref.field == POINT_FIELD_B) ? ELEMENT_TYPE_BOOST_GATE_B : ELEMENT_TYPE_BOOST_GATE_A; break;
+        case LAYER_PORTALS: item.type = (ref.field == POINT_FIELD_B) ? ELEMENT_TYPE_PORTAL_B : ELEMENT_TYPE_PORTAL_A; break;
+        default: item.type = ELEMENT_TYPE_BOUNDS_CORNER; break;
     }
+    return item;
+}
+
+const char *PointFieldName(PointField field) {
+    switch (field) {
+        case POINT_FIELD_A: return "a";
+        case POINT_FIELD_B: return "b";
+        case POINT_FIELD_LOCATION: return "location";
+        default: return "bounds";
+    }
+}
+
+// Finds the two number items a point is made of: both items of an [x, y] array, or for a
+// corner of "bounds" the x of min or max and the y of min or max. Quarantined elements have none.
+bool GetPointItemsJSON(cJSON *element, PointField field, cJSON **xItem, cJSON **yItem) {
+    cJSON *xPoint = NULL;
+    cJSON *yPoint = NULL;
+    if (field >= POINT_FIELD_MIN_MIN) {
+        cJSON *bounds = cJSON_GetObjectItem(element, "bounds");
+        bool maxX = (field == POINT_FIELD_MAX_MIN || field == POINT_FIELD_MAX_MAX);
+        bool maxY = (field == POINT_FIELD_MIN_MAX || field == POINT_FIELD_MAX_MAX);
+        xPoint = cJSON_GetObjectItem(bounds, maxX ? "max" : "min");
+        yPoint = cJSON_GetObjectItem(bounds, maxY ? "max" : "min");
+    } else {
+        xPoint = yPoint = cJSON_GetObjectItem(element, PointFieldName(field));
+    }
+
+    *xItem = cJSON_GetArrayItem(xPoint, 0);
+    cJSON *yFirst = cJSON_GetArrayItem(yPoint, 0);
+    *yItem = yFirst ? yFirst->next : NULL;
+    return cJSON_IsNumber(*xItem) && cJSON_IsNumber(*yItem) && !SchemaIsQuarantined(element);
 }
\ No newline at end of file
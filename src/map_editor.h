@@ -2,27 +2,92 @@
 #define MAP_EDITOR_H
 
 #include "raylib.h" // For Vector2
+#include "cJSON.h"
+#include <stdint.h>
 
 // Shared type definitions for the entire project
 typedef enum {
     ELEMENT_TYPE_NONE = -1,
     ELEMENT_TYPE_STRUCTURE,
     ELEMENT_TYPE_BOOST_GATE_A,
-    ELEMENT_TYPE_BOOST_GATE_B
+    ELEMENT_TYPE_BOOST_GATE_B,
+    ELEMENT_TYPE_PORTAL_A,
+    ELEMENT_TYPE_PORTAL_B,
+    ELEMENT_TYPE_BOUNDS_CORNER  // A corner of a region or world area, see SelectedItem.layer and corner
 } SelectableElementType;
 
+// Stable reference to a layer element that survives insertions and removals around it.
+// Slot 0 is never used, so a zeroed handle refers to nothing.
 typedef struct {
+    uint32_t slot;
+    uint32_t generation;
+} ElementHandle;
+
+// Every editable collection in the config, used to address elements outside the selection
+typedef enum {
+    LAYER_STRUCTURES = 0,
+    LAYER_BOOST_GATES,
+    LAYER_PORTALS,
+    LAYER_SNOW_REGIONS,
+    LAYER_RAIN_REGIONS,
+    LAYER_STAR_REGIONS,
+    LAYER_OCEAN_WORLD_AREA,
+    LAYER_SPACE_WORLD_AREA,
+    LAYER_COUNT
+} EditLayer;
+
+// Which [x, y] array of an element a point refers to. The corners of "bounds" take
+// x from min or max and y from min or max, named in that order.
+typedef enum {
+    POINT_FIELD_LOCATION = 0,
+    POINT_FIELD_A,
+    POINT_FIELD_B,
+    POINT_FIELD_MIN_MIN,
+    POINT_FIELD_MAX_MIN,
+    POINT_FIELD_MIN_MAX,
+    POINT_FIELD_MAX_MAX
+} PointField;
+
+typedef struct {
+    EditLayer layer;
     int index;
+    PointField field;
+} PointRef;
+
+typedef struct {
+    int index;                  // Position in its array, refreshed from handle after structural edits
     SelectableElementType type;
     Vector2 dragStartPosition;
+    ElementHandle handle;
+    EditLayer layer;            // Region or world area layer and corner of an ELEMENT_TYPE_BOUNDS_CORNER
+    PointField corner;
 } SelectedItem;
 
 // --- Extern declarations for Global Variables ---
 // This tells other files like boost_gate.c that these variables exist
 // and will be provided by another file (your main .c file).
+extern const int SCREEN_WIDTH;
+extern const int SCREEN_HEIGHT;
 extern SelectedItem _activeItem;
+extern char *_filePath;
+extern int _parseThreads;
+extern cJSON *_configJson;
+extern cJSON *_structures;
+extern cJSON *_regions;
+extern cJSON *_boost_gates;
 
 // --- Function Prototypes for Globally Used Functions ---
 bool IsItemSelected(SelectedItem item);
+Color GetHandleColor(SelectedItem item, Color color);
+void LoadJsonData();
+void UpdateSelectedItemPosition(SelectedItem item, float x, float y);
+void ClearSelection(void);
+cJSON *GetLayerJSON(EditLayer layer);
+bool IsWorldAreaLayer(EditLayer layer);
+PointRef PointRefFromSelection(SelectedItem item);
+SelectedItem SelectedItemFromPointRef(PointRef ref);
+const char *PointFieldName(PointField field);
+bool GetPointItemsJSON(cJSON *element, PointField field, cJSON **xItem, cJSON **yItem);
+void SetPointJSON(cJSON *point, int x, int y);
 
 #endif // MAP_EDITOR_H
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "memtrack.h"
+#include "cJSON.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define MAX_SUBSYSTEM_DEPTH 16
+
+// Every allocation is prefixed with its size and owner so frees can be charged back.
+// The header is 16 bytes to keep the returned pointer aligned like malloc's.
+typedef struct {
+    size_t size;
+    size_t subsystem;
+} AllocationHeader;
+
+typedef struct {
+    size_t liveBytes;
+    size_t peakBytes;
+    size_t totalAllocations;
+    size_t currentFrameAllocations;
+    size_t currentFrameBytes;
+    size_t lastFrameAllocations;
+    size_t lastFrameBytes;
+} SubsystemCounters;
+
+static SubsystemCounters _counters[MEM_SUBSYSTEM_COUNT] = { 0 };
+static size_t _totalLiveBytes = 0;
+static size_t _totalPeakBytes = 0;
+
+static MemSubsystem _subsystemStack[MAX_SUBSYSTEM_DEPTH];
+static int _subsystemDepth = 0;
+
+// Worker threads count into their own counters so allocating never takes a lock
+static __thread bool _isWorker = false;
+static __thread MemSubsystem _workerSubsystem = MEM_SUBSYSTEM_OTHER;
+static __thread SubsystemCounters _workerCounters[MEM_SUBSYSTEM_COUNT];
+static pthread_mutex_t _mergeLock = PTHREAD_MUTEX_INITIALIZER;
+static SubsystemCounters _handedOff[MEM_SUBSYSTEM_COUNT];  // Counts of background workers, merged by the main thread
+static bool _hasHandedOff = false;
+
+static const char *_subsystemNames[MEM_SUBSYSTEM_COUNT] = { "other", "load", "edit", "draw", "export" };
+
+static MemSubsystem CurrentSubsystem(void)
+{
+    if (_isWorker) return _workerSubsystem;
+    if (_subsystemDepth == 0) return MEM_SUBSYSTEM_OTHER;
+    return _subsystemStack[(_subsystemDepth < MAX_SUBSYSTEM_DEPTH) ? _subsystemDepth - 1 : MAX_SUBSYSTEM_DEPTH - 1];
+}
+
+static void CountAllocation(MemSubsystem subsystem, size_t size)
+{
+    if (_isWorker)
+    {
+        // Peaks are only tracked on the main thread; a worker's total is applied when it ends
+        _workerCounters[subsystem].liveBytes += size;
+        _workerCounters[subsystem].totalAllocations++;
+        _workerCounters[subsystem].currentFrameAllocations++;
+        _workerCounters[subsystem].currentFrameBytes += size;
+        return;
+    }
+
+    SubsystemCounters *counters = &_counters[subsystem];
+    counters->liveBytes += size;
+    counters->totalAllocations++;
+    counters->currentFrameAllocations++;
+    counters->currentFrameBytes += size;
+    if (counters->liveBytes > counters->peakBytes) counters->peakBytes = counters->liveBytes;
+
+    _totalLiveBytes += size;
+    if (_totalLiveBytes > _totalPeakBytes) _totalPeakBytes = _totalLiveBytes;
+}
+
+static void CountFree(MemSubsystem subsystem, size_t size)
+{
+    // May wrap below zero for memory allocated elsewhere; the merge adds it back modulo 2^n
+    if (_isWorker) { _workerCounters[subsystem].liveBytes -= size; return; }
+
+    _counters[subsystem].liveBytes -= size;
+    _totalLiveBytes -= size;
+}
+
+void MemTrackInit(void)
+{
+    cJSON_Hooks hooks = { MemAlloc, MemFree };
+    cJSON_InitHooks(&hooks);
+}
+
+void *MemAlloc(size_t size)
+{
+    AllocationHeader *header = malloc(sizeof(AllocationHeader) + size);
+    if (header == NULL) return NULL;
+
+    MemSubsystem subsystem = CurrentSubsystem();
+    header->size = size;
+    header->subsystem = subsystem;
+    CountAllocation(subsystem, size);
+    return header + 1;
+}
+
+void *MemCalloc(size_t count, size_t size)
+{
+    if (size != 0 && count > ((size_t)-1 - sizeof(AllocationHeader)) / size) return NULL;
+
+    void *ptr = MemAlloc(count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void *MemRealloc(void *ptr, size_t size)
+{
+    if (ptr == NULL) return MemAlloc(size);
+
+    AllocationHeader *header = (AllocationHeader *)ptr - 1;
+    size_t oldSize = header->size;
+    MemSubsystem owner = (MemSubsystem)header->subsystem;
+
+    AllocationHeader *resized = realloc(header, sizeof(AllocationHeader) + size);
+    if (resized == NULL) return NULL;
+
+    // A resize stays charged to the subsystem that made the original allocation
+    CountFree(owner, oldSize);
+    CountAllocation(owner, size);
+    resized->size = size;
+    return resized + 1;
+}
+
+void MemFree(void *ptr)
+{
+    if (ptr == NULL) return;
+
+    AllocationHeader *header = (AllocationHeader *)ptr - 1;
+    CountFree((MemSubsystem)header->subsystem, header->size);
+    free(header);
+}
+
+void MemWorkerBegin(MemSubsystem subsystem)
+{
+    memset(_workerCounters, 0, sizeof(_workerCounters));
+    _workerSubsystem = subsystem;
+    _isWorker = true;
+}
+
+// Adds worker counts to the global ones; the caller holds the merge lock
+static void MergeCounters(const SubsystemCounters *counts)
+{
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++)
+    {
+        SubsystemCounters *counters = &_counters[i];
+        counters->liveBytes += counts[i].liveBytes;
+        counters->totalAllocations += counts[i].totalAllocations;
+        counters->currentFrameAllocations += counts[i].currentFrameAllocations;
+        counters->currentFrameBytes += counts[i].currentFrameBytes;
+        if (counters->liveBytes > counters->peakBytes) counters->peakBytes = counters->liveBytes;
+        _totalLiveBytes += counts[i].liveBytes;
+    }
+    if (_totalLiveBytes > _totalPeakBytes) _totalPeakBytes = _totalLiveBytes;
+}
+
+void MemWorkerEnd(void)
+{
+    if (!_isWorker) return;
+    _isWorker = false;
+
+    pthread_mutex_lock(&_mergeLock);
+    MergeCounters(_workerCounters);
+    pthread_mutex_unlock(&_mergeLock);
+}
+
+void MemMergeWorkers(void)
+{
+    pthread_mutex_lock(&_mergeLock);
+    if (_hasHandedOff)
+    {
+        MergeCounters(_handedOff);
+        memset(_handedOff, 0, sizeof(_handedOff));
+        _hasHandedOff = false;
+    }
+    pthread_mutex_unlock(&_mergeLock);
+}
+
+void MemWorkerHandOff(void)
+{
+    if (!_isWorker) return;
+    _isWorker = false;
+
+    pthread_mutex_lock(&_mergeLock);
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++)
+    {
+        _handedOff[i].liveBytes += _workerCounters[i].liveBytes;
+        _handedOff[i].totalAllocations += _workerCounters[i].totalAllocations;
+        _handedOff[i].currentFrameAllocations += _workerCounters[i].currentFrameAllocations;
+        _handedOff[i].currentFrameBytes += _workerCounters[i].currentFrameBytes;
+    }
+    _hasHandedOff = true;
+    pthread_mutex_unlock(&_mergeLock);
+}
+
+void MemPushSubsystem(MemSubsystem subsystem)
+{
+    if (_subsystemDepth < MAX_SUBSYSTEM_DEPTH) _subsystemStack[_subsystemDepth] = subsystem;
+    _subsystemDepth++;
+}
+
+void MemPopSubsystem(void)
+{
+    if (_subsystemDepth > 0) _subsystemDepth--;
+}
+
+void MemTrackBeginFrame(void)
+{
+    MemMergeWorkers();
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++)
+    {
+        _counters[i].lastFrameAllocations = _counters[i].currentFrameAllocations;
+        _counters[i].lastFrameBytes = _counters[i].currentFrameBytes;
+        _counters[i].currentFrameAllocations = 0;
+        _counters[i].currentFrameBytes = 0;
+    }
+}
+
+MemStats MemGetStats(MemSubsystem subsystem)
+{
+    SubsystemCounters *counters = &_counters[subsystem];
+    return (MemStats){ counters->liveBytes, counters->peakBytes, counters->totalAllocations, counters->lastFrameAllocations, counters->lastFrameBytes };
+}
+
+MemStats MemGetTotalStats(void)
+{
+    MemStats total = { _totalLiveBytes, _totalPeakBytes, 0, 0, 0 };
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++)
+    {
+        total.totalAllocations += _counters[i].totalAllocations;
+        total.frameAllocations += _counters[i].lastFrameAllocations;
+        total.frameBytes += _counters[i].lastFrameBytes;
+    }
+    return total;
+}
+
+const char *MemSubsystemName(MemSubsystem subsystem)
+{
+    return (subsystem >= 0 && subsystem < MEM_SUBSYSTEM_COUNT) ? _subsystemNames[subsystem] : "?";
+}
+
+void MemPrintStats(void)
+{
+    MemMergeWorkers();
+    printf("%-8s %14s %14s %12s %12s\n", "memory", "live bytes", "peak bytes", "allocs", "frame allocs");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++)
+    {
+        MemStats stats = MemGetStats((MemSubsystem)i);
+        printf("%-8s %14zu %14zu %12zu %12zu\n", _subsystemNames[i], stats.liveBytes, stats.peakBytes, stats.totalAllocations, stats.frameAllocations);
+    }
+    MemStats total = MemGetTotalStats();
+    printf("%-8s %14zu %14zu %12zu %12zu\n", "total", total.liveBytes, total.peakBytes, total.totalAllocations, total.frameAllocations);
+}
+
+void DrawMemoryOverlay(int x, int y)
+{
+    MemStats total = MemGetTotalStats();
+    DrawRectangle(x, y, 260, 40 + MEM_SUBSYSTEM_COUNT * 20, Fade(LIGHTGRAY, 0.8f));
+    DrawText(TextFormat("Heap: %.1f MB (peak %.1f MB)", total.liveBytes / 1048576.0, total.peakBytes / 1048576.0), x + 10, y + 10, 15, DARKGRAY);
+
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++)
+    {
+        MemStats stats = MemGetStats((MemSubsystem)i);
+        DrawText(TextFormat("%-7s %8.1f KB %6zu/frame", _subsystemNames[i], stats.liveBytes / 1024.0, stats.frameAllocations), x + 10, y + 35 + i * 20, 15, DARKGRAY);
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef MEMTRACK_H
+#define MEMTRACK_H
+
+#include <stddef.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+typedef enum {
+    MEM_SUBSYSTEM_OTHER = 0,
+    MEM_SUBSYSTEM_LOAD,
+    MEM_SUBSYSTEM_EDIT,
+    MEM_SUBSYSTEM_DRAW,
+    MEM_SUBSYSTEM_EXPORT,
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+typedef struct {
+    size_t liveBytes;          // Bytes currently allocated by this subsystem
+    size_t peakBytes;          // Highest liveBytes seen
+    size_t totalAllocations;   // Allocations since startup
+    size_t frameAllocations;   // Allocations during the last finished frame
+    size_t frameBytes;         // Bytes allocated during the last finished frame
+} MemStats;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Installs the counting allocator as the cJSON allocation hooks. Call before any cJSON use.
+ */
+void MemTrackInit(void);
+
+/**
+ * @brief Counting replacements for malloc/calloc/realloc/free. Memory must be released with MemFree.
+ */
+void *MemAlloc(size_t size);
+void *MemCalloc(size_t count, size_t size);
+void *MemRealloc(void *ptr, size_t size);
+void MemFree(void *ptr);
+
+/**
+ * @brief Tags following allocations with a subsystem until the matching MemPopSubsystem().
+ * @param subsystem The subsystem to charge allocations to.
+ */
+void MemPushSubsystem(MemSubsystem subsystem);
+void MemPopSubsystem(void);
+
+/**
+ * @brief Makes the calling worker thread count its allocations privately, charged to subsystem.
+ *        The allocator itself stays lock free; the counts are merged by MemWorkerEnd().
+ *        The thread that started the workers must not allocate until they have all ended.
+ */
+void MemWorkerBegin(MemSubsystem subsystem);
+
+/**
+ * @brief Merges the calling worker thread's counters into the global ones.
+ */
+void MemWorkerEnd(void);
+
+/**
+ * @brief Ends the calling worker's private counting like MemWorkerEnd(), for a background worker
+ *        that runs while the main thread keeps allocating. Its counts are merged by the main
+ *        thread at the next MemMergeWorkers().
+ */
+void MemWorkerHandOff(void);
+
+/**
+ * @brief Merges the counts of workers that ended with MemWorkerHandOff(). Call on the main thread
+ *        after joining such a worker and before freeing what it allocated; MemTrackBeginFrame()
+ *        and MemPrintStats() call it as well.
+ */
+void MemMergeWorkers(void);
+
+/**
+ * @brief Closes the per-frame allocation counters and starts new ones.
+ */
+void MemTrackBeginFrame(void);
+
+/**
+ * @brief Returns the counters for one subsystem.
+ * @param subsystem The subsystem to query.
+ */
+MemStats MemGetStats(MemSubsystem subsystem);
+
+/**
+ * @brief Returns the counters summed over all subsystems.
+ */
+MemStats MemGetTotalStats(void);
+
+/**
+ * @brief Returns a short display name for a subsystem.
+ */
+const char *MemSubsystemName(MemSubsystem subsystem);
+
+/**
+ * @brief Prints the counters of all subsystems to stdout.
+ */
+void MemPrintStats(void);
+
+/**
+ * @brief Draws the memory counters in a small panel.
+ * @param x Left edge of the panel in screen pixels.
+ * @param y Top edge of the panel in screen pixels.
+ */
+void DrawMemoryOverlay(int x, int y);
+
+#endif // MEMTRACK_H
@@ -0,0 +1,363 @@
+#include "minimap.h"
+#include "point_cache.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <math.h>
+#include <string.h>
+
+#define MINIMAP_MARGIN 10
+#define MINIMAP_BOTTOM 70               // Keeps the help and chunk lines below the panel visible
+#define MINIMAP_PADDING 0.05f           // Share of the world extent left empty around the points
+#define MINIMAP_LEVELS 12               // Shades, one per doubling of the count in a cell
+#define MINIMAP_SOURCE_COUNT 5
+
+typedef struct {
+    EditLayer layer;
+    PointField field;
+    SelectableElementType pointSet;     // Cached positions, or ELEMENT_TYPE_NONE to read the JSON
+} MinimapSource;
+
+typedef struct {
+    int *cells;                         // Density cell of each point, -1 for points without a position
+    int count;
+} SourceCells;
+
+static const MinimapSource _sources[MINIMAP_SOURCE_COUNT] = {
+    { LAYER_STRUCTURES, POINT_FIELD_LOCATION, ELEMENT_TYPE_STRUCTURE },
+    { LAYER_BOOST_GATES, POINT_FIELD_A, ELEMENT_TYPE_BOOST_GATE_A },
+    { LAYER_BOOST_GATES, POINT_FIELD_B, ELEMENT_TYPE_BOOST_GATE_B },
+    { LAYER_PORTALS, POINT_FIELD_A, ELEMENT_TYPE_NONE },
+    { LAYER_PORTALS, POINT_FIELD_B, ELEMENT_TYPE_NONE },
+};
+
+static SourceCells _cells[MINIMAP_SOURCE_COUNT] = { 0 };
+static uint32_t *_counts = NULL;
+static Color *_pixels = NULL;
+static Color *_upload = NULL;           // Changed texels packed row by row for UpdateTextureRec()
+static Texture2D _texture = { 0 };
+static bool _built = false;
+static const cJSON *_builtLayers[LAYER_COUNT] = { 0 };
+static uint64_t _builtStructures[LAYER_COUNT] = { 0 };
+static uint64_t _syncedVersion = 0;     // Changes up to this version are counted
+static float _originX = 0.0f;           // World position of the bottom left texel
+static float _originY = 0.0f;
+static float _cellSize = 1.0f;          // World units per texel
+static int _dirtyMinX, _dirtyMinY, _dirtyMaxX, _dirtyMaxY;
+static bool _dirty = false;
+static bool _dragging = false;
+
+//------------------------------------------------------------------------------------
+// Density
+//------------------------------------------------------------------------------------
+static Color DensityColor(uint32_t count)
+{
+    if (count == 0) return (Color){ 235, 235, 235, 255 };
+
+    int level = 0;
+    while (count > 1 && level < MINIMAP_LEVELS - 1)
+    {
+        count >>= 1;
+        level++;
+    }
+    float t = (float)level / (MINIMAP_LEVELS - 1);
+    return (Color){ (unsigned char)(150 - 140 * t), (unsigned char)(190 - 150 * t), (unsigned char)(235 - 115 * t), 255 };
+}
+
+// Texel of a world point, clamped to the image so points moved off it stay counted
+static int CellOf(float x, float y)
+{
+    if (isnan(x) || isnan(y)) return -1;
+    int cellX = (int)floorf((x - _originX) / _cellSize);
+    int row = MINIMAP_SIZE - 1 - (int)floorf((y - _originY) / _cellSize); // Image rows go down
+    cellX = cellX < 0 ? 0 : (cellX >= MINIMAP_SIZE ? MINIMAP_SIZE - 1 : cellX);
+    row = row < 0 ? 0 : (row >= MINIMAP_SIZE ? MINIMAP_SIZE - 1 : row);
+    return row * MINIMAP_SIZE + cellX;
+}
+
+static void MarkDirty(int cell)
+{
+    int x = cell % MINIMAP_SIZE;
+    int y = cell / MINIMAP_SIZE;
+    if (!_dirty)
+    {
+        _dirtyMinX = _dirtyMaxX = x;
+        _dirtyMinY = _dirtyMaxY = y;
+        _dirty = true;
+        return;
+    }
+    if (x < _dirtyMinX) _dirtyMinX = x;
+    if (x > _dirtyMaxX) _dirtyMaxX = x;
+    if (y < _dirtyMinY) _dirtyMinY = y;
+    if (y > _dirtyMaxY) _dirtyMaxY = y;
+}
+
+static void ChangeCount(int cell, int delta)
+{
+    if (cell < 0) return;
+    _counts[cell] += delta;
+    _pixels[cell] = DensityColor(_counts[cell]);
+    MarkDirty(cell);
+}
+
+// Reads the points of a source into xs and ys, from the point cache where there is one
+static int ReadSource(const MinimapSource *source, const float **xs, const float **ys, float **owned)
+{
+    if (source->pointSet != ELEMENT_TYPE_NONE)
+    {
+        const PointSet *points = GetPointSet(source->pointSet);
+        *xs = points->xs;
+        *ys = points->ys;
+        *owned = NULL;
+        return points->count;
+    }
+
+    cJSON *array = GetLayerJSON(source->layer);
+    int count = cJSON_GetArraySize(array);
+    *owned = MemAlloc(sizeof(float) * 2 * (count > 0 ? count : 1));
+    if (*owned == NULL) return 0;
+
+    int i = 0;
+    cJSON *element = NULL;
+    cJSON_ArrayForEach(element, array)
+    {
+        cJSON *x = NULL, *y = NULL;
+        bool found = GetPointItemsJSON(element, source->field, &x, &y);
+        (*owned)[i] = found ? (float)x->valuedouble : NAN;
+        (*owned)[count + i] = found ? (float)y->valuedouble : NAN;
+        i++;
+    }
+    *xs = *owned;
+    *ys = *owned + count;
+    return count;
+}
+
+static bool IsCurrent(void)
+{
+    if (!_built) return false;
+    for (int s = 0; s < MINIMAP_SOURCE_COUNT; s++)
+    {
+        EditLayer layer = _sources[s].layer;
+        if (_builtLayers[layer] != GetLayerJSON(layer) || _builtStructures[layer] != ChangesGetStructureVersion(layer)) return false;
+    }
+    return ChangesComplete(_syncedVersion);
+}
+
+// Fits the image to the points and the world areas, then counts every point once
+static void Build(void)
+{
+    ProfileBegin("minimap build");
+    MemPushSubsystem(MEM_SUBSYSTEM_DRAW);
+    _built = false;
+    if (_counts == NULL) _counts = MemAlloc(sizeof(uint32_t) * MINIMAP_SIZE * MINIMAP_SIZE);
+    if (_pixels == NULL) _pixels = MemAlloc(sizeof(Color) * MINIMAP_SIZE * MINIMAP_SIZE);
+    if (_upload == NULL) _upload = MemAlloc(sizeof(Color) * MINIMAP_SIZE * MINIMAP_SIZE);
+    if (_counts == NULL || _pixels == NULL || _upload == NULL)
+    {
+        MemPopSubsystem();
+        ProfileEnd();
+        return;
+    }
+
+    const float *xs[MINIMAP_SOURCE_COUNT], *ys[MINIMAP_SOURCE_COUNT];
+    float *owned[MINIMAP_SOURCE_COUNT];
+    int counts[MINIMAP_SOURCE_COUNT];
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (int s = 0; s < MINIMAP_SOURCE_COUNT; s++)
+    {
+        counts[s] = ReadSource(&_sources[s], &xs[s], &ys[s], &owned[s]);
+        for (int i = 0; i < counts[s]; i++)
+        {
+            // NaN fails every compare, so points without a position are skipped
+            if (xs[s][i] < minX) minX = xs[s][i];
+            if (xs[s][i] > maxX) maxX = xs[s][i];
+            if (ys[s][i] < minY) minY = ys[s][i];
+            if (ys[s][i] > maxY) maxY = ys[s][i];
+        }
+    }
+    EditLayer areas[] = { LAYER_OCEAN_WORLD_AREA, LAYER_SPACE_WORLD_AREA };
+    for (int a = 0; a < 2; a++)
+    {
+        cJSON *xItem = NULL, *yItem = NULL;
+        PointField corners[] = { POINT_FIELD_MIN_MIN, POINT_FIELD_MAX_MAX };
+        for (int c = 0; c < 2; c++)
+        {
+            if (!GetPointItemsJSON(GetLayerJSON(areas[a]), corners[c], &xItem, &yItem)) continue;
+            minX = fminf(minX, (float)xItem->valuedouble);
+            maxX = fmaxf(maxX, (float)xItem->valuedouble);
+            minY = fminf(minY, (float)yItem->valuedouble);
+            maxY = fmaxf(maxY, (float)yItem->valuedouble);
+        }
+    }
+    if (minX > maxX)
+    {
+        minX = minY = -1.0f;
+        maxX = maxY = 1.0f;
+    }
+
+    // Square texels: the longer side of the world spans the image
+    float extent = fmaxf(fmaxf(maxX - minX, maxY - minY), 1.0f) * (1.0f + 2.0f * MINIMAP_PADDING);
+    _cellSize = extent / MINIMAP_SIZE;
+    _originX = (minX + maxX - extent) * 0.5f;
+    _originY = (minY + maxY - extent) * 0.5f;
+
+    memset(_counts, 0, sizeof(uint32_t) * MINIMAP_SIZE * MINIMAP_SIZE);
+    bool complete = true;
+    for (int s = 0; s < MINIMAP_SOURCE_COUNT; s++)
+    {
+        SourceCells *cells = &_cells[s];
+        int *array = MemRealloc(cells->cells, sizeof(int) * (counts[s] > 0 ? counts[s] : 1));
+        if (array == NULL) complete = false;
+        else cells->cells = array;
+        cells->count = array ? counts[s] : 0;
+        for (int i = 0; i < cells->count; i++)
+        {
+            cells->cells[i] = CellOf(xs[s][i], ys[s][i]);
+            if (cells->cells[i] >= 0) _counts[cells->cells[i]]++;
+        }
+        MemFree(owned[s]);
+    }
+    for (int cell = 0; cell < MINIMAP_SIZE * MINIMAP_SIZE; cell++) _pixels[cell] = DensityColor(_counts[cell]);
+
+    for (int s = 0; s < MINIMAP_SOURCE_COUNT; s++)
+    {
+        _builtLayers[_sources[s].layer] = GetLayerJSON(_sources[s].layer);
+        _builtStructures[_sources[s].layer] = ChangesGetStructureVersion(_sources[s].layer);
+    }
+    _syncedVersion = ChangesGetVersion();
+    _dirty = true;
+    _dirtyMinX = _dirtyMinY = 0;
+    _dirtyMaxX = _dirtyMaxY = MINIMAP_SIZE - 1;
+    _built = complete;
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+// Moves the points of the elements changed since the last sync to their new texels. No layer
+// was restructured since the build, so the indices in the change log are the build's.
+static void SyncChanges(void)
+{
+    if (ChangesGetVersion() == _syncedVersion) return;
+
+    ChangeIterator it = ChangesBegin(_syncedVersion);
+    ElementChange change;
+    while (ChangesNext(&it, &change))
+    {
+        for (int s = 0; s < MINIMAP_SOURCE_COUNT; s++)
+        {
+            SourceCells *cells = &_cells[s];
+            if (_sources[s].layer != change.layer || change.index < 0 || change.index >= cells->count) continue;
+
+            cJSON *x = NULL, *y = NULL;
+            bool found = GetPointItemsJSON((cJSON *)change.element, _sources[s].field, &x, &y);
+            int cell = found ? CellOf((float)x->valuedouble, (float)y->valuedouble) : -1;
+            if (cell == cells->cells[change.index]) continue;
+            ChangeCount(cells->cells[change.index], -1);
+            ChangeCount(cell, 1);
+            cells->cells[change.index] = cell;
+        }
+    }
+    _syncedVersion = ChangesGetVersion();
+}
+
+// Uploads the bounding box of the changed texels
+static void UploadTexture(void)
+{
+    if (_texture.id == 0)
+    {
+        Image image = { _pixels, MINIMAP_SIZE, MINIMAP_SIZE, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        _texture = LoadTextureFromImage(image);
+        _dirty = false;
+        return;
+    }
+    if (!_dirty) return;
+
+    int width = _dirtyMaxX - _dirtyMinX + 1;
+    int height = _dirtyMaxY - _dirtyMinY + 1;
+    for (int row = 0; row < height; row++)
+    {
+        memcpy(_upload + row * width, _pixels + (_dirtyMinY + row) * MINIMAP_SIZE + _dirtyMinX, sizeof(Color) * width);
+    }
+    UpdateTextureRec(_texture, (Rectangle){ (float)_dirtyMinX, (float)_dirtyMinY, (float)width, (float)height }, _upload);
+    _dirty = false;
+}
+
+static Rectangle PanelBounds(void)
+{
+    return (Rectangle){ MINIMAP_MARGIN, (float)(SCREEN_HEIGHT - MINIMAP_BOTTOM - MINIMAP_SIZE), MINIMAP_SIZE, MINIMAP_SIZE };
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+void MinimapDraw(Vector2 cameraOffset, float displayScale)
+{
+    if (!IsCurrent()) Build();
+    if (!_built) return;
+    SyncChanges();
+
+    ProfileBegin("draw minimap");
+    UploadTexture();
+    Rectangle panel = PanelBounds();
+    DrawTexture(_texture, (int)panel.x, (int)panel.y, WHITE);
+    DrawRectangleLinesEx(panel, 1, GRAY);
+
+    // The camera view in config coordinates, then in texels
+    float minX = -cameraOffset.x / displayScale;
+    float maxX = (SCREEN_WIDTH - cameraOffset.x) / displayScale;
+    float minY = (cameraOffset.y - SCREEN_HEIGHT) / displayScale;
+    float maxY = cameraOffset.y / displayScale;
+    Rectangle view = {
+        panel.x + (minX - _originX) / _cellSize,
+        panel.y + MINIMAP_SIZE - (maxY - _originY) / _cellSize,
+        (maxX - minX) / _cellSize,
+        (maxY - minY) / _cellSize
+    };
+    BeginScissorMode((int)panel.x, (int)panel.y, MINIMAP_SIZE, MINIMAP_SIZE);
+    DrawRectangleLinesEx(view, 2, RED);
+    EndScissorMode();
+    ProfileEnd();
+}
+
+bool MinimapHandleMouse(Vector2 mousePos, Vector2 *cameraOffset, float displayScale)
+{
+    Rectangle panel = PanelBounds();
+    bool inside = CheckCollisionPointRec(mousePos, panel);
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && inside && _built) _dragging = true;
+    if (!IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+    {
+        bool released = _dragging;
+        _dragging = false;
+        return inside || released;
+    }
+    if (!_dragging) return false;
+
+    // Center the view on the world point under the cursor
+    float u = fminf(fmaxf(mousePos.x - panel.x, 0.0f), MINIMAP_SIZE);
+    float v = fminf(fmaxf(mousePos.y - panel.y, 0.0f), MINIMAP_SIZE);
+    float x = _originX + u * _cellSize;
+    float y = _originY + (MINIMAP_SIZE - v) * _cellSize;
+    cameraOffset->x = SCREEN_WIDTH * 0.5f - x * displayScale;
+    cameraOffset->y = SCREEN_HEIGHT * 0.5f + y * displayScale;
+    return true;
+}
+
+void MinimapClear(void)
+{
+    if (_texture.id != 0) UnloadTexture(_texture);
+    _texture = (Texture2D){ 0 };
+    for (int s = 0; s < MINIMAP_SOURCE_COUNT; s++)
+    {
+        MemFree(_cells[s].cells);
+        _cells[s] = (SourceCells){ 0 };
+    }
+    MemFree(_counts);
+    MemFree(_pixels);
+    MemFree(_upload);
+    _counts = NULL;
+    _pixels = NULL;
+    _upload = NULL;
+    _built = false;
+    _dirty = false;
+    _dragging = false;
+}
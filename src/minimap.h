@@ -0,0 +1,35 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "raylib.h"
+#include "map_editor.h"
+
+#define MINIMAP_SIZE 256 // Texture and panel size in pixels
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// A density image of the structures, boost gate ends and portal ends over the whole world,
+// with the camera view drawn on top. The image is counted once per structural change (O(N));
+// after that only the elements changed since the last draw are looked at, and only the cells
+// their points leave and enter are updated, so dragging touches a handful of texels.
+
+/**
+ * @brief Draws the minimap panel in the bottom left corner, uploading the changed texels first.
+ */
+void MinimapDraw(Vector2 cameraOffset, float displayScale);
+
+/**
+ * @brief Moves the camera while the left button is pressed or dragged on the minimap, centering
+ *        the view on the world point under the cursor.
+ * @return true while the mouse is over the panel or a minimap drag is in progress, in which case
+ *         the click must not reach the map below.
+ */
+bool MinimapHandleMouse(Vector2 mousePos, Vector2 *cameraOffset, float displayScale);
+
+/**
+ * @brief Frees the density counts and the texture.
+ */
+void MinimapClear(void);
+
+#endif // MINIMAP_H
@@ -0,0 +1,523 @@
+#include "parallel_parse.h"
+#include "json_scan.h"
+#include "memtrack.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#define MIN_PARALLEL_BYTES (1024 * 1024) // Smaller documents parse faster on one thread
+#define CHUNK_BYTES (256 * 1024)         // Target size of one parse job
+#define RANGES_PER_THREAD 4              // Pre-scan ranges, several per thread to even out the load
+#define MAX_THREADS 64
+
+// A bracket or comma at nesting depth 1 or 2. Depth is that of the container the byte belongs to,
+// so the root's braces are depth 1 and the brackets of a top-level array are depth 2.
+typedef struct {
+    size_t pos;
+    char c;
+    int depth;
+} ScanEvent;
+
+// A slice of the text that starts right after a line break, so it never starts inside a string
+typedef struct {
+    size_t start;
+    size_t end;
+    int startDepth;
+    int endDepth;
+    bool valid;
+    ScanEvent *events;
+    int eventCount;
+    int eventCapacity;
+} ScanRange;
+
+// One value, or a run of array elements, parsed by one worker
+typedef struct {
+    size_t start;
+    size_t end;
+    bool elements;
+    cJSON *head;
+    cJSON *tail;
+    bool failed;
+} ParseJob;
+
+// A top-level member and the jobs that parse its value
+typedef struct {
+    JsonSpan key;
+    int firstJob;
+    int jobCount;
+    bool chunked; // The jobs are element runs of one array
+} MemberPlan;
+
+typedef struct {
+    const char *text;
+    size_t length;
+    ScanRange *ranges;
+    int rangeCount;
+    ParseJob *jobs;
+    int jobCount;
+    int jobCapacity;
+    MemberPlan *members;
+    int memberCount;
+    int memberCapacity;
+} ParseContext;
+
+typedef void (*TaskFunction)(ParseContext *context, int task);
+
+typedef struct {
+    TaskFunction function;
+    ParseContext *context;
+    int taskCount;
+    int nextTask;
+    pthread_mutex_t lock;
+} TaskQueue;
+
+//------------------------------------------------------------------------------------
+// Worker pool
+//------------------------------------------------------------------------------------
+static void *WorkerMain(void *argument)
+{
+    TaskQueue *queue = argument;
+    MemWorkerBegin(MEM_SUBSYSTEM_LOAD);
+    for (;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        int task = queue->nextTask++;
+        pthread_mutex_unlock(&queue->lock);
+        if (task >= queue->taskCount) break;
+        queue->function(queue->context, task);
+    }
+    MemWorkerEnd();
+    return NULL;
+}
+
+// Runs every task on up to threadCount threads and returns when all are done
+static void RunTasks(int threadCount, int taskCount, TaskFunction function, ParseContext *context)
+{
+    TaskQueue queue = { function, context, taskCount, 0 };
+    if (threadCount > taskCount) threadCount = taskCount;
+    if (threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+
+    pthread_t threads[MAX_THREADS];
+    int started = 0;
+    if (threadCount > 1 && pthread_mutex_init(&queue.lock, NULL) == 0)
+    {
+        for (int i = 0; i < threadCount; i++)
+        {
+            if (pthread_create(&threads[started], NULL, WorkerMain, &queue) == 0) started++;
+        }
+        for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+        pthread_mutex_destroy(&queue.lock);
+    }
+
+    // Whatever no thread picked up (no threads at all, or too few started) runs here
+    for (int task = queue.nextTask; task < taskCount; task++) function(context, task);
+}
+
+//------------------------------------------------------------------------------------
+// Pre-scan
+//------------------------------------------------------------------------------------
+static bool AddEvent(ScanRange *range, size_t pos, char c, int depth)
+{
+    if (range->eventCount == range->eventCapacity)
+    {
+        int capacity = (range->eventCapacity == 0) ? 64 : range->eventCapacity * 2;
+        ScanEvent *events = MemRealloc(range->events, sizeof(ScanEvent) * capacity);
+        if (events == NULL) return false;
+        range->events = events;
+        range->eventCapacity = capacity;
+    }
+    range->events[range->eventCount++] = (ScanEvent){ pos, c, depth };
+    return true;
+}
+
+// Tracks strings and nesting over a range. Without record it only measures the depth change;
+// with record it also keeps the events the planner needs, sampling depth 2 commas every CHUNK_BYTES.
+static void ScanRangeBytes(const char *text, ScanRange *range, bool record)
+{
+    int depth = range->startDepth;
+    bool inString = false;
+    bool ok = true;
+    size_t lastSplit = range->start;
+
+    for (size_t pos = range->start; pos < range->end && ok; pos++)
+    {
+        char c = text[pos];
+        if (inString)
+        {
+            if (c == '\\') pos++;
+            else if (c == '"') inString = false;
+            continue;
+        }
+
+        switch (c)
+        {
+            case '"':
+                inString = true;
+                break;
+            case '[':
+            case '{':
+                depth++;
+                if (record && depth <= 2)
+                {
+                    ok = AddEvent(range, pos, c, depth);
+                    lastSplit = pos;
+                }
+                break;
+            case ']':
+            case '}':
+                if (record && depth <= 2) ok = AddEvent(range, pos, c, depth);
+                depth--;
+                break;
+            case ',':
+                if (record && depth == 1) ok = AddEvent(range, pos, c, depth);
+                else if (record && depth == 2 && pos - lastSplit >= CHUNK_BYTES)
+                {
+                    ok = AddEvent(range, pos, c, depth);
+                    lastSplit = pos;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    range->endDepth = depth;
+    range->valid = ok && !inString;
+}
+
+static void MeasureRange(ParseContext *context, int task)
+{
+    ScanRange *range = &context->ranges[task];
+    range->startDepth = 0;
+    ScanRangeBytes(context->text, range, false);
+}
+
+static void RecordRange(ParseContext *context, int task)
+{
+    ScanRangeBytes(context->text, &context->ranges[task], true);
+}
+
+// Splits the text into ranges that each start after a line break
+static int SplitRanges(ParseContext *context, int rangeCount)
+{
+    const char *text = context->text;
+    size_t length = context->length;
+    int count = 0;
+    size_t start = 0;
+
+    for (int i = 1; i < rangeCount && start < length; i++)
+    {
+        size_t target = (size_t)((double)length * i / rangeCount);
+        if (target <= start) continue;
+        const char *lineBreak = memchr(text + target, '\n', length - target);
+        if (lineBreak == NULL) break;
+        size_t end = (size_t)(lineBreak - text) + 1;
+        context->ranges[count++] = (ScanRange){ start, end };
+        start = end;
+    }
+    if (start < length) context->ranges[count++] = (ScanRange){ start, length };
+    return count;
+}
+
+//------------------------------------------------------------------------------------
+// Planning
+//------------------------------------------------------------------------------------
+static bool AddJob(ParseContext *context, size_t start, size_t end, bool elements)
+{
+    if (context->jobCount == context->jobCapacity)
+    {
+        int capacity = (context->jobCapacity == 0) ? 64 : context->jobCapacity * 2;
+        ParseJob *jobs = MemRealloc(context->jobs, sizeof(ParseJob) * capacity);
+        if (jobs == NULL) return false;
+        context->jobs = jobs;
+        context->jobCapacity = capacity;
+    }
+    context->jobs[context->jobCount++] = (ParseJob){ start, end, elements };
+    return true;
+}
+
+static MemberPlan *AddMember(ParseContext *context)
+{
+    if (context->memberCount == context->memberCapacity)
+    {
+        int capacity = (context->memberCapacity == 0) ? 16 : context->memberCapacity * 2;
+        MemberPlan *members = MemRealloc(context->members, sizeof(MemberPlan) * capacity);
+        if (members == NULL) return NULL;
+        context->members = members;
+        context->memberCapacity = capacity;
+    }
+    return &context->members[context->memberCount++];
+}
+
+// Plans the member in [start, end). open/close are its value's depth 2 brackets, if any, and
+// splits the depth 2 commas sampled in between.
+static bool PlanMember(ParseContext *context, size_t start, size_t end, const ScanEvent *open, const ScanEvent *close, const size_t *splits, int splitCount)
+{
+    const char *text = context->text;
+    size_t pos = JsonSkipWhitespace(text, end, start);
+    JsonSpan key;
+    if (pos >= end || text[pos] != '"' || !JsonScanValue(text, end, pos, &key)) return false;
+    size_t colon = JsonSkipWhitespace(text, end, key.end);
+    if (colon >= end || text[colon] != ':') return false;
+    size_t valueStart = JsonSkipWhitespace(text, end, colon + 1);
+
+    MemberPlan *member = AddMember(context);
+    if (member == NULL) return false;
+    *member = (MemberPlan){ key, context->jobCount, 1, false };
+
+    if (open == NULL) return AddJob(context, valueStart, end, false);
+    if (open->pos != valueStart || close == NULL || JsonSkipWhitespace(text, end, close->pos + 1) != end) return false;
+
+    // Large arrays become runs of elements between sampled commas
+    if (open->c == '[' && splitCount > 0)
+    {
+        size_t runStart = open->pos + 1;
+        for (int i = 0; i < splitCount; i++)
+        {
+            if (!AddJob(context, runStart, splits[i], true)) return false;
+            runStart = splits[i] + 1;
+        }
+        if (!AddJob(context, runStart, close->pos, true)) return false;
+        member->jobCount = splitCount + 1;
+        member->chunked = true;
+        return true;
+    }
+    return AddJob(context, valueStart, close->pos + 1, false);
+}
+
+// Turns the recorded events into members and parse jobs
+static bool PlanJobs(ParseContext *context)
+{
+    size_t *splits = NULL;
+    int splitCount = 0;
+    int splitCapacity = 0;
+    bool rootOpen = false;
+    bool rootClosed = false;
+    bool ok = true;
+    size_t memberStart = 0;
+    ScanEvent open = { 0 }, close = { 0 };
+    bool hasOpen = false, hasClose = false;
+
+    for (int r = 0; r < context->rangeCount && ok && !rootClosed; r++)
+    {
+        const ScanRange *range = &context->ranges[r];
+        for (int e = 0; e < range->eventCount && ok && !rootClosed; e++)
+        {
+            ScanEvent event = range->events[e];
+            if (!rootOpen)
+            {
+                // Only an object root is split; anything else is left to cJSON
+                ok = (event.c == '{' && event.depth == 1 && JsonSkipWhitespace(context->text, context->length, 0) == event.pos);
+                rootOpen = true;
+                memberStart = event.pos + 1;
+                continue;
+            }
+
+            if (event.depth == 2)
+            {
+                if (event.c == '[' || event.c == '{') { open = event; hasOpen = true; splitCount = 0; }
+                else if (event.c == ']' || event.c == '}') { close = event; hasClose = true; }
+                else if (hasOpen && !hasClose)
+                {
+                    if (splitCount == splitCapacity)
+                    {
+                        int capacity = (splitCapacity == 0) ? 64 : splitCapacity * 2;
+                        size_t *resized = MemRealloc(splits, sizeof(size_t) * capacity);
+                        if (resized == NULL) { ok = false; break; }
+                        splits = resized;
+                        splitCapacity = capacity;
+                    }
+                    splits[splitCount++] = event.pos;
+                }
+                continue;
+            }
+
+            // A depth 1 comma or the root's closing brace ends a member
+            bool isClose = (event.c == '}' || event.c == ']');
+            if (isClose) rootClosed = true;
+            bool empty = isClose && context->memberCount == 0 && !hasOpen &&
+                         JsonSkipWhitespace(context->text, event.pos, memberStart) == event.pos;
+            if (!empty)
+            {
+                ok = PlanMember(context, memberStart, event.pos, hasOpen ? &open : NULL, hasClose ? &close : NULL, splits, splitCount);
+            }
+            memberStart = event.pos + 1;
+            hasOpen = hasClose = false;
+            splitCount = 0;
+        }
+    }
+    MemFree(splits);
+    return ok && rootClosed;
+}
+
+//------------------------------------------------------------------------------------
+// Parsing and stitching
+//------------------------------------------------------------------------------------
+static cJSON *ParseValueAt(const char *text, size_t *pos, size_t end)
+{
+    const char *parseEnd = NULL;
+    cJSON *item = cJSON_ParseWithLengthOpts(text + *pos, end - *pos, &parseEnd, false);
+    if (item) *pos = (size_t)(parseEnd - text);
+    return item;
+}
+
+static void ParseJobRun(ParseContext *context, int task)
+{
+    ParseJob *job = &context->jobs[task];
+    const char *text = context->text;
+    size_t pos = JsonSkipWhitespace(text, job->end, job->start);
+
+    if (!job->elements)
+    {
+        job->head = job->tail = ParseValueAt(text, &pos, job->end);
+        job->failed = (job->head == NULL || JsonSkipWhitespace(text, job->end, pos) != job->end);
+        return;
+    }
+
+    while (pos < job->end)
+    {
+        cJSON *item = ParseValueAt(text, &pos, job->end);
+        if (item == NULL) { job->failed = true; return; }
+        if (job->tail) { job->tail->next = item; item->prev = job->tail; }
+        else job->head = item;
+        job->tail = item;
+
+        pos = JsonSkipWhitespace(text, job->end, pos);
+        if (pos >= job->end) break;
+        if (text[pos] != ',') { job->failed = true; return; }
+        pos = JsonSkipWhitespace(text, job->end, pos + 1);
+        if (pos >= job->end) { job->failed = true; return; }
+    }
+    job->failed = (job->head == NULL);
+}
+
+// Links the element runs of a chunked array into one array item
+static cJSON *StitchArray(ParseContext *context, const MemberPlan *member)
+{
+    cJSON *array = cJSON_CreateArray();
+    if (array == NULL) return NULL;
+
+    cJSON *tail = NULL;
+    for (int i = 0; i < member->jobCount; i++)
+    {
+        ParseJob *job = &context->jobs[member->firstJob + i];
+        if (tail) { tail->next = job->head; job->head->prev = tail; }
+        else array->child = job->head;
+        tail = job->tail;
+        job->head = job->tail = NULL;
+    }
+    array->child->prev = tail;
+    return array;
+}
+
+static cJSON *Stitch(ParseContext *context)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) return NULL;
+
+    for (int m = 0; m < context->memberCount; m++)
+    {
+        const MemberPlan *member = &context->members[m];
+        cJSON *key = cJSON_ParseWithLength(context->text + member->key.start, member->key.end - member->key.start);
+        cJSON *value = NULL;
+        if (member->chunked) value = StitchArray(context, member);
+        else
+        {
+            value = context->jobs[member->firstJob].head;
+            context->jobs[member->firstJob].head = NULL;
+        }
+
+        bool added = (key && value && cJSON_AddItemToObject(root, key->valuestring, value));
+        cJSON_Delete(key);
+        if (!added)
+        {
+            cJSON_Delete(value);
+            cJSON_Delete(root);
+            return NULL;
+        }
+    }
+    return root;
+}
+
+static void FreeContext(ParseContext *context)
+{
+    for (int i = 0; i < context->rangeCount; i++) MemFree(context->ranges[i].events);
+    // Runs that were not stitched (after a failure) still own their elements
+    for (int i = 0; i < context->jobCount; i++) cJSON_Delete(context->jobs[i].head);
+    MemFree(context->ranges);
+    MemFree(context->jobs);
+    MemFree(context->members);
+}
+
+static cJSON *ParseParallel(const char *text, size_t length, int threadCount)
+{
+    ParseContext context = { text, length };
+    int rangeCount = threadCount * RANGES_PER_THREAD;
+    context.ranges = MemCalloc(rangeCount, sizeof(ScanRange));
+    if (context.ranges == NULL) return NULL;
+    context.rangeCount = SplitRanges(&context, rangeCount);
+
+    // Pass 1 finds how deep each range ends relative to its start, pass 2 records events at
+    // the absolute depths that follow from that
+    RunTasks(threadCount, context.rangeCount, MeasureRange, &context);
+    int depth = 0;
+    bool ok = true;
+    for (int i = 0; i < context.rangeCount && ok; i++)
+    {
+        ok = context.ranges[i].valid;
+        context.ranges[i].startDepth = depth;
+        depth += context.ranges[i].endDepth;
+        if (depth < 0) ok = false;
+    }
+
+    if (ok)
+    {
+        RunTasks(threadCount, context.rangeCount, RecordRange, &context);
+        for (int i = 0; i < context.rangeCount && ok; i++) ok = context.ranges[i].valid;
+    }
+
+    ok = ok && PlanJobs(&context);
+
+    cJSON *document = NULL;
+    if (ok)
+    {
+        RunTasks(threadCount, context.jobCount, ParseJobRun, &context);
+        for (int i = 0; i < context.jobCount && ok; i++) ok = !context.jobs[i].failed;
+        if (ok) document = Stitch(&context);
+    }
+    FreeContext(&context);
+    return document;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+cJSON *ParseConfig(const char *text, size_t length, int threadCount)
+{
+    if (threadCount <= 0) threadCount = GetProcessorCount();
+    if (threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+
+    if (text != NULL && threadCount > 1 && length >= MIN_PARALLEL_BYTES)
+    {
+        cJSON *document = ParseParallel(text, length, threadCount);
+        if (document) return document;
+    }
+
+    // Also reached when the parallel parse failed, so errors are reported exactly like cJSON does
+    return cJSON_ParseWithLength(text, length);
+}
+
+int GetProcessorCount(void)
+{
+#if defined(_WIN32)
+    const char *value = getenv("NUMBER_OF_PROCESSORS");
+    int count = value ? atoi(value) : 1;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (count > 0) ? count : 1;
+}
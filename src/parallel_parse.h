@@ -0,0 +1,28 @@
+#ifndef PARALLEL_PARSE_H
+#define PARALLEL_PARSE_H
+
+#include "cJSON.h"
+#include <stddef.h>
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Parses a config on several threads. A structural pre-scan, itself split across the
+// threads at line breaks (which never occur inside JSON strings), finds the top-level
+// members and cuts large arrays into chunks of elements. The chunks are parsed in
+// parallel with cJSON and their element lists are linked into one document.
+
+/**
+ * @brief Parses text into the same tree cJSON_ParseWithLength() would build.
+ *        Small, single-line or unusual documents are parsed on the calling thread.
+ * @param threadCount Number of threads to use, 0 for one per processor.
+ * @return The document, or NULL on a parse error (cJSON_GetErrorPtr() is set as usual).
+ */
+cJSON *ParseConfig(const char *text, size_t length, int threadCount);
+
+/**
+ * @brief Returns the number of processors available to the editor.
+ */
+int GetProcessorCount(void);
+
+#endif // PARALLEL_PARSE_H
@@ -0,0 +1,559 @@
+#include "picking.h"
+#include "changes.h"
+#include "point_cache.h"
+#include "hit_test.h"
+#include "memtrack.h"
+#include <math.h>
+#include <string.h>
+
+#define PICK_CLASS_COUNT 5
+#define PICK_FIRST_CORNER_CLASS 3
+#define PICK_RADIUS 10.0f
+#define PICK_CORNER_RADIUS 15.0f
+#define PICK_POINTS_PER_CELL 8
+#define PICK_MAX_GRID 1024
+#define PICK_MAX_MOVED 4096 // Moved points kept outside the grid before it is rebuilt
+
+// Slot of a source point that is not in the grid: missing, or in the moved list
+#define SLOT_NONE -1
+#define SLOT_MOVED(k) (-2 - (k))
+
+// Points moved since the build, searched one by one until the next rebuild
+typedef struct {
+    float x;
+    float y;
+    int id;
+    int pickClass;
+} MovedPoint;
+
+// Every point of the visible layers has a source id, numbered layer by layer, element by
+// element, field by field. The grid holds the points sorted by class and then cell.
+typedef struct {
+    float *xs;
+    float *ys;
+    int *ids;
+    int *cellStart;             // PICK_CLASS_COUNT * grid * grid + 1 offsets into the sorted points
+    int *slots;                 // Sorted position of each source id, or SLOT_NONE / SLOT_MOVED(k)
+    int capacity;
+    int cellCapacity;
+    int layerBase[LAYER_COUNT + 1];
+    int grid;
+    float minX, minY, maxX, maxY;
+    float cellsPerUnitX, cellsPerUnitY;
+    uint32_t builtMask;
+    const cJSON *builtLayers[LAYER_COUNT];
+    uint64_t builtVersions[LAYER_COUNT];
+    bool built;
+} PickIndex;
+
+static PickIndex _index = { 0 };
+static MovedPoint _moved[PICK_MAX_MOVED];
+static int _movedCount = 0;
+
+static const int _layerClass[LAYER_COUNT] = { 0, 1, 2, 3, 3, 3, 4, 4 };
+
+//------------------------------------------------------------------------------------
+// Source ids
+//------------------------------------------------------------------------------------
+static PointField FirstField(EditLayer layer)
+{
+    if (layer == LAYER_STRUCTURES) return POINT_FIELD_LOCATION;
+    if (layer == LAYER_BOOST_GATES || layer == LAYER_PORTALS) return POINT_FIELD_A;
+    return POINT_FIELD_MIN_MIN;
+}
+
+static int FieldCount(EditLayer layer)
+{
+    if (layer == LAYER_STRUCTURES) return 1;
+    if (layer == LAYER_BOOST_GATES || layer == LAYER_PORTALS) return 2;
+    return 4;
+}
+
+// Structures and boost gates come from the point cache, which already holds them as arrays
+static const PointSet *CachedPoints(EditLayer layer, int field)
+{
+    if (layer == LAYER_STRUCTURES) return GetPointSet(ELEMENT_TYPE_STRUCTURE);
+    if (layer == LAYER_BOOST_GATES) return GetPointSet(field == 0 ? ELEMENT_TYPE_BOOST_GATE_A : ELEMENT_TYPE_BOOST_GATE_B);
+    return NULL;
+}
+
+static int ElementCount(EditLayer layer)
+{
+    cJSON *json = GetLayerJSON(layer);
+    if (CachedPoints(layer, 0) != NULL) return CachedPoints(layer, 0)->count;
+    if (IsWorldAreaLayer(layer)) return json ? 1 : 0;
+    return cJSON_GetArraySize(json);
+}
+
+static int IdOf(PointRef ref)
+{
+    return _index.layerBase[ref.layer] + ref.index * FieldCount(ref.layer) + (int)(ref.field - FirstField(ref.layer));
+}
+
+static PointRef RefOf(int id)
+{
+    int layer = 0;
+    while (id >= _index.layerBase[layer + 1]) layer++;
+    int local = id - _index.layerBase[layer];
+    int fields = FieldCount((EditLayer)layer);
+    return (PointRef){ (EditLayer)layer, local / fields, (PointField)(FirstField((EditLayer)layer) + local % fields) };
+}
+
+static int ClassOf(int id)
+{
+    return _layerClass[RefOf(id).layer];
+}
+
+//------------------------------------------------------------------------------------
+// Grid
+//------------------------------------------------------------------------------------
+static int Column(float x)
+{
+    int column = (int)floorf((x - _index.minX) * _index.cellsPerUnitX);
+    return column < 0 ? 0 : (column >= _index.grid ? _index.grid - 1 : column);
+}
+
+static int Row(float y)
+{
+    int row = (int)floorf((y - _index.minY) * _index.cellsPerUnitY);
+    return row < 0 ? 0 : (row >= _index.grid ? _index.grid - 1 : row);
+}
+
+static bool InsideGrid(float x, float y)
+{
+    return x >= _index.minX && x <= _index.maxX && y >= _index.minY && y <= _index.maxY;
+}
+
+static bool Reserve(void **array, size_t elementSize, int count)
+{
+    void *resized = MemRealloc(*array, elementSize * (count > 0 ? count : 1));
+    if (resized == NULL) return false;
+    *array = resized;
+    return true;
+}
+
+// Reads the points of every visible layer into xs and ys by source id
+static void ReadPoints(uint32_t layerMask, float *xs, float *ys)
+{
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+    {
+        if ((layerMask & (1u << layer)) == 0) continue;
+
+        int id = _index.layerBase[layer];
+        int fields = FieldCount((EditLayer)layer);
+        PointField first = FirstField((EditLayer)layer);
+        if (CachedPoints((EditLayer)layer, 0) != NULL)
+        {
+            for (int f = 0; f < fields; f++)
+            {
+                const PointSet *points = CachedPoints((EditLayer)layer, f);
+                int count = (_index.layerBase[layer + 1] - id) / fields;
+                if (points->count < count) count = points->count;
+                for (int i = 0; i < count; i++)
+                {
+                    xs[id + i * fields + f] = points->xs[i];
+                    ys[id + i * fields + f] = points->ys[i];
+                }
+            }
+            continue;
+        }
+
+        cJSON *json = GetLayerJSON((EditLayer)layer);
+        cJSON *element = IsWorldAreaLayer((EditLayer)layer) ? json : (json ? json->child : NULL);
+        for (; element != NULL && id < _index.layerBase[layer + 1]; element = element->next)
+        {
+            for (int f = 0; f < fields; f++, id++)
+            {
+                cJSON *xItem = NULL, *yItem = NULL;
+                bool found = GetPointItemsJSON(element, (PointField)(first + f), &xItem, &yItem);
+                xs[id] = found ? (float)xItem->valuedouble : NAN;
+                ys[id] = found ? (float)yItem->valuedouble : NAN;
+            }
+        }
+    }
+}
+
+static bool Build(uint32_t layerMask)
+{
+    int total = 0;
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+    {
+        _index.layerBase[layer] = total;
+        if (layerMask & (1u << layer)) total += ElementCount((EditLayer)layer) * FieldCount((EditLayer)layer);
+    }
+    _index.layerBase[LAYER_COUNT] = total;
+    _movedCount = 0;
+
+    if (total > _index.capacity)
+    {
+        if (!Reserve((void **)&_index.xs, sizeof(float), total) || !Reserve((void **)&_index.ys, sizeof(float), total) ||
+            !Reserve((void **)&_index.ids, sizeof(int), total) || !Reserve((void **)&_index.slots, sizeof(int), total)) return false;
+        _index.capacity = total;
+    }
+    float *xs = MemAlloc(sizeof(float) * (total > 0 ? total : 1));
+    float *ys = MemAlloc(sizeof(float) * (total > 0 ? total : 1));
+    int *keys = MemAlloc(sizeof(int) * (total > 0 ? total : 1));
+    if (xs == NULL || ys == NULL || keys == NULL)
+    {
+        MemFree(xs);
+        MemFree(ys);
+        MemFree(keys);
+        return false;
+    }
+    ReadPoints(layerMask, xs, ys);
+
+    // Bounds and a grid with a few points per cell
+    int valid = 0;
+    _index.minX = _index.minY = INFINITY;
+    _index.maxX = _index.maxY = -INFINITY;
+    for (int id = 0; id < total; id++)
+    {
+        if (isnan(xs[id]) || isnan(ys[id])) continue;
+        if (xs[id] < _index.minX) _index.minX = xs[id];
+        if (xs[id] > _index.maxX) _index.maxX = xs[id];
+        if (ys[id] < _index.minY) _index.minY = ys[id];
+        if (ys[id] > _index.maxY) _index.maxY = ys[id];
+        valid++;
+    }
+    if (valid == 0) _index.minX = _index.minY = _index.maxX = _index.maxY = 0.0f;
+    int grid = (int)sqrtf((float)valid / PICK_POINTS_PER_CELL);
+    _index.grid = grid < 1 ? 1 : (grid > PICK_MAX_GRID ? PICK_MAX_GRID : grid);
+    float width = _index.maxX - _index.minX;
+    float height = _index.maxY - _index.minY;
+    _index.cellsPerUnitX = width > 0.0f ? _index.grid / width : 0.0f;
+    _index.cellsPerUnitY = height > 0.0f ? _index.grid / height : 0.0f;
+
+    int cells = PICK_CLASS_COUNT * _index.grid * _index.grid;
+    if (cells + 1 > _index.cellCapacity)
+    {
+        if (!Reserve((void **)&_index.cellStart, sizeof(int), cells + 1))
+        {
+            MemFree(xs);
+            MemFree(ys);
+            MemFree(keys);
+            return false;
+        }
+        _index.cellCapacity = cells + 1;
+    }
+
+    // Counting sort by class and cell; filling back to front leaves each entry at its bucket start
+    memset(_index.cellStart, 0, sizeof(int) * (cells + 1));
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+    {
+        int *classCells = _index.cellStart + _layerClass[layer] * _index.grid * _index.grid;
+        for (int id = _index.layerBase[layer]; id < _index.layerBase[layer + 1]; id++)
+        {
+            keys[id] = -1;
+            _index.slots[id] = SLOT_NONE;
+            if (isnan(xs[id]) || isnan(ys[id])) continue;
+
+            // Inside the bounds, so truncating is flooring
+            int column = (int)((xs[id] - _index.minX) * _index.cellsPerUnitX);
+            int row = (int)((ys[id] - _index.minY) * _index.cellsPerUnitY);
+            if (column >= _index.grid) column = _index.grid - 1;
+            if (row >= _index.grid) row = _index.grid - 1;
+            keys[id] = (int)(classCells - _index.cellStart) + row * _index.grid + column;
+            classCells[row * _index.grid + column]++;
+        }
+    }
+    int sum = 0;
+    for (int key = 0; key < cells; key++)
+    {
+        sum += _index.cellStart[key];
+        _index.cellStart[key] = sum;
+    }
+    _index.cellStart[cells] = sum;
+    for (int id = total - 1; id >= 0; id--)
+    {
+        if (keys[id] < 0) continue;
+        int slot = --_index.cellStart[keys[id]];
+        _index.xs[slot] = xs[id];
+        _index.ys[slot] = ys[id];
+        _index.ids[slot] = id;
+        _index.slots[id] = slot;
+    }
+
+    MemFree(xs);
+    MemFree(ys);
+    MemFree(keys);
+    return true;
+}
+
+static bool IsCurrent(uint32_t layerMask)
+{
+    if (!_index.built || _index.builtMask != layerMask) return false;
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+    {
+        if ((layerMask & (1u << layer)) == 0) continue;
+        if (_index.builtLayers[layer] != GetLayerJSON((EditLayer)layer) || _index.builtVersions[layer] != ChangesGetStructureVersion((EditLayer)layer)) return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------------
+// Nearest point of one class, searching the grid rows the reach overlaps and then the moved points
+static int NearestInClass(int pickClass, float x, float y, float radius)
+{
+    float best = radius * radius;
+    int bestId = -1;
+
+    if (x + radius >= _index.minX && x - radius <= _index.maxX && y + radius >= _index.minY && y - radius <= _index.maxY)
+    {
+        const int *cells = _index.cellStart + pickClass * _index.grid * _index.grid;
+        int firstColumn = Column(x - radius);
+        int lastColumn = Column(x + radius);
+        for (int row = Row(y - radius); row <= Row(y + radius); row++)
+        {
+            // The cells of a row are contiguous, so one batch covers the whole span
+            int start = cells[row * _index.grid + firstColumn];
+            int end = cells[row * _index.grid + lastColumn + 1];
+            int hit = HitTestNearest(_index.xs + start, _index.ys + start, end - start, x, y, radius);
+            if (hit < 0) continue;
+
+            float dx = _index.xs[start + hit] - x;
+            float dy = _index.ys[start + hit] - y;
+            if (dx * dx + dy * dy < best)
+            {
+                best = dx * dx + dy * dy;
+                bestId = _index.ids[start + hit];
+            }
+        }
+    }
+
+    for (int k = 0; k < _movedCount; k++)
+    {
+        if (_moved[k].pickClass != pickClass) continue;
+        float dx = _moved[k].x - x;
+        float dy = _moved[k].y - y;
+        if (dx * dx + dy * dy < best)
+        {
+            best = dx * dx + dy * dy;
+            bestId = _moved[k].id;
+        }
+    }
+    return bestId;
+}
+
+static bool EnsureIndex(uint32_t layerMask)
+{
+    if (!IsCurrent(layerMask))
+    {
+        MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+        _index.built = Build(layerMask);
+        _index.builtMask = layerMask;
+        for (int layer = 0; layer < LAYER_COUNT; layer++)
+        {
+            _index.builtLayers[layer] = GetLayerJSON((EditLayer)layer);
+            _index.builtVersions[layer] = ChangesGetStructureVersion((EditLayer)layer);
+        }
+        MemPopSubsystem();
+    }
+    return _index.built;
+}
+
+bool PickNearest(float x, float y, float displayScale, uint32_t layerMask, PointRef *picked)
+{
+    if (!EnsureIndex(layerMask)) return false;
+
+    for (int pickClass = 0; pickClass < PICK_CLASS_COUNT; pickClass++)
+    {
+        float radius = (pickClass >= PICK_FIRST_CORNER_CLASS ? PICK_CORNER_RADIUS : PICK_RADIUS) / displayScale;
+        int id = NearestInClass(pickClass, x, y, radius);
+        if (id >= 0)
+        {
+            *picked = RefOf(id);
+            return true;
+        }
+    }
+    return false;
+}
+
+// How a candidate is ranked: by distance, or by the offset along one axis and then the other
+typedef enum {
+    RANK_NEAREST = 0,
+    RANK_ALIGN_X,
+    RANK_ALIGN_Y
+} RankMode;
+
+typedef struct {
+    RankMode mode;
+    float x;
+    float y;
+    float minX, minY, maxX, maxY;   // Only points inside are candidates
+    const PointRef *excluded;
+    int excludedCount;
+    float bestPrimary;
+    float bestSecondary;
+    int bestId;
+    float bestX;
+    float bestY;
+} RankedSearch;
+
+static bool IsExcluded(const RankedSearch *search, int id)
+{
+    PointRef ref = RefOf(id);
+    for (int i = 0; i < search->excludedCount; i++)
+    {
+        if (search->excluded[i].layer == ref.layer && search->excluded[i].index == ref.index) return true;
+    }
+    return false;
+}
+
+// Exclusion is only checked for a point that would be the new best, which few points are
+static void Consider(RankedSearch *search, float px, float py, int id)
+{
+    if (!(px >= search->minX && px <= search->maxX && py >= search->minY && py <= search->maxY)) return;
+
+    float dx = fabsf(px - search->x);
+    float dy = fabsf(py - search->y);
+    float primary = (search->mode == RANK_NEAREST) ? dx * dx + dy * dy : (search->mode == RANK_ALIGN_X ? dx : dy);
+    float secondary = (search->mode == RANK_NEAREST) ? 0.0f : (search->mode == RANK_ALIGN_X ? dy : dx);
+    if (primary > search->bestPrimary || (primary == search->bestPrimary && secondary >= search->bestSecondary)) return;
+    if (IsExcluded(search, id)) return;
+
+    search->bestPrimary = primary;
+    search->bestSecondary = secondary;
+    search->bestId = id;
+    search->bestX = px;
+    search->bestY = py;
+}
+
+// Visits the grid rows and columns the search box overlaps in every class, then the moved points
+static bool RankedFind(RankedSearch *search, Vector2 *position)
+{
+    search->bestPrimary = INFINITY;
+    search->bestSecondary = INFINITY;
+    search->bestId = -1;
+
+    if (search->maxX >= _index.minX && search->minX <= _index.maxX && search->maxY >= _index.minY && search->minY <= _index.maxY)
+    {
+        int firstColumn = Column(search->minX);
+        int lastColumn = Column(search->maxX);
+        for (int pickClass = 0; pickClass < PICK_CLASS_COUNT; pickClass++)
+        {
+            const int *cells = _index.cellStart + pickClass * _index.grid * _index.grid;
+            for (int row = Row(search->minY); row <= Row(search->maxY); row++)
+            {
+                int end = cells[row * _index.grid + lastColumn + 1];
+                for (int slot = cells[row * _index.grid + firstColumn]; slot < end; slot++) Consider(search, _index.xs[slot], _index.ys[slot], _index.ids[slot]);
+            }
+        }
+    }
+    for (int k = 0; k < _movedCount; k++) Consider(search, _moved[k].x, _moved[k].y, _moved[k].id);
+
+    if (search->bestId < 0) return false;
+    *position = (Vector2){ search->bestX, search->bestY };
+    return true;
+}
+
+bool PickNearestExcluding(float x, float y, float radius, uint32_t layerMask, const PointRef *excluded, int excludedCount, PointRef *found, Vector2 *position)
+{
+    if (!EnsureIndex(layerMask)) return false;
+
+    RankedSearch search = { RANK_NEAREST, x, y, x - radius, y - radius, x + radius, y + radius, excluded, excludedCount };
+    if (!RankedFind(&search, position) || search.bestPrimary > radius * radius) return false;
+    *found = RefOf(search.bestId);
+    return true;
+}
+
+bool PickAligned(float x, float y, bool alignX, float tolerance, float range, uint32_t layerMask, const PointRef *excluded, int excludedCount, Vector2 *position)
+{
+    if (!EnsureIndex(layerMask)) return false;
+
+    float halfWidth = alignX ? tolerance : range;
+    float halfHeight = alignX ? range : tolerance;
+    RankedSearch search = { alignX ? RANK_ALIGN_X : RANK_ALIGN_Y, x, y, x - halfWidth, y - halfHeight, x + halfWidth, y + halfHeight, excluded, excludedCount };
+    return RankedFind(&search, position);
+}
+
+//------------------------------------------------------------------------------------
+// Updates
+//------------------------------------------------------------------------------------
+static void GetPosition(int id, float *x, float *y)
+{
+    int slot = _index.slots[id];
+    if (slot >= 0) { *x = _index.xs[slot]; *y = _index.ys[slot]; }
+    else if (slot != SLOT_NONE) { *x = _moved[SLOT_MOVED(0) - slot].x; *y = _moved[SLOT_MOVED(0) - slot].y; }
+    else { *x = NAN; *y = NAN; }
+}
+
+static void SetPosition(int id, float x, float y)
+{
+    int slot = _index.slots[id];
+    if (slot >= 0)
+    {
+        // Small moves usually stay in their cell and are written in place
+        if (InsideGrid(x, y) && Row(y) == Row(_index.ys[slot]) && Column(x) == Column(_index.xs[slot]))
+        {
+            _index.xs[slot] = x;
+            _index.ys[slot] = y;
+            return;
+        }
+        _index.xs[slot] = NAN;
+        _index.ys[slot] = NAN;
+    }
+    else if (slot != SLOT_NONE)
+    {
+        _moved[SLOT_MOVED(0) - slot].x = x;
+        _moved[SLOT_MOVED(0) - slot].y = y;
+        return;
+    }
+
+    if (_movedCount == PICK_MAX_MOVED)
+    {
+        _index.built = false;
+        return;
+    }
+    _moved[_movedCount] = (MovedPoint){ x, y, id, ClassOf(id) };
+    _index.slots[id] = SLOT_MOVED(_movedCount);
+    _movedCount++;
+}
+
+static bool IsMaxX(PointField field)
+{
+    return field == POINT_FIELD_MAX_MIN || field == POINT_FIELD_MAX_MAX;
+}
+
+static bool IsMaxY(PointField field)
+{
+    return field == POINT_FIELD_MIN_MAX || field == POINT_FIELD_MAX_MAX;
+}
+
+void PickingPointMoved(PointRef ref, float x, float y)
+{
+    if (!_index.built || ref.layer < 0 || ref.layer >= LAYER_COUNT || (_index.builtMask & (1u << ref.layer)) == 0) return;
+
+    // Points of elements added since the build come with the rebuild their structure version triggers
+    int fields = FieldCount(ref.layer);
+    int elements = (_index.layerBase[ref.layer + 1] - _index.layerBase[ref.layer]) / fields;
+    if (ref.index < 0 || ref.index >= elements || ref.field < FirstField(ref.layer) || ref.field >= FirstField(ref.layer) + fields) return;
+
+    if (ref.field < POINT_FIELD_MIN_MIN)
+    {
+        SetPosition(IdOf(ref), x, y);
+        return;
+    }
+
+    for (int corner = POINT_FIELD_MIN_MIN; corner <= POINT_FIELD_MAX_MAX && _index.built; corner++)
+    {
+        int id = IdOf((PointRef){ ref.layer, ref.index, (PointField)corner });
+        float cornerX, cornerY;
+        GetPosition(id, &cornerX, &cornerY);
+        if (IsMaxX((PointField)corner) == IsMaxX(ref.field)) cornerX = x;
+        if (IsMaxY((PointField)corner) == IsMaxY(ref.field)) cornerY = y;
+        SetPosition(id, cornerX, cornerY);
+    }
+}
+
+void PickingClear(void)
+{
+    MemFree(_index.xs);
+    MemFree(_index.ys);
+    MemFree(_index.ids);
+    MemFree(_index.cellStart);
+    MemFree(_index.slots);
+    _index = (PickIndex){ 0 };
+    _movedCount = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// One spatial index over every draggable point: structure locations, boost gate and portal
+// ends, and the corners of regions and world areas. Points are grouped by priority class and
+// bucketed into a uniform grid inside each class, so a pick reads only the cells around the
+// cursor. Coordinates are config coordinates (y up).
+
+/**
+ * @brief Finds the point under the cursor. The classes are tried in priority order, structures,
+ *        boost gates, portals, region corners, world area corners, and the nearest point of the
+ *        first class with one in reach wins, the same way for overlapping handles every frame.
+ * @param displayScale Screen pixels per world unit; the reach is 10 pixels, 15 for corners.
+ * @param layerMask Bit (1 << layer) set for each EditLayer that can be picked.
+ * @return false if no point is in reach.
+ */
+bool PickNearest(float x, float y, float displayScale, uint32_t layerMask, PointRef *picked);
+
+/**
+ * @brief Finds the point of any class nearest to (x, y) within radius world units, skipping the
+ *        points of the excluded elements, such as those being dragged.
+ * @param excluded Points whose whole element is skipped.
+ * @return false if no point is in reach.
+ */
+bool PickNearestExcluding(float x, float y, float radius, uint32_t layerMask, const PointRef *excluded, int excludedCount, PointRef *found, Vector2 *position);
+
+/**
+ * @brief Finds a point to line (x, y) up with: the one whose x (alignX) or y is closest to the
+ *        point's, at most tolerance away, and nearest along the other axis within range. Only the
+ *        grid cells of that strip are read.
+ * @return false if no point lies in the strip.
+ */
+bool PickAligned(float x, float y, bool alignX, float tolerance, float range, uint32_t layerMask, const PointRef *excluded, int excludedCount, Vector2 *position);
+
+/**
+ * @brief Updates the index after a point was written, without a rebuild. For a corner, the two
+ *        corners sharing its x or y move with it.
+ */
+void PickingPointMoved(PointRef ref, float x, float y);
+
+/**
+ * @brief Frees the index.
+ */
+void PickingClear(void);
+
+#endif // PICKING_H
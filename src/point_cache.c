@@ -0,0 +1,103 @@
+#include "point_cache.h"
+#include "changes.h"
+#include "picking.h"
+#include "memtrack.h"
+#include <math.h>
+
+#define POINT_SET_COUNT 3
+
+typedef struct {
+    PointSet set;
+    int capacity;
+    const cJSON *builtArray;
+    uint64_t builtVersion;
+    bool built;
+} CachedPointSet;
+
+static CachedPointSet _sets[POINT_SET_COUNT] = { 0 };
+
+// Layer and field the points of a set come from
+static PointRef SetSource(SelectableElementType type)
+{
+    return PointRefFromSelection((SelectedItem){ 0, type });
+}
+
+static bool Build(CachedPointSet *cached, SelectableElementType type)
+{
+    cJSON *array = GetLayerJSON(SetSource(type).layer);
+    PointField field = SetSource(type).field;
+    int count = cJSON_GetArraySize(array);
+    if (count > cached->capacity)
+    {
+        float *xs = MemRealloc(cached->set.xs, sizeof(float) * count);
+        if (xs != NULL) cached->set.xs = xs;
+        float *ys = MemRealloc(cached->set.ys, sizeof(float) * count);
+        if (ys != NULL) cached->set.ys = ys;
+        if (xs == NULL || ys == NULL) return false;
+        cached->capacity = count;
+    }
+
+    int i = 0;
+    cJSON *element = NULL;
+    cJSON_ArrayForEach(element, array)
+    {
+        // Through GetPointItemsJSON(), so quarantined elements are never drawn or picked
+        cJSON *x = NULL, *y = NULL;
+        bool found = GetPointItemsJSON(element, field, &x, &y);
+        cached->set.xs[i] = found ? (float)x->valuedouble : NAN;
+        cached->set.ys[i] = found ? (float)y->valuedouble : NAN;
+        i++;
+    }
+    cached->set.count = i;
+    return true;
+}
+
+const PointSet *GetPointSet(SelectableElementType type)
+{
+    static const PointSet empty = { 0 };
+    if (type < 0 || type >= POINT_SET_COUNT) return &empty;
+
+    CachedPointSet *cached = &_sets[type];
+    EditLayer layer = SetSource(type).layer;
+    const cJSON *array = GetLayerJSON(layer);
+    uint64_t version = ChangesGetStructureVersion(layer);
+    if (cached->built && cached->builtArray == array && cached->builtVersion == version) return &cached->set;
+
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    cached->set.count = 0;
+    cached->built = Build(cached, type);
+    if (!cached->built) cached->set.count = 0;
+    cached->builtArray = array;
+    cached->builtVersion = version;
+    MemPopSubsystem();
+    return &cached->set;
+}
+
+void PointCacheSet(PointRef ref, float x, float y)
+{
+    PickingPointMoved(ref, x, y);
+
+    SelectableElementType type = ELEMENT_TYPE_NONE;
+    for (int i = 0; i < POINT_SET_COUNT; i++)
+    {
+        PointRef source = SetSource((SelectableElementType)i);
+        if (source.layer == ref.layer && source.field == ref.field) type = (SelectableElementType)i;
+    }
+    if (type == ELEMENT_TYPE_NONE) return;
+
+    // A set that is not built, or is out of date, reads the new position when it is rebuilt
+    CachedPointSet *cached = &_sets[type];
+    if (!cached->built || ref.index < 0 || ref.index >= cached->set.count) return;
+    cached->set.xs[ref.index] = x;
+    cached->set.ys[ref.index] = y;
+}
+
+void PointCacheClear(void)
+{
+    for (int i = 0; i < POINT_SET_COUNT; i++)
+    {
+        MemFree(_sets[i].set.xs);
+        MemFree(_sets[i].set.ys);
+        _sets[i] = (CachedPointSet){ 0 };
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef POINT_CACHE_H
+#define POINT_CACHE_H
+
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Positions of the selectable points in contiguous arrays for the batch hit tests,
+// one set per SelectableElementType with the element index as array index. Y is in
+// config coordinates (up), missing points are NaN so they never hit.
+
+typedef struct {
+    int count;
+    float *xs;
+    float *ys;
+} PointSet;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the structure locations, or the a or b ends of the boost gates, rebuilding
+ *        them if elements were added or removed or the document was reloaded.
+ */
+const PointSet *GetPointSet(SelectableElementType type);
+
+/**
+ * @brief Updates a cached position after the point was written, so moves never rebuild a set.
+ *        Every point write goes through here, including the corners of bounds, and is passed
+ *        on to the picking index.
+ */
+void PointCacheSet(PointRef ref, float x, float y);
+
+/**
+ * @brief Frees all sets.
+ */
+void PointCacheClear(void);
+
+#endif // POINT_CACHE_H
@@ -0,0 +1,114 @@
+#include "pointer_map.h"
+#include "memtrack.h"
+
+#define INITIAL_CAPACITY 64
+
+//------------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------------
+static size_t HomeSlot(uint64_t key, size_t capacity)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key & (capacity - 1);
+}
+
+static bool Grow(PointerMap *map)
+{
+    size_t capacity = (map->capacity == 0) ? INITIAL_CAPACITY : map->capacity * 2;
+    uint64_t *keys = MemCalloc(capacity, sizeof(uint64_t));
+    int64_t *values = MemAlloc(capacity * sizeof(int64_t));
+    if (keys == NULL || values == NULL)
+    {
+        MemFree(keys);
+        MemFree(values);
+        return false;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        if (map->keys[i] == 0) continue;
+        size_t slot = HomeSlot(map->keys[i], capacity);
+        while (keys[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        keys[slot] = map->keys[i];
+        values[slot] = map->values[i];
+    }
+    MemFree(map->keys);
+    MemFree(map->values);
+    map->keys = keys;
+    map->values = values;
+    map->capacity = capacity;
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+bool PointerMapPut(PointerMap *map, uint64_t key, int64_t value)
+{
+    if ((map->count + 1) * 2 > map->capacity && !Grow(map)) return false;
+
+    size_t slot = HomeSlot(key, map->capacity);
+    while (map->keys[slot] != 0 && map->keys[slot] != key) slot = (slot + 1) & (map->capacity - 1);
+    if (map->keys[slot] == 0)
+    {
+        map->keys[slot] = key;
+        map->count++;
+    }
+    map->values[slot] = value;
+    return true;
+}
+
+int64_t *PointerMapFind(const PointerMap *map, uint64_t key)
+{
+    if (map->count == 0) return NULL;
+
+    size_t slot = HomeSlot(key, map->capacity);
+    while (map->keys[slot] != 0)
+    {
+        if (map->keys[slot] == key) return &map->values[slot];
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    return NULL;
+}
+
+int64_t PointerMapGet(const PointerMap *map, uint64_t key, int64_t missing)
+{
+    const int64_t *value = PointerMapFind(map, key);
+    return value ? *value : missing;
+}
+
+void PointerMapRemove(PointerMap *map, uint64_t key)
+{
+    if (map->count == 0) return;
+
+    size_t mask = map->capacity - 1;
+    size_t slot = HomeSlot(key, map->capacity);
+    while (map->keys[slot] != key)
+    {
+        if (map->keys[slot] == 0) return;
+        slot = (slot + 1) & mask;
+    }
+
+    // Move later entries of the same probe run back so lookups never stop at the hole
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; map->keys[next] != 0; next = (next + 1) & mask)
+    {
+        size_t home = HomeSlot(map->keys[next], map->capacity);
+        bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (!movable) continue;
+        map->keys[hole] = map->keys[next];
+        map->values[hole] = map->values[next];
+        hole = next;
+    }
+    map->keys[hole] = 0;
+    map->count--;
+}
+
+void PointerMapFree(PointerMap *map)
+{
+    MemFree(map->keys);
+    MemFree(map->values);
+    *map = (PointerMap){ 0 };
+}
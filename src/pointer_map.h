@@ -0,0 +1,60 @@
+#ifndef POINTER_MAP_H
+#define POINTER_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Open addressing hash map from pointers, or other non-zero 64-bit keys such as content
+// hashes, to 64-bit values. Keys are mixed and probed linearly in a power-of-two table that
+// is kept at most half full. Removal moves later entries of the probe run back, so lookups
+// never need tombstones.
+
+typedef struct {
+    uint64_t *keys;           // 0 marks an empty slot
+    int64_t *values;
+    size_t capacity;          // Power of two
+    size_t count;
+} PointerMap;
+
+static inline uint64_t PointerKey(const void *pointer)
+{
+    return (uint64_t)(uintptr_t)pointer;
+}
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Stores value for key, replacing the value it had.
+ * @param key Must not be 0.
+ * @return false if out of memory.
+ */
+bool PointerMapPut(PointerMap *map, uint64_t key, int64_t value);
+
+/**
+ * @brief Returns the value stored for key, or missing if it has none.
+ */
+int64_t PointerMapGet(const PointerMap *map, uint64_t key, int64_t missing);
+
+/**
+ * @brief Returns where the value of key is stored, to be changed in place, or NULL if it has
+ *        none. Valid until the next PointerMapPut().
+ */
+int64_t *PointerMapFind(const PointerMap *map, uint64_t key);
+
+/**
+ * @brief Removes key if it is in the map.
+ */
+void PointerMapRemove(PointerMap *map, uint64_t key);
+
+/**
+ * @brief Frees the table and empties the map.
+ */
+void PointerMapFree(PointerMap *map);
+
+#endif // POINTER_MAP_H
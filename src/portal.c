@@ -1,4 +1,7 @@
 #include "portal.h"
+#include "map_editor.h"
+#include "undo.h"
+#include "schema.h"
 #include <stdio.h>
 
 // Static helper function to add a new a-b point pair
@@ -25,36 +28,7 @@ void AddPortal(cJSON *portals, Vector2 cameraOffset, float displayScale)
     if (portals)
     {
         AddPairedPoint(portals, cameraOffset, displayScale);
-    }
-}
-
-// Public function to update portal positions
-void UpdatePortals(cJSON *portals, Vector2 cameraOffset, float *displayScale)
-{
-    if (!IsMouseButtonDown(MOUSE_LEFT_BUTTON) || !portals) return;
-    
-    Vector2 mouse = GetMousePosition();
-    Vector2 transformedMouse = {mouse.x - cameraOffset.x, mouse.y - cameraOffset.y};
-
-    cJSON *point_pair = NULL;
-    cJSON_ArrayForEach(point_pair, portals)
-    {
-        cJSON *a = cJSON_GetObjectItem(point_pair, "a");
-        cJSON *b = cJSON_GetObjectItem(point_pair, "b");
-
-        Vector2 a_vec = {(cJSON_GetArrayItem(a, 0)->valueint) * *displayScale, -(cJSON_GetArrayItem(a, 1)->valueint) * *displayScale};
-        Vector2 b_vec = {(cJSON_GetArrayItem(b, 0)->valueint) * *displayScale, -(cJSON_GetArrayItem(b, 1)->valueint) * *displayScale};
-
-        if (CheckCollisionPointCircle(transformedMouse, a_vec, 10.0f))
-        {
-            cJSON *new_a = cJSON_CreateIntArray((int[]){transformedMouse.x / *displayScale, -transformedMouse.y / *displayScale}, 2);
-            cJSON_ReplaceItemInObjectCaseSensitive(point_pair, "a", new_a);
-        }
-        else if (CheckCollisionPointCircle(transformedMouse, b_vec, 10.0f))
-        {
-            cJSON *new_b = cJSON_CreateIntArray((int[]){transformedMouse.x / *displayScale, -transformedMouse.y / *displayScale}, 2);
-            cJSON_ReplaceItemInObjectCaseSensitive(point_pair, "b", new_b);
-        }
+        UndoRecordAdd(LAYER_PORTALS, cJSON_GetArraySize(portals) - 1);
     }
 }
 
@@ -64,8 +38,11 @@ void DrawPortals(cJSON *portals, Vector2 cameraOffset, float *displayScale)
     if (!portals) return;
     
     cJSON *point_pair = NULL;
+    int portalIndex = 0;
     cJSON_ArrayForEach(point_pair, portals)
     {
+        if (SchemaIsQuarantined(point_pair)) { portalIndex++; continue; }
+
         cJSON *a = cJSON_GetObjectItem(point_pair, "a");
         cJSON *b = cJSON_GetObjectItem(point_pair, "b");
         
@@ -73,7 +50,9 @@ void DrawPortals(cJSON *portals, Vector2 cameraOffset, float *displayScale)
         Vector2 posB = {(cJSON_GetArrayItem(b, 0)->valueint) * *displayScale + cameraOffset.x, -(cJSON_GetArrayItem(b, 1)->valueint) * *displayScale + cameraOffset.y};
 
         DrawLineEx(posA, posB, 3, MAGENTA);
-        DrawCircleV(posA, 10, MAGENTA);
-        DrawCircleV(posB, 10, MAGENTA);
+        DrawCircleV(posA, 10, GetHandleColor((SelectedItem){ portalIndex, ELEMENT_TYPE_PORTAL_A }, MAGENTA));
+        DrawCircleV(posB, 10, GetHandleColor((SelectedItem){ portalIndex, ELEMENT_TYPE_PORTAL_B }, MAGENTA));
+
+        portalIndex++;
     }
 }
@@ -9,15 +9,7 @@
 //------------------------------------------------------------------------------------
 
 /**
- * @brief Updates the portal endpoint positions based on mouse input.
- * @param portals A cJSON array of portal location objects.
- * @param cameraOffset The current camera offset.
- * @param displayScale The current display scale (zoom).
- */
-void UpdatePortals(cJSON *portals, Vector2 cameraOffset, float *displayScale);
-
-/**
- * @brief Draws the portals on the screen as lines with endpoints.
+ * @brief Draws the portals on the screen as lines with endpoints, highlighting selected and hovered ends.
  * @param portals A cJSON array of portal location objects.
  * @param cameraOffset The current camera offset.
  * @param displayScale The current display scale (zoom).
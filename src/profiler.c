@@ -0,0 +1,212 @@
+#include "profiler.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+// Declared here instead of including windows.h, which clashes with raylib names
+__declspec(dllimport) int __stdcall QueryPerformanceCounter(long long *count);
+__declspec(dllimport) int __stdcall QueryPerformanceFrequency(long long *frequency);
+#else
+#include <time.h>
+#endif
+
+#define MAX_SCOPE_DEPTH 32
+#define MAX_SCOPE_NAMES 48
+
+typedef struct {
+    const char *name;
+    double start;
+} OpenScope;
+
+typedef struct {
+    const char *name;
+    double frameTime;     // Accumulated during the current frame (microseconds)
+    double lastFrameTime; // Total of the last finished frame (microseconds)
+} ScopeStats;
+
+typedef struct {
+    const char *name;
+    double start;
+    double duration;
+} TraceEvent;
+
+static OpenScope _openScopes[MAX_SCOPE_DEPTH];
+static int _openScopeCount = 0;
+
+static ScopeStats _scopeStats[MAX_SCOPE_NAMES];
+static int _scopeStatsCount = 0;
+static double _frameStart = 0.0;
+static double _lastFrameTime = 0.0;
+
+static bool _tracing = false;
+static int _traceFramesLeft = 0;
+static char _traceFilePath[1024] = { 0 };
+static TraceEvent *_traceEvents = NULL;
+static int _traceEventCount = 0;
+static int _traceEventCapacity = 0;
+
+// Monotonic time in microseconds
+static double Now(void)
+{
+#if defined(_WIN32)
+    static long long frequency = 0;
+    long long counter;
+    if (frequency == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter * 1000000.0 / (double)frequency;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#endif
+}
+
+static ScopeStats *FindScopeStats(const char *name)
+{
+    for (int i = 0; i < _scopeStatsCount; i++)
+    {
+        if (_scopeStats[i].name == name || strcmp(_scopeStats[i].name, name) == 0) return &_scopeStats[i];
+    }
+    if (_scopeStatsCount == MAX_SCOPE_NAMES) return NULL;
+
+    _scopeStats[_scopeStatsCount] = (ScopeStats){ name, 0.0, 0.0 };
+    return &_scopeStats[_scopeStatsCount++];
+}
+
+static void RecordTraceEvent(const char *name, double start, double duration)
+{
+    if (_traceEventCount == _traceEventCapacity)
+    {
+        int newCapacity = (_traceEventCapacity == 0) ? 4096 : _traceEventCapacity * 2;
+        TraceEvent *events = realloc(_traceEvents, newCapacity * sizeof(TraceEvent));
+        if (events == NULL) return;
+        _traceEvents = events;
+        _traceEventCapacity = newCapacity;
+    }
+    _traceEvents[_traceEventCount++] = (TraceEvent){ name, start, duration };
+}
+
+void ProfilerBeginFrame(void)
+{
+    for (int i = 0; i < _scopeStatsCount; i++) _scopeStats[i].frameTime = 0.0;
+    _frameStart = Now();
+}
+
+void ProfilerEndFrame(void)
+{
+    double end = Now();
+    _lastFrameTime = end - _frameStart;
+    for (int i = 0; i < _scopeStatsCount; i++) _scopeStats[i].lastFrameTime = _scopeStats[i].frameTime;
+
+    if (_tracing)
+    {
+        RecordTraceEvent("frame", _frameStart, _lastFrameTime);
+        if (--_traceFramesLeft <= 0) ProfilerStopTrace();
+    }
+}
+
+void ProfileBegin(const char *name)
+{
+    if (_openScopeCount == MAX_SCOPE_DEPTH) return;
+    _openScopes[_openScopeCount++] = (OpenScope){ name, Now() };
+}
+
+void ProfileEnd(void)
+{
+    if (_openScopeCount == 0) return;
+
+    OpenScope scope = _openScopes[--_openScopeCount];
+    double duration = Now() - scope.start;
+
+    ScopeStats *stats = FindScopeStats(scope.name);
+    if (stats) stats->frameTime += duration;
+    if (_tracing) RecordTraceEvent(scope.name, scope.start, duration);
+}
+
+void ProfilerStartTrace(const char *filePath, int frameCount)
+{
+    if (_tracing) return;
+
+    snprintf(_traceFilePath, sizeof(_traceFilePath), "%s", filePath);
+    _traceFramesLeft = (frameCount > 0) ? frameCount : 1;
+    _traceEventCount = 0;
+    _tracing = true;
+    printf("Trace capture started (%d frames).\n", _traceFramesLeft);
+}
+
+void ProfilerStopTrace(void)
+{
+    if (!_tracing) return;
+    _tracing = false;
+
+    // Chrome trace-event format: complete ("X") events with microsecond timestamps
+    cJSON *trace = cJSON_CreateObject();
+    cJSON *events = cJSON_AddArrayToObject(trace, "traceEvents");
+    double origin = (_traceEventCount > 0) ? _traceEvents[0].start : 0.0;
+    for (int i = 0; i < _traceEventCount; i++)
+    {
+        if (_traceEvents[i].start < origin) origin = _traceEvents[i].start;
+    }
+    for (int i = 0; i < _traceEventCount; i++)
+    {
+        cJSON *event = cJSON_CreateObject();
+        cJSON_AddStringToObject(event, "name", _traceEvents[i].name);
+        cJSON_AddStringToObject(event, "cat", "editor");
+        cJSON_AddStringToObject(event, "ph", "X");
+        cJSON_AddNumberToObject(event, "ts", _traceEvents[i].start - origin);
+        cJSON_AddNumberToObject(event, "dur", _traceEvents[i].duration);
+        cJSON_AddNumberToObject(event, "pid", 1);
+        cJSON_AddNumberToObject(event, "tid", 1);
+        cJSON_AddItemToArray(events, event);
+    }
+    cJSON_AddStringToObject(trace, "displayTimeUnit", "ms");
+
+    char *jsonString = cJSON_PrintUnformatted(trace);
+    cJSON_Delete(trace);
+    if (jsonString)
+    {
+        if (SaveFileText(_traceFilePath, jsonString)) printf("Trace with %d events written to %s\n", _traceEventCount, _traceFilePath);
+        else printf("ERROR: Failed to write trace file.\n");
+        cJSON_free(jsonString);
+    }
+    else printf("ERROR: Failed to generate trace JSON.\n");
+
+    free(_traceEvents);
+    _traceEvents = NULL;
+    _traceEventCount = 0;
+    _traceEventCapacity = 0;
+}
+
+bool ProfilerIsTracing(void)
+{
+    return _tracing;
+}
+
+double ProfilerGetScopeTime(const char *name)
+{
+    for (int i = 0; i < _scopeStatsCount; i++)
+    {
+        if (_scopeStats[i].name == name || strcmp(_scopeStats[i].name, name) == 0) return _scopeStats[i].lastFrameTime / 1000.0;
+    }
+    return 0.0;
+}
+
+double ProfilerGetTime(void)
+{
+    return Now() / 1000.0;
+}
+
+int DrawProfilerOverlay(int x, int y)
+{
+    int height = 40 + _scopeStatsCount * 20;
+    DrawRectangle(x, y, 260, height, Fade(LIGHTGRAY, 0.8f));
+    DrawText(TextFormat("Frame: %.2f ms%s", _lastFrameTime / 1000.0, _tracing ? "  [TRACING]" : ""), x + 10, y + 10, 20, _tracing ? RED : DARKGRAY);
+
+    for (int i = 0; i < _scopeStatsCount; i++)
+    {
+        DrawText(TextFormat("%-14s %7.3f ms", _scopeStats[i].name, _scopeStats[i].lastFrameTime / 1000.0), x + 10, y + 35 + i * 20, 15, DARKGRAY);
+    }
+    return height;
+}
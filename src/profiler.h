@@ -0,0 +1,67 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "raylib.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Marks the start of a frame. Resets the per-frame scope totals shown in the overlay.
+ */
+void ProfilerBeginFrame(void);
+
+/**
+ * @brief Marks the end of a frame and finishes a trace capture once its frame budget is used up.
+ */
+void ProfilerEndFrame(void);
+
+/**
+ * @brief Opens a named timing scope. Scopes nest and must be closed with ProfileEnd().
+ * @param name A string literal naming the scope (the pointer is kept, not copied).
+ */
+void ProfileBegin(const char *name);
+
+/**
+ * @brief Closes the innermost open timing scope.
+ */
+void ProfileEnd(void);
+
+/**
+ * @brief Starts recording every scope into a Chrome trace-event JSON file.
+ * @param filePath Where the trace is written when the capture finishes.
+ * @param frameCount Number of frames to record. Scopes outside frames (e.g. the initial load) are recorded too.
+ */
+void ProfilerStartTrace(const char *filePath, int frameCount);
+
+/**
+ * @brief Writes the trace recorded so far and stops capturing.
+ */
+void ProfilerStopTrace(void);
+
+/**
+ * @brief Returns true while a trace capture is running.
+ */
+bool ProfilerIsTracing(void);
+
+/**
+ * @brief Returns the time in milliseconds spent in a scope during the last finished frame.
+ * @param name The scope name as passed to ProfileBegin().
+ */
+double ProfilerGetScopeTime(const char *name);
+
+/**
+ * @brief Returns a monotonic timestamp in milliseconds. Usable before the window exists.
+ */
+double ProfilerGetTime(void);
+
+/**
+ * @brief Draws the per-scope timings of the last frame in a small panel.
+ * @param x Left edge of the panel in screen pixels.
+ * @param y Top edge of the panel in screen pixels.
+ * @return The height of the panel, so further panels can be stacked below it.
+ */
+int DrawProfilerOverlay(int x, int y);
+
+#endif // PROFILER_H
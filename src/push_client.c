@@ -0,0 +1,197 @@
+#include "push_client.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#define READ_CHUNK (64 * 1024)
+
+struct PushClient {
+    int fd;
+    unsigned char *data;        // Received bytes not handled yet, from the start of a message
+    size_t length;
+    size_t capacity;            // Always more than length, for the NUL after JSON text
+};
+
+const char *PushFieldName(PushField field)
+{
+    switch (field)
+    {
+        case PUSH_FIELD_LOCATION: return "location";
+        case PUSH_FIELD_A: return "a";
+        case PUSH_FIELD_B: return "b";
+        case PUSH_FIELD_BOUNDS_MIN: return "bounds.min";
+        case PUSH_FIELD_BOUNDS_MAX: return "bounds.max";
+        default: return "?";
+    }
+}
+
+#if defined(_WIN32)
+
+PushClient *PushClientConnect(const char *socketPath) { (void)socketPath; return NULL; }
+int PushClientPoll(PushClient *client, int timeoutMs, PushHandler handler, void *user) { (void)client; (void)timeoutMs; (void)handler; (void)user; return -1; }
+void PushClientClose(PushClient *client) { (void)client; }
+uint64_t PushClientNow(void) { return 0; }
+
+#else
+
+uint64_t PushClientNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+PushClient *PushClientConnect(const char *socketPath)
+{
+    struct sockaddr_un address = { 0 };
+    if (strlen(socketPath) >= sizeof(address.sun_path)) return NULL;
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return NULL;
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    PushClient *client = (PushClient *)calloc(1, sizeof(PushClient));
+    if (client != NULL) client->data = (unsigned char *)malloc(READ_CHUNK + 1);
+    if (client == NULL || client->data == NULL)
+    {
+        free(client);
+        close(fd);
+        return NULL;
+    }
+    client->fd = fd;
+    client->capacity = READ_CHUNK + 1;
+    return client;
+}
+
+void PushClientClose(PushClient *client)
+{
+    if (client == NULL) return;
+    close(client->fd);
+    free(client->data);
+    free(client);
+}
+
+// Decodes one complete message and hands it to the handler; false if it is malformed
+static bool HandleMessage(unsigned char *bytes, uint32_t size, PushHandler handler, void *user)
+{
+    PushMessage message = { 0 };
+    message.type = (PushMessageType)bytes[4];
+    message.layer = (PushLayer)bytes[5];
+    message.sentNs = PushGetU64(bytes + 8);
+    if (message.layer >= PUSH_LAYER_COUNT) return false;
+
+    const unsigned char *payload = bytes + PUSH_HEADER_SIZE;
+    switch (message.type)
+    {
+        case PUSH_MESSAGE_HELLO:
+            if (size < PUSH_HEADER_SIZE + 4 || PushGetU32(payload) != PUSH_PROTOCOL_VERSION) return false;
+            break;
+        case PUSH_MESSAGE_POINT:
+            if (size != PUSH_POINT_SIZE) return false;
+            message.index = PushGetU32(payload);
+            message.field = (PushField)PushGetU16(payload + 4);
+            message.x = PushGetF64(payload + 8);
+            message.y = PushGetF64(payload + 16);
+            if (message.field >= PUSH_FIELD_COUNT) return false;
+            break;
+        case PUSH_MESSAGE_ELEMENT:
+            if (size < PUSH_ELEMENT_MIN_SIZE) return false;
+            message.index = PushGetU32(payload);
+            message.json = (const char *)payload + 4;
+            message.jsonLength = size - PUSH_ELEMENT_MIN_SIZE;
+            break;
+        case PUSH_MESSAGE_LAYER:
+            message.json = (const char *)payload;
+            message.jsonLength = size - PUSH_HEADER_SIZE;
+            break;
+        case PUSH_MESSAGE_FRAME:
+            break;
+        default:
+            return false;
+    }
+
+    // JSON text is terminated in place for the handler, over the first byte of the next message
+    unsigned char saved = bytes[size];
+    bytes[size] = '\0';
+    handler(&message, user);
+    bytes[size] = saved;
+    return true;
+}
+
+// Handles every complete message in the buffer and moves the rest to its start
+static int HandleReceived(PushClient *client, PushHandler handler, void *user)
+{
+    int handled = 0;
+    size_t offset = 0;
+    while (client->length - offset >= PUSH_HEADER_SIZE)
+    {
+        uint32_t size = PushGetU32(client->data + offset);
+        if (size < PUSH_HEADER_SIZE || size > PUSH_MAX_MESSAGE_SIZE) return -1;
+        if (client->length - offset < size)
+        {
+            // Make room for the whole message now, so the next reads can complete it
+            if (size + 1 > client->capacity)
+            {
+                unsigned char *data = (unsigned char *)realloc(client->data, (size_t)size + 1);
+                if (data == NULL) return -1;
+                client->data = data;
+                client->capacity = (size_t)size + 1;
+            }
+            break;
+        }
+        if (!HandleMessage(client->data + offset, size, handler, user)) return -1;
+        offset += size;
+        handled++;
+    }
+
+    memmove(client->data, client->data + offset, client->length - offset);
+    client->length -= offset;
+    return handled;
+}
+
+int PushClientPoll(PushClient *client, int timeoutMs, PushHandler handler, void *user)
+{
+    if (client == NULL) return -1;
+    if (timeoutMs > 0)
+    {
+        struct pollfd wait = { client->fd, POLLIN, 0 };
+        poll(&wait, 1, timeoutMs);
+    }
+
+    int handled = 0;
+    for (;;)
+    {
+        ssize_t count = recv(client->fd, client->data + client->length, client->capacity - 1 - client->length, 0);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0)
+        {
+            HandleReceived(client, handler, user);
+            return -1;
+        }
+
+        client->length += (size_t)count;
+        int result = HandleReceived(client, handler, user);
+        if (result < 0) return -1;
+        handled += result;
+    }
+    return handled;
+}
+
+#endif
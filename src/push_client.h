@@ -0,0 +1,66 @@
+#ifndef PUSH_CLIENT_H
+#define PUSH_CLIENT_H
+
+#include "push_protocol.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Reference receiver for the edits an editor started with --push sends. It has no
+// dependencies besides the C library, so a game can compile push_client.c and
+// push_protocol.h into its own build, call PushClientPoll() once per frame and apply
+// the messages to its world: POINT moves one point of one element, ELEMENT and LAYER
+// carry JSON for the game's own config loader.
+
+typedef struct PushClient PushClient;
+
+typedef struct {
+    PushMessageType type;
+    PushLayer layer;
+    uint32_t index;             // ELEMENT and POINT
+    PushField field;            // POINT
+    double x;                   // POINT
+    double y;
+    const char *json;           // LAYER and ELEMENT, NUL terminated, valid until the handler returns
+    size_t jsonLength;
+    uint64_t sentNs;            // Compare with PushClientNow() for the latency
+} PushMessage;
+
+typedef void (*PushHandler)(const PushMessage *message, void *user);
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Connects to an editor's push socket.
+ * @return The connection, or NULL if no editor listens on the path.
+ */
+PushClient *PushClientConnect(const char *socketPath);
+
+/**
+ * @brief Reads what has arrived and calls the handler for each complete message, in order.
+ * @param timeoutMs How long to wait for the first bytes, 0 to return at once.
+ * @return The number of messages handled, or -1 once the editor closed the connection
+ *         or sent something that is not a message.
+ */
+int PushClientPoll(PushClient *client, int timeoutMs, PushHandler handler, void *user);
+
+/**
+ * @brief Closes the connection and frees the client.
+ */
+void PushClientClose(PushClient *client);
+
+/**
+ * @brief Returns the clock the editor stamps messages with, in nanoseconds.
+ */
+uint64_t PushClientNow(void);
+
+/**
+ * @brief Returns the config key of a field, such as "location" or "bounds.min".
+ */
+const char *PushFieldName(PushField field);
+
+#endif // PUSH_CLIENT_H
@@ -0,0 +1,80 @@
+#ifndef PUSH_PROTOCOL_H
+#define PUSH_PROTOCOL_H
+
+#include <stdint.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------------
+// Wire format
+//------------------------------------------------------------------------------------
+// Edits the editor pushes to a running game over a Unix domain stream socket. The editor
+// listens, the game connects. Everything is little endian. Each message starts with a header:
+//
+//   uint32 size        Whole message in bytes, header included
+//   uint8  type        PushMessageType
+//   uint8  layer       PushLayer, 0 where it does not apply
+//   uint16 reserved
+//   uint64 sentNs      CLOCK_MONOTONIC time the editor sent it, for measuring latency
+//
+// followed by the payload of its type:
+//
+//   HELLO      uint32 protocol version
+//   LAYER      JSON text of the whole layer: an array, or the object of a world area
+//   ELEMENT    uint32 index, JSON text of the element (the object itself for a world area)
+//   POINT      uint32 index, uint16 field, uint16 reserved, float64 x, float64 y
+//   FRAME      nothing
+//
+// A new connection gets HELLO, every layer and a FRAME. After that each editor frame that
+// changed something sends its deltas followed by a FRAME, so a game can apply a frame at once.
+// A LAYER replaces everything received for it before; indices count from 0 in its array.
+
+#define PUSH_PROTOCOL_VERSION 1
+#define PUSH_HEADER_SIZE 16
+#define PUSH_POINT_SIZE (PUSH_HEADER_SIZE + 24)
+#define PUSH_ELEMENT_MIN_SIZE (PUSH_HEADER_SIZE + 4)
+#define PUSH_MAX_MESSAGE_SIZE 0x40000000u       // 1 GB, larger sizes mean a broken stream
+
+typedef enum {
+    PUSH_MESSAGE_HELLO = 1,
+    PUSH_MESSAGE_LAYER,
+    PUSH_MESSAGE_ELEMENT,
+    PUSH_MESSAGE_POINT,
+    PUSH_MESSAGE_FRAME
+} PushMessageType;
+
+// Same order as the editor's layers
+typedef enum {
+    PUSH_LAYER_STRUCTURES = 0,
+    PUSH_LAYER_BOOST_GATES,
+    PUSH_LAYER_PORTALS,
+    PUSH_LAYER_SNOW_REGIONS,
+    PUSH_LAYER_RAIN_REGIONS,
+    PUSH_LAYER_STAR_REGIONS,
+    PUSH_LAYER_OCEAN_WORLD_AREA,
+    PUSH_LAYER_SPACE_WORLD_AREA,
+    PUSH_LAYER_COUNT
+} PushLayer;
+
+typedef enum {
+    PUSH_FIELD_LOCATION = 0,    // "location" of a structure
+    PUSH_FIELD_A,               // "a" of a boost gate or portal
+    PUSH_FIELD_B,               // "b" of a boost gate or portal
+    PUSH_FIELD_BOUNDS_MIN,      // "bounds.min" of a region or world area
+    PUSH_FIELD_BOUNDS_MAX,      // "bounds.max" of a region or world area
+    PUSH_FIELD_COUNT
+} PushField;
+
+//------------------------------------------------------------------------------------
+// Little endian helpers
+//------------------------------------------------------------------------------------
+static inline void PushPutU16(unsigned char *p, uint16_t v) { p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8); }
+static inline void PushPutU32(unsigned char *p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i)); }
+static inline void PushPutU64(unsigned char *p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i)); }
+static inline void PushPutF64(unsigned char *p, double v) { uint64_t bits; memcpy(&bits, &v, 8); PushPutU64(p, bits); }
+
+static inline uint16_t PushGetU16(const unsigned char *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t PushGetU32(const unsigned char *p) { uint32_t v = 0; for (int i = 3; i >= 0; i--) v = (v << 8) | p[i]; return v; }
+static inline uint64_t PushGetU64(const unsigned char *p) { uint64_t v = 0; for (int i = 7; i >= 0; i--) v = (v << 8) | p[i]; return v; }
+static inline double PushGetF64(const unsigned char *p) { uint64_t bits = PushGetU64(p); double v; memcpy(&v, &bits, 8); return v; }
+
+#endif // PUSH_PROTOCOL_H
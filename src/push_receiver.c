@@ -0,0 +1,198 @@
+// Stand-in for a game receiving edits from an editor started with --push <socket>. It keeps the
+// pushed points the way a game would and prints, once a second, how many deltas arrived and how
+// long they took from the editor's send to being applied here.
+//
+// Usage: push_receiver <socket> [--seconds <n>]
+//
+// Build with: make push_receiver
+
+#include "push_client.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SAMPLES (1 << 20)   // Latencies kept per report, later ones in the same second are dropped
+
+typedef struct {
+    double x;
+    double y;
+} PushedPoint;
+
+typedef struct {
+    PushedPoint *points;        // PUSH_FIELD_COUNT points per element
+    uint32_t count;             // Elements with room in points
+} PushedLayer;
+
+typedef struct {
+    uint64_t deltas;            // POINT and ELEMENT messages
+    uint64_t layers;
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t *latencies;        // Nanoseconds, one per delta
+    int sampleCount;
+    uint64_t maxLatency;
+} ReceiveStats;
+
+static PushedLayer _layers[PUSH_LAYER_COUNT] = { 0 };
+static ReceiveStats _second = { 0 };
+static ReceiveStats _total = { 0 };
+static volatile sig_atomic_t _stop = 0;
+
+static void OnSignal(int signal)
+{
+    (void)signal;
+    _stop = 1;
+}
+
+static void Record(ReceiveStats *stats, uint64_t latency, size_t bytes, bool delta)
+{
+    stats->bytes += bytes;
+    if (!delta) return;
+    stats->deltas++;
+    if (latency > stats->maxLatency) stats->maxLatency = latency;
+    if (stats->latencies != NULL && stats->sampleCount < MAX_SAMPLES) stats->latencies[stats->sampleCount++] = latency;
+}
+
+// Applies a point the way a game would: straight into its element's slot
+static void ApplyPoint(const PushMessage *message)
+{
+    PushedLayer *layer = &_layers[message->layer];
+    if (message->index >= layer->count)
+    {
+        uint32_t count = layer->count ? layer->count : 1024;
+        while (count <= message->index) count *= 2;
+        PushedPoint *points = (PushedPoint *)realloc(layer->points, (size_t)count * PUSH_FIELD_COUNT * sizeof(PushedPoint));
+        if (points == NULL) return;
+        memset(points + (size_t)layer->count * PUSH_FIELD_COUNT, 0, (size_t)(count - layer->count) * PUSH_FIELD_COUNT * sizeof(PushedPoint));
+        layer->points = points;
+        layer->count = count;
+    }
+    layer->points[(size_t)message->index * PUSH_FIELD_COUNT + message->field] = (PushedPoint){ message->x, message->y };
+}
+
+static void HandleMessage(const PushMessage *message, void *user)
+{
+    (void)user;
+    uint64_t latency = PushClientNow() - message->sentNs;
+    size_t bytes = PUSH_HEADER_SIZE;
+
+    switch (message->type)
+    {
+        case PUSH_MESSAGE_POINT:
+            ApplyPoint(message);
+            bytes = PUSH_POINT_SIZE;
+            break;
+        case PUSH_MESSAGE_ELEMENT:
+            bytes = PUSH_ELEMENT_MIN_SIZE + message->jsonLength;
+            break;
+        case PUSH_MESSAGE_LAYER:
+            // A game would load the layer from the JSON; here the points start over
+            _layers[message->layer].count = 0;
+            free(_layers[message->layer].points);
+            _layers[message->layer].points = NULL;
+            bytes += message->jsonLength;
+            _second.layers++;
+            _total.layers++;
+            break;
+        case PUSH_MESSAGE_FRAME:
+            _second.frames++;
+            _total.frames++;
+            break;
+        default:
+            break;
+    }
+
+    bool delta = message->type == PUSH_MESSAGE_POINT || message->type == PUSH_MESSAGE_ELEMENT;
+    Record(&_second, latency, bytes, delta);
+    Record(&_total, latency, bytes, delta);
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void PrintStats(const char *label, ReceiveStats *stats, double seconds)
+{
+    if (seconds <= 0.0) seconds = 1.0;
+    printf("%s: %.0f deltas/s, %.0f frames/s, %llu layers, %.2f MB/s", label, stats->deltas / seconds, stats->frames / seconds,
+           (unsigned long long)stats->layers, stats->bytes / seconds / (1024.0 * 1024.0));
+    if (stats->sampleCount > 0)
+    {
+        qsort(stats->latencies, (size_t)stats->sampleCount, sizeof(uint64_t), CompareLatency);
+        double p50 = stats->latencies[stats->sampleCount / 2] / 1e6;
+        double p99 = stats->latencies[(int)((stats->sampleCount - 1) * 0.99)] / 1e6;
+        printf(", latency p50 %.3f ms, p99 %.3f ms, max %.3f ms", p50, p99, stats->maxLatency / 1e6);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *socketPath = NULL;
+    double seconds = 0.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (argv[i][0] != '-') socketPath = argv[i];
+    }
+    if (socketPath == NULL)
+    {
+        printf("Usage: push_receiver <socket> [--seconds <n>]\n");
+        return 1;
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+#if defined(_WIN32)
+    printf("The editor pushes edits over Unix domain sockets, which this build does not use.\n");
+    return 1;
+#endif
+
+    // Wait for the editor, which may not have started listening yet
+    PushClient *client = NULL;
+    while (!_stop && (client = PushClientConnect(socketPath)) == NULL)
+    {
+        struct timespec wait = { 0, 200000000 };
+        nanosleep(&wait, NULL);
+    }
+    if (client == NULL) return 1;
+    printf("Connected to %s\n", socketPath);
+
+    _second.latencies = (uint64_t *)malloc(MAX_SAMPLES * sizeof(uint64_t));
+    _total.latencies = (uint64_t *)malloc(MAX_SAMPLES * sizeof(uint64_t));
+    uint64_t start = PushClientNow();
+    uint64_t reportedAt = start;
+
+    while (!_stop)
+    {
+        if (PushClientPoll(client, 100, HandleMessage, NULL) < 0)
+        {
+            printf("Editor closed the connection\n");
+            break;
+        }
+
+        uint64_t now = PushClientNow();
+        if (now - reportedAt >= 1000000000u)
+        {
+            PrintStats("last second", &_second, (now - reportedAt) / 1e9);
+            uint64_t *latencies = _second.latencies;
+            _second = (ReceiveStats){ 0 };
+            _second.latencies = latencies;
+            reportedAt = now;
+        }
+        if (seconds > 0.0 && (now - start) / 1e9 >= seconds) break;
+    }
+
+    PrintStats("total", &_total, (PushClientNow() - start) / 1e9);
+    PushClientClose(client);
+    free(_second.latencies);
+    free(_total.latencies);
+    for (int i = 0; i < PUSH_LAYER_COUNT; i++) free(_layers[i].points);
+    return 0;
+}
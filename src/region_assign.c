@@ -0,0 +1,265 @@
+#include "region_assign.h"
+#include "changes.h"
+#include "edit_ops.h"
+#include "memtrack.h"
+#include "point_cache.h"
+#include "profiler.h"
+#include "structure_cache.h"
+#include "undo.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define NOT_PROPOSED INT_MIN        // The structure is not part of the preview
+
+typedef struct {
+    float x;
+    float y;
+    int id;
+} Seed;
+
+// Seeds in k-d tree order: the middle of each range splits it, on x at even depths and y at odd ones
+static Seed *_seeds = NULL;
+static int _seedCount = 0;
+static bool _seeded = false;
+static uint64_t _seededVersion = 0;
+static const cJSON *_seededStructures = NULL;
+static const cJSON *_seededRegions = NULL;
+
+static int *_proposed = NULL;       // Proposed region id per structure
+static int _proposedCount = 0;
+static int _changeCount = 0;
+static bool _previewing = false;
+static uint64_t _previewVersion = 0;
+static const cJSON *_previewStructures = NULL;
+static const cJSON *_previewRegions = NULL;
+
+//------------------------------------------------------------------------------------
+// Seeds
+//------------------------------------------------------------------------------------
+static int CompareX(const void *a, const void *b)
+{
+    float x = ((const Seed *)a)->x;
+    float y = ((const Seed *)b)->x;
+    return (x > y) - (x < y);
+}
+
+static int CompareY(const void *a, const void *b)
+{
+    float x = ((const Seed *)a)->y;
+    float y = ((const Seed *)b)->y;
+    return (x > y) - (x < y);
+}
+
+static void BuildTree(Seed *seeds, int count, int depth)
+{
+    if (count <= 1) return;
+    qsort(seeds, (size_t)count, sizeof(Seed), (depth % 2 == 0) ? CompareX : CompareY);
+    int middle = count / 2;
+    BuildTree(seeds, middle, depth + 1);
+    BuildTree(seeds + middle + 1, count - middle - 1, depth + 1);
+}
+
+// Visits the side of each split the point is on first; the other side only if the split line
+// is closer than the best seed so far. Equal distances go to the lower region id.
+static void SearchTree(const Seed *seeds, int count, int depth, float x, float y, int *best, double *bestDistance)
+{
+    if (count <= 0) return;
+    int middle = count / 2;
+    const Seed *seed = &seeds[middle];
+    double dx = (double)x - seed->x;
+    double dy = (double)y - seed->y;
+    double distance = dx * dx + dy * dy;
+    if (distance < *bestDistance || (distance == *bestDistance && seed->id < *best))
+    {
+        *best = seed->id;
+        *bestDistance = distance;
+    }
+
+    double split = (depth % 2 == 0) ? dx : dy;
+    const Seed *near = (split < 0) ? seeds : seed + 1;
+    const Seed *far = (split < 0) ? seed + 1 : seeds;
+    int nearCount = (split < 0) ? middle : count - middle - 1;
+    int farCount = (split < 0) ? count - middle - 1 : middle;
+    SearchTree(near, nearCount, depth + 1, x, y, best, bestDistance);
+    if (split * split <= *bestDistance) SearchTree(far, farCount, depth + 1, x, y, best, bestDistance);
+}
+
+static int Nearest(float x, float y)
+{
+    int best = -1;
+    double bestDistance = INFINITY;
+    SearchTree(_seeds, _seedCount, 0, x, y, &best, &bestDistance);
+    return best;
+}
+
+// Seeds are read again after any edit, as a centre moves with the structures of its region
+static bool UpdateSeeds(void)
+{
+    if (_seeded && _seededVersion == ChangesGetVersion() && _seededStructures == _structures && _seededRegions == _regions) return _seedCount > 0;
+
+    ProfileBegin("region seeds");
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    MemFree(_seeds);
+    _seeds = NULL;
+    _seedCount = 0;
+
+    int regionCount = cJSON_GetArraySize(_regions);
+    _seeds = (Seed *)MemAlloc((size_t)(regionCount > 0 ? regionCount : 1) * sizeof(Seed));
+    double *sums = (double *)MemCalloc((size_t)(regionCount > 0 ? regionCount : 1) * 3, sizeof(double));
+    if (_seeds != NULL && sums != NULL)
+    {
+        // Centres of the structures already in each region, for regions without a location
+        const StructureCache *cache = GetStructureCache();
+        const PointSet *points = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+        int count = (points->count < cache->count) ? points->count : cache->count;
+        for (int i = 0; i < count; i++)
+        {
+            int id = cache->regions[i] - 1;
+            if (id < 0 || id >= regionCount || isnan(points->xs[i]) || isnan(points->ys[i])) continue;
+            sums[id * 3] += points->xs[i];
+            sums[id * 3 + 1] += points->ys[i];
+            sums[id * 3 + 2] += 1.0;
+        }
+
+        int id = 0;
+        cJSON *region = NULL;
+        cJSON_ArrayForEach(region, _regions)
+        {
+            cJSON *location = cJSON_GetObjectItem(region, "location");
+            if (cJSON_IsArray(location) && cJSON_IsNumber(cJSON_GetArrayItem(location, 0)) && cJSON_IsNumber(cJSON_GetArrayItem(location, 1)))
+            {
+                _seeds[_seedCount++] = (Seed){ (float)location->child->valuedouble, (float)location->child->next->valuedouble, id };
+            }
+            else if (sums[id * 3 + 2] > 0.0)
+            {
+                _seeds[_seedCount++] = (Seed){ (float)(sums[id * 3] / sums[id * 3 + 2]), (float)(sums[id * 3 + 1] / sums[id * 3 + 2]), id };
+            }
+            id++;
+        }
+        BuildTree(_seeds, _seedCount, 0);
+    }
+    MemFree(sums);
+
+    _seeded = true;
+    _seededVersion = ChangesGetVersion();
+    _seededStructures = _structures;
+    _seededRegions = _regions;
+    MemPopSubsystem();
+    ProfileEnd();
+    return _seedCount > 0;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+bool RegionAssignPreview(const int *structures, int count)
+{
+    RegionAssignCancel();
+    if (!UpdateSeeds()) return false;
+
+    ProfileBegin("region assign");
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    const StructureCache *cache = GetStructureCache();
+    const PointSet *points = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+    int total = (points->count < cache->count) ? points->count : cache->count;
+
+    _proposed = (int *)MemAlloc((size_t)(total > 0 ? total : 1) * sizeof(int));
+    if (_proposed == NULL)
+    {
+        MemPopSubsystem();
+        ProfileEnd();
+        return false;
+    }
+    _proposedCount = total;
+    for (int i = 0; i < total; i++) _proposed[i] = NOT_PROPOSED;
+
+    int assigned = (structures != NULL) ? count : total;
+    for (int s = 0; s < assigned; s++)
+    {
+        int i = (structures != NULL) ? structures[s] : s;
+        if (i < 0 || i >= total || isnan(points->xs[i]) || isnan(points->ys[i])) continue;
+        _proposed[i] = Nearest(points->xs[i], points->ys[i]);
+        if (_proposed[i] != cache->regions[i] - 1) _changeCount++;
+    }
+
+    _previewing = true;
+    _previewVersion = ChangesGetVersion();
+    _previewStructures = _structures;
+    _previewRegions = _regions;
+    MemPopSubsystem();
+    ProfileEnd();
+    return true;
+}
+
+bool RegionAssignIsPreviewing(void)
+{
+    if (_previewing && (_previewVersion != ChangesGetVersion() || _previewStructures != _structures || _previewRegions != _regions)) RegionAssignCancel();
+    return _previewing;
+}
+
+int RegionAssignPreviewRegion(int structure, int currentRegion)
+{
+    if (!RegionAssignIsPreviewing() || structure < 0 || structure >= _proposedCount || _proposed[structure] == NOT_PROPOSED) return currentRegion;
+    return _proposed[structure] + 1;
+}
+
+int RegionAssignChangeCount(void)
+{
+    return RegionAssignIsPreviewing() ? _changeCount : 0;
+}
+
+int RegionAssignApply(void)
+{
+    if (!RegionAssignIsPreviewing() || _changeCount == 0)
+    {
+        RegionAssignCancel();
+        return 0;
+    }
+
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    const StructureCache *cache = GetStructureCache();
+    int *indices = (int *)MemAlloc((size_t)_changeCount * 2 * sizeof(int));
+    cJSON **oldItems = (cJSON **)MemAlloc((size_t)_changeCount * sizeof(cJSON *));
+    int changed = 0;
+    if (indices != NULL && oldItems != NULL)
+    {
+        int *newIds = indices + _changeCount;
+        for (int i = 0; i < _proposedCount && changed < _changeCount; i++)
+        {
+            if (_proposed[i] == NOT_PROPOSED || _proposed[i] == cache->regions[i] - 1) continue;
+            indices[changed] = i;
+            newIds[changed++] = _proposed[i];
+        }
+        EditSetRegionIds(indices, newIds, changed, oldItems);
+        UndoRecordRegionIds(indices, oldItems, newIds, changed);
+    }
+    MemFree(indices);
+    MemFree(oldItems);
+    MemPopSubsystem();
+    RegionAssignCancel();
+    return changed;
+}
+
+void RegionAssignCancel(void)
+{
+    MemFree(_proposed);
+    _proposed = NULL;
+    _proposedCount = 0;
+    _changeCount = 0;
+    _previewing = false;
+}
+
+int RegionAssignNearest(float x, float y)
+{
+    return UpdateSeeds() ? Nearest(x, y) : -1;
+}
+
+void RegionAssignClear(void)
+{
+    RegionAssignCancel();
+    MemFree(_seeds);
+    _seeds = NULL;
+    _seedCount = 0;
+    _seeded = false;
+}
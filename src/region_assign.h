@@ -0,0 +1,60 @@
+#ifndef REGION_ASSIGN_H
+#define REGION_ASSIGN_H
+
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Assigns region_id by the nearest region seed. A region's seed is its "location" when it has
+// one, else the centre of the structures that already belong to it. The seeds are kept in a
+// k-d tree, so each structure costs one descent plus the few branches its nearest seed could
+// still be in, and millions of structures are assigned in a fraction of a second. The
+// assignment is previewed with the region colors first and only written when applied.
+
+/**
+ * @brief Works out the nearest region of every structure, or of the given ones, and starts
+ *        showing it in place of their current region. Replaces an earlier preview.
+ * @param structures Structure indices, or NULL for all structures.
+ * @return false if no region has a seed.
+ */
+bool RegionAssignPreview(const int *structures, int count);
+
+/**
+ * @brief Whether a preview is shown. Any edit to the document ends it, as the proposal would be stale.
+ */
+bool RegionAssignIsPreviewing(void);
+
+/**
+ * @brief Returns the structure cache region (region id + 1) to draw a structure with: the
+ *        proposed one while previewing, otherwise currentRegion.
+ */
+int RegionAssignPreviewRegion(int structure, int currentRegion);
+
+/**
+ * @brief Number of structures whose region_id the preview would change.
+ */
+int RegionAssignChangeCount(void);
+
+/**
+ * @brief Writes the previewed region_id of every structure it changes as one undo step and ends the preview.
+ * @return Number of structures changed.
+ */
+int RegionAssignApply(void);
+
+/**
+ * @brief Ends the preview without changing anything.
+ */
+void RegionAssignCancel(void);
+
+/**
+ * @brief Returns the id of the region whose seed is nearest to a point, -1 if no region has a seed.
+ */
+int RegionAssignNearest(float x, float y);
+
+/**
+ * @brief Frees the seeds and the preview. Call when the document is replaced.
+ */
+void RegionAssignClear(void);
+
+#endif // REGION_ASSIGN_H
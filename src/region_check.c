@@ -0,0 +1,351 @@
+#include "region_check.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <stdlib.h>
+
+#define REGION_LAYER_COUNT 3
+#define WORLD_LAYER_COUNT 2
+#define MAX_REFRESH_REGIONS 256     // More changed regions than this and the whole sweep runs again
+
+static const EditLayer _regionLayers[REGION_LAYER_COUNT] = { LAYER_SNOW_REGIONS, LAYER_RAIN_REGIONS, LAYER_STAR_REGIONS };
+static const EditLayer _worldLayers[WORLD_LAYER_COUNT] = { LAYER_OCEAN_WORLD_AREA, LAYER_SPACE_WORLD_AREA };
+
+// A region the sweep has passed the left edge of but not the right one yet
+typedef struct {
+    double maxX;
+    double minY;
+    double maxY;
+    int slot;
+} ActiveRegion;
+
+static RegionCheckResult _result = { 0 };
+static int _overlapCapacity = 0;
+static bool _checked = false;
+static RegionBox *_boxes = NULL;            // Every region in document order, layer by layer
+static bool *_valid = NULL;                 // The region has complete bounds
+static bool *_changed = NULL;               // Scratch flags for a refresh
+static int _boxCount = 0;
+static int _layerStart[REGION_LAYER_COUNT + 1] = { 0 };
+static RegionBox _worlds[WORLD_LAYER_COUNT];
+static int _worldCount = 0;
+static const cJSON *_checkedJSON[LAYER_COUNT] = { 0 };
+static uint64_t _checkedWorldVersions[WORLD_LAYER_COUNT] = { 0 };
+static uint64_t _syncedVersion = 0;
+
+//------------------------------------------------------------------------------------
+// Bounds
+//------------------------------------------------------------------------------------
+static bool ReadBox(cJSON *element, EditLayer layer, int index, RegionBox *box)
+{
+    cJSON *minX = NULL, *minY = NULL, *maxX = NULL, *maxY = NULL;
+    if (!GetPointItemsJSON(element, POINT_FIELD_MIN_MIN, &minX, &minY)) return false;
+    if (!GetPointItemsJSON(element, POINT_FIELD_MAX_MAX, &maxX, &maxY)) return false;
+
+    box->layer = layer;
+    box->index = index;
+    box->minX = (minX->valuedouble < maxX->valuedouble) ? minX->valuedouble : maxX->valuedouble;
+    box->maxX = (minX->valuedouble < maxX->valuedouble) ? maxX->valuedouble : minX->valuedouble;
+    box->minY = (minY->valuedouble < maxY->valuedouble) ? minY->valuedouble : maxY->valuedouble;
+    box->maxY = (minY->valuedouble < maxY->valuedouble) ? maxY->valuedouble : minY->valuedouble;
+    return true;
+}
+
+// Touching edges are not an overlap
+static bool Overlaps(const RegionBox *a, const RegionBox *b)
+{
+    return a->minX < b->maxX && b->minX < a->maxX && a->minY < b->maxY && b->minY < a->maxY;
+}
+
+// A region has to lie entirely inside one of the world areas
+static bool IsOutside(const RegionBox *box)
+{
+    for (int w = 0; w < _worldCount; w++)
+    {
+        const RegionBox *world = &_worlds[w];
+        if (box->minX >= world->minX && box->maxX <= world->maxX && box->minY >= world->minY && box->maxY <= world->maxY) return false;
+    }
+    return _worldCount > 0;
+}
+
+static int SlotOf(const RegionBox *box)
+{
+    for (int l = 0; l < REGION_LAYER_COUNT; l++)
+    {
+        if (_regionLayers[l] == box->layer) return _layerStart[l] + box->index;
+    }
+    return -1;
+}
+
+static int CompareMinX(const void *a, const void *b)
+{
+    const RegionBox *x = &_boxes[*(const int *)a];
+    const RegionBox *y = &_boxes[*(const int *)b];
+    return (x->minX > y->minX) - (x->minX < y->minX);
+}
+
+static bool AddOverlap(const RegionBox *a, const RegionBox *b)
+{
+    if (_result.overlapCount == _overlapCapacity)
+    {
+        int capacity = _overlapCapacity ? _overlapCapacity * 2 : 64;
+        RegionOverlap *overlaps = (RegionOverlap *)MemRealloc(_result.overlaps, (size_t)capacity * sizeof(RegionOverlap));
+        if (overlaps == NULL) return false;
+        _result.overlaps = overlaps;
+        _overlapCapacity = capacity;
+    }
+
+    // Reported in document order, so the same pair always reads the same way
+    bool swap = (a->layer > b->layer) || (a->layer == b->layer && a->index > b->index);
+    RegionOverlap *overlap = &_result.overlaps[_result.overlapCount++];
+    overlap->a = swap ? *b : *a;
+    overlap->b = swap ? *a : *b;
+    overlap->minX = (a->minX > b->minX) ? a->minX : b->minX;
+    overlap->minY = (a->minY > b->minY) ? a->minY : b->minY;
+    overlap->maxX = (a->maxX < b->maxX) ? a->maxX : b->maxX;
+    overlap->maxY = (a->maxY < b->maxY) ? a->maxY : b->maxY;
+    return true;
+}
+
+static void RememberVersions(void)
+{
+    for (int l = 0; l < LAYER_COUNT; l++) _checkedJSON[l] = GetLayerJSON((EditLayer)l);
+    for (int w = 0; w < WORLD_LAYER_COUNT; w++) _checkedWorldVersions[w] = ChangesGetLayerVersion(_worldLayers[w]);
+    _syncedVersion = ChangesGetVersion();
+    _checked = true;
+}
+
+//------------------------------------------------------------------------------------
+// Check
+//------------------------------------------------------------------------------------
+static void FreeRegions(void)
+{
+    MemFree(_result.overlaps);
+    MemFree(_result.outside);
+    MemFree(_boxes);
+    MemFree(_valid);
+    MemFree(_changed);
+    _result = (RegionCheckResult){ 0 };
+    _overlapCapacity = 0;
+    _boxes = NULL;
+    _valid = NULL;
+    _changed = NULL;
+    _boxCount = 0;
+    _checked = false;
+}
+
+// Reads every region and sweeps them all
+static void CheckAll(void)
+{
+    ProfileBegin("region check");
+    MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+    FreeRegions();
+
+    int capacity = 0;
+    for (int l = 0; l < REGION_LAYER_COUNT; l++)
+    {
+        _layerStart[l] = capacity;
+        capacity += cJSON_GetArraySize(GetLayerJSON(_regionLayers[l]));
+    }
+    _layerStart[REGION_LAYER_COUNT] = capacity;
+
+    _worldCount = 0;
+    for (int w = 0; w < WORLD_LAYER_COUNT; w++)
+    {
+        if (ReadBox(GetLayerJSON(_worldLayers[w]), _worldLayers[w], 0, &_worlds[_worldCount])) _worldCount++;
+    }
+    _result.hasWorld = _worldCount > 0;
+
+    size_t slots = (capacity > 0) ? (size_t)capacity : 1;
+    _boxes = (RegionBox *)MemAlloc(slots * sizeof(RegionBox));
+    _valid = (bool *)MemCalloc(slots, sizeof(bool));
+    _changed = (bool *)MemCalloc(slots, sizeof(bool));
+    _result.outside = (RegionBox *)MemAlloc(slots * sizeof(RegionBox));
+    int *order = (int *)MemAlloc(slots * sizeof(int));
+    ActiveRegion *active = (ActiveRegion *)MemAlloc(slots * sizeof(ActiveRegion));
+
+    if (_boxes != NULL && _valid != NULL && _changed != NULL && _result.outside != NULL && order != NULL && active != NULL)
+    {
+        _boxCount = capacity;
+        int count = 0;
+        for (int l = 0; l < REGION_LAYER_COUNT; l++)
+        {
+            int index = 0;
+            cJSON *region = NULL;
+            cJSON_ArrayForEach(region, GetLayerJSON(_regionLayers[l]))
+            {
+                int slot = _layerStart[l] + index;
+                _valid[slot] = ReadBox(region, _regionLayers[l], index, &_boxes[slot]);
+                if (_valid[slot]) order[count++] = slot;
+                if (_valid[slot] && IsOutside(&_boxes[slot])) _result.outside[_result.outsideCount++] = _boxes[slot];
+                index++;
+            }
+        }
+        _result.regionCount = count;
+
+        // Sweep: regions whose right edge is left of the current left edge can no longer overlap
+        // anything. The open ones keep their extent next to each other, so the scan stays in cache.
+        qsort(order, (size_t)count, sizeof(int), CompareMinX);
+        int activeCount = 0;
+        bool full = false;
+        for (int i = 0; i < count; i++)
+        {
+            const RegionBox *box = &_boxes[order[i]];
+            int kept = 0;
+            for (int a = 0; a < activeCount; a++)
+            {
+                if (active[a].maxX <= box->minX) continue;
+                active[kept++] = active[a];
+                if (!full && active[a].minY < box->maxY && box->minY < active[a].maxY) full = !AddOverlap(&_boxes[active[a].slot], box);
+            }
+            activeCount = kept;
+            active[activeCount++] = (ActiveRegion){ box->maxX, box->minY, box->maxY, order[i] };
+        }
+    }
+    MemFree(order);
+    MemFree(active);
+
+    RememberVersions();
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+// Regions that were only moved or resized are compared again against all others, one pass
+// each, instead of sweeping everything; false if the full check has to run instead
+static bool Refresh(void)
+{
+    if (_changed == NULL || !ChangesComplete(_syncedVersion)) return false;
+    for (int l = 0; l < LAYER_COUNT; l++)
+    {
+        if (_checkedJSON[l] != GetLayerJSON((EditLayer)l)) return false;
+    }
+    for (int w = 0; w < WORLD_LAYER_COUNT; w++)
+    {
+        if (_checkedWorldVersions[w] != ChangesGetLayerVersion(_worldLayers[w])) return false;
+    }
+    for (int l = 0; l < REGION_LAYER_COUNT; l++)
+    {
+        if (ChangesGetStructureVersion(_regionLayers[l]) > _syncedVersion) return false;
+    }
+
+    int changedSlots[MAX_REFRESH_REGIONS];
+    int changedCount = 0;
+    ElementChange change;
+    ChangeIterator it = ChangesBegin(_syncedVersion);
+    while (ChangesNext(&it, &change))
+    {
+        for (int l = 0; l < REGION_LAYER_COUNT; l++)
+        {
+            if (change.layer != _regionLayers[l]) continue;
+            if (changedCount == MAX_REFRESH_REGIONS || change.index >= _layerStart[l + 1] - _layerStart[l]) return false;
+            changedSlots[changedCount++] = _layerStart[l] + change.index;
+        }
+    }
+    if (changedCount == 0)
+    {
+        _syncedVersion = ChangesGetVersion();
+        return true;
+    }
+
+    ProfileBegin("region check refresh");
+    MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+    for (int c = 0; c < changedCount; c++) _changed[changedSlots[c]] = true;
+
+    // Forget what the changed regions were part of
+    int kept = 0;
+    for (int i = 0; i < _result.overlapCount; i++)
+    {
+        const RegionOverlap *overlap = &_result.overlaps[i];
+        if (!_changed[SlotOf(&overlap->a)] && !_changed[SlotOf(&overlap->b)]) _result.overlaps[kept++] = *overlap;
+    }
+    _result.overlapCount = kept;
+    kept = 0;
+    for (int i = 0; i < _result.outsideCount; i++)
+    {
+        if (!_changed[SlotOf(&_result.outside[i])]) _result.outside[kept++] = _result.outside[i];
+    }
+    _result.outsideCount = kept;
+
+    for (int c = 0; c < changedCount; c++)
+    {
+        int slot = changedSlots[c];
+        int l = 0;
+        while (slot >= _layerStart[l + 1]) l++;
+        int index = slot - _layerStart[l];
+        bool valid = ReadBox(cJSON_GetArrayItem(GetLayerJSON(_regionLayers[l]), index), _regionLayers[l], index, &_boxes[slot]);
+        _result.regionCount += (int)valid - (int)_valid[slot];
+        _valid[slot] = valid;
+    }
+
+    // Pairs of two changed regions are added by the first of them only
+    bool full = false;
+    for (int c = 0; c < changedCount && !full; c++)
+    {
+        int slot = changedSlots[c];
+        if (!_valid[slot]) continue;
+        const RegionBox *box = &_boxes[slot];
+        if (IsOutside(box)) _result.outside[_result.outsideCount++] = *box;
+        for (int other = 0; other < _boxCount && !full; other++)
+        {
+            if (other == slot || !_valid[other] || (_changed[other] && other < slot)) continue;
+            if (Overlaps(box, &_boxes[other])) full = !AddOverlap(box, &_boxes[other]);
+        }
+    }
+
+    for (int c = 0; c < changedCount; c++) _changed[changedSlots[c]] = false;
+    _syncedVersion = ChangesGetVersion();
+    MemPopSubsystem();
+    ProfileEnd();
+    return !full;
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+const RegionCheckResult *RegionCheckGet(void)
+{
+    if (!_checked || (ChangesGetVersion() != _syncedVersion && !Refresh())) CheckAll();
+    return &_result;
+}
+
+void RegionCheckDraw(Vector2 cameraOffset, float displayScale)
+{
+    const RegionCheckResult *result = RegionCheckGet();
+    Rectangle screen = { 0, 0, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+    for (int i = 0; i < result->overlapCount; i++)
+    {
+        const RegionOverlap *overlap = &result->overlaps[i];
+        Rectangle rect = { (float)overlap->minX * displayScale + cameraOffset.x, -(float)overlap->maxY * displayScale + cameraOffset.y,
+                           (float)(overlap->maxX - overlap->minX) * displayScale, (float)(overlap->maxY - overlap->minY) * displayScale };
+        if (!CheckCollisionRecs(rect, screen)) continue;
+        DrawRectangleRec(rect, Fade(RED, 0.35f));
+        DrawRectangleLinesEx(rect, 2, RED);
+    }
+    for (int i = 0; i < result->outsideCount; i++)
+    {
+        const RegionBox *box = &result->outside[i];
+        Rectangle rect = { (float)box->minX * displayScale + cameraOffset.x, -(float)box->maxY * displayScale + cameraOffset.y,
+                           (float)(box->maxX - box->minX) * displayScale, (float)(box->maxY - box->minY) * displayScale };
+        if (!CheckCollisionRecs(rect, screen)) continue;
+        DrawRectangleLinesEx(rect, 4, RED);
+        DrawText("Outside the world", (int)rect.x + 20, (int)(rect.y + rect.height) - 30, 20, RED);
+    }
+}
+
+const char *RegionLayerName(EditLayer layer)
+{
+    switch (layer)
+    {
+        case LAYER_SNOW_REGIONS: return "snow_regions";
+        case LAYER_RAIN_REGIONS: return "rain_regions";
+        case LAYER_STAR_REGIONS: return "star_regions";
+        case LAYER_OCEAN_WORLD_AREA: return "ocean_world_area";
+        case LAYER_SPACE_WORLD_AREA: return "space_world_area";
+        default: return "?";
+    }
+}
+
+void RegionCheckClear(void)
+{
+    FreeRegions();
+}
@@ -0,0 +1,63 @@
+#ifndef REGION_CHECK_H
+#define REGION_CHECK_H
+
+#include "raylib.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Finds snow, rain and star regions that overlap each other or reach outside both world
+// areas. The regions are sorted by their left edge and swept from left to right, keeping
+// only the ones whose x range is still open; each new region is compared against those
+// alone (sweep and prune), so the check costs O(n log n + k) for k overlaps instead of
+// comparing every pair. After a drag only the moved regions are compared again, against
+// all others, and nothing runs while no region or world area changes.
+
+typedef struct {
+    EditLayer layer;
+    int index;
+    double minX, minY, maxX, maxY;      // Normalized, so min <= max even for a flipped region
+} RegionBox;
+
+typedef struct {
+    RegionBox a;
+    RegionBox b;
+    double minX, minY, maxX, maxY;      // Where they overlap
+} RegionOverlap;
+
+typedef struct {
+    RegionOverlap *overlaps;
+    int overlapCount;
+    RegionBox *outside;                 // Regions not inside the ocean or the space world area
+    int outsideCount;
+    int regionCount;
+    bool hasWorld;                      // Whether either world area exists to check against
+} RegionCheckResult;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the overlaps and out-of-world regions of the loaded config, checking again
+ *        first if a region or world area changed since the last call.
+ */
+const RegionCheckResult *RegionCheckGet(void);
+
+/**
+ * @brief Fills the overlapping part of each pair and outlines each region outside the world in red.
+ */
+void RegionCheckDraw(Vector2 cameraOffset, float displayScale);
+
+/**
+ * @brief Returns the config key of a region or world area layer, such as "snow_regions".
+ */
+const char *RegionLayerName(EditLayer layer);
+
+/**
+ * @brief Frees the result. Call when the document is replaced.
+ */
+void RegionCheckClear(void);
+
+#endif // REGION_CHECK_H
@@ -0,0 +1,410 @@
+#include "region_index.h"
+#include "changes.h"
+#include "hit_test.h"
+#include "memtrack.h"
+#include "point_cache.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define REGION_LAYER_COUNT 3
+#define NODE_SIZE 16                // Children per node
+#define MAX_LEVELS 16
+#define QUERY_STACK_SIZE (MAX_LEVELS * NODE_SIZE)   // A walk holds at most one node's children per level
+#define QUERY_INITIAL_HITS 64
+
+static const EditLayer _regionLayers[REGION_LAYER_COUNT] = { LAYER_SNOW_REGIONS, LAYER_RAIN_REGIONS, LAYER_STAR_REGIONS };
+
+// Nodes and entries share the layout, so a level is refitted the same way whatever it holds
+typedef struct {
+    float minX, minY, maxX, maxY;
+    int slot;                       // Entries: the region; nodes: unused
+} IndexBox;
+
+static RegionBox *_boxes = NULL;            // Every region in document order, layer by layer
+static bool *_valid = NULL;                 // The region has complete bounds
+static int *_entryOf = NULL;                // Position of each region in _entries, -1 if not indexed
+static IndexBox *_entries = NULL;           // Regions in tree order
+static IndexBox *_nodes = NULL;             // Every level after the other, leaves first and the root last
+static int _boxCount = 0;
+static int _entryCount = 0;
+static int _layerStart[REGION_LAYER_COUNT + 1] = { 0 };
+static int _levelStart[MAX_LEVELS + 1] = { 0 };   // First node of each level, the end of the last at _levelStart[_levelCount]
+static int _levelCount = 0;
+static int _refitted = 0;                   // Regions moved since the tree was packed
+static bool _built = false;
+static const cJSON *_builtJSON[REGION_LAYER_COUNT] = { 0 };
+static uint64_t _syncedVersion = 0;
+static int *_hitSlots = NULL;               // Regions found by the last point query, grown as needed
+static int _hitCapacity = 0;
+
+// Last RegionIndexCountStructures() answer
+static struct {
+    EditLayer layer;
+    int index;
+    int count;
+    const cJSON *structures;
+    const cJSON *region;
+    uint64_t structuresVersion;
+    uint64_t regionVersion;
+    bool valid;
+} _counted = { 0 };
+
+//------------------------------------------------------------------------------------
+// Bounds
+//------------------------------------------------------------------------------------
+static bool ReadBox(cJSON *element, EditLayer layer, int index, RegionBox *box)
+{
+    cJSON *minX = NULL, *minY = NULL, *maxX = NULL, *maxY = NULL;
+    if (!GetPointItemsJSON(element, POINT_FIELD_MIN_MIN, &minX, &minY)) return false;
+    if (!GetPointItemsJSON(element, POINT_FIELD_MAX_MAX, &maxX, &maxY)) return false;
+
+    box->layer = layer;
+    box->index = index;
+    box->minX = (minX->valuedouble < maxX->valuedouble) ? minX->valuedouble : maxX->valuedouble;
+    box->maxX = (minX->valuedouble < maxX->valuedouble) ? maxX->valuedouble : minX->valuedouble;
+    box->minY = (minY->valuedouble < maxY->valuedouble) ? minY->valuedouble : maxY->valuedouble;
+    box->maxY = (minY->valuedouble < maxY->valuedouble) ? maxY->valuedouble : minY->valuedouble;
+    return true;
+}
+
+// Stored as float so a point test matches HitTestRect() on the float structure locations
+static IndexBox EntryOf(int slot)
+{
+    const RegionBox *box = &_boxes[slot];
+    return (IndexBox){ (float)box->minX, (float)box->minY, (float)box->maxX, (float)box->maxY, slot };
+}
+
+static void Enclose(IndexBox *node, const IndexBox *children, int count)
+{
+    *node = (IndexBox){ INFINITY, INFINITY, -INFINITY, -INFINITY, -1 };
+    for (int i = 0; i < count; i++)
+    {
+        if (children[i].minX < node->minX) node->minX = children[i].minX;
+        if (children[i].minY < node->minY) node->minY = children[i].minY;
+        if (children[i].maxX > node->maxX) node->maxX = children[i].maxX;
+        if (children[i].maxY > node->maxY) node->maxY = children[i].maxY;
+    }
+}
+
+// Children of node n on a level: entries below the leaves, nodes of the level below otherwise
+static const IndexBox *ChildrenOf(int level, int n, int *count)
+{
+    int position = (n - _levelStart[level]) * NODE_SIZE;
+    int total = (level == 0) ? _entryCount : _levelStart[level] - _levelStart[level - 1];
+    *count = (total - position < NODE_SIZE) ? total - position : NODE_SIZE;
+    return (level == 0) ? &_entries[position] : &_nodes[_levelStart[level - 1] + position];
+}
+
+static int CompareCenterX(const void *a, const void *b)
+{
+    float x = ((const IndexBox *)a)->minX + ((const IndexBox *)a)->maxX;
+    float y = ((const IndexBox *)b)->minX + ((const IndexBox *)b)->maxX;
+    return (x > y) - (x < y);
+}
+
+static int CompareCenterY(const void *a, const void *b)
+{
+    float x = ((const IndexBox *)a)->minY + ((const IndexBox *)a)->maxY;
+    float y = ((const IndexBox *)b)->minY + ((const IndexBox *)b)->maxY;
+    return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------------
+static void FreeIndex(void)
+{
+    MemFree(_boxes);
+    MemFree(_valid);
+    MemFree(_entryOf);
+    MemFree(_entries);
+    MemFree(_nodes);
+    _boxes = NULL;
+    _valid = NULL;
+    _entryOf = NULL;
+    _entries = NULL;
+    _nodes = NULL;
+    _boxCount = 0;
+    _entryCount = 0;
+    _levelCount = 0;
+    _built = false;
+}
+
+static void RememberVersions(void)
+{
+    for (int l = 0; l < REGION_LAYER_COUNT; l++) _builtJSON[l] = GetLayerJSON(_regionLayers[l]);
+    _syncedVersion = ChangesGetVersion();
+    _built = true;
+}
+
+// Sort-tile-recursive packing: every slice holds a whole number of leaves, so entry p is
+// always a child of leaf p / NODE_SIZE and a moved region finds its way to the root
+static void Pack(void)
+{
+    int leafCount = (_entryCount + NODE_SIZE - 1) / NODE_SIZE;
+    int sliceCount = (int)ceil(sqrt((double)leafCount));
+    int sliceSize = (sliceCount > 0) ? ((leafCount + sliceCount - 1) / sliceCount) * NODE_SIZE : NODE_SIZE;
+
+    qsort(_entries, (size_t)_entryCount, sizeof(IndexBox), CompareCenterX);
+    for (int start = 0; start < _entryCount; start += sliceSize)
+    {
+        int count = (_entryCount - start < sliceSize) ? _entryCount - start : sliceSize;
+        qsort(&_entries[start], (size_t)count, sizeof(IndexBox), CompareCenterY);
+    }
+    for (int p = 0; p < _entryCount; p++) _entryOf[_entries[p].slot] = p;
+
+    // Nodes above the leaves group consecutive nodes, which the slices already keep close together
+    _levelCount = 0;
+    _levelStart[0] = 0;
+    int below = _entryCount;
+    int nodeCount = 0;
+    do
+    {
+        int count = (below + NODE_SIZE - 1) / NODE_SIZE;
+        int level = _levelCount++;
+        _levelStart[level + 1] = nodeCount + count;
+        for (int n = nodeCount; n < nodeCount + count; n++)
+        {
+            int childCount = 0;
+            const IndexBox *children = ChildrenOf(level, n, &childCount);
+            Enclose(&_nodes[n], children, childCount);
+        }
+        nodeCount += count;
+        below = count;
+    } while (below > 1 && _levelCount < MAX_LEVELS);
+    _refitted = 0;
+}
+
+// Reads every region and packs the tree
+static void Build(void)
+{
+    ProfileBegin("region index");
+    MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+    FreeIndex();
+
+    int capacity = 0;
+    for (int l = 0; l < REGION_LAYER_COUNT; l++)
+    {
+        _layerStart[l] = capacity;
+        capacity += cJSON_GetArraySize(GetLayerJSON(_regionLayers[l]));
+    }
+    _layerStart[REGION_LAYER_COUNT] = capacity;
+
+    // Each level has a sixteenth of the one below rounded up, so all of them fit in a fifteenth plus one per level
+    size_t slots = (capacity > 0) ? (size_t)capacity : 1;
+    _boxes = (RegionBox *)MemAlloc(slots * sizeof(RegionBox));
+    _valid = (bool *)MemCalloc(slots, sizeof(bool));
+    _entryOf = (int *)MemAlloc(slots * sizeof(int));
+    _entries = (IndexBox *)MemAlloc(slots * sizeof(IndexBox));
+    _nodes = (IndexBox *)MemAlloc((slots / 15 + MAX_LEVELS) * sizeof(IndexBox));
+
+    if (_boxes != NULL && _valid != NULL && _entryOf != NULL && _entries != NULL && _nodes != NULL)
+    {
+        _boxCount = capacity;
+        for (int l = 0; l < REGION_LAYER_COUNT; l++)
+        {
+            int index = 0;
+            cJSON *region = NULL;
+            cJSON_ArrayForEach(region, GetLayerJSON(_regionLayers[l]))
+            {
+                int slot = _layerStart[l] + index;
+                _valid[slot] = ReadBox(region, _regionLayers[l], index, &_boxes[slot]);
+                _entryOf[slot] = -1;
+                if (_valid[slot]) _entries[_entryCount++] = EntryOf(slot);
+                index++;
+            }
+        }
+        Pack();
+    }
+    else
+    {
+        FreeIndex();
+    }
+
+    RememberVersions();
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+// Moved and resized regions update their leaf and each node above it; false if the tree
+// has to be packed again instead
+static bool Refit(void)
+{
+    if (_entries == NULL || !ChangesComplete(_syncedVersion)) return false;
+    for (int l = 0; l < REGION_LAYER_COUNT; l++)
+    {
+        if (_builtJSON[l] != GetLayerJSON(_regionLayers[l])) return false;
+        if (ChangesGetStructureVersion(_regionLayers[l]) > _syncedVersion) return false;
+    }
+
+    ElementChange change;
+    ChangeIterator it = ChangesBegin(_syncedVersion);
+    while (ChangesNext(&it, &change))
+    {
+        for (int l = 0; l < REGION_LAYER_COUNT; l++)
+        {
+            if (change.layer != _regionLayers[l]) continue;
+            if (change.index >= _layerStart[l + 1] - _layerStart[l]) return false;
+
+            // A region gaining or losing its bounds changes the entry count
+            int slot = _layerStart[l] + change.index;
+            if (!ReadBox((cJSON *)change.element, _regionLayers[l], change.index, &_boxes[slot]) || !_valid[slot]) return false;
+
+            int position = _entryOf[slot];
+            _entries[position] = EntryOf(slot);
+            for (int level = 0, n = position / NODE_SIZE; level < _levelCount; level++)
+            {
+                int childCount = 0;
+                const IndexBox *children = ChildrenOf(level, _levelStart[level] + n, &childCount);
+                Enclose(&_nodes[_levelStart[level] + n], children, childCount);
+                n /= NODE_SIZE;
+            }
+
+            // Boxes grown by many moves overlap more and more; packing again tightens them
+            if (++_refitted > _entryCount / 4 + NODE_SIZE) return false;
+        }
+    }
+    _syncedVersion = ChangesGetVersion();
+    return true;
+}
+
+static void Sync(void)
+{
+    if (!_built || (ChangesGetVersion() != _syncedVersion && !Refit())) Build();
+}
+
+// Makes room for one more hit; on failure the hit is still counted but not returned
+static bool ReserveHit(int found)
+{
+    if (found < _hitCapacity) return true;
+    int capacity = (_hitCapacity > 0) ? _hitCapacity * 2 : QUERY_INITIAL_HITS;
+    int *slots = MemRealloc(_hitSlots, sizeof(int) * (size_t)capacity);
+    if (slots == NULL) return false;
+    _hitSlots = slots;
+    _hitCapacity = capacity;
+    return true;
+}
+
+static int CompareSlot(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+int RegionIndexQueryPoint(float x, float y, RegionBox *out, int max)
+{
+    Sync();
+    if (_levelCount == 0 || _entryCount == 0) return 0;
+
+    int found = 0;
+    int kept = 0;
+    bool collect = out != NULL && max > 0;
+    int stack[QUERY_STACK_SIZE];
+    int stackLevel[QUERY_STACK_SIZE];
+    int top = 0;
+    stack[top] = _levelStart[_levelCount - 1];
+    stackLevel[top++] = _levelCount - 1;
+
+    while (top > 0)
+    {
+        top--;
+        int level = stackLevel[top];
+        int childCount = 0;
+        const IndexBox *children = ChildrenOf(level, stack[top], &childCount);
+        int first = (level == 0) ? 0 : (int)(children - _nodes);
+        for (int c = 0; c < childCount; c++)
+        {
+            const IndexBox *child = &children[c];
+            if (!(x >= child->minX && x < child->maxX && y >= child->minY && y < child->maxY)) continue;
+            if (level > 0)
+            {
+                stack[top] = first + c;
+                stackLevel[top++] = level - 1;
+            }
+            else
+            {
+                if (collect && kept == found && ReserveHit(found)) _hitSlots[kept++] = child->slot;
+                found++;
+            }
+        }
+    }
+
+    if (kept > 0)
+    {
+        qsort(_hitSlots, (size_t)kept, sizeof(int), CompareSlot);
+        for (int i = 0; i < kept && i < max; i++) out[i] = _boxes[_hitSlots[i]];
+    }
+    return found;
+}
+
+int RegionIndexStructuresIn(EditLayer layer, int index, int *out, int max)
+{
+    RegionBox box;
+    if (!ReadBox(cJSON_GetArrayItem(GetLayerJSON(layer), index), layer, index, &box)) return -1;
+
+    const PointSet *set = GetPointSet(ELEMENT_TYPE_STRUCTURE);
+    if (set->count == 0) return 0;
+    uint32_t *mask = HitTestGetMask(set->count);
+    if (mask == NULL) return -1;
+    int count = HitTestRect(set->xs, set->ys, set->count, (float)box.minX, (float)box.minY, (float)box.maxX, (float)box.maxY, mask);
+    if (out == NULL || max <= 0) return count;
+
+    int written = 0;
+    for (int w = 0; w < HitTestMaskWords(set->count) && written < max; w++)
+    {
+        uint32_t bits = mask[w];
+        while (bits != 0 && written < max)
+        {
+            out[written++] = w * 32 + HitTestLowestBit(bits);
+            bits &= bits - 1;
+        }
+    }
+    return count;
+}
+
+int RegionIndexCountStructures(EditLayer layer, int index)
+{
+    const cJSON *structures = GetLayerJSON(LAYER_STRUCTURES);
+    const cJSON *region = cJSON_GetArrayItem(GetLayerJSON(layer), index);
+    uint64_t structuresVersion = ChangesGetLayerVersion(LAYER_STRUCTURES);
+    uint64_t regionVersion = ChangesGetElementVersion(region);
+
+    if (!_counted.valid || _counted.layer != layer || _counted.index != index || _counted.structures != structures || _counted.region != region ||
+        _counted.structuresVersion != structuresVersion || _counted.regionVersion != regionVersion)
+    {
+        _counted.layer = layer;
+        _counted.index = index;
+        _counted.count = RegionIndexStructuresIn(layer, index, NULL, 0);
+        _counted.structures = structures;
+        _counted.region = region;
+        _counted.structuresVersion = structuresVersion;
+        _counted.regionVersion = regionVersion;
+        _counted.valid = true;
+    }
+    return _counted.count;
+}
+
+const char *RegionKindName(EditLayer layer)
+{
+    switch (layer)
+    {
+        case LAYER_SNOW_REGIONS: return "Snow";
+        case LAYER_RAIN_REGIONS: return "Rain";
+        case LAYER_STAR_REGIONS: return "Star";
+        default: return "?";
+    }
+}
+
+void RegionIndexClear(void)
+{
+    FreeIndex();
+    MemFree(_hitSlots);
+    _hitSlots = NULL;
+    _hitCapacity = 0;
+    _counted.valid = false;
+}
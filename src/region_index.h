@@ -0,0 +1,50 @@
+#ifndef REGION_INDEX_H
+#define REGION_INDEX_H
+
+#include "region_check.h"
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Answers which snow, rain and star regions contain a point, and which structures lie inside
+// a region. The region bounds are kept in a packed R-tree: sorted into vertical slices by
+// centre x, each slice by centre y, and grouped 16 to a node, level by level up to the root,
+// so a point query only opens the nodes whose box contains it. A moved region only updates
+// its node and the ones above it; the tree is packed again when regions are added, removed
+// or reloaded. A point is inside a region when minX <= x < maxX and minY <= y < maxY, the
+// same rule HitTestRect() uses.
+
+/**
+ * @brief Finds the regions that contain a point, rebuilding or updating the index first if a
+ *        region changed since the last query.
+ * @param out Receives up to max of them in document order, snow before rain before star.
+ *            Fewer are written only if memory for the hits runs out.
+ * @return Number of regions that contain the point, which may be more than max.
+ */
+int RegionIndexQueryPoint(float x, float y, RegionBox *out, int max);
+
+/**
+ * @brief Finds the structures whose location lies inside a region.
+ * @param out Receives up to max structure indices in ascending order; may be NULL to only count.
+ * @return Number of structures inside, which may be more than max, or -1 if the region has no
+ *         complete bounds.
+ */
+int RegionIndexStructuresIn(EditLayer layer, int index, int *out, int max);
+
+/**
+ * @brief Like RegionIndexStructuresIn() without indices, but remembers the last answer until a
+ *        structure or the region changes, so it can be drawn every frame.
+ */
+int RegionIndexCountStructures(EditLayer layer, int index);
+
+/**
+ * @brief Returns "Snow", "Rain" or "Star" for a region layer.
+ */
+const char *RegionKindName(EditLayer layer);
+
+/**
+ * @brief Frees the index. Call when the document is replaced.
+ */
+void RegionIndexClear(void);
+
+#endif // REGION_INDEX_H
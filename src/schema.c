@@ -0,0 +1,452 @@
+#include "schema.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "pointer_map.h"
+#include "profiler.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_FIELDS 3
+#define NO_FIELD 0xFF
+#define NO_ITEM -1
+#define NO_INDEX -1
+#define ELEMENT_INVALID 1
+#define ELEMENT_QUARANTINED 2
+#define SEVERAL_FIELDS 0xFE         // More than one field starts with the character
+#define FLAGGED_QUARANTINED ((int64_t)1 << 32) // Set above the issue signature of a flagged element
+
+typedef enum {
+    SECTION_STRUCTURES,
+    SECTION_REGIONS,
+    SECTION_BOOST_GATES,
+    SECTION_PORTALS,
+    SECTION_SNOW_REGIONS,
+    SECTION_RAIN_REGIONS,
+    SECTION_STAR_REGIONS,
+    SECTION_OCEAN_WORLD_AREA,
+    SECTION_SPACE_WORLD_AREA,
+    SECTION_COUNT
+} Section;
+
+typedef enum {
+    FIELD_POINT,                // [x, y]
+    FIELD_BOUNDS,               // { "min": [x, y], "max": [x, y] }
+    FIELD_STRING,
+    FIELD_REGION_ID,            // Index into "regions"
+} FieldKind;
+
+typedef enum {
+    PART_NONE,
+    PART_MIN,
+    PART_MAX,
+} BoundsPart;
+
+typedef enum {
+    PROBLEM_NOT_ARRAY,
+    PROBLEM_NOT_OBJECT,
+    PROBLEM_MISSING,
+    PROBLEM_NOT_POINT,
+    PROBLEM_POINT_LENGTH,
+    PROBLEM_NOT_NUMBER,
+    PROBLEM_NOT_STRING,
+    PROBLEM_NOT_WHOLE,
+    PROBLEM_OUT_OF_RANGE,
+} Problem;
+
+typedef struct {
+    const char *key;
+    FieldKind kind;
+    bool required;
+    bool quarantine;            // A problem with it keeps the element out of drawing and editing
+} FieldRule;
+
+typedef struct {
+    const char *path;           // JSON path of the section below the root
+    EditLayer layer;            // LAYER_COUNT for sections the editor does not draw
+    bool single;                // One object rather than an array of them
+    FieldRule fields[MAX_FIELDS];
+    int fieldCount;
+} SectionSchema;
+
+// Kept small, as a broken config can have an issue per element
+typedef struct {
+    int index;                  // Element, NO_INDEX for the section itself
+    int value;                  // Item count or region id, where the problem has one
+    uint8_t section;
+    uint8_t field;              // Rule of the section, NO_FIELD for the element itself
+    uint8_t part;
+    int8_t item;                // Coordinate, NO_ITEM for the whole value
+    uint8_t problem;
+    bool quarantined;
+} Issue;
+
+static const SectionSchema _schemas[SECTION_COUNT] = {
+    [SECTION_STRUCTURES] = { "structures", LAYER_STRUCTURES, false, {
+        { "location", FIELD_POINT, true, true },
+        { "name", FIELD_STRING, false, false },
+        { "region_id", FIELD_REGION_ID, false, false } }, 3 },
+    [SECTION_REGIONS] = { "regions", LAYER_COUNT, false, {
+        { "name", FIELD_STRING, false, false },
+        { "location", FIELD_POINT, false, false } }, 2 },
+    [SECTION_BOOST_GATES] = { "boost_gates", LAYER_BOOST_GATES, false, {
+        { "a", FIELD_POINT, true, true },
+        { "b", FIELD_POINT, true, true } }, 2 },
+    [SECTION_PORTALS] = { "portals.locations", LAYER_PORTALS, false, {
+        { "a", FIELD_POINT, true, true },
+        { "b", FIELD_POINT, true, true } }, 2 },
+    [SECTION_SNOW_REGIONS] = { "snow_regions", LAYER_SNOW_REGIONS, false, { { "bounds", FIELD_BOUNDS, true, true } }, 1 },
+    [SECTION_RAIN_REGIONS] = { "rain_regions", LAYER_RAIN_REGIONS, false, { { "bounds", FIELD_BOUNDS, true, true } }, 1 },
+    [SECTION_STAR_REGIONS] = { "star_regions", LAYER_STAR_REGIONS, false, { { "bounds", FIELD_BOUNDS, true, true } }, 1 },
+    [SECTION_OCEAN_WORLD_AREA] = { "ocean_world_area", LAYER_OCEAN_WORLD_AREA, true, { { "bounds", FIELD_BOUNDS, true, true } }, 1 },
+    [SECTION_SPACE_WORLD_AREA] = { "space_world_area", LAYER_SPACE_WORLD_AREA, true, { { "bounds", FIELD_BOUNDS, true, true } }, 1 },
+};
+
+// Field of each section by the first character of its key, either case, so most members are
+// matched with one lookup and one compare
+static uint8_t _fieldByFirst[SECTION_COUNT][256];
+static bool _compiled = false;
+
+static SchemaReport _report = { 0 };
+static Issue *_issues = NULL;
+static int _issueCapacity = 0;
+// Elements with issues, mapped to a hash of their issues and whether they are quarantined, so
+// an edit that leaves the issues as they were needs no new report
+static PointerMap _flagged = { 0 };
+static bool _recording = false;             // Issues are kept; off while a refresh only probes changed elements
+static uint32_t _signature = 0;             // Hash of the issues found since it was last reset
+static bool _checked = false;
+static const cJSON *_checkedJSON[SECTION_COUNT] = { 0 };
+static int _regionCount = 0;
+static uint64_t _syncedVersion = 0;
+
+//------------------------------------------------------------------------------------
+// Checks
+//------------------------------------------------------------------------------------
+static const cJSON *SectionJSON(Section section)
+{
+    if (section == SECTION_REGIONS) return _regions;
+    return GetLayerJSON(_schemas[section].layer);
+}
+
+// Case-insensitive like cJSON_GetObjectItem()
+static bool KeyEquals(const char *key, const char *name)
+{
+    if (key == NULL) return false;
+    while (*key != '\0' && tolower((unsigned char)*key) == *name) { key++; name++; }
+    return *key == '\0' && *name == '\0';
+}
+
+// Keeps a problem for the report; a refresh only wants to know whether there is one
+static void Report(Section section, int index, int field, BoundsPart part, int item, Problem problem, int value)
+{
+    uint32_t code = ((uint32_t)field << 24) | ((uint32_t)part << 16) | ((uint32_t)(uint8_t)item << 8) | (uint32_t)problem;
+    _signature = (_signature ^ code ^ ((uint32_t)value * 0x9E3779B9u)) * 16777619u;
+    if (!_recording) return;
+    if (_report.issueCount == _issueCapacity)
+    {
+        int capacity = (_issueCapacity == 0) ? 64 : _issueCapacity * 2;
+        Issue *issues = MemRealloc(_issues, (size_t)capacity * sizeof(Issue));
+        if (issues == NULL) return;
+        _issues = issues;
+        _issueCapacity = capacity;
+    }
+
+    bool quarantined = (field == NO_FIELD) || _schemas[section].fields[field].quarantine;
+    _issues[_report.issueCount++] = (Issue){ index, value, (uint8_t)section, (uint8_t)field, (uint8_t)part, (int8_t)item, (uint8_t)problem, quarantined };
+}
+
+static bool CheckPoint(const cJSON *point, Section section, int index, int field, BoundsPart part)
+{
+    if (!cJSON_IsArray(point))
+    {
+        Report(section, index, field, part, NO_ITEM, PROBLEM_NOT_POINT, 0);
+        return false;
+    }
+
+    bool valid = true;
+    int count = 0;
+    for (const cJSON *item = point->child; item != NULL; item = item->next, count++)
+    {
+        if (count < 2 && !cJSON_IsNumber(item))
+        {
+            Report(section, index, field, part, count, PROBLEM_NOT_NUMBER, 0);
+            valid = false;
+        }
+    }
+    if (count != 2)
+    {
+        Report(section, index, field, part, NO_ITEM, PROBLEM_POINT_LENGTH, count);
+        valid = false;
+    }
+    return valid;
+}
+
+static bool CheckBounds(const cJSON *bounds, Section section, int index, int field)
+{
+    if (!cJSON_IsObject(bounds))
+    {
+        Report(section, index, field, PART_NONE, NO_ITEM, PROBLEM_NOT_OBJECT, 0);
+        return false;
+    }
+
+    const cJSON *min = NULL, *max = NULL;
+    for (const cJSON *member = bounds->child; member != NULL; member = member->next)
+    {
+        if (min == NULL && KeyEquals(member->string, "min")) min = member;
+        else if (max == NULL && KeyEquals(member->string, "max")) max = member;
+    }
+
+    bool valid = true;
+    if (min == NULL) Report(section, index, field, PART_MIN, NO_ITEM, PROBLEM_MISSING, 0);
+    if (max == NULL) Report(section, index, field, PART_MAX, NO_ITEM, PROBLEM_MISSING, 0);
+    if (min == NULL || !CheckPoint(min, section, index, field, PART_MIN)) valid = false;
+    if (max == NULL || !CheckPoint(max, section, index, field, PART_MAX)) valid = false;
+    return valid;
+}
+
+static bool CheckField(const cJSON *value, Section section, int index, int field)
+{
+    const FieldRule *rule = &_schemas[section].fields[field];
+    if (value == NULL)
+    {
+        if (rule->required) Report(section, index, field, PART_NONE, NO_ITEM, PROBLEM_MISSING, 0);
+        return !rule->required;
+    }
+
+    switch (rule->kind)
+    {
+        case FIELD_POINT: return CheckPoint(value, section, index, field, PART_NONE);
+        case FIELD_BOUNDS: return CheckBounds(value, section, index, field);
+        case FIELD_STRING:
+            if (cJSON_IsString(value)) return true;
+            Report(section, index, field, PART_NONE, NO_ITEM, PROBLEM_NOT_STRING, 0);
+            return false;
+        case FIELD_REGION_ID:
+            if (!cJSON_IsNumber(value) || floor(value->valuedouble) != value->valuedouble)
+            {
+                Report(section, index, field, PART_NONE, NO_ITEM, PROBLEM_NOT_WHOLE, 0);
+                return false;
+            }
+            if (value->valuedouble >= 0.0 && value->valuedouble < _regionCount) return true;
+            Report(section, index, field, PART_NONE, NO_ITEM, PROBLEM_OUT_OF_RANGE, value->valueint);
+            return false;
+    }
+    return true;
+}
+
+static void Compile(void)
+{
+    for (int s = 0; s < SECTION_COUNT; s++)
+    {
+        memset(_fieldByFirst[s], NO_FIELD, sizeof(_fieldByFirst[s]));
+        for (int f = 0; f < _schemas[s].fieldCount; f++)
+        {
+            unsigned char first = (unsigned char)_schemas[s].fields[f].key[0];
+            uint8_t *lower = &_fieldByFirst[s][first];
+            uint8_t *upper = &_fieldByFirst[s][toupper(first)];
+            *lower = *upper = (*lower == NO_FIELD) ? (uint8_t)f : SEVERAL_FIELDS;
+        }
+    }
+    _compiled = true;
+}
+
+// One walk over the members finds every field, the first match winning as in cJSON_GetObjectItem()
+static int CheckElement(const cJSON *element, Section section, int index)
+{
+    const SectionSchema *schema = &_schemas[section];
+    if (!cJSON_IsObject(element))
+    {
+        Report(section, index, NO_FIELD, PART_NONE, NO_ITEM, PROBLEM_NOT_OBJECT, 0);
+        return ELEMENT_INVALID | ELEMENT_QUARANTINED;
+    }
+
+    const cJSON *values[MAX_FIELDS] = { NULL };
+    for (const cJSON *member = element->child; member != NULL; member = member->next)
+    {
+        if (member->string == NULL) continue;
+        int candidate = _fieldByFirst[section][(unsigned char)member->string[0]];
+        if (candidate == NO_FIELD) continue;
+        for (int f = (candidate == SEVERAL_FIELDS) ? 0 : candidate; f < schema->fieldCount; f++)
+        {
+            if (values[f] == NULL && KeyEquals(member->string, schema->fields[f].key))
+            {
+                values[f] = member;
+                break;
+            }
+            if (candidate != SEVERAL_FIELDS) break;
+        }
+    }
+
+    int flags = 0;
+    for (int f = 0; f < schema->fieldCount; f++)
+    {
+        if (CheckField(values[f], section, index, f)) continue;
+        flags |= ELEMENT_INVALID;
+        if (schema->fields[f].quarantine) flags |= ELEMENT_QUARANTINED;
+    }
+    return flags;
+}
+
+static void Flag(const cJSON *element, int flags)
+{
+    if (flags == 0) return;
+    _report.invalidCount++;
+    if (flags & ELEMENT_QUARANTINED) _report.quarantinedCount++;
+    PointerMapPut(&_flagged, PointerKey(element), (int64_t)_signature | ((flags & ELEMENT_QUARANTINED) ? FLAGGED_QUARANTINED : 0));
+}
+
+static void Check(void)
+{
+    ProfileBegin("schema check");
+    MemPushSubsystem(MEM_SUBSYSTEM_OTHER);
+    if (!_compiled) Compile();
+    PointerMapFree(&_flagged);
+    _report = (SchemaReport){ 0 };
+    _regionCount = cJSON_GetArraySize(_regions);
+    _recording = true;
+
+    for (int s = 0; s < SECTION_COUNT; s++)
+    {
+        const cJSON *json = SectionJSON((Section)s);
+        _checkedJSON[s] = json;
+        if (json == NULL) continue;
+
+        if (_schemas[s].single)
+        {
+            _report.elementCount++;
+            _signature = 0;
+            Flag(json, CheckElement(json, (Section)s, 0));
+            continue;
+        }
+
+        // Whatever is in a section that is not an array, nothing can make sense of it
+        if (!cJSON_IsArray(json))
+        {
+            Report((Section)s, NO_INDEX, NO_FIELD, PART_NONE, NO_ITEM, PROBLEM_NOT_ARRAY, 0);
+            _signature = 0;
+            for (const cJSON *child = json->child; child != NULL; child = child->next) Flag(child, ELEMENT_INVALID | ELEMENT_QUARANTINED);
+            continue;
+        }
+
+        int index = 0;
+        for (const cJSON *element = json->child; element != NULL; element = element->next)
+        {
+            _signature = 0;
+            Flag(element, CheckElement(element, (Section)s, index++));
+        }
+        _report.elementCount += index;
+    }
+
+    _recording = false;
+    _checked = true;
+    _syncedVersion = ChangesGetVersion();
+    MemPopSubsystem();
+    ProfileEnd();
+}
+
+// Changed elements whose issues are the same as before, usually none, leave the report as it
+// is; false if the whole check has to run instead
+static bool Refresh(void)
+{
+    if (!ChangesComplete(_syncedVersion) || cJSON_GetArraySize(_regions) != _regionCount) return false;
+    for (int s = 0; s < SECTION_COUNT; s++)
+    {
+        if (_checkedJSON[s] != SectionJSON((Section)s)) return false;
+        if (_schemas[s].layer != LAYER_COUNT && ChangesGetStructureVersion(_schemas[s].layer) > _syncedVersion) return false;
+    }
+
+    ElementChange change;
+    ChangeIterator it = ChangesBegin(_syncedVersion);
+    while (ChangesNext(&it, &change))
+    {
+        if (change.element == NULL) return false;
+        int64_t flagged = PointerMapGet(&_flagged, PointerKey(change.element), -1);
+        for (int s = 0; s < SECTION_COUNT; s++)
+        {
+            if (_schemas[s].layer != change.layer) continue;
+            _signature = 0;
+            int flags = CheckElement(change.element, (Section)s, change.index);
+            if ((flagged >= 0) ? (flags == 0 || _signature != (uint32_t)flagged) : (flags != 0)) return false;
+        }
+    }
+    _syncedVersion = ChangesGetVersion();
+    return true;
+}
+
+static void Sync(void)
+{
+    if (_checked && _syncedVersion == ChangesGetVersion()) return;
+    if (!_checked || !Refresh()) Check();
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+const SchemaReport *SchemaGetReport(void)
+{
+    Sync();
+    return &_report;
+}
+
+static int Append(char *text, int size, int length, const char *format, ...)
+{
+    if (length >= size - 1) return length;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text + length, (size_t)(size - length), format, args);
+    va_end(args);
+    if (written < 0) return length;
+    return (length + written < size - 1) ? length + written : size - 1;
+}
+
+void SchemaDescribeIssue(int issue, char *text, int size)
+{
+    if (size <= 0) return;
+    text[0] = '\0';
+    if (issue < 0 || issue >= _report.issueCount) return;
+
+    const Issue *found = &_issues[issue];
+    const SectionSchema *schema = &_schemas[found->section];
+    int length = Append(text, size, 0, "$.%s", schema->path);
+    if (found->index != NO_INDEX && !schema->single) length = Append(text, size, length, "[%d]", found->index);
+    if (found->field != NO_FIELD) length = Append(text, size, length, ".%s", schema->fields[found->field].key);
+    if (found->part != PART_NONE) length = Append(text, size, length, (found->part == PART_MIN) ? ".min" : ".max");
+    if (found->item != NO_ITEM) length = Append(text, size, length, "[%d]", found->item);
+
+    switch ((Problem)found->problem)
+    {
+        case PROBLEM_NOT_ARRAY: length = Append(text, size, length, ": is not an array"); break;
+        case PROBLEM_NOT_OBJECT: length = Append(text, size, length, ": is not an object"); break;
+        case PROBLEM_MISSING: length = Append(text, size, length, ": is missing"); break;
+        case PROBLEM_NOT_POINT: length = Append(text, size, length, ": is not an [x, y] array"); break;
+        case PROBLEM_POINT_LENGTH: length = Append(text, size, length, ": has %d items instead of 2", found->value); break;
+        case PROBLEM_NOT_NUMBER: length = Append(text, size, length, ": is not a number"); break;
+        case PROBLEM_NOT_STRING: length = Append(text, size, length, ": is not a string"); break;
+        case PROBLEM_NOT_WHOLE: length = Append(text, size, length, ": is not a whole number"); break;
+        case PROBLEM_OUT_OF_RANGE: length = Append(text, size, length, ": %d is not one of the %d regions", found->value, _regionCount); break;
+    }
+    if (found->quarantined) Append(text, size, length, " (quarantined)");
+}
+
+bool SchemaIsQuarantined(const cJSON *element)
+{
+    if (element == NULL) return false;
+    Sync();
+    if (_report.quarantinedCount == 0) return false;
+
+    return (PointerMapGet(&_flagged, PointerKey(element), 0) & FLAGGED_QUARANTINED) != 0;
+}
+
+void SchemaClear(void)
+{
+    PointerMapFree(&_flagged);
+    MemFree(_issues);
+    _issues = NULL;
+    _issueCapacity = 0;
+    _report = (SchemaReport){ 0 };
+    _checked = false;
+}
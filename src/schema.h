@@ -0,0 +1,56 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include "map_editor.h"
+
+#define SCHEMA_ISSUE_TEXT_SIZE 160
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Checks every element of the loaded config against a schema compiled into per-section
+// tables of fields: which are required, which must be [x, y] arrays of two numbers, strings
+// or region ids in range. Each element's members are walked once, in the same single pass
+// over the document that would draw it, and a problem is only turned into text when it is
+// printed, so a valid config is checked at parse speed.
+//
+// Elements whose points are broken are quarantined: they stay in the document, so exports
+// write them back untouched, but GetPointItemsJSON() and the draw functions skip them.
+// Problems that nothing would crash on, such as a region id out of range, are only reported.
+// After an edit only the changed elements are checked again; the whole pass runs again when
+// elements come and go or a changed element has or had a problem.
+
+typedef struct {
+    int elementCount;           // Elements checked
+    int issueCount;
+    int invalidCount;           // Elements with at least one issue
+    int quarantinedCount;
+} SchemaReport;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the counts of the loaded config, checking it again first if it changed.
+ */
+const SchemaReport *SchemaGetReport(void);
+
+/**
+ * @brief Writes an issue as its JSON path and the problem, such as
+ *        "$.structures[12].location[1]: is not a number".
+ * @param issue From 0 to issueCount - 1 of the report.
+ */
+void SchemaDescribeIssue(int issue, char *text, int size);
+
+/**
+ * @brief Whether an element (or world area object) is kept out of drawing and editing.
+ */
+bool SchemaIsQuarantined(const cJSON *element);
+
+/**
+ * @brief Frees the issues. Call when the document is replaced.
+ */
+void SchemaClear(void);
+
+#endif // SCHEMA_H
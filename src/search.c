@@ -0,0 +1,368 @@
+#include "search.h"
+#include "changes.h"
+#include "memtrack.h"
+#include "string_pool.h"
+#include "structure_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BUCKET_BITS 18
+#define BUCKET_COUNT (1 << BUCKET_BITS)
+#define MAX_CHANGED 4096        // Names changed in place before the table is built again
+#define BLOCK_BITS 6            // Sources per block signature, as a power of two
+
+// Sources are numbered structures first, then regions. Each bucket is an ascending list of the
+// sources with a gram in it, a source repeated when several of its grams are.
+typedef struct {
+    uint32_t *postings;
+    int *bucketStart;           // BUCKET_COUNT + 1 offsets into postings
+    uint32_t *names;            // String pool id each source was indexed under, 0 for none
+    uint64_t *signatures;       // Bit per character class in the name, to check short queries
+    uint64_t *blockSignatures;  // Signatures of each block of sources combined
+    uint16_t *changedSlot;      // 1 + position in the changed list, 0 for sources not in it
+    int postingCapacity;
+    int sourceCapacity;
+    int structureCount;
+    int sourceCount;
+    uint64_t builtGeneration;
+    uint64_t syncedVersion;     // Structure edits up to this version are in the index
+    bool built;
+} NameIndex;
+
+static NameIndex _index = { 0 };
+static int _changed[MAX_CHANGED];           // Structures whose names changed since the build
+static uint32_t _changedNames[MAX_CHANGED];
+static int _changedCount = 0;
+static uint64_t _namesVersion = 0;          // Bumped whenever a name may read differently
+
+static SearchResult _results[SEARCH_MAX_RESULTS];
+static int _resultCount = 0;
+static bool _truncated = false;
+static char _query[SEARCH_QUERY_SIZE] = "";
+static uint64_t _queryNamesVersion = 0;
+static bool _queried = false;
+
+//------------------------------------------------------------------------------------
+// Index
+//------------------------------------------------------------------------------------
+// ASCII only, so the bytes of UTF-8 names are compared as they are
+static unsigned char Fold(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+static uint32_t Bucket(uint32_t gram)
+{
+    return (gram * 2654435761u) >> (32 - BUCKET_BITS);
+}
+
+// Letters and digits get a bit each, the other bytes share the rest
+static uint64_t SignatureBit(unsigned char c)
+{
+    if (c >= 'a' && c <= 'z') return 1ull << (c - 'a');
+    if (c >= '0' && c <= '9') return 1ull << (26 + c - '0');
+    return 1ull << (36 + c % 28);
+}
+
+static bool Reserve(void **array, size_t elementSize, int count)
+{
+    void *resized = MemRealloc(*array, elementSize * (count > 0 ? count : 1));
+    if (resized == NULL) return false;
+    *array = resized;
+    return true;
+}
+
+static const char *SourceName(const StructureCache *cache, int source)
+{
+    return StringPoolGet(source < _index.structureCount ? cache->names[source] : _index.names[source]);
+}
+
+// Counts the grams of a name into their buckets, or lists the name in them when filling, and
+// returns its signature. The gram rolls along the name a byte at a time.
+static uint64_t IndexName(const unsigned char *text, uint32_t source, bool fill)
+{
+    uint64_t signature = 0;
+    uint32_t gram = 0;
+    for (int i = 0; text[i] != '\0'; i++)
+    {
+        unsigned char c = Fold(text[i]);
+        signature |= SignatureBit(c);
+        gram = (gram >> 8) | (uint32_t)c << 16;
+        if (i < 2) continue;
+
+        uint32_t bucket = Bucket(gram);
+        if (fill) _index.postings[--_index.bucketStart[bucket]] = source;
+        else _index.bucketStart[bucket]++;
+    }
+    return signature;
+}
+
+static bool Build(const StructureCache *cache)
+{
+    _changedCount = 0;
+    int regionCount = cJSON_GetArraySize(_regions);
+    int sources = cache->count + regionCount;
+    if (sources > _index.sourceCapacity)
+    {
+        if (!Reserve((void **)&_index.names, sizeof(uint32_t), sources) || !Reserve((void **)&_index.signatures, sizeof(uint64_t), sources) ||
+            !Reserve((void **)&_index.blockSignatures, sizeof(uint64_t), (sources >> BLOCK_BITS) + 1) || !Reserve((void **)&_index.changedSlot, sizeof(uint16_t), sources)) return false;
+        _index.sourceCapacity = sources;
+    }
+    if (_index.bucketStart == NULL && !Reserve((void **)&_index.bucketStart, sizeof(int), BUCKET_COUNT + 1)) return false;
+
+    _index.structureCount = cache->count;
+    _index.sourceCount = sources;
+    if (cache->count > 0) memcpy(_index.names, cache->names, sizeof(uint32_t) * cache->count);
+    memset(_index.changedSlot, 0, sizeof(uint16_t) * sources);
+    int id = 0;
+    cJSON *region = NULL;
+    cJSON_ArrayForEach(region, _regions)
+    {
+        bool named = cJSON_GetStringValue(cJSON_GetObjectItem(region, "name")) != NULL && id + 1 < cache->regionCount;
+        _index.names[cache->count + id] = named ? cache->regionNames[id + 1] : 0;
+        id++;
+    }
+
+    // Count the buckets of every name, then fill back to front so each bucket ends up ascending
+    // and bucketStart at its start
+    memset(_index.bucketStart, 0, sizeof(int) * (BUCKET_COUNT + 1));
+    memset(_index.blockSignatures, 0, sizeof(uint64_t) * ((sources >> BLOCK_BITS) + 1));
+    for (int source = 0; source < sources; source++)
+    {
+        _index.signatures[source] = IndexName((const unsigned char *)StringPoolGet(_index.names[source]), (uint32_t)source, false);
+        _index.blockSignatures[source >> BLOCK_BITS] |= _index.signatures[source];
+    }
+    int total = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+    {
+        total += _index.bucketStart[bucket];
+        _index.bucketStart[bucket] = total;
+    }
+    _index.bucketStart[BUCKET_COUNT] = total;
+    if (total > _index.postingCapacity)
+    {
+        if (!Reserve((void **)&_index.postings, sizeof(uint32_t), total)) return false;
+        _index.postingCapacity = total;
+    }
+    for (int source = sources - 1; source >= 0; source--) IndexName((const unsigned char *)StringPoolGet(_index.names[source]), (uint32_t)source, true);
+    return true;
+}
+
+static void Rebuild(const StructureCache *cache)
+{
+    _index.built = Build(cache);
+    _index.builtGeneration = cache->generation;
+    _index.syncedVersion = ChangesGetLayerVersion(LAYER_STRUCTURES);
+    _namesVersion++;
+}
+
+// Catches up with the structure cache: rebuilt when it was, else the names edited in place
+// since the last sync go to the changed list
+static bool Sync(void)
+{
+    const StructureCache *cache = GetStructureCache();
+    if (!_index.built || _index.builtGeneration != cache->generation || !ChangesComplete(_index.syncedVersion))
+    {
+        Rebuild(cache);
+        return _index.built;
+    }
+    uint64_t layerVersion = ChangesGetLayerVersion(LAYER_STRUCTURES);
+    if (_index.syncedVersion == layerVersion) return true;
+
+    ChangeIterator it = ChangesBegin(_index.syncedVersion);
+    ElementChange change;
+    while (ChangesNext(&it, &change))
+    {
+        if (change.layer != LAYER_STRUCTURES || change.index < 0 || change.index >= _index.structureCount) continue;
+
+        uint32_t name = cache->names[change.index];
+        int slot = _index.changedSlot[change.index];
+        if (slot > 0)
+        {
+            if (_changedNames[slot - 1] != name) _namesVersion++;
+            _changedNames[slot - 1] = name;
+            continue;
+        }
+        if (name == _index.names[change.index]) continue; // Moved, or another field changed
+
+        if (_changedCount == MAX_CHANGED)
+        {
+            Rebuild(cache);
+            return _index.built;
+        }
+        _changed[_changedCount] = change.index;
+        _changedNames[_changedCount] = name;
+        _changedCount++;
+        _index.changedSlot[change.index] = (uint16_t)_changedCount;
+        _namesVersion++;
+    }
+    _index.syncedVersion = layerVersion;
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------------
+static bool Contains(const char *name, const char *folded, int length)
+{
+    for (const unsigned char *start = (const unsigned char *)name; *start != '\0'; start++)
+    {
+        int i = 0;
+        while (i < length && Fold(start[i]) == (unsigned char)folded[i]) i++;
+        if (i == length) return true;
+    }
+    return false;
+}
+
+static void AddResult(int source)
+{
+    if (_resultCount == SEARCH_MAX_RESULTS)
+    {
+        _truncated = true;
+        return;
+    }
+    bool region = source >= _index.structureCount;
+    _results[_resultCount++] = (SearchResult){ region ? SEARCH_REGION : SEARCH_STRUCTURE, region ? source - _index.structureCount : source };
+}
+
+static int CompareResults(const void *a, const void *b)
+{
+    const SearchResult *left = a;
+    const SearchResult *right = b;
+    if (left->kind != right->kind) return (left->kind < right->kind) ? -1 : 1;
+    return (left->index > right->index) - (left->index < right->index);
+}
+
+static void Run(const char *folded, int length)
+{
+    _resultCount = 0;
+    _truncated = false;
+    if (length == 0 || !_index.built) return;
+
+    // Every match is in the shortest bucket of the query's grams. Shorter queries check the
+    // signatures of blocks of names and then of each name, ruling out most without reading them.
+    const StructureCache *cache = GetStructureCache();
+    const uint32_t *list = NULL;
+    int begin = 0;
+    int end = _index.sourceCount;
+    uint64_t signature = 0;
+    uint32_t gram = 0;
+    for (int i = 0; i < length; i++)
+    {
+        signature |= SignatureBit((unsigned char)folded[i]);
+        gram = (gram >> 8) | (uint32_t)(unsigned char)folded[i] << 16;
+        if (i < 2) continue;
+
+        uint32_t bucket = Bucket(gram);
+        if (list == NULL || _index.bucketStart[bucket + 1] - _index.bucketStart[bucket] < end - begin)
+        {
+            list = _index.postings;
+            begin = _index.bucketStart[bucket];
+            end = _index.bucketStart[bucket + 1];
+        }
+    }
+
+    for (int block = 0; list == NULL && (block << BLOCK_BITS) < _index.sourceCount && !_truncated; block++)
+    {
+        if ((_index.blockSignatures[block] & signature) != signature) continue;
+
+        int blockEnd = (block + 1) << BLOCK_BITS;
+        if (blockEnd > _index.sourceCount) blockEnd = _index.sourceCount;
+        for (int source = block << BLOCK_BITS; source < blockEnd && !_truncated; source++)
+        {
+            if ((_index.signatures[source] & signature) != signature) continue;
+            if (source < _index.structureCount && _index.changedSlot[source] != 0) continue;
+            if (Contains(SourceName(cache, source), folded, length)) AddResult(source);
+        }
+    }
+    for (int i = begin; list != NULL && i < end && !_truncated; i++)
+    {
+        int source = (int)list[i];
+        if (i > begin && list[i - 1] == list[i]) continue;
+        if (source < _index.structureCount && _index.changedSlot[source] != 0) continue;
+        if (Contains(SourceName(cache, source), folded, length)) AddResult(source);
+    }
+    for (int k = 0; k < _changedCount && !_truncated; k++)
+    {
+        if (Contains(SourceName(cache, _changed[k]), folded, length)) AddResult(_changed[k]);
+    }
+    if (_changedCount > 0) qsort(_results, _resultCount, sizeof(SearchResult), CompareResults);
+}
+
+const SearchResult *SearchFind(const char *query, int *count, bool *truncated)
+{
+    char folded[SEARCH_QUERY_SIZE];
+    int length = 0;
+    for (; query != NULL && query[length] != '\0' && length < SEARCH_QUERY_SIZE - 1; length++) folded[length] = (char)Fold((unsigned char)query[length]);
+    folded[length] = '\0';
+
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    Sync();
+    MemPopSubsystem();
+    if (!_queried || _queryNamesVersion != _namesVersion || strcmp(folded, _query) != 0)
+    {
+        Run(folded, length);
+        memcpy(_query, folded, length + 1);
+        _queryNamesVersion = _namesVersion;
+        _queried = true;
+    }
+
+    *count = _resultCount;
+    if (truncated != NULL) *truncated = _truncated;
+    return _results;
+}
+
+const char *SearchResultName(SearchResult result)
+{
+    const StructureCache *cache = GetStructureCache();
+    if (result.kind == SEARCH_STRUCTURE) return (result.index >= 0 && result.index < cache->count) ? StringPoolGet(cache->names[result.index]) : "";
+    return (result.index >= 0 && result.index + 1 < cache->regionCount) ? StringPoolGet(cache->regionNames[result.index + 1]) : "";
+}
+
+bool SearchResultPosition(SearchResult result, Vector2 *position)
+{
+    const StructureCache *cache = GetStructureCache();
+    if (result.kind == SEARCH_STRUCTURE)
+    {
+        if (result.index < 0 || result.index >= cache->count || cache->locations[result.index] == NULL) return false;
+        const cJSON *location = cache->locations[result.index];
+        *position = (Vector2){ (float)location->child->valuedouble, (float)location->child->next->valuedouble };
+        return true;
+    }
+
+    const cJSON *location = cJSON_GetObjectItem(cJSON_GetArrayItem(_regions, result.index), "location");
+    if (cJSON_GetArraySize(location) == 2 && cJSON_IsNumber(location->child) && cJSON_IsNumber(location->child->next))
+    {
+        *position = (Vector2){ (float)location->child->valuedouble, (float)location->child->next->valuedouble };
+        return true;
+    }
+
+    double sumX = 0.0;
+    double sumY = 0.0;
+    int members = 0;
+    for (int i = 0; i < cache->count; i++)
+    {
+        if (cache->regions[i] != result.index + 1 || cache->locations[i] == NULL) continue;
+        sumX += cache->locations[i]->child->valuedouble;
+        sumY += cache->locations[i]->child->next->valuedouble;
+        members++;
+    }
+    if (members == 0) return false;
+    *position = (Vector2){ (float)(sumX / members), (float)(sumY / members) };
+    return true;
+}
+
+void SearchClear(void)
+{
+    MemFree(_index.postings);
+    MemFree(_index.bucketStart);
+    MemFree(_index.names);
+    MemFree(_index.signatures);
+    MemFree(_index.blockSignatures);
+    MemFree(_index.changedSlot);
+    _index = (NameIndex){ 0 };
+    _changedCount = 0;
+    _resultCount = 0;
+    _truncated = false;
+    _queried = false;
+}
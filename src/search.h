@@ -0,0 +1,62 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "raylib.h"
+#include "map_editor.h"
+
+#define SEARCH_MAX_RESULTS 512  // Matches kept per query, as many as can be selected
+#define SEARCH_QUERY_SIZE 64
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Finds structures and regions by a part of their name, ignoring case. Every name is split
+// into its three-letter grams, and the names holding each gram are listed in one bucket of a
+// hashed table built in two passes over the structure cache. A query reads only the shortest
+// bucket of its own grams and checks those names, so a keystroke costs microseconds with
+// millions of names. Shorter queries first test a bitmask of the characters in each block of
+// 64 names and then in each name, so only names holding all their characters are read.
+//
+// Names edited in place, by a live reload or a merge, are kept in a short list that every
+// query also checks, and their old entries are skipped, until structures are added or
+// removed and the table is built again anyway.
+
+typedef enum {
+    SEARCH_STRUCTURE = 0,
+    SEARCH_REGION               // An entry of "regions", which structures refer to by region_id
+} SearchKind;
+
+typedef struct {
+    SearchKind kind;
+    int index;
+} SearchResult;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the structures and regions whose name contains the query, structures first,
+ *        each in document order. Repeating a query is free until names change.
+ * @param truncated Set when there are more than SEARCH_MAX_RESULTS matches. May be NULL.
+ */
+const SearchResult *SearchFind(const char *query, int *count, bool *truncated);
+
+/**
+ * @brief Returns the name of a result. Valid until the next search or edit.
+ */
+const char *SearchResultName(SearchResult result);
+
+/**
+ * @brief Returns where to look at a result: a structure's location, a region's "location" or
+ *        else the centre of its structures.
+ * @return false if it has neither.
+ */
+bool SearchResultPosition(SearchResult result, Vector2 *position);
+
+/**
+ * @brief Frees the index. Call when the document is replaced.
+ */
+void SearchClear(void);
+
+#endif // SEARCH_H
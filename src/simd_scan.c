@@ -0,0 +1,264 @@
+#include "simd_scan.h"
+#include <stdbool.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define SIMD_SCAN_SSE2 1
+#include <emmintrin.h>
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+typedef size_t (*ScanFunction)(const unsigned char *text, size_t length);
+
+typedef struct {
+    ScanFunction skipSpace;
+    ScanFunction findQuoteOrBackslash;
+    ScanFunction findEscape;
+} ScanFunctions;
+
+//------------------------------------------------------------------------------------
+// Scalar
+//------------------------------------------------------------------------------------
+static size_t SkipSpaceScalar(const unsigned char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] <= 0x20) i++;
+    return i;
+}
+
+static size_t FindQuoteOrBackslashScalar(const unsigned char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] != '"' && text[i] != '\\') i++;
+    return i;
+}
+
+static size_t FindEscapeScalar(const unsigned char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] >= 0x20 && text[i] != '"' && text[i] != '\\') i++;
+    return i;
+}
+
+static const ScanFunctions _scalar = { SkipSpaceScalar, FindQuoteOrBackslashScalar, FindEscapeScalar };
+
+//------------------------------------------------------------------------------------
+// SSE2, 16 bytes per step
+//------------------------------------------------------------------------------------
+#if defined(SIMD_SCAN_SSE2)
+// Unsigned a <= limit for every byte, as min(a, limit) == a
+#define SSE2_AT_MOST(v, limit) _mm_cmpeq_epi8(_mm_min_epu8((v), (limit)), (v))
+
+static size_t SkipSpaceSse2(const unsigned char *text, size_t length)
+{
+    const __m128i space = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(SSE2_AT_MOST(v, space)) & 0xFFFFu;
+        if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + SkipSpaceScalar(text + i, length - i);
+}
+
+static size_t FindQuoteOrBackslashSse2(const unsigned char *text, size_t length)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + FindQuoteOrBackslashScalar(text + i, length - i);
+}
+
+static size_t FindEscapeSse2(const unsigned char *text, size_t length)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)), SSE2_AT_MOST(v, control));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask != 0) return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + FindEscapeScalar(text + i, length - i);
+}
+
+static const ScanFunctions _sse2 = { SkipSpaceSse2, FindQuoteOrBackslashSse2, FindEscapeSse2 };
+#endif
+
+//------------------------------------------------------------------------------------
+// AVX2, 32 bytes per step
+//------------------------------------------------------------------------------------
+// Only the vector loops are compiled for AVX2. They report a match or where they stopped and
+// the SSE2 code finishes the tail, and short inputs never touch the 256-bit registers at all,
+// as mixing them with SSE code in one function costs more than a short scan saves.
+#if defined(SIMD_SCAN_AVX2)
+#define AVX2_AT_MOST(v, limit) _mm256_cmpeq_epi8(_mm256_min_epu8((v), (limit)), (v))
+
+__attribute__((target("avx2")))
+static bool SkipSpaceAvx2Blocks(const unsigned char *text, size_t length, size_t *index)
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(AVX2_AT_MOST(v, space));
+        if (mask != 0)
+        {
+            *index = i + (size_t)__builtin_ctz(mask);
+            return true;
+        }
+    }
+    *index = i;
+    return false;
+}
+
+__attribute__((target("avx2")))
+static bool FindQuoteOrBackslashAvx2Blocks(const unsigned char *text, size_t length, size_t *index)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        if (mask != 0)
+        {
+            *index = i + (size_t)__builtin_ctz(mask);
+            return true;
+        }
+    }
+    *index = i;
+    return false;
+}
+
+__attribute__((target("avx2")))
+static bool FindEscapeAvx2Blocks(const unsigned char *text, size_t length, size_t *index)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)), AVX2_AT_MOST(v, control));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        if (mask != 0)
+        {
+            *index = i + (size_t)__builtin_ctz(mask);
+            return true;
+        }
+    }
+    *index = i;
+    return false;
+}
+
+// Below this many bytes the SSE2 loop alone is faster
+#define AVX2_MIN_LENGTH 256
+
+static size_t SkipSpaceAvx2(const unsigned char *text, size_t length)
+{
+    size_t i = 0;
+    if (length >= AVX2_MIN_LENGTH && SkipSpaceAvx2Blocks(text, length, &i)) return i;
+    return i + SkipSpaceSse2(text + i, length - i);
+}
+
+static size_t FindQuoteOrBackslashAvx2(const unsigned char *text, size_t length)
+{
+    size_t i = 0;
+    if (length >= AVX2_MIN_LENGTH && FindQuoteOrBackslashAvx2Blocks(text, length, &i)) return i;
+    return i + FindQuoteOrBackslashSse2(text + i, length - i);
+}
+
+static size_t FindEscapeAvx2(const unsigned char *text, size_t length)
+{
+    size_t i = 0;
+    if (length >= AVX2_MIN_LENGTH && FindEscapeAvx2Blocks(text, length, &i)) return i;
+    return i + FindEscapeSse2(text + i, length - i);
+}
+
+static const ScanFunctions _avx2 = { SkipSpaceAvx2, FindQuoteOrBackslashAvx2, FindEscapeAvx2 };
+#endif
+
+//------------------------------------------------------------------------------------
+// Dispatch
+//------------------------------------------------------------------------------------
+#if defined(SIMD_SCAN_SSE2)
+static const ScanFunctions *_functions = &_sse2;
+static SimdLevel _level = SIMD_LEVEL_SSE2;
+#else
+static const ScanFunctions *_functions = &_scalar;
+static SimdLevel _level = SIMD_LEVEL_SCALAR;
+#endif
+
+void SimdScanInit(void)
+{
+    SimdScanSetLevel(SIMD_LEVEL_AVX2);
+}
+
+SimdLevel SimdScanSetLevel(SimdLevel level)
+{
+#if defined(SIMD_SCAN_AVX2)
+    __builtin_cpu_init();
+    if (level >= SIMD_LEVEL_AVX2 && __builtin_cpu_supports("avx2"))
+    {
+        _functions = &_avx2;
+        return _level = SIMD_LEVEL_AVX2;
+    }
+#endif
+#if defined(SIMD_SCAN_SSE2)
+    if (level >= SIMD_LEVEL_SSE2)
+    {
+        _functions = &_sse2;
+        return _level = SIMD_LEVEL_SSE2;
+    }
+#endif
+    _functions = &_scalar;
+    return _level = SIMD_LEVEL_SCALAR;
+}
+
+SimdLevel SimdScanGetLevel(void)
+{
+    return _level;
+}
+
+const char *SimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+        case SIMD_LEVEL_SSE2: return "sse2";
+        case SIMD_LEVEL_AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+size_t SimdSkipSpace(const unsigned char *text, size_t length)
+{
+    return _functions->skipSpace(text, length);
+}
+
+size_t SimdFindQuoteOrBackslash(const unsigned char *text, size_t length)
+{
+    return _functions->findQuoteOrBackslash(text, length);
+}
+
+size_t SimdFindEscape(const unsigned char *text, size_t length)
+{
+    return _functions->findEscape(text, length);
+}
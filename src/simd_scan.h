@@ -0,0 +1,57 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Byte scanning primitives used by the cJSON parser and printer. Each has a scalar, an SSE2
+// and an AVX2 version with identical results; the fastest one the CPU supports is used.
+
+typedef enum {
+    SIMD_LEVEL_SCALAR = 0,
+    SIMD_LEVEL_SSE2,
+    SIMD_LEVEL_AVX2,
+    SIMD_LEVEL_COUNT
+} SimdLevel;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Selects the best level the CPU supports. Call once at startup, before any threads run.
+ *        Without it the baseline level of the target (SSE2 on x86-64, else scalar) is used.
+ */
+void SimdScanInit(void);
+
+/**
+ * @brief Forces a level, e.g. to compare levels. Levels the CPU or compiler lacks are clamped.
+ * @return The level now in use.
+ */
+SimdLevel SimdScanSetLevel(SimdLevel level);
+
+/**
+ * @brief Returns the level in use and its display name.
+ */
+SimdLevel SimdScanGetLevel(void);
+const char *SimdLevelName(SimdLevel level);
+
+/**
+ * @brief Returns the number of leading bytes that are whitespace to cJSON (any byte <= 0x20).
+ */
+size_t SimdSkipSpace(const unsigned char *text, size_t length);
+
+/**
+ * @brief Returns the index of the first '"' or '\\', or length if there is none.
+ */
+size_t SimdFindQuoteOrBackslash(const unsigned char *text, size_t length);
+
+/**
+ * @brief Returns the index of the first byte that must be escaped in a JSON string
+ *        ('"', '\\' or a control character below 0x20), or length if there is none.
+ */
+size_t SimdFindEscape(const unsigned char *text, size_t length);
+
+#endif // SIMD_SCAN_H
@@ -0,0 +1,76 @@
+#include "snapping.h"
+#include "picking.h"
+#include <math.h>
+
+#define POINT_REACH 12.0f       // Pixels within which a point lands on another
+#define ALIGN_TOLERANCE 6.0f    // Pixels an axis may be off to line up
+#define ALIGN_RANGE 600.0f      // Pixels along the other axis to look for a point to line up with
+#define TARGET_RADIUS 8
+
+static float _gridSpacing = DEFAULT_SNAP_GRID;
+
+//------------------------------------------------------------------------------------
+// Snapping
+//------------------------------------------------------------------------------------
+void SnapSetGrid(float spacing)
+{
+    _gridSpacing = (spacing > 0.0f) ? spacing : 0.0f;
+}
+
+SnapResult SnapPoint(float x, float y, float displayScale, uint32_t layerMask, const PointRef *dragged, int draggedCount, int modes)
+{
+    SnapResult snap = { 0 };
+    snap.x = x;
+    snap.y = y;
+
+    if (modes & SNAP_POINTS)
+    {
+        PointRef target;
+        if (PickNearestExcluding(x, y, POINT_REACH / displayScale, layerMask, dragged, draggedCount, &target, &snap.point))
+        {
+            snap.x = snap.point.x;
+            snap.y = snap.point.y;
+            snap.snappedX = true;
+            snap.snappedY = true;
+            snap.toPoint = true;
+            return snap;
+        }
+    }
+
+    if (modes & SNAP_ALIGN)
+    {
+        float tolerance = ALIGN_TOLERANCE / displayScale;
+        float range = ALIGN_RANGE / displayScale;
+        snap.alignedX = PickAligned(x, y, true, tolerance, range, layerMask, dragged, draggedCount, &snap.alignX);
+        snap.alignedY = PickAligned(x, y, false, tolerance, range, layerMask, dragged, draggedCount, &snap.alignY);
+        if (snap.alignedX) { snap.x = snap.alignX.x; snap.snappedX = true; }
+        if (snap.alignedY) { snap.y = snap.alignY.y; snap.snappedY = true; }
+    }
+
+    if ((modes & SNAP_GRID) && _gridSpacing > 0.0f)
+    {
+        if (!snap.snappedX) { snap.x = roundf(x / _gridSpacing) * _gridSpacing; snap.snappedX = true; }
+        if (!snap.snappedY) { snap.y = roundf(y / _gridSpacing) * _gridSpacing; snap.snappedY = true; }
+    }
+    return snap;
+}
+
+void SnapDrawGuides(const SnapResult *snap, Vector2 cameraOffset, float displayScale)
+{
+    Vector2 at = { snap->x * displayScale + cameraOffset.x, -snap->y * displayScale + cameraOffset.y };
+    if (snap->toPoint)
+    {
+        DrawCircleLines((int)at.x, (int)at.y, TARGET_RADIUS, MAGENTA);
+        return;
+    }
+    if (snap->alignedX)
+    {
+        Vector2 from = { snap->alignX.x * displayScale + cameraOffset.x, -snap->alignX.y * displayScale + cameraOffset.y };
+        DrawLineV(from, at, MAGENTA);
+    }
+    if (snap->alignedY)
+    {
+        Vector2 from = { snap->alignY.x * displayScale + cameraOffset.x, -snap->alignY.y * displayScale + cameraOffset.y };
+        DrawLineV(from, at, MAGENTA);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef SNAPPING_H
+#define SNAPPING_H
+
+#include "raylib.h"
+#include "map_editor.h"
+
+#define DEFAULT_SNAP_GRID 50.0f // World units between grid lines
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Snaps the point being dragged while it moves. A point within a few pixels of another
+// element's point lands on it; otherwise each axis lines up with the nearest point that has
+// (almost) the same x or y, and an axis left free rounds to the grid. The queries go through
+// the picking index and only read the grid cells around the point or along one thin strip, so
+// they take microseconds every drag frame however large the map is. The points of the dragged
+// elements are skipped so a drag never snaps to itself.
+
+typedef enum {
+    SNAP_GRID = 1 << 0,
+    SNAP_POINTS = 1 << 1,
+    SNAP_ALIGN = 1 << 2
+} SnapMode;
+
+typedef struct {
+    float x;                    // Snapped position, config coordinates
+    float y;
+    bool snappedX;              // Whether x was changed by a snap
+    bool snappedY;
+    bool toPoint;               // Landed on another element's point
+    Vector2 point;
+    bool alignedX;              // x lined up with the point at alignX
+    Vector2 alignX;
+    bool alignedY;              // y lined up with the point at alignY
+    Vector2 alignY;
+} SnapResult;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Sets the grid spacing in world units. 0 turns the grid off.
+ */
+void SnapSetGrid(float spacing);
+
+/**
+ * @brief Snaps a dragged point.
+ * @param displayScale Screen pixels per world unit; the snap reaches are in pixels.
+ * @param layerMask Bit (1 << layer) set for each EditLayer that can be snapped to.
+ * @param dragged Points of the elements being dragged, which are never snapped to.
+ * @param modes SnapMode bits.
+ */
+SnapResult SnapPoint(float x, float y, float displayScale, uint32_t layerMask, const PointRef *dragged, int draggedCount, int modes);
+
+/**
+ * @brief Draws the alignment lines and the target of a snap.
+ */
+void SnapDrawGuides(const SnapResult *snap, Vector2 cameraOffset, float displayScale);
+
+#endif // SNAPPING_H
@@ -1,102 +1,19 @@
 #include "cJSON.h"
 #include "raylib.h"
 #include "snow_region.h"
+#include "undo.h"
+#include "schema.h"
 
-void UpdateSnowRegions(cJSON *snow_regions, Vector2 cameraOffset, float *displayScale)
-{
-    Vector2 mouse = GetMousePosition();
-
-    // Transform the mouse position to take into acount the moved camera
-    Vector2 transformedMouse = {mouse.x - cameraOffset.x, mouse.y - cameraOffset.y};
-
-    cJSON *snow_region = NULL;
-    cJSON_ArrayForEach(snow_region, snow_regions)
-    {
-        cJSON *bounds = cJSON_GetObjectItem(snow_region, "bounds");
-        if (bounds != NULL)
-        {
-            cJSON *min = cJSON_GetObjectItem(bounds, "min");
-            cJSON *max = cJSON_GetObjectItem(bounds, "max");
-
-            int min_x = cJSON_GetArrayItem(min, 0)->valueint;
-            int min_y = cJSON_GetArrayItem(min, 1)->valueint;
-
-            int max_x = cJSON_GetArrayItem(max, 0)->valueint;
-            int max_y = cJSON_GetArrayItem(max, 1)->valueint;
-
-            Vector2 topLeft = {min_x * *displayScale, -(max_y * *displayScale)};
-            Vector2 topRight = {max_x * *displayScale, -(max_y * *displayScale)};
-            Vector2 bottomLeft = {min_x * *displayScale, -(min_y * *displayScale)};
-            Vector2 bottomRight = {max_x * *displayScale, -(min_y * *displayScale)};
-
-            // Transform the mouse position to take into acount the moved camera
-            Vector2 transformedMouse = {mouse.x - cameraOffset.x, mouse.y - cameraOffset.y};
-
-            // Set active structure if we hover over it
-            if (CheckCollisionPointCircle(transformedMouse, topLeft, 15.0f))
-            {
-                if (IsMouseButtonDown(MOUSE_LEFT_BUTTON))
-                {
-                    topLeft = transformedMouse;
-                    min_x = (int)(topLeft.x / *displayScale);
-                    max_y = -(int)(topLeft.y / *displayScale);
-                }
-            }
-
-            if (CheckCollisionPointCircle(transformedMouse, topRight, 15.0f))
-            {
-                if (IsMouseButtonDown(MOUSE_LEFT_BUTTON))
-                {
-                    topRight = transformedMouse;
-                    max_x = (int)(topRight.x / *displayScale);
-                    max_y = -(int)(topRight.y / *displayScale);
-                }
-            }
-
-            if (CheckCollisionPointCircle(transformedMouse, bottomLeft, 15.0f))
-            {
-                if (IsMouseButtonDown(MOUSE_LEFT_BUTTON))
-                {
-                    bottomLeft = transformedMouse;
-                    min_x = (int)(bottomLeft.x / *displayScale);
-                    min_y = -(int)(bottomLeft.y / *displayScale);
-                }
-            }
-
-            if (CheckCollisionPointCircle(transformedMouse, bottomRight, 15.0f))
-            {
-                if (IsMouseButtonDown(MOUSE_LEFT_BUTTON))
-                {
-                    bottomRight = transformedMouse;
-                    max_x = (int)(bottomRight.x / *displayScale);
-                    min_y = -(int)(bottomRight.y / *displayScale);
-                }
-            }
-
-            cJSON *new_min = cJSON_CreateIntArray((int[]){min_x, min_y}, 2);
-            cJSON *new_max = cJSON_CreateIntArray((int[]){max_x, max_y}, 2);
-            if (!cJSON_ReplaceItemInObjectCaseSensitive(bounds, "min", new_min))
-            {
-                printf("Error moving snow region point!");
-                return;
-            }
-            if (!cJSON_ReplaceItemInObjectCaseSensitive(bounds, "max", new_max))
-            {
-                printf("Error moving snow region point!");
-                return;
-            }
-        }
-    }
-}
-
-void DrawSnowRegions(cJSON *snow_regions, Vector2 _cameraOffset, float *_displayScale, char *headerText)
+void DrawSnowRegions(cJSON *snow_regions, EditLayer layer, Vector2 _cameraOffset, float *_displayScale, char *headerText)
 {
     // Draw the snow regions
     cJSON *snow_region = NULL;
+    int regionIndex = -1;
     cJSON_ArrayForEach(snow_region, snow_regions)
     {
+        regionIndex++;
         cJSON *bounds = cJSON_GetObjectItem(snow_region, "bounds");
-        if (bounds != NULL)
+        if (bounds != NULL && !SchemaIsQuarantined(snow_region))
         {
             cJSON *min = cJSON_GetObjectItem(bounds, "min");
             cJSON *max = cJSON_GetObjectItem(bounds, "max");
@@ -110,16 +27,22 @@ void DrawSnowRegions(cJSON *snow_regions, Vector2 _cameraOffset, float *_display
             // Snow Region Label
             DrawText(headerText, (min_x + 20) * *_displayScale + _cameraOffset.x, -((max_y - 15) * *_displayScale) + _cameraOffset.y, 20, BLUE);
             DrawRectangleLinesEx((Rectangle){min_x * *_displayScale + _cameraOffset.x, -(max_y * *_displayScale) + _cameraOffset.y, (max_x - min_x) * *_displayScale, (max_y - min_y) * *_displayScale}, 2, BLUE);
-            DrawCircle((min_x + 8) * *_displayScale + _cameraOffset.x, -((max_y - 5) * *_displayScale) + _cameraOffset.y, 10, BLUE);
-            DrawCircle((min_x + 8) * *_displayScale + _cameraOffset.x, -((min_y - 5) * *_displayScale) + _cameraOffset.y, 10, BLUE);
-            DrawCircle((max_x - 8) * *_displayScale + _cameraOffset.x, -((max_y - 5) * *_displayScale) + _cameraOffset.y, 10, BLUE);
-            DrawCircle((max_x - 8) * *_displayScale + _cameraOffset.x, -((min_y - 5) * *_displayScale) + _cameraOffset.y, 10, BLUE);
+            SelectedItem corner = { regionIndex, ELEMENT_TYPE_BOUNDS_CORNER, { 0 }, { 0 }, layer, POINT_FIELD_MIN_MAX };
+            DrawCircle((min_x + 8) * *_displayScale + _cameraOffset.x, -((max_y - 5) * *_displayScale) + _cameraOffset.y, 10, GetHandleColor(corner, BLUE));
+            corner.corner = POINT_FIELD_MIN_MIN;
+            DrawCircle((min_x + 8) * *_displayScale + _cameraOffset.x, -((min_y - 5) * *_displayScale) + _cameraOffset.y, 10, GetHandleColor(corner, BLUE));
+            corner.corner = POINT_FIELD_MAX_MAX;
+            DrawCircle((max_x - 8) * *_displayScale + _cameraOffset.x, -((max_y - 5) * *_displayScale) + _cameraOffset.y, 10, GetHandleColor(corner, BLUE));
+            corner.corner = POINT_FIELD_MAX_MIN;
+            DrawCircle((max_x - 8) * *_displayScale + _cameraOffset.x, -((min_y - 5) * *_displayScale) + _cameraOffset.y, 10, GetHandleColor(corner, BLUE));
         }
     }
 }
 
-void AddSnowRegion(cJSON *snow_regions)
+void AddSnowRegion(cJSON *snow_regions, EditLayer layer)
 {
+    if (!snow_regions) return;
+
     cJSON *new_snow_region = cJSON_CreateObject();
 
     // Create a new min and max array at the center of the screen
@@ -133,4 +56,5 @@ void AddSnowRegion(cJSON *snow_regions)
     cJSON_AddItemToObject(new_snow_region, "bounds", new_bounds);
 
     cJSON_AddItemToArray(snow_regions, new_snow_region);
+    UndoRecordAdd(layer, cJSON_GetArraySize(snow_regions) - 1);
 }
\ No newline at end of file
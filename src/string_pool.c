@@ -0,0 +1,102 @@
+#include "string_pool.h"
+#include "memtrack.h"
+#include <stdbool.h>
+#include <string.h>
+
+// Ids are byte offsets into _text. Offset 0 holds the empty string.
+static char *_text = NULL;
+static size_t _textSize = 0;
+static size_t _textCapacity = 0;
+
+// Open addressing set of ids, keyed by the string they name
+static uint32_t *_ids = NULL;       // UINT32_MAX marks an empty slot
+static size_t _idCapacity = 0;      // Power of two
+static size_t _idCount = 0;
+
+static uint64_t HashText(const char *text, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)text[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+static bool GrowIds(void)
+{
+    size_t capacity = (_idCapacity == 0) ? 1024 : _idCapacity * 2;
+    uint32_t *ids = MemAlloc(capacity * sizeof(uint32_t));
+    if (ids == NULL) return false;
+    memset(ids, 0xff, capacity * sizeof(uint32_t));
+
+    for (size_t i = 0; i < _idCapacity; i++)
+    {
+        if (_ids[i] == UINT32_MAX) continue;
+        const char *text = _text + _ids[i];
+        size_t slot = HashText(text, strlen(text)) & (capacity - 1);
+        while (ids[slot] != UINT32_MAX) slot = (slot + 1) & (capacity - 1);
+        ids[slot] = _ids[i];
+    }
+    MemFree(_ids);
+    _ids = ids;
+    _idCapacity = capacity;
+    return true;
+}
+
+static bool ReserveText(size_t size)
+{
+    if (_textSize + size <= _textCapacity) return true;
+
+    size_t capacity = (_textCapacity == 0) ? 64 * 1024 : _textCapacity;
+    while (capacity < _textSize + size) capacity *= 2;
+    if (capacity > UINT32_MAX) return false;
+
+    char *text = MemRealloc(_text, capacity);
+    if (text == NULL) return false;
+    _text = text;
+    _textCapacity = capacity;
+    return true;
+}
+
+uint32_t StringPoolIntern(const char *text)
+{
+    if (text == NULL || text[0] == '\0') return 0;
+    if (_text == NULL)
+    {
+        if (!ReserveText(1)) return 0;
+        _text[_textSize++] = '\0';
+    }
+    if ((_idCount + 1) * 2 > _idCapacity && !GrowIds()) return 0;
+
+    size_t length = strlen(text);
+    size_t slot = HashText(text, length) & (_idCapacity - 1);
+    while (_ids[slot] != UINT32_MAX)
+    {
+        if (strcmp(_text + _ids[slot], text) == 0) return _ids[slot];
+        slot = (slot + 1) & (_idCapacity - 1);
+    }
+
+    if (!ReserveText(length + 1)) return 0;
+    uint32_t id = (uint32_t)_textSize;
+    memcpy(_text + _textSize, text, length + 1);
+    _textSize += length + 1;
+    _ids[slot] = id;
+    _idCount++;
+    return id;
+}
+
+const char *StringPoolGet(uint32_t id)
+{
+    if (_text == NULL || id >= _textSize) return "";
+    return _text + id;
+}
+
+void StringPoolClear(void)
+{
+    MemFree(_text);
+    MemFree(_ids);
+    _text = NULL;
+    _textSize = 0;
+    _textCapacity = 0;
+    _ids = NULL;
+    _idCapacity = 0;
+    _idCount = 0;
+}
@@ -0,0 +1,28 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+// Interned strings stored back to back in one buffer. Equal strings share one copy and
+// one id, so tables can hold 32-bit ids instead of pointers into the document.
+
+/**
+ * @brief Returns the id of text, copying it into the pool the first time it is seen.
+ * @return The id, or 0 (the empty string) if text is NULL or the pool is out of memory.
+ */
+uint32_t StringPoolIntern(const char *text);
+
+/**
+ * @brief Returns the interned string for an id. Valid until the next StringPoolIntern() or StringPoolClear().
+ */
+const char *StringPoolGet(uint32_t id);
+
+/**
+ * @brief Frees every interned string, e.g. when the document is reloaded.
+ */
+void StringPoolClear(void);
+
+#endif // STRING_POOL_H
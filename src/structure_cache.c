@@ -0,0 +1,153 @@
+#include "structure_cache.h"
+#include "map_editor.h"
+#include "changes.h"
+#include "string_pool.h"
+#include "memtrack.h"
+#include <ctype.h>
+
+static StructureCache _cache = { 0 };
+static int _capacity = 0;
+static int _regionCapacity = 0;
+static const cJSON *_builtStructures = NULL;
+static const cJSON *_builtRegions = NULL;
+static uint64_t _builtVersion = 0;
+static uint64_t _syncedVersion = 0;    // Structure edits up to this version are in the cache
+static bool _built = false;
+static uint64_t _generation = 0;       // Kept across clears, so a generation is never reused
+
+static const Color _regionColors[] = { PINK, ORANGE, SKYBLUE, PURPLE, BROWN, BEIGE, VIOLET, GOLD, LIME };
+#define REGION_COLOR_COUNT (int)(sizeof(_regionColors) / sizeof(_regionColors[0]))
+
+// Case-insensitive like cJSON_GetObjectItem()
+static bool KeyEquals(const char *key, const char *name)
+{
+    if (key == NULL) return false;
+    while (*key != '\0' && tolower((unsigned char)*key) == *name) { key++; name++; }
+    return *key == '\0' && *name == '\0';
+}
+
+static bool Reserve(void **array, size_t elementSize, int count)
+{
+    void *resized = MemRealloc(*array, elementSize * (count > 0 ? count : 1));
+    if (resized == NULL) return false;
+    *array = resized;
+    return true;
+}
+
+static bool BuildRegions(void)
+{
+    int regionArrayCount = cJSON_GetArraySize(_regions);
+    int count = 1 + (regionArrayCount > REGION_COLOR_COUNT ? regionArrayCount : REGION_COLOR_COUNT);
+    if (count > _regionCapacity)
+    {
+        if (!Reserve((void **)&_cache.regionNames, sizeof(uint32_t), count)) return false;
+        if (!Reserve((void **)&_cache.regionColors, sizeof(Color), count)) return false;
+        _regionCapacity = count;
+    }
+
+    uint32_t noRegion = StringPoolIntern("No Region");
+    for (int i = 0; i < count; i++)
+    {
+        _cache.regionNames[i] = noRegion;
+        _cache.regionColors[i] = (i > 0 && i <= REGION_COLOR_COUNT) ? _regionColors[i - 1] : GREEN;
+    }
+
+    int id = 0;
+    cJSON *region = NULL;
+    cJSON_ArrayForEach(region, _regions)
+    {
+        const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(region, "name"));
+        if (name) _cache.regionNames[id + 1] = StringPoolIntern(name);
+        id++;
+    }
+    _cache.regionCount = count;
+    return true;
+}
+
+static void CacheStructure(int i, const cJSON *structure)
+{
+    // One walk over the members instead of a lookup per field
+    cJSON *location = NULL;
+    cJSON *name = NULL;
+    cJSON *regionId = NULL;
+    for (cJSON *member = structure->child; member != NULL; member = member->next)
+    {
+        if (location == NULL && KeyEquals(member->string, "location")) location = member;
+        else if (name == NULL && KeyEquals(member->string, "name")) name = member;
+        else if (regionId == NULL && KeyEquals(member->string, "region_id")) regionId = member;
+    }
+
+    _cache.locations[i] = (location && location->child && location->child->next) ? location : NULL;
+    _cache.names[i] = StringPoolIntern(cJSON_GetStringValue(name));
+
+    int region = 0;
+    if (regionId && regionId->valueint >= 0 && regionId->valueint + 1 < _cache.regionCount) region = regionId->valueint + 1;
+    _cache.regions[i] = region;
+}
+
+static bool BuildStructures(void)
+{
+    int count = cJSON_GetArraySize(_structures);
+    if (count > _capacity)
+    {
+        if (!Reserve((void **)&_cache.locations, sizeof(cJSON *), count)) return false;
+        if (!Reserve((void **)&_cache.names, sizeof(uint32_t), count)) return false;
+        if (!Reserve((void **)&_cache.regions, sizeof(int), count)) return false;
+        _capacity = count;
+    }
+
+    int i = 0;
+    cJSON *structure = NULL;
+    cJSON_ArrayForEach(structure, _structures) CacheStructure(i++, structure);
+    _cache.count = i;
+    return true;
+}
+
+const StructureCache *GetStructureCache(void)
+{
+    uint64_t version = ChangesGetStructureVersion(LAYER_STRUCTURES);
+    uint64_t layerVersion = ChangesGetLayerVersion(LAYER_STRUCTURES);
+    if (_built && _builtStructures == _structures && _builtRegions == _regions && _builtVersion == version && ChangesComplete(_syncedVersion))
+    {
+        // Structures edited in place are refreshed one by one, as a live reload may replace their members
+        if (_syncedVersion != layerVersion)
+        {
+            MemPushSubsystem(MEM_SUBSYSTEM_DRAW);
+            ChangeIterator it = ChangesBegin(_syncedVersion);
+            ElementChange change;
+            while (ChangesNext(&it, &change))
+            {
+                if (change.layer == LAYER_STRUCTURES && change.index >= 0 && change.index < _cache.count) CacheStructure(change.index, change.element);
+            }
+            _syncedVersion = layerVersion;
+            MemPopSubsystem();
+        }
+        return &_cache;
+    }
+
+    MemPushSubsystem(MEM_SUBSYSTEM_DRAW);
+    _cache.count = 0;
+    _built = BuildRegions() && BuildStructures();
+    if (!_built) _cache.count = 0;
+    _cache.generation = ++_generation;
+    _builtStructures = _structures;
+    _builtRegions = _regions;
+    _builtVersion = version;
+    _syncedVersion = layerVersion;
+    MemPopSubsystem();
+    return &_cache;
+}
+
+void StructureCacheClear(void)
+{
+    MemFree(_cache.locations);
+    MemFree(_cache.names);
+    MemFree(_cache.regions);
+    MemFree(_cache.regionNames);
+    MemFree(_cache.regionColors);
+    _cache = (StructureCache){ 0 };
+    _capacity = 0;
+    _regionCapacity = 0;
+    _built = false;
+    StringPoolClear();
+}
@@ -0,0 +1,41 @@
+#ifndef STRUCTURE_CACHE_H
+#define STRUCTURE_CACHE_H
+
+#include "cJSON.h"
+#include "raylib.h"
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+// Draw data of all structures in dense arrays, resolved once instead of per frame.
+// Region 0 stands for "no region"; region id r is stored as r + 1.
+
+typedef struct {
+    int count;
+    cJSON **locations;      // The [x, y] arrays, edited in place so positions stay live
+    uint32_t *names;        // String pool ids
+    int *regions;           // Indices into regionNames / regionColors
+    int regionCount;
+    uint32_t *regionNames;  // String pool ids
+    Color *regionColors;
+    uint64_t generation;    // Changes on every rebuild, after which indices and string ids may differ
+} StructureCache;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the draw data of the current structures, rebuilding it if structures
+ *        were added or removed or the document was reloaded since the last call, and
+ *        refreshing the entries of structures that changed in place.
+ */
+const StructureCache *GetStructureCache(void);
+
+/**
+ * @brief Frees the cache and the interned strings.
+ */
+void StructureCacheClear(void);
+
+#endif // STRUCTURE_CACHE_H
@@ -0,0 +1,464 @@
+#include "undo.h"
+#include "edit_ops.h"
+#include "journal.h"
+#include "handles.h"
+#include "memtrack.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_UNDO_STEPS 256
+
+typedef enum {
+    COMMAND_MOVE = 0,
+    COMMAND_SET_POINT,
+    COMMAND_SET_BOUNDS,
+    COMMAND_ADD,
+    COMMAND_REMOVE,
+    COMMAND_SET_REGION_IDS,
+    COMMAND_REMOVE_MANY
+} CommandType;
+
+// One compact edit. Only the data needed to replay the edit in both directions is stored.
+typedef struct {
+    CommandType type;
+    EditLayer layer;
+    int index;
+    union {
+        struct { PointRef *refs; int count; int dx; int dy; } move;
+        struct { PointRef ref; int oldX; int oldY; int newX; int newY; } point;
+        struct { int oldBounds[4]; int newBounds[4]; } bounds;
+        struct { int *indices; cJSON **items; int count; } regions; // Old region_id items, then new ones; NULL for none
+        cJSON *element; // Detached element, owned by the history while it is outside the document
+        struct { int *indices; cJSON **elements; int count; } many; // Ascending indices; elements set like element
+    } data;
+} EditCommand;
+
+typedef struct {
+    EditCommand *commands;
+    int count;
+    int capacity;
+} UndoStep;
+
+static UndoStep _steps[MAX_UNDO_STEPS];
+static int _stepCount = 0;    // Steps in the history, applied ones first
+static int _appliedCount = 0; // Steps currently applied to the document
+static UndoStep _pending = { 0 };
+static bool _inTransaction = false;
+
+//------------------------------------------------------------------------------------
+// Applying commands
+//------------------------------------------------------------------------------------
+static void InsertElement(EditCommand *command)
+{
+    EditInsertElement(command->layer, command->index, command->data.element);
+    command->data.element = NULL;
+}
+
+static void DetachElement(EditCommand *command)
+{
+    command->data.element = EditDetachElement(command->layer, command->index);
+}
+
+// Applies a command forwards (redo) or backwards (undo)
+static void ApplyCommand(EditCommand *command, bool forward)
+{
+    switch (command->type)
+    {
+        case COMMAND_MOVE: {
+            int sign = forward ? 1 : -1;
+            EditMovePoints(command->data.move.refs, command->data.move.count, command->data.move.dx * sign, command->data.move.dy * sign);
+            break;
+        }
+        case COMMAND_SET_POINT:
+            if (forward) EditSetPoint(command->data.point.ref, command->data.point.newX, command->data.point.newY);
+            else EditSetPoint(command->data.point.ref, command->data.point.oldX, command->data.point.oldY);
+            break;
+        case COMMAND_SET_BOUNDS:
+            EditSetBounds(command->layer, command->index, forward ? command->data.bounds.newBounds : command->data.bounds.oldBounds);
+            break;
+        case COMMAND_ADD:
+            if (forward) InsertElement(command);
+            else DetachElement(command);
+            break;
+        case COMMAND_REMOVE:
+            if (forward) DetachElement(command);
+            else InsertElement(command);
+            break;
+        case COMMAND_SET_REGION_IDS: {
+            int count = command->data.regions.count;
+            EditSetRegionIdItems(command->data.regions.indices, command->data.regions.items + (forward ? count : 0), count);
+            break;
+        }
+        case COMMAND_REMOVE_MANY:
+            if (forward) EditDetachElements(command->layer, command->data.many.indices, command->data.many.count, command->data.many.elements);
+            else
+            {
+                EditInsertElements(command->layer, command->data.many.indices, command->data.many.elements, command->data.many.count);
+                memset(command->data.many.elements, 0, sizeof(cJSON *) * command->data.many.count);
+            }
+            break;
+    }
+}
+
+// Appends the effect a command had on the document to the autosave journal
+static void JournalCommand(EditCommand *command, bool forward)
+{
+    switch (command->type)
+    {
+        case COMMAND_MOVE: {
+            int sign = forward ? 1 : -1;
+            JournalAppendMove(command->data.move.refs, command->data.move.count, command->data.move.dx * sign, command->data.move.dy * sign);
+            break;
+        }
+        case COMMAND_SET_POINT:
+            if (forward) JournalAppendPoint(command->data.point.ref, command->data.point.newX, command->data.point.newY);
+            else JournalAppendPoint(command->data.point.ref, command->data.point.oldX, command->data.point.oldY);
+            break;
+        case COMMAND_SET_BOUNDS:
+            JournalAppendBounds(command->layer, command->index, forward ? command->data.bounds.newBounds : command->data.bounds.oldBounds);
+            break;
+        case COMMAND_ADD:
+        case COMMAND_REMOVE:
+            // Whether the element is now in the document decides between insert and remove
+            if ((command->type == COMMAND_ADD) == forward) JournalAppendInsert(command->layer, command->index, EditGetElement(command->layer, command->index));
+            else JournalAppendRemove(command->layer, command->index);
+            break;
+        case COMMAND_SET_REGION_IDS: {
+            int count = command->data.regions.count;
+            JournalAppendRegionIds(command->data.regions.indices, command->data.regions.items + (forward ? count : 0), count);
+            break;
+        }
+        case COMMAND_REMOVE_MANY:
+            if (forward) JournalAppendRemoveMany(command->layer, command->data.many.indices, command->data.many.count);
+            else
+            {
+                // The history no longer holds the elements, so their slots are borrowed to find them again
+                EditGetElements(command->layer, command->data.many.indices, command->data.many.count, command->data.many.elements);
+                JournalAppendInsertMany(command->layer, command->data.many.indices, command->data.many.elements, command->data.many.count);
+                memset(command->data.many.elements, 0, sizeof(cJSON *) * command->data.many.count);
+            }
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------------
+// History bookkeeping
+//------------------------------------------------------------------------------------
+static void FreeRegionItems(int *indices, cJSON **items, int count)
+{
+    for (int i = 0; items != NULL && i < 2 * count; i++) cJSON_Delete(items[i]);
+    MemFree(items);
+    MemFree(indices);
+}
+
+static void FreeStep(UndoStep *step)
+{
+    for (int i = 0; i < step->count; i++)
+    {
+        EditCommand *command = &step->commands[i];
+        if (command->type == COMMAND_MOVE) MemFree(command->data.move.refs);
+        else if (command->type == COMMAND_SET_REGION_IDS) FreeRegionItems(command->data.regions.indices, command->data.regions.items, command->data.regions.count);
+        else if (command->type == COMMAND_REMOVE_MANY)
+        {
+            for (int j = 0; j < command->data.many.count; j++)
+            {
+                HandleRelease(command->data.many.elements[j]);
+                cJSON_Delete(command->data.many.elements[j]);
+            }
+            MemFree(command->data.many.indices);
+            MemFree(command->data.many.elements);
+        }
+        // Detached elements are only set while the history owns them
+        else if (command->type == COMMAND_ADD || command->type == COMMAND_REMOVE)
+        {
+            HandleRelease(command->data.element);
+            cJSON_Delete(command->data.element);
+        }
+    }
+    MemFree(step->commands);
+    *step = (UndoStep){ 0 };
+}
+
+static void PushStep(UndoStep step)
+{
+    // A new edit invalidates everything that was undone
+    for (int i = _appliedCount; i < _stepCount; i++) FreeStep(&_steps[i]);
+    _stepCount = _appliedCount;
+
+    if (_stepCount == MAX_UNDO_STEPS)
+    {
+        FreeStep(&_steps[0]);
+        memmove(&_steps[0], &_steps[1], sizeof(UndoStep) * (MAX_UNDO_STEPS - 1));
+        _stepCount--;
+    }
+
+    _steps[_stepCount++] = step;
+    _appliedCount = _stepCount;
+}
+
+static EditCommand *AppendCommand(EditCommand command)
+{
+    UndoStep *step = &_pending;
+    if (step->count == step->capacity)
+    {
+        int newCapacity = (step->capacity == 0) ? 4 : step->capacity * 2;
+        EditCommand *commands = MemRealloc(step->commands, sizeof(EditCommand) * newCapacity);
+        if (commands == NULL) return NULL;
+        step->commands = commands;
+        step->capacity = newCapacity;
+    }
+    step->commands[step->count] = command;
+    return &step->commands[step->count++];
+}
+
+static void FinishRecord(void)
+{
+    if (!_inTransaction) UndoEndTransaction();
+}
+
+//------------------------------------------------------------------------------------
+// Public API
+//------------------------------------------------------------------------------------
+void UndoBeginTransaction(void)
+{
+    _inTransaction = true;
+}
+
+void UndoEndTransaction(void)
+{
+    _inTransaction = false;
+    if (_pending.count == 0) return;
+
+    // Coalesced commands are only final now; the others were journaled when recorded
+    for (int i = 0; i < _pending.count; i++)
+    {
+        if (_pending.commands[i].type == COMMAND_SET_POINT || _pending.commands[i].type == COMMAND_SET_BOUNDS) JournalCommand(&_pending.commands[i], true);
+    }
+
+    PushStep(_pending);
+    _pending = (UndoStep){ 0 };
+}
+
+void UndoRecordMove(const PointRef *refs, int count, int dx, int dy)
+{
+    if (count <= 0 || (dx == 0 && dy == 0)) return;
+
+    PointRef *copy = MemAlloc(sizeof(PointRef) * count);
+    if (copy == NULL) return;
+    memcpy(copy, refs, sizeof(PointRef) * count);
+
+    EditCommand command = { COMMAND_MOVE, LAYER_STRUCTURES, 0 };
+    command.data.move.refs = copy;
+    command.data.move.count = count;
+    command.data.move.dx = dx;
+    command.data.move.dy = dy;
+    EditCommand *recorded = AppendCommand(command);
+    if (recorded) JournalCommand(recorded, true);
+    else MemFree(copy);
+    FinishRecord();
+}
+
+void UndoRecordPoint(PointRef ref, int oldX, int oldY, int newX, int newY)
+{
+    // Continuous drags report every frame; keep the first old value and the latest new value
+    for (int i = 0; i < _pending.count; i++)
+    {
+        EditCommand *command = &_pending.commands[i];
+        if (command->type == COMMAND_SET_POINT && command->data.point.ref.layer == ref.layer &&
+            command->data.point.ref.index == ref.index && command->data.point.ref.field == ref.field)
+        {
+            command->data.point.newX = newX;
+            command->data.point.newY = newY;
+            FinishRecord();
+            return;
+        }
+    }
+
+    EditCommand command = { COMMAND_SET_POINT, ref.layer, ref.index };
+    command.data.point.ref = ref;
+    command.data.point.oldX = oldX;
+    command.data.point.oldY = oldY;
+    command.data.point.newX = newX;
+    command.data.point.newY = newY;
+    AppendCommand(command);
+    FinishRecord();
+}
+
+void UndoRecordBounds(EditLayer layer, int index, const int oldBounds[4], const int newBounds[4])
+{
+    for (int i = 0; i < _pending.count; i++)
+    {
+        EditCommand *command = &_pending.commands[i];
+        if (command->type == COMMAND_SET_BOUNDS && command->layer == layer && command->index == index)
+        {
+            memcpy(command->data.bounds.newBounds, newBounds, sizeof(int) * 4);
+            FinishRecord();
+            return;
+        }
+    }
+
+    EditCommand command = { COMMAND_SET_BOUNDS, layer, index };
+    memcpy(command.data.bounds.oldBounds, oldBounds, sizeof(int) * 4);
+    memcpy(command.data.bounds.newBounds, newBounds, sizeof(int) * 4);
+    AppendCommand(command);
+    FinishRecord();
+}
+
+void UndoRecordRegionIds(const int *indices, cJSON **oldItems, const int *newIds, int count)
+{
+    if (count <= 0) return;
+
+    int *copiedIndices = MemAlloc(sizeof(int) * count);
+    cJSON **items = MemCalloc(2 * count, sizeof(cJSON *));
+    if (copiedIndices == NULL || items == NULL)
+    {
+        for (int i = 0; i < count; i++) cJSON_Delete(oldItems[i]);
+        FreeRegionItems(copiedIndices, items, 0);
+        return;
+    }
+    memcpy(copiedIndices, indices, sizeof(int) * count);
+    memcpy(items, oldItems, sizeof(cJSON *) * count);
+    for (int i = 0; i < count; i++) items[count + i] = (newIds[i] >= 0) ? cJSON_CreateNumber(newIds[i]) : NULL;
+
+    EditCommand command = { COMMAND_SET_REGION_IDS, LAYER_STRUCTURES, 0 };
+    command.data.regions.indices = copiedIndices;
+    command.data.regions.items = items;
+    command.data.regions.count = count;
+    EditCommand *recorded = AppendCommand(command);
+    if (recorded) JournalCommand(recorded, true);
+    else FreeRegionItems(copiedIndices, items, count);
+    FinishRecord();
+}
+
+void UndoRecordAdd(EditLayer layer, int index)
+{
+    // Every structural edit outside undo/redo is recorded here right after it was applied
+    HandleLayerChanged(layer);
+
+    EditCommand command = { COMMAND_ADD, layer, index };
+    command.data.element = NULL;
+    EditCommand *recorded = AppendCommand(command);
+    if (recorded) JournalCommand(recorded, true);
+    FinishRecord();
+}
+
+void UndoRecordRemove(EditLayer layer, int index, cJSON *detached)
+{
+    HandleLayerChanged(layer);
+
+    EditCommand command = { COMMAND_REMOVE, layer, index };
+    command.data.element = detached;
+    EditCommand *recorded = AppendCommand(command);
+    if (recorded) JournalCommand(recorded, true);
+    else
+    {
+        HandleRelease(detached);
+        cJSON_Delete(detached);
+    }
+    FinishRecord();
+}
+
+void UndoRecordRemoveMany(EditLayer layer, const int *indices, cJSON **detached, int count)
+{
+    if (count <= 0) return;
+
+    int *indicesCopy = MemAlloc(sizeof(int) * count);
+    cJSON **elements = MemAlloc(sizeof(cJSON *) * count);
+    EditCommand command = { COMMAND_REMOVE_MANY, layer, 0 };
+    command.data.many.indices = indicesCopy;
+    command.data.many.elements = elements;
+    command.data.many.count = count;
+    EditCommand *recorded = (indicesCopy != NULL && elements != NULL) ? AppendCommand(command) : NULL;
+    if (recorded == NULL)
+    {
+        MemFree(indicesCopy);
+        MemFree(elements);
+        for (int i = 0; i < count; i++)
+        {
+            HandleRelease(detached[i]);
+            cJSON_Delete(detached[i]);
+        }
+        FinishRecord();
+        return;
+    }
+
+    memcpy(indicesCopy, indices, sizeof(int) * count);
+    memcpy(elements, detached, sizeof(cJSON *) * count);
+    JournalCommand(recorded, true);
+    FinishRecord();
+}
+
+static UndoResult StepResult(const UndoStep *step)
+{
+    for (int i = 0; i < step->count; i++)
+    {
+        CommandType type = step->commands[i].type;
+        if (type == COMMAND_ADD || type == COMMAND_REMOVE || type == COMMAND_REMOVE_MANY) return UNDO_RESULT_APPLIED_STRUCTURAL;
+    }
+    return UNDO_RESULT_APPLIED;
+}
+
+UndoResult Undo(void)
+{
+    if (_inTransaction || _appliedCount == 0) return UNDO_RESULT_NOTHING;
+
+    UndoStep *step = &_steps[--_appliedCount];
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    for (int i = step->count - 1; i >= 0; i--)
+    {
+        ApplyCommand(&step->commands[i], false);
+        JournalCommand(&step->commands[i], false);
+    }
+    MemPopSubsystem();
+    return StepResult(step);
+}
+
+UndoResult Redo(void)
+{
+    if (_inTransaction || _appliedCount == _stepCount) return UNDO_RESULT_NOTHING;
+
+    UndoStep *step = &_steps[_appliedCount++];
+    MemPushSubsystem(MEM_SUBSYSTEM_EDIT);
+    for (int i = 0; i < step->count; i++)
+    {
+        ApplyCommand(&step->commands[i], true);
+        JournalCommand(&step->commands[i], true);
+    }
+    MemPopSubsystem();
+    return StepResult(step);
+}
+
+void UndoClear(void)
+{
+    for (int i = 0; i < _stepCount; i++) FreeStep(&_steps[i]);
+    FreeStep(&_pending);
+    _stepCount = 0;
+    _appliedCount = 0;
+    _inTransaction = false;
+}
+
+int UndoGetUndoCount(void)
+{
+    return _appliedCount;
+}
+
+int UndoGetRedoCount(void)
+{
+    return _stepCount - _appliedCount;
+}
+
+size_t UndoGetMemoryUsage(void)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < _stepCount; i++)
+    {
+        bytes += sizeof(EditCommand) * _steps[i].capacity;
+        for (int j = 0; j < _steps[i].count; j++)
+        {
+            if (_steps[i].commands[j].type == COMMAND_MOVE) bytes += sizeof(PointRef) * _steps[i].commands[j].data.move.count;
+            else if (_steps[i].commands[j].type == COMMAND_SET_REGION_IDS) bytes += (sizeof(int) + 2 * (sizeof(cJSON *) + sizeof(cJSON))) * _steps[i].commands[j].data.regions.count;
+            else if (_steps[i].commands[j].type == COMMAND_REMOVE_MANY) bytes += (sizeof(int) + sizeof(cJSON *)) * _steps[i].commands[j].data.many.count;
+        }
+    }
+    return bytes;
+}
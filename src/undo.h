@@ -0,0 +1,107 @@
+#ifndef UNDO_H
+#define UNDO_H
+
+#include "cJSON.h"
+#include "map_editor.h"
+
+//------------------------------------------------------------------------------------
+// Types
+//------------------------------------------------------------------------------------
+
+// What a call to Undo() or Redo() did, so the caller knows whether indices moved
+typedef enum {
+    UNDO_RESULT_NOTHING = 0,
+    UNDO_RESULT_APPLIED,
+    UNDO_RESULT_APPLIED_STRUCTURAL // Elements were added or removed, array indices changed
+} UndoResult;
+
+//------------------------------------------------------------------------------------
+// Function Declarations
+//------------------------------------------------------------------------------------
+
+/**
+ * @brief Groups all following records into one undo step until UndoEndTransaction().
+ *        Records made outside a transaction become a step of their own.
+ */
+void UndoBeginTransaction(void);
+
+/**
+ * @brief Closes the current transaction and pushes it onto the undo stack if anything was recorded.
+ */
+void UndoEndTransaction(void);
+
+/**
+ * @brief Records that a set of points has been moved by the same delta. The move must already be applied.
+ * @param refs The moved points. The array is copied.
+ * @param count Number of points.
+ * @param dx Horizontal delta in world units.
+ * @param dy Vertical delta in world units (config space, y up).
+ */
+void UndoRecordMove(const PointRef *refs, int count, int dx, int dy);
+
+/**
+ * @brief Records that a single point changed. Repeated records for the same point in one transaction are coalesced.
+ */
+void UndoRecordPoint(PointRef ref, int oldX, int oldY, int newX, int newY);
+
+/**
+ * @brief Records that the bounds of a region or world area changed. Coalesced like UndoRecordPoint().
+ * @param layer The region layer.
+ * @param index The region's index in its array (0 for world areas).
+ * @param oldBounds Previous { min_x, min_y, max_x, max_y }.
+ * @param newBounds New { min_x, min_y, max_x, max_y }.
+ */
+void UndoRecordBounds(EditLayer layer, int index, const int oldBounds[4], const int newBounds[4]);
+
+/**
+ * @brief Records that the region_id of a set of structures changed. The change must already be applied.
+ * @param oldItems The region_id item each structure had before, NULL for none, as returned by
+ *        EditSetRegionIds(). The history takes ownership of the items, not of the array.
+ * @param newIds Id each structure has now, negative for none.
+ */
+void UndoRecordRegionIds(const int *indices, cJSON **oldItems, const int *newIds, int count);
+
+/**
+ * @brief Records that an element was inserted at index. The element must already be in the array.
+ */
+void UndoRecordAdd(EditLayer layer, int index);
+
+/**
+ * @brief Records that an element was detached from index. The undo history takes ownership of it.
+ */
+void UndoRecordRemove(EditLayer layer, int index, cJSON *detached);
+
+/**
+ * @brief Records that a set of elements was detached with EditDetachElements(). The undo history
+ *        takes ownership of them.
+ * @param indices Ascending indices the elements had.
+ */
+void UndoRecordRemoveMany(EditLayer layer, const int *indices, cJSON **detached, int count);
+
+/**
+ * @brief Reverts the most recent undo step.
+ */
+UndoResult Undo(void);
+
+/**
+ * @brief Re-applies the most recently undone step.
+ */
+UndoResult Redo(void);
+
+/**
+ * @brief Drops the whole history, e.g. after the document was reloaded.
+ */
+void UndoClear(void);
+
+/**
+ * @brief Returns the number of steps that can be undone and redone.
+ */
+int UndoGetUndoCount(void);
+int UndoGetRedoCount(void);
+
+/**
+ * @brief Returns the heap bytes held by command records and point lists. Detached elements are not counted.
+ */
+size_t UndoGetMemoryUsage(void);
+
+#endif // UNDO_H
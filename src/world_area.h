@@ -3,27 +3,21 @@
 
 #include "cJSON.h"
 #include "raylib.h"
+#include "map_editor.h"
 
 //------------------------------------------------------------------------------------
 // Function Declarations
 //------------------------------------------------------------------------------------
 
-/**
- * @brief Updates the position of a single world area based on mouse input.
- * @param world_area A cJSON object representing the world area.
- * @param cameraOffset The current camera offset.
- * @param displayScale The current display scale (zoom).
- */
-void UpdateWorldArea(cJSON *world_area, Vector2 cameraOffset, float *displayScale);
-
 /**
  * @brief Draws a single world area on the screen.
  * @param world_area A cJSON object representing the world area.
+ * @param layer Which world area this is, to highlight its selected and hovered corners.
  * @param cameraOffset The current camera offset.
  * @param displayScale The current display scale (zoom).
  * @param headerText The text to display for the area.
  * @param color The color to use for drawing the area.
  */
-void DrawWorldArea(cJSON *world_area, Vector2 cameraOffset, float *displayScale, const char *headerText, Color color);
+void DrawWorldArea(cJSON *world_area, EditLayer layer, Vector2 cameraOffset, float *displayScale, const char *headerText, Color color);
 
 #endif // WORLD_AREA_H